@@ -55,6 +55,7 @@ typedef struct {
     char pid_file[MAX_PATH_LENGTH];
     char log_file[MAX_PATH_LENGTH];
     int log_level; // 0=ERROR, 1=WARN, 2=INFO, 3=DEBUG
+    bool log_async; // Write logs from a background thread instead of the calling thread
 
     // Syslog settings
     bool syslog_enabled;           // Whether to log to syslog
@@ -64,6 +65,7 @@ typedef struct {
     // Storage settings
     char storage_path[MAX_PATH_LENGTH];
     char storage_path_hls[MAX_PATH_LENGTH]; // Path for HLS segments, overrides storage_path/hls when specified
+    bool hls_memory_enabled; // Keep live HLS playlists and segments in RAM instead of writing them to disk
     uint64_t max_storage_size; // in bytes
     int retention_days;
     bool auto_delete_oldest;
@@ -73,6 +75,7 @@ typedef struct {
     char mp4_storage_path[256];      // Path for MP4 recordings storage
     int mp4_segment_duration;        // Duration of each MP4 segment in seconds
     int mp4_retention_days;          // Number of days to keep MP4 recordings
+    int mp4_preview_interval;        // Seconds between timeline thumbnails of a segment, 0 disables them
     
     // Models settings
     char models_path[MAX_PATH_LENGTH]; // Path to detection models directory
@@ -106,9 +109,11 @@ typedef struct {
     bool onvif_discovery_enabled;    // Whether ONVIF discovery is enabled
     int onvif_discovery_interval;    // Interval in seconds between discovery attempts
     char onvif_discovery_network[64]; // Network to scan for ONVIF devices (e.g., "192.168.1.0/24")
+    int onvif_discovery_concurrency; // Connects and probes kept in flight while scanning a network
     
     // Stream settings
     int max_streams;
+    bool shared_ingest_enabled;      // Open each camera once and fan packets out to HLS, MP4 and detection
     stream_config_t streams[MAX_STREAMS];
     
     // Memory optimization
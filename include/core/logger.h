@@ -3,6 +3,7 @@
 
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 
 // Log levels
 // Change your logger.h enum to avoid conflicting with syslog.h
@@ -25,6 +26,32 @@ int init_logger(void);
  */
 void shutdown_logger(void);
 
+/**
+ * Start asynchronous logging
+ *
+ * Messages are then formatted on the calling thread into a bounded queue and
+ * written to the log file, console, syslog and JSON log by a background thread
+ * that flushes once per batch.  When the queue is full, messages are dropped
+ * and counted; errors are written synchronously instead.
+ * Must be called after daemonizing, threads do not survive fork().
+ *
+ * @return 0 on success, non-zero on failure (logging stays synchronous)
+ */
+int start_async_logger(void);
+
+/**
+ * Stop asynchronous logging, writing out anything still queued
+ */
+void stop_async_logger(void);
+
+/**
+ * Get asynchronous logging statistics
+ *
+ * @param written Number of messages written by the background thread (may be NULL)
+ * @param dropped Number of messages dropped because the queue was full (may be NULL)
+ */
+void get_logger_stats(uint64_t *written, uint64_t *dropped);
+
 /**
  * Set the log level
  * 
@@ -109,6 +136,19 @@ void log_message_v(log_level_t level, const char *format, va_list args);
  */
 int log_rotate(size_t max_size, int max_files);
 
+/**
+ * Run a function while no log output is being written
+ *
+ * While fn runs, the log file holds exactly the messages up to the current
+ * recent-log cursor, so a reader can combine both without gaps or repeats.
+ * fn must not log.
+ *
+ * @param fn Function to run
+ * @param arg Argument for fn
+ * @return Return value of fn, -1 if fn is NULL
+ */
+int run_with_log_output_locked(int (*fn)(void *arg), void *arg);
+
 /**
  * Get the string representation of a log level
  *
@@ -0,0 +1,75 @@
+/**
+ * @file logger_recent.h
+ * @brief In-memory index of recent log records
+ *
+ * The logger appends every message it writes to a bounded ring, so the log
+ * viewer can be served without reading or forking anything.  Each record
+ * gets a sequence number; clients poll with the last sequence number they
+ * saw (or a timestamp) and only receive newer records.
+ */
+
+#ifndef LOGGER_RECENT_H
+#define LOGGER_RECENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "core/logger.h"
+
+// Number of records kept in memory
+#define RECENT_LOG_CAPACITY 1024
+
+// Longer messages are truncated in memory (the log files keep them whole)
+#define RECENT_LOG_MESSAGE_SIZE 512
+
+typedef struct {
+    uint64_t seq;                           // Sequence number, starting at 1
+    time_t time;
+    log_level_t level;
+    char message[RECENT_LOG_MESSAGE_SIZE];
+} recent_log_record_t;
+
+/**
+ * @brief Append a record (called by the logger for every message it writes)
+ *
+ * @param level Log level
+ * @param time Time the message was logged
+ * @param message Formatted message
+ */
+void append_recent_log(log_level_t level, time_t time, const char *message);
+
+/**
+ * @brief Get the sequence number of the newest record
+ *
+ * @return Sequence number, 0 if nothing was logged yet
+ */
+uint64_t get_recent_log_cursor(void);
+
+/**
+ * @brief Get recent records
+ *
+ * Returns matching records in chronological order: the oldest ones after
+ * after_seq when polling with a cursor, otherwise the newest ones.
+ *
+ * @param max_level Most verbose level to include (LOG_LEVEL_DEBUG for everything)
+ * @param after_seq Only records with a larger sequence number (0 for no limit)
+ * @param since Only records logged after this time (0 for no limit)
+ * @param max_records Maximum number of records to return
+ * @param records Array of records (allocated, caller frees), NULL if none
+ * @param cursor Sequence number to poll with next time (may be NULL)
+ * @param truncated Set to true if records after after_seq were already evicted, or
+ *                  without after_seq, if older matching records were left out (may be NULL)
+ * @return Number of records, -1 on error
+ */
+int get_recent_logs(log_level_t max_level, uint64_t after_seq, time_t since, int max_records,
+                    recent_log_record_t **records, uint64_t *cursor, bool *truncated);
+
+/**
+ * @brief Get the lowercase level name used in the JSON log and API
+ *
+ * @param level Log level
+ * @return "error", "warning", "info" or "debug"
+ */
+const char *get_recent_log_level_name(log_level_t level);
+
+#endif /* LOGGER_RECENT_H */
@@ -127,6 +127,18 @@ int db_auth_get_user_by_username(const char *username, user_t *user);
  */
 int db_auth_get_user_by_api_key(const char *api_key, user_t *user);
 
+/**
+ * @brief Validate an API key
+ * 
+ * Like db_auth_validate_session(), results are cached for a short time and
+ * dropped when the key is regenerated or the user changes.
+ * 
+ * @param api_key API key
+ * @param user_id Pointer to store the user ID (optional, can be NULL)
+ * @return 0 on success, non-zero on failure
+ */
+int db_auth_validate_api_key(const char *api_key, int64_t *user_id);
+
 /**
  * @brief Generate a new API key for a user
  * 
@@ -164,6 +176,9 @@ int db_auth_create_session(int64_t user_id, const char *ip_address, const char *
 /**
  * @brief Validate a session token
  * 
+ * Validated tokens are cached for a short time (see db_auth_cache.h), so
+ * repeated checks of the same session do not query the database.
+ * 
  * @param token Session token
  * @param user_id Pointer to store the user ID (optional, can be NULL)
  * @return 0 on success, non-zero on failure
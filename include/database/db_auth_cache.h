@@ -0,0 +1,90 @@
+/**
+ * @file db_auth_cache.h
+ * @brief In-memory cache of validated authentication credentials
+ *
+ * Session tokens, API keys and basic-auth credential digests that were
+ * validated against the database are remembered for a short time, so the
+ * requests a browser fires for every video segment and thumbnail do not each
+ * need a database round trip (or a PBKDF2 hash for basic auth).  Entries are
+ * spread over independently locked shards and expire after
+ * AUTH_CACHE_TTL_SECONDS, or earlier when the session itself expires.
+ * db_auth.c drops entries when a session is deleted and drops every entry of
+ * a user whose password, status or API key changes or who is deleted.
+ */
+
+#ifndef LIGHTNVR_DB_AUTH_CACHE_H
+#define LIGHTNVR_DB_AUTH_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// Lifetime of a cached validation in seconds
+#define AUTH_CACHE_TTL_SECONDS 60
+
+// Longest key that can be cached (session tokens are the longest)
+#define AUTH_CACHE_MAX_KEY 128
+
+/**
+ * @brief Kinds of cached credentials
+ */
+typedef enum {
+    AUTH_CACHE_SESSION = 0,   /**< Session token */
+    AUTH_CACHE_API_KEY,       /**< API key */
+    AUTH_CACHE_BASIC          /**< Hex digest of a username and password */
+} auth_cache_kind_t;
+
+/**
+ * @brief Look up a validated credential
+ *
+ * @param kind Credential kind
+ * @param key Credential
+ * @param user_id Receives the user ID on a hit (optional, can be NULL)
+ * @return true on a hit, false if the credential is not cached or expired
+ */
+bool auth_cache_lookup(auth_cache_kind_t kind, const char *key, int64_t *user_id);
+
+/**
+ * @brief Current invalidation generation
+ *
+ * Read before validating a credential against the database and pass it to
+ * auth_cache_store(), so a validation that raced with an invalidation is
+ * not cached.
+ *
+ * @return Generation counter
+ */
+unsigned int auth_cache_generation(void);
+
+/**
+ * @brief Remember a credential that was just validated
+ *
+ * @param kind Credential kind
+ * @param key Credential (longer keys are not cached)
+ * @param user_id User the credential belongs to
+ * @param expires_at Time the credential itself expires, 0 for no limit
+ * @param generation Value of auth_cache_generation() before the validation
+ */
+void auth_cache_store(auth_cache_kind_t kind, const char *key, int64_t user_id, time_t expires_at,
+                      unsigned int generation);
+
+/**
+ * @brief Forget one credential
+ *
+ * @param kind Credential kind
+ * @param key Credential
+ */
+void auth_cache_remove(auth_cache_kind_t kind, const char *key);
+
+/**
+ * @brief Forget every credential of a user
+ *
+ * @param user_id User ID
+ */
+void auth_cache_invalidate_user(int64_t user_id);
+
+/**
+ * @brief Forget every cached credential
+ */
+void auth_cache_clear(void);
+
+#endif /* LIGHTNVR_DB_AUTH_CACHE_H */
@@ -8,6 +8,9 @@
 /**
  * Store detection results in the database
  * 
+ * When the detection writer is running the results are queued and written
+ * by its next batch, otherwise they are written before returning.
+ * 
  * @param stream_name Stream name
  * @param result Detection results
  * @param timestamp Timestamp of the detection (0 for current time)
@@ -0,0 +1,53 @@
+/**
+ * Asynchronous detection writer
+ *
+ * Detection threads hand their results to a bounded lock-free queue and
+ * return immediately.  A single writer thread drains the queue every few
+ * milliseconds and inserts everything it finds, from all streams, in one
+ * transaction with a prepared statement that lives as long as the thread.
+ */
+
+#ifndef DB_DETECTIONS_WRITER_H
+#define DB_DETECTIONS_WRITER_H
+
+#include <stdint.h>
+#include <time.h>
+#include "video/detection_result.h"
+
+/**
+ * Start the detection writer thread
+ *
+ * @param flush_interval_ms Time between batches in milliseconds (10-5000)
+ * @return 0 on success, -1 on error
+ */
+int start_detection_writer(int flush_interval_ms);
+
+/**
+ * Stop the detection writer thread, writing out anything still queued
+ *
+ * Must be called before the database is shut down.
+ */
+void stop_detection_writer(void);
+
+/**
+ * Queue detection results for the writer thread
+ *
+ * Never blocks and never touches the database.
+ *
+ * @param stream_name Stream name
+ * @param result Detection results
+ * @param timestamp Timestamp of the detection
+ * @return 0 if queued, -1 if the writer is not running or the queue is full
+ */
+int queue_detections(const char *stream_name, const detection_result_t *result, time_t timestamp);
+
+/**
+ * Get detection writer statistics
+ *
+ * @param written Number of detection results written (may be NULL)
+ * @param batches Number of transactions committed (may be NULL)
+ * @param rejected Number of results not queued because the queue was full (may be NULL)
+ */
+void get_detection_writer_stats(uint64_t *written, uint64_t *batches, uint64_t *rejected);
+
+#endif // DB_DETECTIONS_WRITER_H
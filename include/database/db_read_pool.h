@@ -0,0 +1,86 @@
+#ifndef LIGHTNVR_DB_READ_POOL_H
+#define LIGHTNVR_DB_READ_POOL_H
+
+#include <stdbool.h>
+#include <sqlite3.h>
+
+/**
+ * Read-only SQLite connections for queries
+ *
+ * With WAL enabled, readers do not block the writer or each other, so read
+ * queries check out one of a few read-only connections instead of taking
+ * the global database mutex.  A thread gets back the connection it used
+ * last whenever it is free, so long-lived worker threads keep a warm
+ * per-connection prepared-statement cache.  When the pool is not running
+ * (no WAL, or during startup and shutdown) the primary connection is used
+ * under the database mutex, so callers do not need a fallback path.
+ *
+ * Usage:
+ *     db_read_conn_t *conn;
+ *     sqlite3_stmt *stmt = db_read_query(sql, &conn);
+ *     if (!stmt) return -1;    // Already logged, nothing to release
+ *     ... bind, step ...
+ *     db_read_release(conn);   // Never finalize statements from the pool
+ */
+
+// Number of read-only connections
+#define DB_READ_POOL_SIZE 4
+
+// Prepared statements cached per connection
+#define DB_READ_STMT_CACHE_SIZE 24
+
+typedef struct db_read_conn db_read_conn_t;
+
+/**
+ * Open the read-only connections
+ *
+ * @param db_path Path to the database file
+ * @return 0 on success, -1 on error (reads then go through the primary connection)
+ */
+int init_db_read_pool(const char *db_path);
+
+/**
+ * Close the read-only connections, waiting briefly for those checked out
+ */
+void shutdown_db_read_pool(void);
+
+/**
+ * Check out a connection for reading
+ *
+ * @return Connection, or NULL if the database is not initialized
+ */
+db_read_conn_t *db_read_acquire(void);
+
+/**
+ * Get the SQLite handle of a checked out connection (for sqlite3_errmsg)
+ */
+sqlite3 *db_read_handle(db_read_conn_t *conn);
+
+/**
+ * Get a prepared statement for a query, from the connection's cache if possible
+ *
+ * The statement is reset and its bindings cleared when the connection is released.
+ *
+ * @param conn Checked out connection
+ * @param sql Query text
+ * @return Statement, or NULL on error
+ */
+sqlite3_stmt *db_read_prepare(db_read_conn_t *conn, const char *sql);
+
+/**
+ * Check out a connection and prepare a query on it
+ *
+ * Failures are logged and leave no connection checked out.
+ *
+ * @param sql Query text
+ * @param conn Receives the connection, return it with db_read_release()
+ * @return Statement, or NULL on error
+ */
+sqlite3_stmt *db_read_query(const char *sql, db_read_conn_t **conn);
+
+/**
+ * Return a connection to the pool
+ */
+void db_read_release(db_read_conn_t *conn);
+
+#endif // LIGHTNVR_DB_READ_POOL_H
@@ -21,6 +21,21 @@ typedef struct {
     char trigger_type[16];  // 'scheduled', 'detection', 'motion', 'manual'
 } recording_metadata_t;
 
+// Per-stream storage counters, kept in step with the recordings table by triggers
+typedef struct {
+    char stream_name[64];
+    uint64_t size_bytes;
+    int recording_count;
+} recording_storage_usage_t;
+
+// File columns of a recording, used by the background size verification
+typedef struct {
+    uint64_t id;
+    char file_path[256];
+    uint64_t size_bytes;
+    bool is_complete;
+} recording_file_info_t;
+
 /**
  * Add recording metadata to the database
  * 
@@ -41,6 +56,48 @@ uint64_t add_recording_metadata(const recording_metadata_t *metadata);
 int update_recording_metadata(uint64_t id, time_t end_time, 
                              uint64_t size_bytes, bool is_complete);
 
+/**
+ * Update the size of a recording that is still being written
+ *
+ * Completed recordings are left untouched, they carry the final size
+ * reported by the muxer.
+ *
+ * @param id Recording ID
+ * @param size_bytes Current size in bytes
+ * @return 0 on success, non-zero on failure
+ */
+int update_recording_size(uint64_t id, uint64_t size_bytes);
+
+/**
+ * Replace the size of a completed recording with the size of its file
+ *
+ * Used by the storage audit when a file changed outside the database, the
+ * storage usage triggers move the stream's counter along with it.
+ *
+ * @param id Recording ID
+ * @param size_bytes Size of the file in bytes
+ * @return 0 on success, non-zero on failure
+ */
+int correct_recording_size(uint64_t id, uint64_t size_bytes);
+
+/**
+ * Mark a recording complete with the metadata collected by the muxer
+ *
+ * End time, size, resolution, frame rate and codec are written in a single
+ * UPDATE, so a finished recording needs no further probing or syncing.
+ *
+ * @param id Recording ID
+ * @param end_time End time
+ * @param size_bytes Final file size in bytes
+ * @param width Video width (0 keeps the stored value)
+ * @param height Video height (0 keeps the stored value)
+ * @param fps Frame rate (0 keeps the stored value)
+ * @param codec Video codec name (NULL or empty keeps the stored value)
+ * @return 0 on success, non-zero on failure
+ */
+int finalize_recording_metadata(uint64_t id, time_t end_time, uint64_t size_bytes,
+                                int width, int height, int fps, const char *codec);
+
 /**
  * Get recording metadata from the database
  * 
@@ -112,4 +169,109 @@ int delete_recording_metadata(uint64_t id);
  */
 int delete_old_recording_metadata(uint64_t max_age);
 
+/**
+ * Delete a list of recordings in a single transaction
+ *
+ * IDs are deleted in chunks of set-based statements and the file paths of
+ * the deleted rows are returned, so the caller can remove the files once
+ * the rows are gone. Nothing is deleted if any statement fails.
+ *
+ * @param ids Recording IDs, IDs that do not exist are skipped
+ * @param id_count Number of IDs
+ * @param file_paths Receives the paths of the deleted recordings, free with free_recording_paths()
+ * @return Number of recordings deleted, or -1 on error
+ */
+int delete_recordings_by_ids(const uint64_t *ids, int id_count, char ***file_paths);
+
+/**
+ * Delete the recordings matching a filter in a single transaction
+ *
+ * Matches the same complete recordings as get_recording_count().
+ *
+ * @param start_time Start time filter (0 for no filter)
+ * @param end_time End time filter (0 for no filter)
+ * @param stream_name Stream name filter (NULL for all streams)
+ * @param has_detection Only delete detection recordings if non-zero
+ * @param file_paths Receives the paths of the deleted recordings, free with free_recording_paths()
+ * @return Number of recordings deleted, or -1 on error
+ */
+int delete_recordings_by_filter(time_t start_time, time_t end_time, const char *stream_name,
+                                int has_detection, char ***file_paths);
+
+/**
+ * Free the file paths returned by a batch delete
+ *
+ * @param file_paths Paths, may be NULL
+ * @param count Number of paths
+ */
+void free_recording_paths(char **file_paths, int count);
+
+/**
+ * Get the oldest complete recordings, oldest first
+ *
+ * Reads at most max_count rows through the start_time indexes, so retention
+ * only ever looks at the recordings it is about to delete.
+ *
+ * @param stream_name Stream name filter (NULL for all streams)
+ * @param before Only recordings that started before this time (0 for no limit)
+ * @param metadata Array to fill with recording metadata
+ * @param max_count Maximum number of recordings to return
+ * @return Number of recordings found, or -1 on error
+ */
+int get_oldest_recordings(const char *stream_name, time_t before,
+                          recording_metadata_t *metadata, int max_count);
+
+/**
+ * Get the total size of recordings
+ *
+ * Reads the per-stream storage counters, so this does not scan the recordings.
+ *
+ * @param stream_name Stream name filter (NULL for all streams)
+ * @return Total size in bytes, or -1 on error
+ */
+int64_t get_recordings_total_size(const char *stream_name);
+
+/**
+ * Get the names of the streams that have recordings, in name order
+ *
+ * Includes streams that have since been removed from the configuration.
+ *
+ * @param names Array to fill with stream names
+ * @param max_count Maximum number of names to return
+ * @return Number of names found, or -1 on error
+ */
+int get_recording_stream_names(char (*names)[64], int max_count);
+
+/**
+ * Get the per-stream storage counters, in name order
+ *
+ * Only streams with at least one recording are returned.
+ *
+ * @param usage Array to fill with the counters
+ * @param max_count Maximum number of streams to return
+ * @return Number of streams found, or -1 on error
+ */
+int get_recording_storage_usage(recording_storage_usage_t *usage, int max_count);
+
+/**
+ * Check the per-stream storage counters against the recordings table and
+ * rebuild them if any stream disagrees
+ *
+ * The comparison runs on a read-only connection, only a rebuild takes the
+ * database lock. Files on disk are not looked at.
+ *
+ * @return Number of streams that had drifted, or -1 on error
+ */
+int reconcile_recording_storage_usage(void);
+
+/**
+ * Get a page of recording files in ID order, starting after a cursor
+ *
+ * @param after_id Only recordings with a larger ID are returned (0 for the first page)
+ * @param files Array to fill
+ * @param max_count Maximum number of recordings to return
+ * @return Number of recordings found (0 past the end), or -1 on error
+ */
+int get_recording_files_after_id(uint64_t after_id, recording_file_info_t *files, int max_count);
+
 #endif // LIGHTNVR_DB_RECORDINGS_H
@@ -26,6 +26,17 @@ int start_recording_sync_thread(int interval_seconds);
  */
 int stop_recording_sync_thread(void);
 
+/**
+ * Mark a recording as needing a size sync
+ *
+ * Called whenever a recording that is still being written is added or
+ * updated. The sync thread only checks marked recordings, plus a slow paged
+ * verification of the rest of the table.
+ *
+ * @param recording_id Recording ID
+ */
+void mark_recording_dirty(uint64_t recording_id);
+
 /**
  * Force an immediate sync of all recordings
  * 
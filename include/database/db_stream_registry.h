@@ -0,0 +1,63 @@
+/**
+ * @file db_stream_registry.h
+ * @brief Authoritative in-memory copy of the stream configurations
+ *
+ * The registry is loaded from the streams table on first use and is
+ * updated by the stream write functions in db_streams.c (and by anything
+ * else that writes the table through stream_registry_reload()), so lookups
+ * never touch SQLite.  Every change bumps a global generation counter.
+ * Worker threads keep a private copy of their stream's configuration and
+ * call stream_registry_refresh() in their loop: while nothing changed that
+ * is a single atomic load and comparison, and only after a change is the
+ * configuration copied again under the registry's read lock.
+ */
+
+#ifndef LIGHTNVR_DB_STREAM_REGISTRY_H
+#define LIGHTNVR_DB_STREAM_REGISTRY_H
+
+#include <stdint.h>
+#include "core/config.h"
+
+/**
+ * @brief Current registry generation
+ *
+ * @return Generation, 0 until the registry has been loaded
+ */
+uint64_t stream_registry_generation(void);
+
+/**
+ * @brief Look up a stream configuration
+ *
+ * @param name Stream name
+ * @param config Receives a copy of the configuration
+ * @return 0 on success, -1 if the stream does not exist
+ */
+int stream_registry_get(const char *name, stream_config_t *config);
+
+/**
+ * @brief Refresh a private copy of a stream configuration if it changed
+ *
+ * @param name Stream name
+ * @param config Private copy, overwritten when the registry changed
+ * @param generation Generation of the private copy, start with 0
+ * @return 1 if the copy was updated, 0 if nothing changed, -1 if the stream
+ *         no longer exists
+ */
+int stream_registry_refresh(const char *name, stream_config_t *config, uint64_t *generation);
+
+/**
+ * @brief Re-read one stream from the database into the registry
+ *
+ * Called after the streams table was written.  A stream that is no longer
+ * in the table is dropped from the registry.
+ *
+ * @param name Stream name
+ */
+void stream_registry_reload(const char *name);
+
+/**
+ * @brief Drop every registry entry, the next lookup reloads the table
+ */
+void stream_registry_clear(void);
+
+#endif /* LIGHTNVR_DB_STREAM_REGISTRY_H */
@@ -39,7 +39,10 @@ int delete_stream_config(const char *name);
 int delete_stream_config_internal(const char *name, bool permanent);
 
 /**
- * Get a stream configuration from the database
+ * Get a stream configuration
+ *
+ * Served from the in-memory stream registry (see db_stream_registry.h)
+ * without touching the database.
  *
  * @param name Stream name to get
  * @param stream Stream configuration to fill
@@ -47,6 +50,15 @@ int delete_stream_config_internal(const char *name, bool permanent);
  */
 int get_stream_config_by_name(const char *name, stream_config_t *stream);
 
+/**
+ * Get a stream configuration from the database, bypassing the registry
+ *
+ * @param name Stream name to get
+ * @param stream Stream configuration to fill
+ * @return 0 on success, non-zero on failure
+ */
+int get_stream_config_from_db(const char *name, stream_config_t *stream);
+
 /**
  * Get all stream configurations from the database
  *
@@ -78,4 +90,24 @@ int get_enabled_stream_count(void);
  */
 int is_stream_eligible_for_live_streaming(const char *stream_name);
 
+/**
+ * Get the retention settings of a stream
+ *
+ * @param name Stream name
+ * @param retention_days Receives the retention in days (0 = use the global setting)
+ * @param max_storage_mb Receives the storage quota in MB (0 = no quota)
+ * @return 0 on success, non-zero on failure
+ */
+int get_stream_retention_config(const char *name, int *retention_days, int *max_storage_mb);
+
+/**
+ * Set the retention settings of a stream
+ *
+ * @param name Stream name
+ * @param retention_days Retention in days (0 = use the global setting)
+ * @param max_storage_mb Storage quota in MB (0 = no quota)
+ * @return 0 on success, non-zero on failure
+ */
+int set_stream_retention_config(const char *name, int retention_days, int max_storage_mb);
+
 #endif // LIGHTNVR_DB_STREAMS_H
@@ -0,0 +1,50 @@
+#ifndef SOD_GEMM_H
+#define SOD_GEMM_H
+
+/**
+ * Convolution backend for the SOD CNN
+ *
+ * A packed, cache-blocked single precision GEMM with vectorized micro-kernels
+ * (AVX2/FMA or NEON, selected at runtime) and an im2col that copies whole
+ * rows, both split across a fixed pool of worker threads.  The pool is
+ * started on first use.  When another network is already using it, a call
+ * runs on the calling thread instead of waiting, so several detection
+ * threads never block each other.
+ */
+
+/**
+ * C += ALPHA * A * B with row-major A (M x K), B (K x N) and C (M x N)
+ */
+void sod_gemm_nn(int M, int N, int K, float ALPHA,
+                 const float *A, int lda,
+                 const float *B, int ldb,
+                 float *C, int ldc);
+
+/**
+ * Unfold an image (channels x height x width) into the column matrix used by
+ * the convolution GEMM, (channels * ksize * ksize) x (height_col * width_col)
+ */
+void sod_im2col(const float *data_im, int channels, int height, int width,
+                int ksize, int stride, int pad, float *data_col);
+
+/**
+ * Set the number of threads used by the backend, including the caller
+ *
+ * Must be called before the first convolution to take effect for the worker
+ * pool; later calls can only lower the number of threads used.
+ *
+ * @param threads Thread count, or 0 for one per online CPU
+ */
+void sod_gemm_set_threads(int threads);
+
+/**
+ * Get the number of threads used by the backend, including the caller
+ */
+int sod_gemm_get_threads(void);
+
+/**
+ * Get the name of the selected GEMM micro-kernel ("avx2", "neon" or "generic")
+ */
+const char *sod_gemm_kernel_name(void);
+
+#endif /* SOD_GEMM_H */
@@ -110,6 +110,11 @@ int delete_recording(const char *path);
 /**
  * Apply retention policy (delete oldest recordings if storage limit is reached)
  *
+ * Works from the recordings table: for every stream, recordings older than
+ * its retention (per-stream setting, else the global one) and recordings
+ * over its quota are deleted oldest first in small batches, then the global
+ * size limit is enforced the same way.
+ *
  * @return Number of recordings deleted, or -1 on error
  */
 int apply_retention_policy(void);
@@ -130,6 +135,13 @@ int set_max_storage_size(uint64_t max_size);
  */
 int set_retention_days(int days);
 
+/**
+ * Set whether the oldest recordings are deleted when the storage limit is reached
+ *
+ * @param enabled True to enforce the storage limit
+ */
+void set_auto_delete_oldest(bool enabled);
+
 /**
  * Check if storage is available
  *
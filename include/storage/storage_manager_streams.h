@@ -20,7 +20,9 @@ typedef struct {
 /**
  * Get storage usage per stream
  * 
- * @param storage_path Base storage path
+ * Reads the per-stream counters kept in the database, it does not scan the disk.
+ * 
+ * @param storage_path Base storage path (unused)
  * @param stream_info Array to fill with stream storage information
  * @param max_streams Maximum number of streams to return
  * @return Number of streams found, or -1 on error
@@ -0,0 +1,52 @@
+#ifndef DETECTION_FRAME_CACHE_H
+#define DETECTION_FRAME_CACHE_H
+
+#include <stdint.h>
+#include <libavutil/frame.h>
+#include "video/detection_model.h"
+
+struct SwsContext;
+
+/**
+ * Per-stream frame conversion cache for detection
+ *
+ * Keeps the scaler and the RGB destination buffer of a detection thread
+ * alive across frames.  Decoded frames are resized and converted to packed
+ * RGB in a single sws_scale pass, directly to the model's input size when
+ * the model has a fixed one, otherwise to the configured downscaled size.
+ * Everything is rebuilt only when the source resolution, pixel format or
+ * the model changes.
+ */
+typedef struct {
+    struct SwsContext *sws_ctx;
+    detection_model_t model;        // Model the target size was chosen for
+    int src_width;
+    int src_height;
+    int src_format;
+    int dst_width;
+    int dst_height;
+    int channels;
+    uint8_t *buffer;                // Packed RGB, dst_width * dst_height * channels
+} detection_frame_cache_t;
+
+/**
+ * Convert a decoded frame for a model
+ *
+ * @param cache Conversion cache of the calling stream
+ * @param frame Decoded frame
+ * @param model Model the frame is for
+ * @param width Receives the width of the converted frame
+ * @param height Receives the height of the converted frame
+ * @param channels Receives the number of channels of the converted frame
+ * @return Converted frame, owned by the cache and valid until the next call, or NULL on error
+ */
+const uint8_t *detection_frame_cache_convert(detection_frame_cache_t *cache, const AVFrame *frame,
+                                             detection_model_t model,
+                                             int *width, int *height, int *channels);
+
+/**
+ * Free the scaler and buffers of a cache
+ */
+void detection_frame_cache_free(detection_frame_cache_t *cache);
+
+#endif /* DETECTION_FRAME_CACHE_H */
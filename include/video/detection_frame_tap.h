@@ -0,0 +1,57 @@
+/**
+ * Live keyframe tap for object detection
+ *
+ * Attaches a keyframes-only subscriber to the shared ingest of a stream and
+ * decodes the keyframes it receives with a persistent decoder.  Detection
+ * threads use this instead of polling the HLS directory and re-opening and
+ * decoding whole segments from disk.
+ */
+
+#ifndef DETECTION_FRAME_TAP_H
+#define DETECTION_FRAME_TAP_H
+
+#include <stdbool.h>
+#include <libavutil/frame.h>
+
+// Keyframes buffered for a detection thread before older ones are discarded
+#define DETECTION_FRAME_TAP_QUEUE_SIZE 4
+
+typedef struct detection_frame_tap detection_frame_tap_t;
+
+/**
+ * Open a keyframe tap on the live ingest of a stream
+ *
+ * Only available when shared ingest is enabled; callers fall back to reading
+ * HLS segments otherwise.
+ *
+ * @param stream_name The name of the stream
+ * @return Tap handle, or NULL if shared ingest is disabled or on error
+ */
+detection_frame_tap_t *detection_frame_tap_open(const char *stream_name);
+
+/**
+ * Close a keyframe tap
+ *
+ * @param tap Tap handle (may be NULL)
+ */
+void detection_frame_tap_close(detection_frame_tap_t *tap);
+
+/**
+ * Wait for the next keyframe and decode it
+ *
+ * @param tap Tap handle
+ * @param frame Receives the decoded picture
+ * @param timeout_ms Maximum time to wait for a keyframe
+ * @return 0 on success, AVERROR(EAGAIN) if no picture is available yet,
+ *         AVERROR_EOF if the ingest stopped, other negative on error
+ */
+int detection_frame_tap_read(detection_frame_tap_t *tap, AVFrame *frame, int timeout_ms);
+
+/**
+ * Discard keyframes queued while detection was not due
+ *
+ * @param tap Tap handle
+ */
+void detection_frame_tap_flush(detection_frame_tap_t *tap);
+
+#endif /* DETECTION_FRAME_TAP_H */
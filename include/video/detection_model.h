@@ -71,6 +71,16 @@ void* get_realnet_model_handle(detection_model_t model);
  */
 const char* get_model_type_from_handle(detection_model_t model);
 
+/**
+ * Get the fixed input size of a model
+ *
+ * @param model Detection model handle
+ * @param width Receives the input width
+ * @param height Receives the input height
+ * @return 0 if the model has a fixed input size, -1 if it accepts any size
+ */
+int get_model_input_size(detection_model_t model, int *width, int *height);
+
 /**
  * Clean up old models in the global cache
  *
@@ -7,6 +7,7 @@
 #include <time.h>
 #include "video/packet_processor.h" // For MAX_STREAM_NAME definition
 #include "video/detection_model.h"
+#include "video/detection_frame_cache.h"
 
 // Maximum number of streams we can handle
 #define MAX_STREAM_THREADS 32
@@ -26,6 +27,7 @@ typedef struct {
     time_t last_detection_time;
     int component_id;
     atomic_int detection_in_progress; // Atomic flag to track if a detection is currently running
+    detection_frame_cache_t frame_cache; // Scaler and RGB buffer reused across frames
 } stream_detection_thread_t;
 
 // Global variable for startup delay
@@ -0,0 +1,140 @@
+/**
+ * In-memory live HLS segment store
+ *
+ * When [storage] hls_in_memory is enabled the HLS writer hands every playlist
+ * and segment it finishes to this store instead of writing it to disk.  Each
+ * stream keeps its playlists plus a ring of the most recent media segments,
+ * and the web server and detection threads read them straight from memory.
+ * Files are immutable and reference counted, so a reader can keep using a
+ * segment after the writer has replaced or evicted it.
+ */
+
+#ifndef HLS_MEMORY_STORE_H
+#define HLS_MEMORY_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <libavformat/avformat.h>
+
+// Media segments kept per stream, a few more than the playlist lists so
+// slightly late clients can still fetch the oldest listed segment
+#define HLS_MEMORY_MAX_SEGMENTS 9
+
+// Playlists and initialization segments kept per stream
+#define HLS_MEMORY_MAX_PINNED 4
+
+// Longest file name that can be stored
+#define HLS_MEMORY_MAX_FILE_NAME 64
+
+/**
+ * Immutable file held by the store
+ */
+typedef struct {
+    char name[HLS_MEMORY_MAX_FILE_NAME];
+    uint8_t *data;       // Contents, allocated with av_malloc
+    size_t size;
+    uint64_t serial;     // Unique across the store, used as the HTTP ETag
+    time_t created;
+    int refcount;        // Protected by the store lock
+} hls_memory_file_t;
+
+/**
+ * Store a finished playlist or segment
+ *
+ * Replaces a file of the same name.  Media segments beyond
+ * HLS_MEMORY_MAX_SEGMENTS evict the oldest one.
+ *
+ * @param stream_name Stream the file belongs to
+ * @param file_name File name as referenced by the playlist
+ * @param data Contents allocated with av_malloc, ownership passes to the store
+ * @param size Size of the contents
+ * @return 0 on success, -1 on error (data is freed)
+ */
+int hls_memory_store_put(const char *stream_name, const char *file_name, uint8_t *data, size_t size);
+
+/**
+ * Look up a file
+ *
+ * @param stream_name Stream name
+ * @param file_name File name
+ * @return Referenced file to release with hls_memory_file_release(), or NULL if not stored
+ */
+hls_memory_file_t *hls_memory_store_get(const char *stream_name, const char *file_name);
+
+/**
+ * Release a file returned by hls_memory_store_get()
+ *
+ * @param file File (may be NULL)
+ */
+void hls_memory_file_release(hls_memory_file_t *file);
+
+/**
+ * Write a copy of a stored file to disk
+ *
+ * Used where a file has to outlive its place in the ring, such as the
+ * pre-detection buffer.
+ *
+ * @param stream_name Stream name
+ * @param file_name File name
+ * @param path Destination path, replaced if it exists
+ * @return 0 on success, -1 if the file is not stored or could not be written
+ */
+int hls_memory_store_save(const char *stream_name, const char *file_name, const char *path);
+
+/**
+ * Get the live playlist position of a stream
+ *
+ * @param stream_name Stream name
+ * @param last_sequence Receives the media sequence number of the newest listed segment
+ * @param target_duration Receives the playlist target duration in seconds (optional)
+ * @return true if a playlist with at least one segment is stored
+ */
+bool hls_memory_store_playlist_state(const char *stream_name, int64_t *last_sequence,
+                                     int *target_duration);
+
+/**
+ * Get the newest media segment of a stream
+ *
+ * @param stream_name Stream name
+ * @param file_name Buffer for the segment file name
+ * @param file_name_size Size of the buffer
+ * @param created Receives the time the segment was stored (optional)
+ * @param segment_count Receives the number of stored segments (optional)
+ * @return true if the stream has at least one segment
+ */
+bool hls_memory_store_newest_segment(const char *stream_name, char *file_name, size_t file_name_size,
+                                     time_t *created, int *segment_count);
+
+/**
+ * Drop every file of a stream
+ *
+ * @param stream_name Stream name
+ */
+void hls_memory_store_remove(const char *stream_name);
+
+/**
+ * Drop every stored file, called at shutdown
+ */
+void hls_memory_store_clear(void);
+
+/**
+ * Open a read-only, seekable AVIOContext over a stored file
+ *
+ * The context takes over the caller's reference to the file.
+ *
+ * @param file File from hls_memory_store_get()
+ * @return Context to close with hls_memory_file_close_read(), or NULL on error
+ *         (the reference is kept by the caller)
+ */
+AVIOContext *hls_memory_file_open_read(hls_memory_file_t *file);
+
+/**
+ * Close a context from hls_memory_file_open_read() and release its file
+ *
+ * @param pb Context to close, set to NULL
+ */
+void hls_memory_file_close_read(AVIOContext **pb);
+
+#endif /* HLS_MEMORY_STORE_H */
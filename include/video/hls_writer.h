@@ -7,10 +7,14 @@
 #include <libavcodec/bsf.h>
 
 #include "core/config.h"
+#include "video/hls_memory_store.h"
 
 // Use a different name to avoid conflict with MAX_PATH_LENGTH in config.h
 #define HLS_MAX_PATH_LENGTH 1024
 
+// Playlists and segments the HLS muxer can have open at once in memory mode
+#define HLS_MEMORY_MAX_OPEN_OUTPUTS 4
+
 // Forward declaration for the DTS tracking structure
 typedef struct {
     int64_t first_dts;
@@ -44,6 +48,18 @@ typedef struct hls_writer_t {
 
     // Mutex for thread safety
     pthread_mutex_t mutex;
+
+    // Write playlists and segments to the in-memory store instead of disk
+    bool in_memory;
+
+    // Muxer options handed to avformat_write_header in memory mode
+    AVDictionary *muxer_options;
+
+    // Outputs the muxer currently has open in memory mode
+    struct {
+        AVIOContext *pb;
+        char name[HLS_MEMORY_MAX_FILE_NAME];
+    } memory_outputs[HLS_MEMORY_MAX_OPEN_OUTPUTS];
 } hls_writer_t;
 
 /**
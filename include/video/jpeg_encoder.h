@@ -0,0 +1,30 @@
+#ifndef LIGHTNVR_JPEG_ENCODER_H
+#define LIGHTNVR_JPEG_ENCODER_H
+
+#include <stddef.h>
+
+/**
+ * In-memory JPEG encoding with libavcodec's MJPEG encoder
+ *
+ * Each calling thread keeps its own encoder and scaler contexts, which are
+ * only rebuilt when the frame size, pixel layout or quality changes, so a
+ * detection thread encoding a fixed-size frame per cycle allocates nothing
+ * after the first call.  The contexts are freed when the thread exits.
+ */
+
+/**
+ * Encode a packed frame as JPEG
+ *
+ * @param frame_data Packed pixels (grayscale, RGB or RGBA)
+ * @param width Frame width
+ * @param height Frame height
+ * @param channels Bytes per pixel: 1, 3 or 4
+ * @param quality JPEG quality 1-100
+ * @param jpeg_data Receives a malloc'd buffer with the JPEG data, freed by the caller
+ * @param jpeg_size Receives the size of the JPEG data
+ * @return 0 on success, -1 on error
+ */
+int jpeg_encode_frame(const unsigned char *frame_data, int width, int height, int channels,
+                      int quality, unsigned char **jpeg_data, size_t *jpeg_size);
+
+#endif /* LIGHTNVR_JPEG_ENCODER_H */
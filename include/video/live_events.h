@@ -0,0 +1,98 @@
+/**
+ * Live event hub
+ *
+ * Detection results, motion state changes and recording state changes are
+ * published here by the threads that produce them.  The hub keeps the latest
+ * detection result of every stream plus a short ring of recent events, each
+ * with a sequence number, so the web server can push them to subscribed
+ * clients without querying the database.  Checking for new events is a
+ * single atomic load of the newest sequence number.
+ */
+
+#ifndef LIVE_EVENTS_H
+#define LIVE_EVENTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "core/config.h"
+#include "video/detection_result.h"
+
+// Number of recent events kept for subscribers that fall behind
+#define LIVE_EVENTS_RING_SIZE 256
+
+typedef enum {
+    LIVE_EVENT_DETECTION = 0,   // New detection result, read it with live_events_get_detections()
+    LIVE_EVENT_MOTION,          // Motion started or ended
+    LIVE_EVENT_RECORDING        // Recording started or stopped
+} live_event_type_t;
+
+typedef struct {
+    uint64_t sequence;
+    live_event_type_t type;
+    char stream_name[MAX_STREAM_NAME];
+    time_t timestamp;
+    bool active;                // Motion or recording state, detection count > 0 for detections
+} live_event_t;
+
+/**
+ * Publish the latest detection result of a stream
+ *
+ * @param stream_name Stream name
+ * @param result Detection result (an empty result clears the stream's detections)
+ * @param timestamp Time of the frame, 0 for now
+ */
+void live_events_publish_detections(const char *stream_name, const detection_result_t *result,
+                                    time_t timestamp);
+
+/**
+ * Publish a motion state change
+ *
+ * Reports that repeat the stream's current motion state are ignored.
+ *
+ * @param stream_name Stream name
+ * @param active Whether motion is in progress
+ * @param timestamp Time of the change, 0 for now
+ */
+void live_events_publish_motion(const char *stream_name, bool active, time_t timestamp);
+
+/**
+ * Publish a recording state change
+ *
+ * @param stream_name Stream name
+ * @param active Whether the stream is now recording
+ */
+void live_events_publish_recording(const char *stream_name, bool active);
+
+/**
+ * Sequence number of the newest event
+ *
+ * @return Sequence number, 0 before the first event
+ */
+uint64_t live_events_sequence(void);
+
+/**
+ * Read events newer than a sequence number
+ *
+ * Events that already fell out of the ring are skipped.
+ *
+ * @param after Sequence number of the last event the caller has seen
+ * @param events Array to fill, oldest first
+ * @param max_events Size of the array
+ * @return Number of events returned
+ */
+int live_events_read(uint64_t after, live_event_t *events, int max_events);
+
+/**
+ * Get the latest detection result of a stream
+ *
+ * @param stream_name Stream name
+ * @param result Receives the detection result
+ * @param timestamp Receives the time of the result (optional)
+ * @param sequence Receives the sequence number of the event that published it (optional)
+ * @return true if the stream has published a result
+ */
+bool live_events_get_detections(const char *stream_name, detection_result_t *result,
+                                time_t *timestamp, uint64_t *sequence);
+
+#endif /* LIVE_EVENTS_H */
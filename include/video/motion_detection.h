@@ -46,6 +46,25 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
                  int width, int height, int channels, time_t frame_time,
                  detection_result_t *result);
 
+/**
+ * Process the luma plane of a decoded YUV frame for motion detection
+ *
+ * The plane is read in place (no RGB conversion and no copy unless the rows
+ * have to be packed), and all working buffers are kept with the stream, so a
+ * steady-state call does not allocate.
+ *
+ * @param stream_name The name of the stream
+ * @param y_plane Luma plane (e.g. AVFrame data[0] of a YUV420P/NV12 frame)
+ * @param linesize Bytes between the starts of consecutive rows (>= width)
+ * @param width Frame width
+ * @param height Frame height
+ * @param frame_time Timestamp of the frame
+ * @param result Pointer to detection result structure to fill
+ * @return 0 on success, non-zero on failure
+ */
+int detect_motion_yuv(const char *stream_name, const uint8_t *y_plane, int linesize,
+                      int width, int height, time_t frame_time, detection_result_t *result);
+
 /**
  * Configure advanced motion detection parameters
  * 
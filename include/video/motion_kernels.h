@@ -0,0 +1,84 @@
+#ifndef MOTION_KERNELS_H
+#define MOTION_KERNELS_H
+
+#include <stdint.h>
+
+/**
+ * Pixel kernels used by motion detection
+ *
+ * Every implementation produces bit-exact the same output as the scalar
+ * reference; the vector variants only change how fast it is computed.
+ * The best variant supported by the running CPU is selected once at runtime.
+ */
+
+typedef enum {
+    MOTION_ISA_SCALAR = 0,
+    MOTION_ISA_SSE2,
+    MOTION_ISA_AVX2,
+    MOTION_ISA_NEON,
+    MOTION_ISA_COUNT
+} motion_isa_t;
+
+/**
+ * Per-cell motion statistics over a sampled (every other row and column) region
+ */
+typedef struct {
+    int samples;        // Pixels sampled
+    int changed;        // Sampled pixels whose difference exceeded the threshold
+    int total_diff;     // Sum of the differences of the changed pixels
+} motion_cell_stats_t;
+
+typedef struct {
+    motion_isa_t isa;
+    const char *name;
+
+    /**
+     * Convert packed RGB24 to 8-bit luma using (76 R + 150 G + 29 B) >> 8
+     */
+    void (*rgb_to_gray)(const uint8_t *rgb, int rgb_stride, uint8_t *gray, int gray_stride,
+                        int width, int height);
+
+    /**
+     * Average factor x factor blocks; blocks at the right and bottom edges are
+     * clipped to the source and averaged over the pixels they contain
+     */
+    void (*downscale)(const uint8_t *src, int src_stride, int src_width, int src_height, int factor,
+                      uint8_t *dst, int dst_width, int dst_height);
+
+    /**
+     * Separable box blur (horizontal then vertical) with edge-clipped windows
+     *
+     * @param tmp Scratch buffer of width * height bytes
+     */
+    void (*box_blur)(const uint8_t *src, uint8_t *dst, int width, int height, int radius, uint8_t *tmp);
+
+    /**
+     * Running average: bg = ((256 - alpha) * bg + alpha * cur) >> 8
+     */
+    void (*update_background)(uint8_t *bg, const uint8_t *cur, int count, int alpha);
+
+    /**
+     * Compare curr against prev and bg over [x0, x1) x [y0, y1), sampling every
+     * other pixel in both directions; a pixel counts as changed when
+     * max(|curr - prev|, |curr - bg|) > threshold
+     */
+    void (*cell_stats)(const uint8_t *curr, const uint8_t *prev, const uint8_t *bg, int stride,
+                       int x0, int y0, int x1, int y1, int threshold, motion_cell_stats_t *stats);
+} motion_kernels_t;
+
+/**
+ * Get the fastest kernels supported by this CPU
+ *
+ * @return Kernel table (never NULL)
+ */
+const motion_kernels_t *motion_kernels_get(void);
+
+/**
+ * Get the kernels for a specific instruction set
+ *
+ * @param isa Instruction set
+ * @return Kernel table, or NULL if the build or the CPU does not support it
+ */
+const motion_kernels_t *motion_kernels_for_isa(motion_isa_t isa);
+
+#endif /* MOTION_KERNELS_H */
@@ -39,4 +39,17 @@ int apply_h264_annexb_filter(AVPacket *packet, enum AVCodecID codec_id);
  */
 int mp4_writer_write_packet(mp4_writer_t *writer, const AVPacket *in_pkt, const AVStream *input_stream);
 
+/**
+ * Mark the writer's current recording complete in the database
+ *
+ * Commits the metadata the segment recorder collected while muxing in a
+ * single update.  When no statistics are available (the segment never got
+ * its trailer) the size is read from disk and the current time is used as
+ * the end time.  Clears current_recording_id.
+ *
+ * @param writer The MP4 writer instance
+ * @param stats Statistics of the finished segment, may be NULL
+ */
+void mp4_writer_finalize_recording(mp4_writer_t *writer, const segment_stats_t *stats);
+
 #endif /* MP4_WRITER_INTERNAL_H */
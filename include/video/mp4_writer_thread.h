@@ -14,7 +14,9 @@
 #include <pthread.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdatomic.h>
+#include <time.h>
 #include "core/config.h"
 
 // Forward declaration
@@ -23,6 +25,25 @@ typedef struct mp4_writer mp4_writer_t;
 // Forward declaration for AVFormatContext
 struct AVFormatContext;
 
+// Forward declaration for the shared ingest subscriber
+struct packet_bus_subscriber;
+
+/**
+ * Recording metadata collected by the muxer while writing a segment
+ */
+typedef struct {
+    bool valid;               // Set once the segment's trailer has been written
+    time_t start_time;        // Wall clock time of the first keyframe
+    int64_t duration_us;      // Span of the written video packets in microseconds
+    uint64_t size_bytes;      // Final size of the MP4 file
+    int video_packets;        // Number of video packets written
+    int keyframes;            // Number of video keyframes written
+    int width;
+    int height;
+    int fps;
+    char codec[16];
+} segment_stats_t;
+
 /**
  * Structure to track segment information per stream
  */
@@ -30,6 +51,8 @@ typedef struct {
     int segment_index;
     bool has_audio;
     bool last_frame_was_key;  // Flag to indicate if the last frame of previous segment was a key frame
+    struct packet_bus_subscriber *bus_sub;  // Shared ingest subscription, NULL when reading the camera directly
+    segment_stats_t stats;    // Metadata of the last segment written by record_segment
 } segment_info_t;
 
 /**
@@ -0,0 +1,57 @@
+#ifndef ONVIF_DISCOVERY_SCAN_H
+#define ONVIF_DISCOVERY_SCAN_H
+
+#include <stdint.h>
+#include "video/onvif_discovery.h"
+
+// Largest number of host addresses scanned in one pass (a /16)
+#define ONVIF_SCAN_MAX_HOSTS 65534
+
+// Connects and WS-Discovery probes kept in flight by default and at most
+#define ONVIF_SCAN_DEFAULT_CONCURRENCY 256
+#define ONVIF_SCAN_MAX_CONCURRENCY 1024
+
+// Time a single connect attempt may take
+#define ONVIF_SCAN_CONNECT_TIMEOUT_MS 300
+
+// Time to keep listening for WS-Discovery replies after the last connect finished
+#define ONVIF_SCAN_REPLY_WAIT_MS 1000
+
+/**
+ * Result of a subnet scan
+ */
+typedef struct {
+    char (*candidate_ips)[16];  // Hosts with an open ONVIF or HTTP port, free with onvif_scan_result_free()
+    int candidate_count;
+    int device_count;           // Devices that answered a WS-Discovery probe
+} onvif_scan_result_t;
+
+/**
+ * Scan a subnet for ONVIF devices
+ *
+ * Every host gets a non-blocking connect to ports 80 and 3702 and a unicast
+ * WS-Discovery probe, all multiplexed over one epoll instance with at most
+ * concurrency connects in flight.  The probes (plus one to the multicast
+ * group and the subnet broadcast address) are sent from a single UDP socket
+ * that collects the ProbeMatch replies while the scan runs.
+ *
+ * @param network_addr Network address in host byte order
+ * @param broadcast Broadcast address in host byte order
+ * @param concurrency Connects in flight, clamped to 1..ONVIF_SCAN_MAX_CONCURRENCY
+ * @param devices Array to fill with devices that answered WS-Discovery
+ * @param max_devices Size of the devices array
+ * @param result Receives the devices found and the candidate hosts
+ * @return 0 on success, -1 on error
+ */
+int onvif_scan_network(uint32_t network_addr, uint32_t broadcast, int concurrency,
+                       onvif_device_info_t *devices, int max_devices,
+                       onvif_scan_result_t *result);
+
+/**
+ * Free the candidate list of a scan result
+ *
+ * @param result Scan result
+ */
+void onvif_scan_result_free(onvif_scan_result_t *result);
+
+#endif /* ONVIF_DISCOVERY_SCAN_H */
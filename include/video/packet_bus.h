@@ -0,0 +1,136 @@
+/**
+ * Shared RTSP ingest packet bus
+ *
+ * Each camera URL is opened once by a dedicated demux thread which fans the
+ * demuxed packets out to any number of in-process consumers (HLS writer,
+ * MP4 segment recorder, detection).  Packets are handed out as new references
+ * to the same reference-counted buffers, so adding a consumer costs a queue
+ * slot rather than a camera session, a network stream and a demux pass.
+ *
+ * The bus for a URL is created on the first subscribe and torn down when the
+ * last subscriber goes away.
+ */
+
+#ifndef PACKET_BUS_H
+#define PACKET_BUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <libavformat/avformat.h>
+#include "core/config.h"
+
+// Maximum number of consumers attached to one ingest
+#define PACKET_BUS_MAX_SUBSCRIBERS 8
+
+// Default number of packets queued per subscriber before it is resynced
+#define PACKET_BUS_DEFAULT_QUEUE_SIZE 512
+
+// Returned by packet_bus_read() when the ingest reconnected and the stream
+// layout may have changed; the consumer must call packet_bus_copy_streams() again
+#define PACKET_BUS_ERR_RESET AVERROR(ECONNRESET)
+
+// Subscriber flags
+#define PACKET_BUS_SUB_VIDEO_ONLY     0x01  // Drop audio and other non-video packets
+#define PACKET_BUS_SUB_KEYFRAMES_ONLY 0x02  // Only deliver video keyframes (implies VIDEO_ONLY)
+
+typedef struct packet_bus_subscriber packet_bus_subscriber_t;
+
+/**
+ * Per-subscriber statistics
+ */
+typedef struct {
+    uint64_t packets_delivered;
+    uint64_t packets_dropped;   // Packets discarded because the consumer fell behind
+    int queued;                 // Packets currently waiting in the queue
+    int queue_size;
+} packet_bus_subscriber_stats_t;
+
+/**
+ * Initialize the packet bus system
+ */
+void init_packet_bus_system(void);
+
+/**
+ * Stop all ingest threads and wait for them to exit
+ */
+void shutdown_packet_bus_system(void);
+
+/**
+ * Check whether shared ingest is enabled in the configuration
+ *
+ * @return true if consumers should read from the packet bus
+ */
+bool packet_bus_is_enabled(void);
+
+/**
+ * Subscribe to the shared ingest of a URL, starting the demux thread if needed
+ *
+ * @param stream_name Stream name (used for logging)
+ * @param url Input URL; consumers using the same URL share one session
+ * @param protocol STREAM_PROTOCOL_TCP or STREAM_PROTOCOL_UDP (used if the ingest is created)
+ * @param consumer_name Short consumer label such as "hls" or "mp4"
+ * @param flags PACKET_BUS_SUB_* flags
+ * @param queue_size Maximum packets queued, or 0 for PACKET_BUS_DEFAULT_QUEUE_SIZE
+ * @return Subscriber handle, or NULL on error
+ */
+packet_bus_subscriber_t *packet_bus_subscribe(const char *stream_name, const char *url, int protocol,
+                                              const char *consumer_name, int flags, int queue_size);
+
+/**
+ * Detach a subscriber; the ingest stops when its last subscriber is gone
+ *
+ * @param sub Subscriber handle (may be NULL)
+ */
+void packet_bus_unsubscribe(packet_bus_subscriber_t *sub);
+
+/**
+ * Build a stand-alone format context describing the ingest streams
+ *
+ * The returned context carries a copy of every stream's codec parameters,
+ * time base and frame rate so that consumer code written against an input
+ * AVFormatContext keeps working.  It has no demuxer attached; free it with
+ * avformat_close_input().  Stream indices match pkt->stream_index of packets
+ * returned by packet_bus_read().
+ *
+ * @param sub Subscriber handle
+ * @param ctx Receives the new context
+ * @param timeout_ms How long to wait for the ingest to connect
+ * @return 0 on success, AVERROR(EAGAIN) on timeout, other negative on error
+ */
+int packet_bus_copy_streams(packet_bus_subscriber_t *sub, AVFormatContext **ctx, int timeout_ms);
+
+/**
+ * Read the next packet for this subscriber
+ *
+ * @param sub Subscriber handle
+ * @param pkt Packet receiving a new reference to the shared data
+ * @param timeout_ms Maximum time to wait for a packet
+ * @return 0 on success, AVERROR(EAGAIN) on timeout, PACKET_BUS_ERR_RESET after
+ *         an ingest reconnect, AVERROR_EOF if the ingest was stopped
+ */
+int packet_bus_read(packet_bus_subscriber_t *sub, AVPacket *pkt, int timeout_ms);
+
+/**
+ * Discard everything queued for a subscriber
+ *
+ * @param sub Subscriber handle
+ */
+void packet_bus_flush(packet_bus_subscriber_t *sub);
+
+/**
+ * Get subscriber statistics
+ *
+ * @param sub Subscriber handle
+ * @param stats Receives the statistics
+ * @return 0 on success, -1 on error
+ */
+int packet_bus_get_subscriber_stats(packet_bus_subscriber_t *sub, packet_bus_subscriber_stats_t *stats);
+
+/**
+ * Get the number of active ingest threads
+ *
+ * @return Number of URLs currently being demuxed by the packet bus
+ */
+int packet_bus_active_ingest_count(void);
+
+#endif /* PACKET_BUS_H */
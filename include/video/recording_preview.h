@@ -0,0 +1,96 @@
+/**
+ * Timeline previews for MP4 recordings
+ *
+ * While a segment is recorded, a keyframe is decoded every few seconds
+ * and scaled down to a small thumbnail.  When the segment is closed the
+ * thumbnails are tiled into one JPEG sprite sheet and the keyframe byte
+ * offsets of the finished file are written to a small JSON index next to
+ * the recording:
+ *
+ *   recording_20240101_120000.mp4
+ *   recording_20240101_120000.preview.json
+ *   recording_20240101_120000.sprite.jpg
+ *
+ * The timeline can then show what happened in a segment and seek to a
+ * keyframe with a couple of small fetches instead of reading the MP4.
+ */
+
+#ifndef RECORDING_PREVIEW_H
+#define RECORDING_PREVIEW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <libavcodec/avcodec.h>
+
+// Thumbnail width in the sprite sheet, the height follows the aspect ratio
+#define RECORDING_PREVIEW_TILE_WIDTH 160
+
+// Thumbnails per sprite sheet row
+#define RECORDING_PREVIEW_COLUMNS 10
+
+// Thumbnails kept per segment, the sampling interval doubles when a long segment exceeds it
+#define RECORDING_PREVIEW_MAX_TILES 120
+
+// JPEG quality of the sprite sheet
+#define RECORDING_PREVIEW_JPEG_QUALITY 60
+
+typedef struct recording_preview recording_preview_t;
+
+/**
+ * Start collecting previews for a new segment
+ *
+ * @param codecpar Parameters of the recorded video stream
+ * @param time_base Time base of the packets passed to recording_preview_add_keyframe()
+ * @param interval Seconds between sampled thumbnails, 0 to only write the keyframe index
+ * @return Preview context, or NULL if previews cannot be generated for this stream
+ */
+recording_preview_t *recording_preview_begin(const AVCodecParameters *codecpar, AVRational time_base,
+                                             int interval);
+
+/**
+ * Offer a keyframe of the segment, called before the packet is written
+ *
+ * Keyframes closer than the sampling interval to the previous thumbnail
+ * are ignored without decoding.
+ *
+ * @param preview Preview context
+ * @param pkt Keyframe packet, not modified
+ * @param pts Presentation timestamp of the packet as written to the segment
+ */
+void recording_preview_add_keyframe(recording_preview_t *preview, const AVPacket *pkt, int64_t pts);
+
+/**
+ * Write the keyframe index and sprite sheet of a closed segment and free the context
+ *
+ * @param preview Preview context
+ * @param recording_path Path of the finished MP4 file
+ * @return 0 on success, -1 on error
+ */
+int recording_preview_finish(recording_preview_t *preview, const char *recording_path);
+
+/**
+ * Free a preview context without writing anything
+ *
+ * @param preview Preview context, may be NULL
+ */
+void recording_preview_free(recording_preview_t *preview);
+
+/**
+ * Build the path of a preview file of a recording
+ *
+ * @param recording_path Path of the MP4 file
+ * @param suffix Preview file suffix, ".preview.json" or ".sprite.jpg"
+ * @param path Receives the preview path
+ * @param path_size Size of the path buffer
+ * @return 0 on success, -1 if the path does not fit
+ */
+int recording_preview_path(const char *recording_path, const char *suffix, char *path, size_t path_size);
+
+/**
+ * Delete the preview files of a recording
+ *
+ * @param recording_path Path of the MP4 file
+ */
+void recording_preview_remove(const char *recording_path);
+
+#endif /* RECORDING_PREVIEW_H */
@@ -0,0 +1,22 @@
+#ifndef LIGHTNVR_SEGMENT_REMUX_H
+#define LIGHTNVR_SEGMENT_REMUX_H
+
+/**
+ * Join a list of MPEG-TS segments into one MP4 without re-encoding
+ *
+ * Packets are read with libavformat and written straight into the MP4
+ * muxer.  Each segment's timestamps are shifted to continue where the
+ * previous segment ended, so discontinuities between segments do not leave
+ * gaps or overlaps, and the output starts at zero.  Segments whose codecs
+ * do not match the first one are skipped.
+ *
+ * @param segment_paths Segment files, oldest first
+ * @param count Number of segments
+ * @param output_path MP4 file to create (overwritten if it exists)
+ * @param duration Receives the duration of the output in seconds (may be NULL)
+ * @return Number of segments written, or -1 on error
+ */
+int remux_segments_to_mp4(const char *const *segment_paths, int count,
+                          const char *output_path, double *duration);
+
+#endif /* LIGHTNVR_SEGMENT_REMUX_H */
@@ -40,6 +40,18 @@ detection_model_t load_sod_model(const char *model_path, float threshold);
 int detect_with_sod_model(detection_model_t model, const unsigned char *frame_data,
                          int width, int height, int channels, detection_result_t *result);
 
+/**
+ * Get the input size of a SOD CNN model
+ *
+ * Frames of exactly this size skip SOD's internal resize.
+ *
+ * @param model SOD model handle
+ * @param width Receives the network input width
+ * @param height Receives the network input height
+ * @return 0 on success, -1 if the size is not known
+ */
+int get_sod_model_input_size(detection_model_t model, int *width, int *height);
+
 /**
  * Check if SOD is available
  *
@@ -7,7 +7,8 @@
  * Filter detections based on configured zones for a stream
  * 
  * This function:
- * 1. Loads zones for the stream from the database
+ * 1. Looks up the stream's compiled zones, loading them from the database
+ *    only on the first call or after zone_filter_invalidate()
  * 2. Filters detections to only include those within enabled zones
  * 3. Applies per-zone class filters and confidence thresholds
  * 4. Sets the zone_id field for each accepted detection
@@ -20,5 +21,14 @@
  */
 int filter_detections_by_zones(const char *stream_name, detection_result_t *result);
 
+/**
+ * Drop the cached zones of a stream so the next filter reloads them
+ *
+ * Must be called whenever a stream's zones change in the database.
+ *
+ * @param stream_name The name of the stream, or NULL for all streams
+ */
+void zone_filter_invalidate(const char *stream_name);
+
 #endif /* LIGHTNVR_ZONE_FILTER_H */
 
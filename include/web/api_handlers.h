@@ -412,4 +412,18 @@ void cleanup_health_check_system(void);
 int log_level_meets_minimum(const char *log_level, const char *min_level);
 int get_json_logs_tail(const char *min_level, const char *last_timestamp, char ***logs, int *count);
 
+/**
+ * @brief Add the last lines of the log file to a JSON array
+ *
+ * The file is read while no log output is written, so the returned cursor
+ * can be used to poll the in-memory recent-log index without gaps or repeats.
+ *
+ * @param min_level Minimum log level to include
+ * @param max_lines Maximum number of lines
+ * @param logs_array Array to add {timestamp, level, message} objects to, oldest first
+ * @param cursor Recent-log cursor of the newest line in the file
+ * @return Number of entries added, -1 on error
+ */
+int add_log_file_tail_to_json(const char *min_level, int max_lines, cJSON *logs_array, uint64_t *cursor);
+
 #endif /* API_HANDLERS_H */
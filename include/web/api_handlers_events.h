@@ -0,0 +1,34 @@
+/**
+ * @file api_handlers_events.h
+ * @brief Server-sent event stream of live detections, motion and recording state
+ */
+
+#ifndef API_HANDLERS_EVENTS_H
+#define API_HANDLERS_EVENTS_H
+
+#include "mongoose.h"
+
+/**
+ * @brief Handler for GET /api/events
+ * Open a text/event-stream subscription.  The optional streams query
+ * parameter is a comma separated list of stream names to receive events
+ * for, all streams are sent without it.
+ */
+void mg_handle_get_live_events(struct mg_connection *c, struct mg_http_message *hm);
+
+/**
+ * @brief Send pending events to a subscribed connection, called for every
+ * connection on MG_EV_POLL
+ *
+ * @param c Connection
+ */
+void mg_live_events_poll(struct mg_connection *c);
+
+/**
+ * @brief Free the subscription of a closing connection
+ *
+ * @param c Connection
+ */
+void mg_live_events_release(struct mg_connection *c);
+
+#endif /* API_HANDLERS_EVENTS_H */
@@ -3,6 +3,9 @@
 
 #include "web/web_server.h"
 
+struct mg_connection;
+struct mg_http_message;
+
 /**
  * Handle streaming request (HLS, WebRTC)
  */
@@ -38,4 +41,35 @@ void handle_stream_toggle(const http_request_t *request, http_response_t *respon
  */
 void register_streaming_api_handlers(void);
 
+/**
+ * Serve a live HLS file from the in-memory segment store
+ *
+ * Answers conditional requests (If-None-Match) with 304 and holds playlist
+ * requests carrying _HLS_msn until that media sequence number is available.
+ *
+ * @param c Connection
+ * @param hm HTTP message
+ * @param stream_name Decoded stream name
+ * @param file_name Requested playlist or segment
+ * @return true if the request was answered or parked, false if the store does
+ *         not hold the file and it should be served from disk
+ */
+bool mg_serve_hls_from_memory(struct mg_connection *c, struct mg_http_message *hm,
+                              const char *stream_name, const char *file_name);
+
+/**
+ * Answer a parked blocking playlist request once it can be satisfied or
+ * has timed out, called for every connection on MG_EV_POLL
+ *
+ * @param c Connection
+ */
+void mg_hls_poll_blocked_request(struct mg_connection *c);
+
+/**
+ * Free the parked blocking playlist request of a closing connection
+ *
+ * @param c Connection
+ */
+void mg_hls_release_blocked_request(struct mg_connection *c);
+
 #endif /* API_HANDLERS_STREAMING_H */
@@ -15,6 +15,7 @@ typedef struct {
     time_t end_time;
     uint64_t size_bytes;
     bool has_detection;
+    bool has_preview;       // Keyframe index and sprite sheet were written for the segment
 } timeline_segment_t;
 
 /**
@@ -40,4 +40,32 @@ int mongoose_server_mg_to_request(struct mg_connection *conn, struct mg_http_mes
  */
 int mongoose_server_send_response(struct mg_connection *conn, const http_response_t *response);
 
+/**
+ * @brief Park a handler-owned pointer on a connection
+ *
+ * The pointer is kept in the connection's data area together with a tag
+ * naming its owner, so poll and close events can find it again.
+ *
+ * @param conn Mongoose connection
+ * @param tag Owner tag (non-zero)
+ * @param ptr Pointer to keep
+ */
+void mongoose_server_attach_data(struct mg_connection *conn, char tag, void *ptr);
+
+/**
+ * @brief Get the pointer parked on a connection
+ *
+ * @param conn Mongoose connection
+ * @param tag Owner tag passed to mongoose_server_attach_data
+ * @return void* The pointer, or NULL if none is parked under this tag
+ */
+void *mongoose_server_get_data(struct mg_connection *conn, char tag);
+
+/**
+ * @brief Forget the pointer parked on a connection (the caller frees it)
+ *
+ * @param conn Mongoose connection
+ */
+void mongoose_server_detach_data(struct mg_connection *conn);
+
 #endif /* MONGOOSE_SERVER_H */
@@ -6,6 +6,7 @@
 #ifndef MONGOOSE_SERVER_MULTITHREADING_H
 #define MONGOOSE_SERVER_MULTITHREADING_H
 
+#include <stdbool.h>
 #include "mongoose.h"
 
 /**
@@ -19,8 +20,79 @@ struct mg_thread_data {
 };
 
 /**
- * @brief Start a thread
- * 
+ * @brief Priority of work queued on the worker pool
+ *
+ * When the queue fills up, low priority work is turned away first so that
+ * interactive requests (auth, health, live view) keep being served.
+ */
+typedef enum {
+  MG_WORK_PRIORITY_NORMAL = 0,
+  MG_WORK_PRIORITY_HIGH,
+  MG_WORK_PRIORITY_LOW,
+  MG_WORK_PRIORITY_COUNT
+} mg_work_priority_t;
+
+/**
+ * @brief Worker pool metrics
+ */
+typedef struct {
+  int threads;                   // Worker threads
+  int active;                    // Workers currently running a request
+  int queued;                    // Requests waiting for a worker
+  int queued_by_priority[MG_WORK_PRIORITY_COUNT];
+  int capacity;                  // Maximum queued requests
+  int peak_queued;               // Highest queue depth seen
+  unsigned long long completed;  // Requests run to completion
+  unsigned long long rejected;   // Requests answered with 503
+  double avg_wait_ms;            // Mean time spent queued
+  double max_wait_ms;            // Longest time spent queued
+  double avg_run_ms;             // Mean time spent running
+} mg_worker_pool_stats_t;
+
+/**
+ * @brief Start the fixed-size worker pool used for threaded requests
+ *
+ * @param threads Number of worker threads, or 0 for a default based on the CPU count
+ * @param queue_capacity Maximum number of queued requests, or 0 for the default
+ * @return 0 on success, -1 on error
+ */
+int mg_worker_pool_init(int threads, int queue_capacity);
+
+/**
+ * @brief Stop the worker pool
+ *
+ * Requests still queued are answered with 503, running requests are waited
+ * for up to a few seconds.
+ */
+void mg_worker_pool_shutdown(void);
+
+/**
+ * @brief Queue a threaded request on the worker pool
+ *
+ * On success the pool owns data and frees it after the handler ran.
+ * Without a running pool the request gets its own detached thread.
+ *
+ * @param data Thread data for mg_thread_function
+ * @param priority Priority of the request
+ * @return true if queued, false if the pool is saturated (data is not freed)
+ */
+bool mg_queue_request(struct mg_thread_data *data, mg_work_priority_t priority);
+
+/**
+ * @brief Get the worker pool metrics
+ *
+ * @param stats Structure to fill
+ */
+void mg_worker_pool_get_stats(mg_worker_pool_stats_t *stats);
+
+/**
+ * @brief Run a function on its own detached thread
+ *
+ * For handlers that reply before handing off work, or whose work can run
+ * for a long time (discovery, deletes), so it is never rejected with 503
+ * and does not hold a worker pool thread.  Ordinary requests go through
+ * mg_queue_request instead.
+ *
  * @param f Thread function
  * @param p Thread data
  */
@@ -28,6 +28,7 @@ void load_default_config(config_t *config) {
     snprintf(config->pid_file, MAX_PATH_LENGTH, "/var/run/lightnvr.pid");
     snprintf(config->log_file, MAX_PATH_LENGTH, "/var/log/lightnvr.log");
     config->log_level = LOG_LEVEL_INFO;
+    config->log_async = true;
 
     // Syslog settings
     config->syslog_enabled = false;
@@ -37,6 +38,7 @@ void load_default_config(config_t *config) {
     // Storage settings
     snprintf(config->storage_path, MAX_PATH_LENGTH, "/var/lib/lightnvr/recordings");
     config->storage_path_hls[0] = '\0'; // Empty by default, will use storage_path if not specified
+    config->hls_memory_enabled = false;
     config->max_storage_size = 0; // 0 means unlimited
     config->retention_days = 30;
     config->auto_delete_oldest = true;
@@ -46,6 +48,7 @@ void load_default_config(config_t *config) {
     snprintf(config->mp4_storage_path, sizeof(config->mp4_storage_path), "/var/lib/lightnvr/recordings/mp4");
     config->mp4_segment_duration = 900; // 15 minutes
     config->mp4_retention_days = 30;
+    config->mp4_preview_interval = 10;
 
     // Models settings
     snprintf(config->models_path, MAX_PATH_LENGTH, "/var/lib/lightnvr/models");
@@ -75,8 +78,12 @@ void load_default_config(config_t *config) {
     config->web_cache_max_age_fonts = 2592000;    // 30 days for fonts
     config->web_cache_max_age_default = 86400;    // 1 day default
     
+    // ONVIF settings
+    config->onvif_discovery_concurrency = 256;
+
     // Stream settings
     config->max_streams = 16;
+    config->shared_ingest_enabled = false;
     
     // Memory optimization
     config->buffer_size = 1024; // 1MB buffer size
@@ -282,6 +289,8 @@ static int config_ini_handler(void* user, const char* section, const char* name,
             strncpy(config->log_file, value, MAX_PATH_LENGTH - 1);
         } else if (strcmp(name, "log_level") == 0) {
             config->log_level = atoi(value);
+        } else if (strcmp(name, "log_async") == 0) {
+            config->log_async = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
         } else if (strcmp(name, "syslog_enabled") == 0) {
             config->syslog_enabled = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
         } else if (strcmp(name, "syslog_ident") == 0) {
@@ -312,6 +321,8 @@ static int config_ini_handler(void* user, const char* section, const char* name,
             strncpy(config->storage_path, value, MAX_PATH_LENGTH - 1);
         } else if (strcmp(name, "path_hls") == 0) {
             strncpy(config->storage_path_hls, value, MAX_PATH_LENGTH - 1);
+        } else if (strcmp(name, "hls_in_memory") == 0) {
+            config->hls_memory_enabled = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
         } else if (strcmp(name, "max_size") == 0) {
             config->max_storage_size = strtoull(value, NULL, 10);
         } else if (strcmp(name, "retention_days") == 0) {
@@ -327,6 +338,8 @@ static int config_ini_handler(void* user, const char* section, const char* name,
             config->mp4_segment_duration = atoi(value);
         } else if (strcmp(name, "mp4_retention_days") == 0) {
             config->mp4_retention_days = atoi(value);
+        } else if (strcmp(name, "mp4_preview_interval") == 0) {
+            config->mp4_preview_interval = atoi(value);
         }
     }
     // Models settings
@@ -370,6 +383,8 @@ static int config_ini_handler(void* user, const char* section, const char* name,
     else if (strcmp(section, "streams") == 0) {
         if (strcmp(name, "max_streams") == 0) {
             config->max_streams = atoi(value);
+        } else if (strcmp(name, "shared_ingest") == 0) {
+            config->shared_ingest_enabled = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
         }
     }
     // Stream-specific settings (format: stream_name.setting)
@@ -431,6 +446,12 @@ static int config_ini_handler(void* user, const char* section, const char* name,
             strncpy(config->hw_accel_device, value, 31);
         }
     }
+    // ONVIF discovery
+    else if (strcmp(section, "onvif") == 0) {
+        if (strcmp(name, "discovery_concurrency") == 0) {
+            config->onvif_discovery_concurrency = atoi(value);
+        }
+    }
     // go2rtc settings
     else if (strcmp(section, "go2rtc") == 0) {
         if (strcmp(name, "binary_path") == 0) {
@@ -890,6 +911,7 @@ int save_config(const config_t *config, const char *path) {
     fprintf(file, "pid_file = %s\n", config->pid_file);
     fprintf(file, "log_file = %s\n", config->log_file);
     fprintf(file, "log_level = %d  ; 0=ERROR, 1=WARN, 2=INFO, 3=DEBUG\n", config->log_level);
+    fprintf(file, "log_async = %s  ; Write logs from a background thread\n", config->log_async ? "true" : "false");
     fprintf(file, "syslog_enabled = %s\n", config->syslog_enabled ? "true" : "false");
     fprintf(file, "syslog_ident = %s\n", config->syslog_ident);
 
@@ -917,6 +939,8 @@ int save_config(const config_t *config, const char *path) {
     if (config->storage_path_hls[0] != '\0') {
         fprintf(file, "path_hls = %s  ; Dedicated path for HLS segments\n", config->storage_path_hls);
     }
+    fprintf(file, "hls_in_memory = %s  ; Serve live HLS from RAM instead of writing segments to disk\n",
+            config->hls_memory_enabled ? "true" : "false");
     
     fprintf(file, "max_size = %llu  ; 0 means unlimited, otherwise bytes\n", (unsigned long long)config->max_storage_size);
     fprintf(file, "retention_days = %d\n", config->retention_days);
@@ -929,7 +953,9 @@ int save_config(const config_t *config, const char *path) {
         fprintf(file, "mp4_path = %s\n", config->mp4_storage_path);
     }
     fprintf(file, "mp4_segment_duration = %d\n", config->mp4_segment_duration);
-    fprintf(file, "mp4_retention_days = %d\n\n", config->mp4_retention_days);
+    fprintf(file, "mp4_retention_days = %d\n", config->mp4_retention_days);
+    fprintf(file, "mp4_preview_interval = %d  ; Seconds between timeline thumbnails, 0 disables them\n\n",
+            config->mp4_preview_interval);
 
     // Write models settings
     fprintf(file, "[models]\n");
@@ -956,7 +982,9 @@ int save_config(const config_t *config, const char *path) {
     
     // Write stream settings
     fprintf(file, "[streams]\n");
-    fprintf(file, "max_streams = %d\n\n", config->max_streams);
+    fprintf(file, "max_streams = %d\n", config->max_streams);
+    fprintf(file, "shared_ingest = %s  ; One camera connection shared by HLS, MP4 and detection\n\n",
+            config->shared_ingest_enabled ? "true" : "false");
     
     // Write memory optimization settings
     fprintf(file, "[memory]\n");
@@ -970,6 +998,11 @@ int save_config(const config_t *config, const char *path) {
     fprintf(file, "hw_accel_enabled = %s\n", config->hw_accel_enabled ? "true" : "false");
     fprintf(file, "hw_accel_device = %s\n\n", config->hw_accel_device);
     
+    // Write ONVIF discovery settings
+    fprintf(file, "[onvif]\n");
+    fprintf(file, "discovery_concurrency = %d  ; Connects and probes in flight while scanning\n\n",
+            config->onvif_discovery_concurrency);
+    
     // Write go2rtc settings
     fprintf(file, "[go2rtc]\n");
     fprintf(file, "binary_path = %s\n", config->go2rtc_binary_path);
@@ -2,8 +2,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
 #include <time.h>
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -40,6 +44,69 @@ static const char *log_level_strings[] = {
     "DEBUG"
 };
 
+// Asynchronous logging: queued messages (power of two) and their maximum length
+#define ASYNC_LOG_QUEUE_SIZE 512
+#define ASYNC_LOG_QUEUE_MASK (ASYNC_LOG_QUEUE_SIZE - 1)
+#define ASYNC_LOG_MESSAGE_SIZE 4096
+
+// Wake the writer early once the queue is this full
+#define ASYNC_LOG_HIGH_WATER (ASYNC_LOG_QUEUE_SIZE / 4)
+
+// Time between flushes when the queue is quiet
+#define ASYNC_LOG_FLUSH_MS 100
+
+typedef struct {
+    atomic_size_t sequence;
+    log_level_t level;
+    time_t time;
+    char message[ASYNC_LOG_MESSAGE_SIZE];
+} async_log_slot_t;
+
+// Same bounded multi-producer ring as the detection writer: producers claim a
+// slot with a compare-and-swap and publish it by bumping its sequence number
+static struct {
+    async_log_slot_t slots[ASYNC_LOG_QUEUE_SIZE];
+    atomic_size_t enqueue_pos;
+    atomic_size_t dequeue_pos;      // Only advanced by the writer thread
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    atomic_bool running;
+    atomic_int producers;           // Callers between the running check and publishing
+
+    atomic_uint_fast64_t written;
+    atomic_uint_fast64_t dropped;
+} async_log = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+// Formatted timestamps of the last second seen by this thread
+typedef struct {
+    time_t second;
+    char text[32];
+    char iso[32];
+} log_time_cache_t;
+
+static __thread log_time_cache_t time_cache = { .second = (time_t)-1 };
+
+/**
+ * Get the text and ISO timestamps for a time, reformatting at most once per second
+ */
+static void format_log_time(time_t now, const char **text, const char **iso) {
+    if (now != time_cache.second) {
+        struct tm tm_info;
+        localtime_r(&now, &tm_info);
+        strftime(time_cache.text, sizeof(time_cache.text), "%Y-%m-%d %H:%M:%S", &tm_info);
+        strftime(time_cache.iso, sizeof(time_cache.iso), "%Y-%m-%dT%H:%M:%S", &tm_info);
+        time_cache.second = now;
+    }
+
+    *text = time_cache.text;
+    *iso = time_cache.iso;
+}
+
 // Initialize the logging system
 int init_logger(void) {
     // Initialize mutex
@@ -66,6 +133,9 @@ int init_logger(void) {
 
 // Shutdown the logging system
 void shutdown_logger(void) {
+    // Write out anything still queued while the sinks are open
+    stop_async_logger();
+
     pthread_mutex_lock(&logger.mutex);
 
     if (logger.log_file != NULL && logger.log_file != stdout && logger.log_file != stderr) {
@@ -279,46 +349,27 @@ const char *sanitize_for_logging(const char *str, size_t max_len) {
     return sanitized;
 }
 
-// Log a message at the specified level with va_list
-void log_message_v(log_level_t level, const char *format, va_list args) {
-    // Only log messages at or below the configured log level
-    // For example, if log_level is INFO (2), we log ERROR (0), WARN (1), and INFO (2), but not DEBUG (3)
-    if (level > logger.log_level) {
-        return;
+/**
+ * Write one entry to the text log, the console and syslog
+ *
+ * Must be called with the logger mutex held.
+ */
+static void write_log_entry_locked(log_level_t level, time_t time, const char *timestamp, const char *message) {
+    // Feed the in-memory index used by the log viewer if it is linked in
+    extern __attribute__((weak)) void append_recent_log(log_level_t level, time_t time, const char *message);
+    if (append_recent_log) {
+        append_recent_log(level, time, message);
     }
 
-    time_t now;
-    struct tm *tm_info;
-    char timestamp[32];
-    char iso_timestamp[32];
-
-    // Get current time
-    time(&now);
-    tm_info = localtime(&now);
-
-    // Format timestamp for text log
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
-
-    // Format ISO timestamp for JSON log
-    strftime(iso_timestamp, sizeof(iso_timestamp), "%Y-%m-%dT%H:%M:%S", tm_info);
-
-    // Format the log message
-    char message[4096];
-    vsnprintf(message, sizeof(message), format, args);
-
-    pthread_mutex_lock(&logger.mutex);
-
     // Write to log file if available
     if (logger.log_file && logger.log_file != stdout && logger.log_file != stderr) {
         fprintf(logger.log_file, "[%s] [%s] %s\n", timestamp, log_level_strings[level], message);
-        fflush(logger.log_file);
     }
 
     // Always write to console (tee behavior)
     // Use stderr for errors, stdout for other levels
     FILE *console = (level == LOG_LEVEL_ERROR) ? stderr : stdout;
     fprintf(console, "[%s] [%s] %s\n", timestamp, log_level_strings[level], message);
-    fflush(console);
 
     // Write to syslog if enabled
     if (logger.syslog_enabled) {
@@ -343,9 +394,259 @@ void log_message_v(log_level_t level, const char *format, va_list args) {
         }
         syslog(syslog_priority, "%s", message);
     }
+}
+
+/**
+ * Flush the text log and the console
+ *
+ * Must be called with the logger mutex held.
+ */
+static void flush_log_sinks_locked(void) {
+    if (logger.log_file && logger.log_file != stdout && logger.log_file != stderr) {
+        fflush(logger.log_file);
+    }
+    fflush(stdout);
+    fflush(stderr);
+}
+
+/**
+ * Queue a message for the writer thread, formatting it in the slot
+ *
+ * @return 0 if queued, -1 if the queue is full (args is left untouched)
+ */
+static int queue_log_message(log_level_t level, time_t now, const char *format, va_list args) {
+    async_log_slot_t *slot;
+    size_t pos = atomic_load_explicit(&async_log.enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        slot = &async_log.slots[pos & ASYNC_LOG_QUEUE_MASK];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&async_log.enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&async_log.enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    slot->time = now;
+    vsnprintf(slot->message, sizeof(slot->message), format, args);
+
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+    // Errors are written promptly, everything else waits for the batch
+    size_t depth = pos + 1 - atomic_load_explicit(&async_log.dequeue_pos, memory_order_relaxed);
+    if (level == LOG_LEVEL_ERROR || depth == ASYNC_LOG_HIGH_WATER) {
+        pthread_mutex_lock(&async_log.mutex);
+        pthread_cond_signal(&async_log.cond);
+        pthread_mutex_unlock(&async_log.mutex);
+    }
+
+    return 0;
+}
+
+/**
+ * Write every published message, flushing each sink once
+ *
+ * @return Number of messages written
+ */
+static int drain_log_queue(void) {
+    extern __attribute__((weak)) int write_json_log_buffered(log_level_t level, const char *timestamp, const char *message);
+    extern __attribute__((weak)) void flush_json_log(void);
+    static uint64_t reported_drops = 0;
+
+    size_t pos = atomic_load_explicit(&async_log.dequeue_pos, memory_order_relaxed);
+    int written = 0;
+
+    // Only this thread and rare synchronous writers (errors on overflow, rotation) take the mutex
+    pthread_mutex_lock(&logger.mutex);
+
+    // Bounded so producers cannot keep the writer inside the logger mutex
+    while (written < ASYNC_LOG_QUEUE_SIZE) {
+        async_log_slot_t *slot = &async_log.slots[pos & ASYNC_LOG_QUEUE_MASK];
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != pos + 1) {
+            break;
+        }
+
+        const char *timestamp;
+        const char *iso_timestamp;
+        format_log_time(slot->time, &timestamp, &iso_timestamp);
+
+        write_log_entry_locked(slot->level, slot->time, timestamp, slot->message);
+        if (write_json_log_buffered) {
+            write_json_log_buffered(slot->level, iso_timestamp, slot->message);
+        }
+
+        atomic_store_explicit(&slot->sequence, pos + ASYNC_LOG_QUEUE_SIZE, memory_order_release);
+        pos++;
+        atomic_store_explicit(&async_log.dequeue_pos, pos, memory_order_relaxed);
+        written++;
+    }
+
+    // Say how much was lost since the last report
+    uint64_t dropped = atomic_load_explicit(&async_log.dropped, memory_order_relaxed);
+    if (dropped != reported_drops) {
+        char message[128];
+        const char *timestamp;
+        const char *iso_timestamp;
+        snprintf(message, sizeof(message), "Logger queue full, dropped %llu messages",
+                 (unsigned long long)(dropped - reported_drops));
+        time_t now = time(NULL);
+        format_log_time(now, &timestamp, &iso_timestamp);
+
+        write_log_entry_locked(LOG_LEVEL_WARN, now, timestamp, message);
+        if (write_json_log_buffered) {
+            write_json_log_buffered(LOG_LEVEL_WARN, iso_timestamp, message);
+        }
+        reported_drops = dropped;
+        written++;
+    }
+
+    if (written > 0) {
+        flush_log_sinks_locked();
+        if (flush_json_log) {
+            flush_json_log();
+        }
+    }
 
     pthread_mutex_unlock(&logger.mutex);
 
+    if (written > 0) {
+        atomic_fetch_add_explicit(&async_log.written, written, memory_order_relaxed);
+    }
+
+    return written;
+}
+
+/**
+ * Writer thread function
+ */
+static void *async_log_thread_func(void *arg) {
+    (void)arg;
+
+    while (atomic_load_explicit(&async_log.running, memory_order_acquire)) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += (long)ASYNC_LOG_FLUSH_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&async_log.mutex);
+        if (atomic_load_explicit(&async_log.running, memory_order_acquire)) {
+            pthread_cond_timedwait(&async_log.cond, &async_log.mutex, &deadline);
+        }
+        pthread_mutex_unlock(&async_log.mutex);
+
+        while (drain_log_queue() >= ASYNC_LOG_QUEUE_SIZE) {
+        }
+    }
+
+    // New producers now write synchronously; wait for those that already
+    // passed the running check to publish, then write out whatever is left
+    while (atomic_load(&async_log.producers) > 0) {
+        sched_yield();
+    }
+    while (drain_log_queue() > 0) {
+    }
+
+    return NULL;
+}
+
+int start_async_logger(void) {
+    pthread_mutex_lock(&async_log.mutex);
+
+    if (atomic_load(&async_log.running)) {
+        pthread_mutex_unlock(&async_log.mutex);
+        return 0;
+    }
+
+    for (size_t i = 0; i < ASYNC_LOG_QUEUE_SIZE; i++) {
+        atomic_store_explicit(&async_log.slots[i].sequence, i, memory_order_relaxed);
+    }
+    atomic_store_explicit(&async_log.enqueue_pos, 0, memory_order_relaxed);
+    atomic_store_explicit(&async_log.dequeue_pos, 0, memory_order_relaxed);
+    atomic_store(&async_log.running, true);
+
+    if (pthread_create(&async_log.thread, NULL, async_log_thread_func, NULL) != 0) {
+        atomic_store(&async_log.running, false);
+        pthread_mutex_unlock(&async_log.mutex);
+        fprintf(stderr, "Failed to create logger thread: %s\n", strerror(errno));
+        return -1;
+    }
+
+    pthread_mutex_unlock(&async_log.mutex);
+    return 0;
+}
+
+void stop_async_logger(void) {
+    pthread_mutex_lock(&async_log.mutex);
+    if (!atomic_load(&async_log.running)) {
+        pthread_mutex_unlock(&async_log.mutex);
+        return;
+    }
+
+    atomic_store(&async_log.running, false);
+    pthread_cond_signal(&async_log.cond);
+    pthread_mutex_unlock(&async_log.mutex);
+
+    pthread_join(async_log.thread, NULL);
+}
+
+void get_logger_stats(uint64_t *written, uint64_t *dropped) {
+    if (written) *written = atomic_load(&async_log.written);
+    if (dropped) *dropped = atomic_load(&async_log.dropped);
+}
+
+// Log a message at the specified level with va_list
+void log_message_v(log_level_t level, const char *format, va_list args) {
+    // Only log messages at or below the configured log level
+    // For example, if log_level is INFO (2), we log ERROR (0), WARN (1), and INFO (2), but not DEBUG (3)
+    if (level > logger.log_level) {
+        return;
+    }
+
+    time_t now = time(NULL);
+
+    // Hand the message to the writer thread if it is running. Registering as a
+    // producer first lets stop_async_logger wait for us before its final drain.
+    atomic_fetch_add(&async_log.producers, 1);
+    if (atomic_load(&async_log.running)) {
+        int queued = queue_log_message(level, now, format, args);
+        atomic_fetch_sub(&async_log.producers, 1);
+        if (queued == 0) {
+            return;
+        }
+
+        // Queue full: drop everything but errors, which are written below
+        if (level != LOG_LEVEL_ERROR) {
+            atomic_fetch_add_explicit(&async_log.dropped, 1, memory_order_relaxed);
+            return;
+        }
+    } else {
+        atomic_fetch_sub(&async_log.producers, 1);
+    }
+
+    const char *timestamp;
+    const char *iso_timestamp;
+    format_log_time(now, &timestamp, &iso_timestamp);
+
+    // Format the log message
+    char message[4096];
+    vsnprintf(message, sizeof(message), format, args);
+
+    pthread_mutex_lock(&logger.mutex);
+    write_log_entry_locked(level, now, timestamp, message);
+    flush_log_sinks_locked();
+    pthread_mutex_unlock(&logger.mutex);
+
     // Write to JSON log file if the function is available
     // This is a weak symbol that can be overridden by the actual implementation
     // If the JSON logger is not linked, this will be a no-op
@@ -355,6 +656,19 @@ void log_message_v(log_level_t level, const char *format, va_list args) {
     }
 }
 
+// Run a function while no log output is being written
+int run_with_log_output_locked(int (*fn)(void *arg), void *arg) {
+    if (!fn) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&logger.mutex);
+    int result = fn(arg);
+    pthread_mutex_unlock(&logger.mutex);
+
+    return result;
+}
+
 // Get the string representation of a log level
 const char *get_log_level_string(log_level_t level) {
     if (level >= LOG_LEVEL_ERROR && level <= LOG_LEVEL_DEBUG) {
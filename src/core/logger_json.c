@@ -154,14 +154,9 @@ void shutdown_json_logger(void) {
 }
 
 /**
- * @brief Write a log entry to the JSON log file
- * 
- * @param level Log level
- * @param timestamp Timestamp string
- * @param message Log message
- * @return int 0 on success, non-zero on error
+ * @brief Format and write one entry, optionally flushing the file
  */
-int write_json_log(log_level_t level, const char *timestamp, const char *message) {
+static int write_json_entry(log_level_t level, const char *timestamp, const char *message, int flush) {
     if (!json_logger.initialized || !json_logger.log_file) {
         return -1;
     }
@@ -197,7 +192,9 @@ int write_json_log(log_level_t level, const char *timestamp, const char *message
         result = -1;
     }
     
-    fflush(json_logger.log_file);
+    if (flush) {
+        fflush(json_logger.log_file);
+    }
     
     pthread_mutex_unlock(&json_logger.mutex);
     
@@ -206,6 +203,45 @@ int write_json_log(log_level_t level, const char *timestamp, const char *message
     return result;
 }
 
+/**
+ * @brief Write a log entry to the JSON log file
+ * 
+ * @param level Log level
+ * @param timestamp Timestamp string
+ * @param message Log message
+ * @return int 0 on success, non-zero on error
+ */
+int write_json_log(log_level_t level, const char *timestamp, const char *message) {
+    return write_json_entry(level, timestamp, message, 1);
+}
+
+/**
+ * @brief Write a log entry without flushing the JSON log file
+ * 
+ * @param level Log level
+ * @param timestamp Timestamp string
+ * @param message Log message
+ * @return int 0 on success, non-zero on error
+ */
+int write_json_log_buffered(log_level_t level, const char *timestamp, const char *message) {
+    return write_json_entry(level, timestamp, message, 0);
+}
+
+/**
+ * @brief Flush entries written with write_json_log_buffered
+ */
+void flush_json_log(void) {
+    if (!json_logger.initialized) {
+        return;
+    }
+    
+    pthread_mutex_lock(&json_logger.mutex);
+    if (json_logger.log_file) {
+        fflush(json_logger.log_file);
+    }
+    pthread_mutex_unlock(&json_logger.mutex);
+}
+
 /**
  * @brief Get logs from the JSON log file with timestamp-based pagination
  * 
@@ -0,0 +1,205 @@
+/**
+ * @file logger_recent.c
+ * @brief In-memory index of recent log records
+ *
+ * Records live in a circular array in sequence order.  Sequence numbers are
+ * contiguous, so the position of any sequence number still in memory is
+ * computed directly, and a timestamp is found with a binary search since
+ * records are appended in time order.  Per-level counts let queries for
+ * levels with nothing in memory return without scanning.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "core/logger_recent.h"
+
+static struct {
+    recent_log_record_t records[RECENT_LOG_CAPACITY];
+    uint64_t next_seq;              // Sequence number of the next record
+    int count;                      // Records in memory
+    int level_counts[LOG_LEVEL_DEBUG + 1];
+    pthread_mutex_t mutex;
+} recent = {
+    .next_seq = 1,
+    .count = 0,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+// Lowercase level names, as in the JSON log
+static const char *recent_level_names[] = {
+    "error",
+    "warning",
+    "info",
+    "debug"
+};
+
+static recent_log_record_t *record_at_seq(uint64_t seq) {
+    return &recent.records[seq % RECENT_LOG_CAPACITY];
+}
+
+void append_recent_log(log_level_t level, time_t time, const char *message) {
+    if (level < LOG_LEVEL_ERROR || level > LOG_LEVEL_DEBUG || !message) {
+        return;
+    }
+
+    pthread_mutex_lock(&recent.mutex);
+
+    recent_log_record_t *record = record_at_seq(recent.next_seq);
+    if (recent.count == RECENT_LOG_CAPACITY) {
+        // Evict the oldest record, which lives in the slot being reused
+        recent.level_counts[record->level]--;
+    } else {
+        recent.count++;
+    }
+
+    record->seq = recent.next_seq++;
+    record->time = time;
+    record->level = level;
+    strncpy(record->message, message, sizeof(record->message) - 1);
+    record->message[sizeof(record->message) - 1] = '\0';
+    recent.level_counts[level]++;
+
+    pthread_mutex_unlock(&recent.mutex);
+}
+
+uint64_t get_recent_log_cursor(void) {
+    pthread_mutex_lock(&recent.mutex);
+    uint64_t cursor = recent.next_seq - 1;
+    pthread_mutex_unlock(&recent.mutex);
+    return cursor;
+}
+
+/**
+ * First sequence number logged after a time (mutex must be held)
+ */
+static uint64_t first_seq_after(uint64_t oldest, uint64_t newest, time_t since) {
+    uint64_t lo = oldest;
+    uint64_t hi = newest + 1;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (record_at_seq(mid)->time <= since) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int get_recent_logs(log_level_t max_level, uint64_t after_seq, time_t since, int max_records,
+                    recent_log_record_t **records, uint64_t *cursor, bool *truncated) {
+    if (!records || max_records <= 0) {
+        return -1;
+    }
+
+    *records = NULL;
+    if (truncated) {
+        *truncated = false;
+    }
+
+    pthread_mutex_lock(&recent.mutex);
+
+    uint64_t newest = recent.next_seq - 1;
+    uint64_t oldest = recent.next_seq - (uint64_t)recent.count;
+    if (cursor) {
+        *cursor = newest;
+    }
+
+    // Nothing in memory at the requested levels
+    int candidates = 0;
+    for (int level = LOG_LEVEL_ERROR; level <= (int)max_level && level <= LOG_LEVEL_DEBUG; level++) {
+        candidates += recent.level_counts[level];
+    }
+    if (candidates == 0 || after_seq >= newest) {
+        pthread_mutex_unlock(&recent.mutex);
+        return 0;
+    }
+
+    uint64_t start = oldest;
+    if (after_seq > 0) {
+        if (after_seq + 1 < oldest) {
+            if (truncated) {
+                *truncated = true;
+            }
+        } else {
+            start = after_seq + 1;
+        }
+    }
+    if (since > 0) {
+        uint64_t first = first_seq_after(oldest, newest, since);
+        if (first > start) {
+            start = first;
+        }
+    }
+
+    if (max_records > candidates) {
+        max_records = candidates;
+    }
+
+    recent_log_record_t *result = malloc((size_t)max_records * sizeof(recent_log_record_t));
+    if (!result) {
+        pthread_mutex_unlock(&recent.mutex);
+        return -1;
+    }
+
+    int count = 0;
+    if (after_seq > 0) {
+        // Polling: return the oldest matches after the cursor so nothing is
+        // skipped, and resume after the last record looked at
+        uint64_t seq;
+        for (seq = start; seq <= newest && count < max_records; seq++) {
+            const recent_log_record_t *record = record_at_seq(seq);
+            if (record->level <= max_level && (since <= 0 || record->time > since)) {
+                result[count++] = *record;
+            }
+        }
+        if (cursor) {
+            *cursor = seq - 1;
+        }
+    } else {
+        // First page: the newest matches, walking backwards
+        uint64_t seq;
+        for (seq = newest; seq >= start && count < max_records; seq--) {
+            const recent_log_record_t *record = record_at_seq(seq);
+            if (record->level <= max_level && (since <= 0 || record->time > since)) {
+                result[count++] = *record;
+            }
+        }
+
+        // Report whether older matches were left out
+        for (; seq >= start && truncated && !*truncated; seq--) {
+            const recent_log_record_t *record = record_at_seq(seq);
+            if (record->level <= max_level && (since <= 0 || record->time > since)) {
+                *truncated = true;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&recent.mutex);
+
+    if (after_seq == 0) {
+        for (int i = 0; i < count / 2; i++) {
+            recent_log_record_t tmp = result[i];
+            result[i] = result[count - 1 - i];
+            result[count - 1 - i] = tmp;
+        }
+    }
+
+    if (count == 0) {
+        free(result);
+        result = NULL;
+    }
+
+    *records = result;
+    return count;
+}
+
+const char *get_recent_log_level_name(log_level_t level) {
+    if (level >= LOG_LEVEL_ERROR && level <= LOG_LEVEL_DEBUG) {
+        return recent_level_names[level];
+    }
+    return "info";
+}
@@ -41,6 +41,7 @@
 #include "video/onvif_discovery.h"
 #include "video/ffmpeg_leak_detector.h"
 #include "video/onvif_motion_recording.h"
+#include "video/packet_bus.h"
 
 // Include go2rtc headers if USE_GO2RTC is defined
 #ifdef USE_GO2RTC
@@ -54,6 +55,7 @@ void init_recordings_system(void);
 #include "database/db_schema_cache.h"
 #include "database/db_core.h"
 #include "database/db_recordings_sync.h"
+#include "database/db_detections_writer.h"
 #include <sqlite3.h>
 #include "web/http_server.h"
 #include "web/mongoose_server.h"
@@ -530,7 +532,9 @@ int main(int argc, char *argv[]) {
     init_schema_cache();
     log_info("Schema cache initialized");
 
-    // Initialize storage manager
+    // Initialize storage manager (retention settings first, the manager thread applies them right away)
+    set_retention_days(config.retention_days);
+    set_auto_delete_oldest(config.auto_delete_oldest);
     if (init_storage_manager(config.storage_path, config.max_storage_size) != 0) {
         log_error("Failed to initialize storage manager");
         goto cleanup;
@@ -545,6 +549,11 @@ int main(int argc, char *argv[]) {
         log_info("Recording sync thread started");
     }
 
+    // Start the detection writer so detection threads never wait on the database
+    if (start_detection_writer(250) != 0) {
+        log_warn("Failed to start detection writer, detections will be written synchronously");
+    }
+
     // Load stream configurations from database
     if (load_stream_configs(&config) < 0) {
         log_error("Failed to load stream configurations from database");
@@ -670,6 +679,15 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Move log I/O off the calling threads (after daemonizing, the writer thread would not survive fork)
+    if (config.log_async) {
+        if (start_async_logger() == 0) {
+            log_info("Asynchronous logging enabled");
+        } else {
+            log_warn("Failed to start asynchronous logging, writing logs synchronously");
+        }
+    }
+
     // Initialize stream state manager
     if (init_stream_state_manager(config.max_streams) != 0) {
         log_error("Failed to initialize stream state manager");
@@ -774,6 +792,9 @@ int main(int argc, char *argv[]) {
     init_timestamp_trackers();
     log_info("Timestamp trackers initialized");
 
+    // Initialize shared camera ingest before any of its consumers start
+    init_packet_bus_system();
+
     init_hls_streaming_backend();
     init_mp4_recording_backend();
     log_info("MP4 writer shutdown system initialized");
@@ -1193,6 +1214,10 @@ cleanup:
         // Wait for MP4 recording to clean up
         usleep(1000000);  // 1000ms
 
+        // Stop the shared ingest threads now that their consumers are gone
+        log_info("Shutting down shared ingest...");
+        shutdown_packet_bus_system();
+
         // Clean up FFmpeg resources
         log_info("Cleaning up transcoding backend...");
         cleanup_transcoding_backend();
@@ -1233,6 +1258,9 @@ cleanup:
         log_info("Shutting down recording sync thread...");
         stop_recording_sync_thread();
 
+        log_info("Stopping detection writer...");
+        stop_detection_writer();
+
         // Add a memory barrier before database shutdown to ensure all previous operations are complete
         __sync_synchronize();
 
@@ -1309,6 +1337,7 @@ cleanup:
         shutdown_detection_stream_system();
         cleanup_mp4_recording_backend();
         cleanup_hls_streaming_backend();
+        shutdown_packet_bus_system();
         cleanup_transcoding_backend();
 
         // Shut down remaining components
@@ -1325,6 +1354,7 @@ cleanup:
         shutdown_stream_state_adapter();
         shutdown_stream_state_manager();
         shutdown_storage_manager();
+        stop_detection_writer();
 
         // Ensure all database operations are complete before cleanup
         log_info("Ensuring all database operations are complete...");
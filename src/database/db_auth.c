@@ -11,9 +11,11 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/time.h>
 
 #include "database/db_auth.h"
+#include "database/db_auth_cache.h"
 #include "database/db_core.h"
 #include "core/logger.h"
 #include "core/config.h"
@@ -181,6 +183,66 @@ static int hex_to_bin(const char *hex, unsigned char *data, size_t data_length)
     return 0;
 }
 
+// Per-process secret keying the credential digests held in the auth cache
+static char credential_cache_secret[33];
+static bool credential_cache_secret_ok = false;
+static pthread_once_t credential_cache_secret_once = PTHREAD_ONCE_INIT;
+
+static void init_credential_cache_secret(void) {
+    credential_cache_secret_ok = generate_random_string(credential_cache_secret, 32) == 0;
+}
+
+/**
+ * Digest a username and password for the auth cache
+ *
+ * HMAC-SHA256 under a random per-process secret, so the cache never holds
+ * the password or anything that can be checked against it elsewhere.
+ *
+ * @param username Username
+ * @param password Password
+ * @param key Buffer to store the hex digest
+ * @param key_size Size of the key buffer
+ * @return 0 on success, non-zero on failure
+ */
+static int credential_cache_key(const char *username, const char *password,
+                                char *key, size_t key_size) {
+    pthread_once(&credential_cache_secret_once, init_credential_cache_secret);
+    if (!credential_cache_secret_ok) {
+        return -1;
+    }
+
+    // Streamed into the HMAC so the client-sized credentials are never copied.
+    // The NUL keeps "ab"+"c" and "a"+"bc" apart.
+    static const unsigned char separator = '\0';
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+
+    int rc = mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
+    if (rc == 0) {
+        rc = mbedtls_md_hmac_starts(&ctx, (const unsigned char *)credential_cache_secret,
+                                    strlen(credential_cache_secret));
+    }
+    if (rc == 0) {
+        rc = mbedtls_md_hmac_update(&ctx, (const unsigned char *)username, strlen(username));
+    }
+    if (rc == 0) {
+        rc = mbedtls_md_hmac_update(&ctx, &separator, 1);
+    }
+    if (rc == 0) {
+        rc = mbedtls_md_hmac_update(&ctx, (const unsigned char *)password, strlen(password));
+    }
+    if (rc == 0) {
+        rc = mbedtls_md_hmac_finish(&ctx, digest);
+    }
+    mbedtls_md_free(&ctx);
+    if (rc != 0) {
+        return -1;
+    }
+
+    return bin_to_hex(digest, SHA256_DIGEST_LENGTH, key, key_size);
+}
+
 /**
  * Initialize the authentication system
  */
@@ -429,6 +491,9 @@ int db_auth_update_user(int64_t user_id, const char *email, int role, int is_act
     
     sqlite3_finalize(stmt);
     
+    // A deactivated user must lose access right away
+    auth_cache_invalidate_user(user_id);
+    
     log_info("User updated successfully: %lld", (long long)user_id);
     return 0;
 }
@@ -543,6 +608,9 @@ int db_auth_change_password(int64_t user_id, const char *new_password) {
     
     sqlite3_finalize(stmt);
     
+    // Drop cached credentials that were checked against the old password
+    auth_cache_invalidate_user(user_id);
+    
     log_info("Password changed successfully for user: %lld", (long long)user_id);
     return 0;
 }
@@ -593,6 +661,8 @@ int db_auth_delete_user(int64_t user_id) {
     
     sqlite3_finalize(stmt);
     
+    auth_cache_invalidate_user(user_id);
+    
     log_info("User deleted successfully: %lld", (long long)user_id);
     return 0;
 }
@@ -801,6 +871,37 @@ int db_auth_get_user_by_api_key(const char *api_key, user_t *user) {
     return 0;
 }
 
+/**
+ * Validate an API key
+ */
+int db_auth_validate_api_key(const char *api_key, int64_t *user_id) {
+    if (!api_key || api_key[0] == '\0') {
+        return -1;
+    }
+    
+    if (auth_cache_lookup(AUTH_CACHE_API_KEY, api_key, user_id)) {
+        return 0;
+    }
+    unsigned int cache_generation = auth_cache_generation();
+    
+    user_t user;
+    if (db_auth_get_user_by_api_key(api_key, &user) != 0) {
+        return -1;
+    }
+    
+    if (!user.is_active) {
+        log_debug("API key belongs to an inactive user");
+        return -1;
+    }
+    
+    if (user_id) {
+        *user_id = user.id;
+    }
+    
+    auth_cache_store(AUTH_CACHE_API_KEY, api_key, user.id, 0, cache_generation);
+    return 0;
+}
+
 /**
  * Generate a new API key for a user
  */
@@ -863,6 +964,9 @@ int db_auth_generate_api_key(int64_t user_id, char *api_key, size_t api_key_size
     
     sqlite3_finalize(stmt);
     
+    // The previous key must stop working right away
+    auth_cache_invalidate_user(user_id);
+    
     log_info("API key generated successfully for user: %lld", (long long)user_id);
     return 0;
 }
@@ -876,6 +980,15 @@ int db_auth_authenticate(const char *username, const char *password, int64_t *us
         return -1;
     }
     
+    // Basic auth sends the credentials with every request, skip the PBKDF2
+    // hash and the query for ones verified recently
+    char cache_key[SHA256_DIGEST_LENGTH * 2 + 1];
+    bool cacheable = credential_cache_key(username, password, cache_key, sizeof(cache_key)) == 0;
+    if (cacheable && auth_cache_lookup(AUTH_CACHE_BASIC, cache_key, user_id)) {
+        return 0;
+    }
+    unsigned int cache_generation = auth_cache_generation();
+    
     sqlite3 *db = get_db_handle();
     if (!db) {
         log_error("Database not initialized");
@@ -955,6 +1068,10 @@ int db_auth_authenticate(const char *username, const char *password, int64_t *us
         *user_id = id;
     }
     
+    if (cacheable) {
+        auth_cache_store(AUTH_CACHE_BASIC, cache_key, id, 0, cache_generation);
+    }
+    
     // Update last login time
     sqlite3_finalize(stmt);
     
@@ -1068,6 +1185,12 @@ int db_auth_validate_session(const char *token, int64_t *user_id) {
         return -1;
     }
     
+    // Most requests of a session are answered from the cache
+    if (auth_cache_lookup(AUTH_CACHE_SESSION, token, user_id)) {
+        return 0;
+    }
+    unsigned int cache_generation = auth_cache_generation();
+    
     sqlite3 *db = get_db_handle();
     if (!db) {
         log_error("Database not initialized");
@@ -1121,6 +1244,7 @@ int db_auth_validate_session(const char *token, int64_t *user_id) {
     
     sqlite3_finalize(stmt);
     
+    auth_cache_store(AUTH_CACHE_SESSION, token, id, expires_at, cache_generation);
     return 0;
 }
 
@@ -1158,6 +1282,8 @@ int db_auth_delete_session(const char *token) {
     
     sqlite3_finalize(stmt);
     
+    auth_cache_remove(AUTH_CACHE_SESSION, token);
+    
     log_info("Session deleted successfully");
     return 0;
 }
@@ -1191,6 +1317,8 @@ int db_auth_delete_user_sessions(int64_t user_id) {
     
     sqlite3_finalize(stmt);
     
+    auth_cache_invalidate_user(user_id);
+    
     log_info("Sessions deleted successfully for user: %lld", (long long)user_id);
     return 0;
 }
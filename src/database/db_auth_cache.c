@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "database/db_auth_cache.h"
+#include "core/logger.h"
+
+// Number of independently locked shards, a power of two
+#define AUTH_CACHE_SHARDS 16
+
+// Entries per shard
+#define AUTH_CACHE_SHARD_ENTRIES 32
+
+typedef struct {
+    bool used;
+    auth_cache_kind_t kind;
+    char key[AUTH_CACHE_MAX_KEY + 1];
+    int64_t user_id;
+    time_t expires_at;
+} auth_cache_entry_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    auth_cache_entry_t entries[AUTH_CACHE_SHARD_ENTRIES];
+} auth_cache_shard_t;
+
+static auth_cache_shard_t auth_cache_shards[AUTH_CACHE_SHARDS];
+static pthread_once_t auth_cache_once = PTHREAD_ONCE_INIT;
+
+// Bumped by every removal so in-flight validations do not re-add stale entries
+static atomic_uint auth_cache_epoch;
+
+static void auth_cache_init_shards(void) {
+    for (int i = 0; i < AUTH_CACHE_SHARDS; i++) {
+        pthread_mutex_init(&auth_cache_shards[i].mutex, NULL);
+    }
+}
+
+/**
+ * FNV-1a hash of the kind and key, picks the shard
+ */
+static uint32_t auth_cache_hash(auth_cache_kind_t kind, const char *key) {
+    uint32_t hash = 2166136261u ^ (uint32_t)kind;
+    for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static auth_cache_shard_t *auth_cache_shard(auth_cache_kind_t kind, const char *key) {
+    pthread_once(&auth_cache_once, auth_cache_init_shards);
+    return &auth_cache_shards[auth_cache_hash(kind, key) & (AUTH_CACHE_SHARDS - 1)];
+}
+
+static auth_cache_entry_t *auth_cache_find(auth_cache_shard_t *shard, auth_cache_kind_t kind,
+                                           const char *key) {
+    for (int i = 0; i < AUTH_CACHE_SHARD_ENTRIES; i++) {
+        auth_cache_entry_t *entry = &shard->entries[i];
+        if (entry->used && entry->kind == kind && strcmp(entry->key, key) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Look up a validated credential
+ */
+bool auth_cache_lookup(auth_cache_kind_t kind, const char *key, int64_t *user_id) {
+    if (!key || strlen(key) > AUTH_CACHE_MAX_KEY) {
+        return false;
+    }
+
+    auth_cache_shard_t *shard = auth_cache_shard(kind, key);
+    time_t now = time(NULL);
+    bool hit = false;
+
+    pthread_mutex_lock(&shard->mutex);
+    auth_cache_entry_t *entry = auth_cache_find(shard, kind, key);
+    if (entry) {
+        if (now < entry->expires_at) {
+            if (user_id) {
+                *user_id = entry->user_id;
+            }
+            hit = true;
+        } else {
+            entry->used = false;
+        }
+    }
+    pthread_mutex_unlock(&shard->mutex);
+
+    return hit;
+}
+
+/**
+ * Current invalidation generation
+ */
+unsigned int auth_cache_generation(void) {
+    return atomic_load(&auth_cache_epoch);
+}
+
+/**
+ * Remember a credential that was just validated
+ */
+void auth_cache_store(auth_cache_kind_t kind, const char *key, int64_t user_id, time_t expires_at,
+                      unsigned int generation) {
+    if (!key || strlen(key) > AUTH_CACHE_MAX_KEY) {
+        return;
+    }
+
+    time_t now = time(NULL);
+    time_t cache_expiry = now + AUTH_CACHE_TTL_SECONDS;
+    if (expires_at > 0 && expires_at < cache_expiry) {
+        cache_expiry = expires_at;
+    }
+    if (cache_expiry <= now) {
+        return;
+    }
+
+    auth_cache_shard_t *shard = auth_cache_shard(kind, key);
+
+    pthread_mutex_lock(&shard->mutex);
+    // Checked under the shard lock, removals bump the epoch before taking it
+    if (atomic_load(&auth_cache_epoch) != generation) {
+        pthread_mutex_unlock(&shard->mutex);
+        return;
+    }
+
+    auth_cache_entry_t *entry = auth_cache_find(shard, kind, key);
+    if (!entry) {
+        // Take a free or expired slot, otherwise evict the entry closest to expiry
+        for (int i = 0; i < AUTH_CACHE_SHARD_ENTRIES; i++) {
+            auth_cache_entry_t *candidate = &shard->entries[i];
+            if (!candidate->used || candidate->expires_at <= now) {
+                entry = candidate;
+                break;
+            }
+            if (!entry || candidate->expires_at < entry->expires_at) {
+                entry = candidate;
+            }
+        }
+    }
+
+    entry->used = true;
+    entry->kind = kind;
+    strncpy(entry->key, key, sizeof(entry->key) - 1);
+    entry->key[sizeof(entry->key) - 1] = '\0';
+    entry->user_id = user_id;
+    entry->expires_at = cache_expiry;
+    pthread_mutex_unlock(&shard->mutex);
+}
+
+/**
+ * Forget one credential
+ */
+void auth_cache_remove(auth_cache_kind_t kind, const char *key) {
+    if (!key || strlen(key) > AUTH_CACHE_MAX_KEY) {
+        return;
+    }
+
+    auth_cache_shard_t *shard = auth_cache_shard(kind, key);
+    atomic_fetch_add(&auth_cache_epoch, 1);
+
+    pthread_mutex_lock(&shard->mutex);
+    auth_cache_entry_t *entry = auth_cache_find(shard, kind, key);
+    if (entry) {
+        entry->used = false;
+    }
+    pthread_mutex_unlock(&shard->mutex);
+}
+
+/**
+ * Forget every credential of a user
+ */
+void auth_cache_invalidate_user(int64_t user_id) {
+    pthread_once(&auth_cache_once, auth_cache_init_shards);
+    atomic_fetch_add(&auth_cache_epoch, 1);
+
+    int removed = 0;
+    for (int s = 0; s < AUTH_CACHE_SHARDS; s++) {
+        auth_cache_shard_t *shard = &auth_cache_shards[s];
+        pthread_mutex_lock(&shard->mutex);
+        for (int i = 0; i < AUTH_CACHE_SHARD_ENTRIES; i++) {
+            if (shard->entries[i].used && shard->entries[i].user_id == user_id) {
+                shard->entries[i].used = false;
+                removed++;
+            }
+        }
+        pthread_mutex_unlock(&shard->mutex);
+    }
+
+    if (removed > 0) {
+        log_debug("Dropped %d cached credentials of user %lld", removed, (long long)user_id);
+    }
+}
+
+/**
+ * Forget every cached credential
+ */
+void auth_cache_clear(void) {
+    pthread_once(&auth_cache_once, auth_cache_init_shards);
+    atomic_fetch_add(&auth_cache_epoch, 1);
+
+    for (int s = 0; s < AUTH_CACHE_SHARDS; s++) {
+        auth_cache_shard_t *shard = &auth_cache_shards[s];
+        pthread_mutex_lock(&shard->mutex);
+        for (int i = 0; i < AUTH_CACHE_SHARD_ENTRIES; i++) {
+            shard->entries[i].used = false;
+        }
+        pthread_mutex_unlock(&shard->mutex);
+    }
+}
@@ -21,6 +21,8 @@
 #include "database/db_core.h"
 #include "database/db_schema.h"
 #include "database/db_backup.h"
+#include "database/db_read_pool.h"
+#include "database/db_stream_registry.h"
 #include "core/logger.h"
 
 // Database handle
@@ -576,6 +578,11 @@ int init_database(const char *db_path) {
 
     log_info("Database initialized successfully");
 
+    // With WAL, readers get their own connections and stop queueing behind writers
+    if (wal_mode_enabled) {
+        init_db_read_pool(db_path);
+    }
+
     // Create an initial backup if this is a new database
     if (is_new_database) {
         log_info("Creating initial backup of new database");
@@ -611,6 +618,12 @@ static void reset_sqlite_internal_state(void) {
 void shutdown_database(void) {
     log_info("Starting database shutdown process");
 
+    // Readers fall back to the primary connection from here on
+    shutdown_db_read_pool();
+
+    // Stream lookups after this point reload from the next database
+    stream_registry_clear();
+
     // Create a final backup before shutting down
     if (db != NULL && db_file_path[0] != '\0') {
         log_info("Creating final backup before shutdown");
@@ -12,6 +12,8 @@
 
 #include "database/db_detections.h"
 #include "database/db_core.h"
+#include "database/db_read_pool.h"
+#include "database/db_detections_writer.h"
 #include "core/logger.h"
 #include "video/detection_result.h"
 
@@ -46,81 +48,22 @@ int store_detections_in_db(const char *stream_name, const detection_result_t *re
         timestamp = time(NULL);
     }
     
-    log_info("Storing %d detections in database for stream %s", result->count, stream_name);
-    
-    // Log the first detection for debugging
-    if (result->count > 0) {
-        log_info("First detection: %s (%.2f%%) at [%.2f, %.2f, %.2f, %.2f]",
-                result->detections[0].label,
-                result->detections[0].confidence * 100.0f,
-                result->detections[0].x,
-                result->detections[0].y,
-                result->detections[0].width,
-                result->detections[0].height);
+    if (result->count <= 0) {
+        return 0;
     }
     
-    pthread_mutex_lock(db_mutex);
-    
-    // Check if detections table exists
-    char *err_msg = NULL;
-    char **query_result;
-    int rows, cols;
-    rc = sqlite3_get_table(db, 
-                          "SELECT name FROM sqlite_master WHERE type='table' AND name='detections';", 
-                          &query_result, &rows, &cols, &err_msg);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Failed to check if detections table exists: %s", err_msg);
-        sqlite3_free(err_msg);
-        pthread_mutex_unlock(db_mutex);
-        return -1;
+    // Normally the writer thread batches the insert, the caller never waits on SQLite
+    if (queue_detections(stream_name, result, timestamp) == 0) {
+        log_debug("Queued %d detections for stream %s", result->count, stream_name);
+        return 0;
     }
     
-    if (rows == 0) {
-        log_error("Detections table does not exist, recreating it");
-        sqlite3_free_table(query_result);
-        
-        // Create detections table
-        const char *create_detections_table =
-            "CREATE TABLE IF NOT EXISTS detections ("
-            "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-            "stream_name TEXT NOT NULL,"
-            "timestamp INTEGER NOT NULL,"
-            "label TEXT NOT NULL,"
-            "confidence REAL NOT NULL,"
-            "x REAL NOT NULL,"
-            "y REAL NOT NULL,"
-            "width REAL NOT NULL,"
-            "height REAL NOT NULL,"
-            "track_id INTEGER DEFAULT -1,"
-            "zone_id TEXT DEFAULT ''"
-            ");";
-        
-        rc = sqlite3_exec(db, create_detections_table, NULL, NULL, &err_msg);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to create detections table: %s", err_msg);
-            sqlite3_free(err_msg);
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-        
-        // Create indexes
-        const char *create_indexes = 
-            "CREATE INDEX IF NOT EXISTS idx_detections_stream_timestamp ON detections (stream_name, timestamp);"
-            "CREATE INDEX IF NOT EXISTS idx_detections_timestamp ON detections (timestamp);";
-        
-        rc = sqlite3_exec(db, create_indexes, NULL, NULL, &err_msg);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to create indexes: %s", err_msg);
-            sqlite3_free(err_msg);
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-    } else {
-        sqlite3_free_table(query_result);
-    }
+    // Writer not running or its queue is full, write synchronously
+    log_debug("Storing %d detections in database for stream %s", result->count, stream_name);
     
-    // Begin transaction for better performance when inserting multiple detections
+    pthread_mutex_lock(db_mutex);
+    
+    char *err_msg = NULL;
     rc = sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, &err_msg);
     if (rc != SQLITE_OK) {
         log_error("Failed to begin transaction: %s", err_msg);
@@ -169,7 +112,6 @@ int store_detections_in_db(const char *stream_name, const detection_result_t *re
         sqlite3_clear_bindings(stmt);
     }
     
-    // Untrack and finalize the prepared statement
     sqlite3_finalize(stmt);
     
     // Commit transaction
@@ -182,25 +124,8 @@ int store_detections_in_db(const char *stream_name, const detection_result_t *re
         return -1;
     }
     
-    // Verify the detections were stored
-    char verify_sql[256];
-    snprintf(verify_sql, sizeof(verify_sql), 
-            "SELECT COUNT(*) FROM detections WHERE stream_name = '%s' AND timestamp = %lld;",
-            stream_name, (long long)timestamp);
-    
-    rc = sqlite3_get_table(db, verify_sql, &query_result, &rows, &cols, &err_msg);
-    if (rc != SQLITE_OK) {
-        log_error("Failed to verify detections were stored: %s", err_msg);
-        sqlite3_free(err_msg);
-    } else if (rows > 0 && cols > 0) {
-        int count = atoi(query_result[1]); // First row, first column
-        log_info("Verified %d detections were stored in database for stream %s", count, stream_name);
-        sqlite3_free_table(query_result);
-    }
-    
     pthread_mutex_unlock(db_mutex);
     
-    log_info("Successfully stored %d detections in database for stream %s", result->count, stream_name);
     return 0;
 }
 
@@ -216,11 +141,9 @@ int store_detections_in_db(const char *stream_name, const detection_result_t *re
  */
 int get_detections_from_db_time_range(const char *stream_name, detection_result_t *result, 
                                      uint64_t max_age, time_t start_time, time_t end_time) {
-    int rc;
     sqlite3_stmt *stmt;
     
     sqlite3 *db = get_db_handle();
-    pthread_mutex_t *db_mutex = get_db_mutex();
     
     if (!db) {
         log_error("Database not initialized");
@@ -235,10 +158,10 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
     // Initialize result
     memset(result, 0, sizeof(detection_result_t));
     
-    pthread_mutex_lock(db_mutex);
-    
     // Build query based on filters
     char sql[512];
+    sqlite3_int64 bounds[2];
+    int bound_count = 0;
     
     if (start_time > 0 && end_time > 0) {
         // Time range filter
@@ -251,19 +174,8 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
                 "WHERE stream_name = ? AND timestamp >= ? AND timestamp <= ? "
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
-        
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-        
-        // Bind parameters
-        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)start_time);
-        sqlite3_bind_int64(stmt, 3, (sqlite3_int64)end_time);
-        sqlite3_bind_int(stmt, 4, MAX_DETECTIONS);
+        bounds[bound_count++] = (sqlite3_int64)start_time;
+        bounds[bound_count++] = (sqlite3_int64)end_time;
     } else if (start_time > 0) {
         // Start time filter only
         log_info("Getting detections for stream %s from %lld", 
@@ -275,18 +187,7 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
                 "WHERE stream_name = ? AND timestamp >= ? "
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
-        
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-        
-        // Bind parameters
-        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)start_time);
-        sqlite3_bind_int(stmt, 3, MAX_DETECTIONS);
+        bounds[bound_count++] = (sqlite3_int64)start_time;
     } else if (end_time > 0) {
         // End time filter only
         log_info("Getting detections for stream %s until %lld", 
@@ -298,18 +199,7 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
                 "WHERE stream_name = ? AND timestamp <= ? "
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
-        
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-        
-        // Bind parameters
-        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)end_time);
-        sqlite3_bind_int(stmt, 3, MAX_DETECTIONS);
+        bounds[bound_count++] = (sqlite3_int64)end_time;
     } else if (max_age > 0) {
         // Max age filter
         // Calculate cutoff time
@@ -325,18 +215,7 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
                 "WHERE stream_name = ? AND timestamp >= ? "
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
-
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-
-        // Bind parameters
-        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)cutoff_time);
-        sqlite3_bind_int(stmt, 3, MAX_DETECTIONS);
+        bounds[bound_count++] = (sqlite3_int64)cutoff_time;
     } else {
         // No filters, just get the latest detections
         log_info("Getting latest detections for stream %s (no time filters)", stream_name);
@@ -347,19 +226,21 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
                 "WHERE stream_name = ? "
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
-        
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-        
-        // Bind parameters
-        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 2, MAX_DETECTIONS);
     }
     
+    db_read_conn_t *conn;
+    stmt = db_read_query(sql, &conn);
+    if (!stmt) {
+        return -1;
+    }
+    
+    // Bind parameters
+    sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
+    for (int i = 0; i < bound_count; i++) {
+        sqlite3_bind_int64(stmt, i + 2, bounds[i]);
+    }
+    sqlite3_bind_int(stmt, bound_count + 2, MAX_DETECTIONS);
+    
     // Execute query and fetch results
     int count = 0;
     while (sqlite3_step(stmt) == SQLITE_ROW && count < MAX_DETECTIONS) {
@@ -389,9 +270,7 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
     }
     
     result->count = count;
-
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(db_mutex);
+    db_read_release(conn);
     
     log_info("Found %d detections in database for stream %s", count, stream_name);
     return count;
@@ -410,11 +289,9 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
  */
 int get_detection_timestamps(const char *stream_name, detection_result_t *result, time_t *timestamps,
                            uint64_t max_age, time_t start_time, time_t end_time) {
-    int rc;
     sqlite3_stmt *stmt;
     
     sqlite3 *db = get_db_handle();
-    pthread_mutex_t *db_mutex = get_db_mutex();
     
     if (!db) {
         log_error("Database not initialized");
@@ -426,10 +303,10 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
         return -1;
     }
     
-    pthread_mutex_lock(db_mutex);
-    
     // Build query based on filters
     char sql[512];
+    sqlite3_int64 bounds[2];
+    int bound_count = 0;
     
     if (start_time > 0 && end_time > 0) {
         // Time range filter
@@ -439,19 +316,8 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
                 "WHERE stream_name = ? AND timestamp >= ? AND timestamp <= ? "
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
-        
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-
-        // Bind parameters
-        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)start_time);
-        sqlite3_bind_int64(stmt, 3, (sqlite3_int64)end_time);
-        sqlite3_bind_int(stmt, 4, MAX_DETECTIONS);
+        bounds[bound_count++] = (sqlite3_int64)start_time;
+        bounds[bound_count++] = (sqlite3_int64)end_time;
     } else if (start_time > 0) {
         // Start time filter only
         snprintf(sql, sizeof(sql), 
@@ -460,18 +326,7 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
                 "WHERE stream_name = ? AND timestamp >= ? "
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
-        
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-        
-        // Bind parameters
-        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)start_time);
-        sqlite3_bind_int(stmt, 3, MAX_DETECTIONS);
+        bounds[bound_count++] = (sqlite3_int64)start_time;
     } else if (end_time > 0) {
         // End time filter only
         snprintf(sql, sizeof(sql), 
@@ -480,18 +335,7 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
                 "WHERE stream_name = ? AND timestamp <= ? "
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
-        
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-        
-        // Bind parameters
-        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)end_time);
-        sqlite3_bind_int(stmt, 3, MAX_DETECTIONS);
+        bounds[bound_count++] = (sqlite3_int64)end_time;
     } else if (max_age > 0) {
         // Max age filter
         // Calculate cutoff time
@@ -504,18 +348,7 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
                 "WHERE stream_name = ? AND timestamp >= ? "
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
-        
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-        
-        // Bind parameters
-        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)cutoff_time);
-        sqlite3_bind_int(stmt, 3, MAX_DETECTIONS);
+        bounds[bound_count++] = (sqlite3_int64)cutoff_time;
     } else {
         // No filters, just get the latest detections
         snprintf(sql, sizeof(sql), 
@@ -524,19 +357,21 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
                 "WHERE stream_name = ? "
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
-        
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
-            return -1;
-        }
-        
-        // Bind parameters
-        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 2, MAX_DETECTIONS);
     }
     
+    db_read_conn_t *conn;
+    stmt = db_read_query(sql, &conn);
+    if (!stmt) {
+        return -1;
+    }
+    
+    // Bind parameters
+    sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
+    for (int i = 0; i < bound_count; i++) {
+        sqlite3_bind_int64(stmt, i + 2, bounds[i]);
+    }
+    sqlite3_bind_int(stmt, bound_count + 2, MAX_DETECTIONS);
+    
     // Execute query and fetch results
     int count = 0;
     while (sqlite3_step(stmt) == SQLITE_ROW && count < result->count) {
@@ -567,9 +402,7 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
         
         count++;
     }
-    
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(db_mutex);
+    db_read_release(conn);
     
     return 0;
 }
@@ -0,0 +1,353 @@
+/**
+ * Asynchronous detection writer
+ *
+ * Producers (detection threads) claim a slot of a bounded multi-producer
+ * ring with a compare-and-swap on the enqueue position and publish it by
+ * bumping the slot's sequence number, so they never take a lock.  The writer
+ * thread is the only consumer: every flush interval it takes the database
+ * mutex once, opens one transaction and inserts every published slot with a
+ * statement prepared when the thread started.  Slots are only handed back
+ * once the transaction has committed, so a failed batch is retried.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <sqlite3.h>
+
+#include "core/logger.h"
+#include "database/db_core.h"
+#include "database/db_detections_writer.h"
+
+// Number of queued detection results (power of two)
+#define DETECTION_QUEUE_SIZE 256
+#define DETECTION_QUEUE_MASK (DETECTION_QUEUE_SIZE - 1)
+
+// Wake the writer early once the queue is this full
+#define DETECTION_QUEUE_HIGH_WATER (DETECTION_QUEUE_SIZE / 2)
+
+typedef struct {
+    atomic_size_t sequence;
+    char stream_name[64];
+    time_t timestamp;
+    detection_result_t result;
+} detection_slot_t;
+
+static struct {
+    detection_slot_t slots[DETECTION_QUEUE_SIZE];
+    atomic_size_t enqueue_pos;
+    atomic_size_t dequeue_pos;      // Only advanced by the writer thread
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    atomic_bool running;
+    atomic_int producers;           // queue_detections() calls in progress
+    int flush_interval_ms;
+
+    atomic_uint_fast64_t written;
+    atomic_uint_fast64_t batches;
+    atomic_uint_fast64_t rejected;
+} writer = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .flush_interval_ms = 250,
+};
+
+/**
+ * Reset the ring so slot i expects enqueue position i
+ */
+static void reset_queue(void) {
+    for (size_t i = 0; i < DETECTION_QUEUE_SIZE; i++) {
+        atomic_store_explicit(&writer.slots[i].sequence, i, memory_order_relaxed);
+    }
+    atomic_store_explicit(&writer.enqueue_pos, 0, memory_order_relaxed);
+    atomic_store_explicit(&writer.dequeue_pos, 0, memory_order_relaxed);
+}
+
+int queue_detections(const char *stream_name, const detection_result_t *result, time_t timestamp) {
+    if (!stream_name || !result) {
+        return -1;
+    }
+
+    // Register before checking running, the writer waits for registered producers before its final drain
+    atomic_fetch_add(&writer.producers, 1);
+    if (!atomic_load(&writer.running)) {
+        atomic_fetch_sub(&writer.producers, 1);
+        return -1;
+    }
+
+    detection_slot_t *slot;
+    size_t pos = atomic_load_explicit(&writer.enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        slot = &writer.slots[pos & DETECTION_QUEUE_MASK];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+        if (diff == 0) {
+            // Slot is free for this position, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&writer.enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The writer has not consumed this slot yet, the queue is full
+            atomic_fetch_add_explicit(&writer.rejected, 1, memory_order_relaxed);
+            atomic_fetch_sub(&writer.producers, 1);
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&writer.enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    strncpy(slot->stream_name, stream_name, sizeof(slot->stream_name) - 1);
+    slot->stream_name[sizeof(slot->stream_name) - 1] = '\0';
+    slot->timestamp = timestamp;
+    slot->result.count = result->count < MAX_DETECTIONS ? result->count : MAX_DETECTIONS;
+    memcpy(slot->result.detections, result->detections,
+           slot->result.count * sizeof(detection_t));
+
+    // Publish the slot to the writer
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+    // Signalling without the mutex can be missed, the timed wait covers that
+    size_t depth = pos + 1 - atomic_load_explicit(&writer.dequeue_pos, memory_order_relaxed);
+    if (depth == DETECTION_QUEUE_HIGH_WATER) {
+        pthread_cond_signal(&writer.cond);
+    }
+
+    atomic_fetch_sub(&writer.producers, 1);
+    return 0;
+}
+
+/**
+ * Prepare the long-lived insert statement
+ */
+static sqlite3_stmt *prepare_insert_statement(sqlite3 *db) {
+    sqlite3_stmt *stmt = NULL;
+    const char *sql = "INSERT INTO detections (stream_name, timestamp, label, confidence, x, y, width, height, track_id, zone_id) "
+                      "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+
+    int rc = sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        log_error("Failed to prepare detection insert statement: %s", sqlite3_errmsg(db));
+        return NULL;
+    }
+
+    return stmt;
+}
+
+/**
+ * Write every published slot in one transaction
+ *
+ * @return Number of detection results written, or -1 on error
+ */
+static int flush_queue(sqlite3_stmt **stmt) {
+    size_t pos = atomic_load_explicit(&writer.dequeue_pos, memory_order_relaxed);
+    detection_slot_t *slot = &writer.slots[pos & DETECTION_QUEUE_MASK];
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != pos + 1) {
+        return 0;
+    }
+
+    sqlite3 *db = get_db_handle();
+    pthread_mutex_t *db_mutex = get_db_mutex();
+    if (!db) {
+        return -1;
+    }
+
+    pthread_mutex_lock(db_mutex);
+
+    if (!*stmt) {
+        *stmt = prepare_insert_statement(db);
+        if (!*stmt) {
+            pthread_mutex_unlock(db_mutex);
+            return -1;
+        }
+    }
+
+    char *err_msg = NULL;
+    if (sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, &err_msg) != SQLITE_OK) {
+        log_error("Failed to begin detection batch: %s", err_msg);
+        sqlite3_free(err_msg);
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+
+    size_t first = pos;
+    int written = 0;
+    int rows = 0;
+    // Bounded so a steady stream of producers cannot hold the database mutex indefinitely
+    while (written < DETECTION_QUEUE_SIZE) {
+        slot = &writer.slots[pos & DETECTION_QUEUE_MASK];
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != pos + 1) {
+            break;
+        }
+
+        for (int i = 0; i < slot->result.count; i++) {
+            const detection_t *det = &slot->result.detections[i];
+            sqlite3_bind_text(*stmt, 1, slot->stream_name, -1, SQLITE_STATIC);
+            sqlite3_bind_int64(*stmt, 2, (sqlite3_int64)slot->timestamp);
+            sqlite3_bind_text(*stmt, 3, det->label, -1, SQLITE_STATIC);
+            sqlite3_bind_double(*stmt, 4, det->confidence);
+            sqlite3_bind_double(*stmt, 5, det->x);
+            sqlite3_bind_double(*stmt, 6, det->y);
+            sqlite3_bind_double(*stmt, 7, det->width);
+            sqlite3_bind_double(*stmt, 8, det->height);
+            sqlite3_bind_int(*stmt, 9, det->track_id);
+            sqlite3_bind_text(*stmt, 10, det->zone_id, -1, SQLITE_STATIC);
+
+            if (sqlite3_step(*stmt) != SQLITE_DONE) {
+                log_error("Failed to insert detection for stream %s: %s",
+                          slot->stream_name, sqlite3_errmsg(db));
+            } else {
+                rows++;
+            }
+            sqlite3_reset(*stmt);
+        }
+        sqlite3_clear_bindings(*stmt);
+        pos++;
+        written++;
+    }
+
+    int rc = sqlite3_exec(db, "COMMIT;", NULL, NULL, &err_msg);
+    if (rc != SQLITE_OK) {
+        // The slots stay queued and the next flush writes them again
+        log_error("Failed to commit detection batch of %d results: %s", written, err_msg);
+        sqlite3_free(err_msg);
+        sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+
+    pthread_mutex_unlock(db_mutex);
+
+    // Hand the committed slots back to the producers, one lap ahead
+    for (size_t p = first; p < pos; p++) {
+        atomic_store_explicit(&writer.slots[p & DETECTION_QUEUE_MASK].sequence, p + DETECTION_QUEUE_SIZE,
+                              memory_order_release);
+    }
+    atomic_store_explicit(&writer.dequeue_pos, pos, memory_order_relaxed);
+
+    atomic_fetch_add_explicit(&writer.written, written, memory_order_relaxed);
+    atomic_fetch_add_explicit(&writer.batches, 1, memory_order_relaxed);
+    log_debug("Detection writer stored %d rows from %d results", rows, written);
+
+    return written;
+}
+
+/**
+ * Writer thread function
+ */
+static void *detection_writer_thread_func(void *arg) {
+    (void)arg;
+    sqlite3_stmt *stmt = NULL;
+
+    log_info("Detection writer thread started with flush interval: %d ms", writer.flush_interval_ms);
+
+    while (atomic_load_explicit(&writer.running, memory_order_acquire)) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += writer.flush_interval_ms / 1000;
+        deadline.tv_nsec += (long)(writer.flush_interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&writer.mutex);
+        if (atomic_load_explicit(&writer.running, memory_order_acquire)) {
+            pthread_cond_timedwait(&writer.cond, &writer.mutex, &deadline);
+        }
+        pthread_mutex_unlock(&writer.mutex);
+
+        flush_queue(&stmt);
+    }
+
+    // Producers that saw running before it was cleared may still be publishing
+    while (atomic_load(&writer.producers) > 0) {
+        sched_yield();
+    }
+
+    // Producers are stopped, write out whatever is left
+    int flushed;
+    while ((flushed = flush_queue(&stmt)) > 0) {
+    }
+    if (flushed < 0) {
+        log_error("Detection writer exiting with unwritten detections");
+    }
+
+    if (stmt) {
+        pthread_mutex_t *db_mutex = get_db_mutex();
+        pthread_mutex_lock(db_mutex);
+        sqlite3_finalize(stmt);
+        pthread_mutex_unlock(db_mutex);
+    }
+
+    log_info("Detection writer thread exiting");
+    return NULL;
+}
+
+int start_detection_writer(int flush_interval_ms) {
+    pthread_mutex_lock(&writer.mutex);
+
+    if (atomic_load(&writer.running)) {
+        log_warn("Detection writer is already running");
+        pthread_mutex_unlock(&writer.mutex);
+        return 0;
+    }
+
+    if (flush_interval_ms < 10) {
+        flush_interval_ms = 10;
+    } else if (flush_interval_ms > 5000) {
+        flush_interval_ms = 5000;
+    }
+    writer.flush_interval_ms = flush_interval_ms;
+
+    reset_queue();
+    atomic_store(&writer.running, true);
+
+    if (pthread_create(&writer.thread, NULL, detection_writer_thread_func, NULL) != 0) {
+        log_error("Failed to create detection writer thread: %s", strerror(errno));
+        atomic_store(&writer.running, false);
+        pthread_mutex_unlock(&writer.mutex);
+        return -1;
+    }
+
+    pthread_mutex_unlock(&writer.mutex);
+    return 0;
+}
+
+void stop_detection_writer(void) {
+    pthread_mutex_lock(&writer.mutex);
+    if (!atomic_load(&writer.running)) {
+        pthread_mutex_unlock(&writer.mutex);
+        return;
+    }
+
+    atomic_store(&writer.running, false);
+    pthread_cond_signal(&writer.cond);
+    pthread_mutex_unlock(&writer.mutex);
+
+    if (pthread_join(writer.thread, NULL) != 0) {
+        log_error("Failed to join detection writer thread");
+        return;
+    }
+
+    log_info("Detection writer stopped (%llu results in %llu batches, %llu rejected)",
+             (unsigned long long)atomic_load(&writer.written),
+             (unsigned long long)atomic_load(&writer.batches),
+             (unsigned long long)atomic_load(&writer.rejected));
+}
+
+void get_detection_writer_stats(uint64_t *written, uint64_t *batches, uint64_t *rejected) {
+    if (written) *written = atomic_load(&writer.written);
+    if (batches) *batches = atomic_load(&writer.batches);
+    if (rejected) *rejected = atomic_load(&writer.rejected);
+}
@@ -0,0 +1,310 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sqlite3.h>
+
+#include "database/db_read_pool.h"
+#include "database/db_core.h"
+#include "core/logger.h"
+
+// How long a reader waits for a free connection before using the primary one
+#define DB_READ_ACQUIRE_TIMEOUT_SEC 5
+
+typedef struct {
+    char *sql;              // Owned copy of the query, NULL for uncached statements
+    sqlite3_stmt *stmt;
+    bool in_use;
+} db_read_stmt_t;
+
+struct db_read_conn {
+    sqlite3 *db;
+    bool primary;           // The shared read-write connection, used under the database mutex
+    bool in_use;
+    db_read_stmt_t stmts[DB_READ_STMT_CACHE_SIZE];
+    int next_victim;
+};
+
+static struct {
+    db_read_conn_t conns[DB_READ_POOL_SIZE];
+    int count;
+    bool running;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} pool = {
+    .count = 0,
+    .running = false,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+// Fallback when the pool is not running
+static db_read_conn_t primary_conn = { .primary = true };
+
+// Connection this thread used last, handed back to it when free
+static __thread db_read_conn_t *preferred_conn = NULL;
+
+/**
+ * Finalize every statement of a connection and forget the cache
+ */
+static void clear_statements(db_read_conn_t *conn) {
+    for (int i = 0; i < DB_READ_STMT_CACHE_SIZE; i++) {
+        if (conn->stmts[i].stmt) {
+            sqlite3_finalize(conn->stmts[i].stmt);
+        }
+        free(conn->stmts[i].sql);
+        conn->stmts[i].sql = NULL;
+        conn->stmts[i].stmt = NULL;
+        conn->stmts[i].in_use = false;
+    }
+    conn->next_victim = 0;
+}
+
+int init_db_read_pool(const char *db_path) {
+    if (!db_path) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool.mutex);
+
+    if (pool.running) {
+        pthread_mutex_unlock(&pool.mutex);
+        return 0;
+    }
+
+    pool.count = 0;
+    for (int i = 0; i < DB_READ_POOL_SIZE; i++) {
+        db_read_conn_t *conn = &pool.conns[i];
+        memset(conn, 0, sizeof(*conn));
+
+        // Each connection is only ever used by one thread at a time
+        int rc = sqlite3_open_v2(db_path, &conn->db,
+                                 SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+        if (rc != SQLITE_OK) {
+            log_error("Failed to open read-only database connection: %s",
+                      conn->db ? sqlite3_errmsg(conn->db) : sqlite3_errstr(rc));
+            if (conn->db) {
+                sqlite3_close_v2(conn->db);
+                conn->db = NULL;
+            }
+            break;
+        }
+
+        sqlite3_busy_timeout(conn->db, 5000);
+        pool.count++;
+    }
+
+    if (pool.count == 0) {
+        pthread_mutex_unlock(&pool.mutex);
+        log_warn("No read-only database connections available, reads will use the primary connection");
+        return -1;
+    }
+
+    pool.running = true;
+    pthread_mutex_unlock(&pool.mutex);
+
+    log_info("Database read pool started with %d read-only connections", pool.count);
+    return 0;
+}
+
+void shutdown_db_read_pool(void) {
+    pthread_mutex_lock(&pool.mutex);
+
+    if (!pool.running) {
+        pthread_mutex_unlock(&pool.mutex);
+        return;
+    }
+
+    // New readers go to the primary connection from here on
+    pool.running = false;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += DB_READ_ACQUIRE_TIMEOUT_SEC;
+
+    for (int i = 0; i < pool.count; i++) {
+        db_read_conn_t *conn = &pool.conns[i];
+        while (conn->in_use) {
+            if (pthread_cond_timedwait(&pool.cond, &pool.mutex, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+
+        if (conn->in_use) {
+            // Leak it rather than close it under a running query
+            log_warn("Read-only database connection %d still in use at shutdown", i);
+            continue;
+        }
+
+        clear_statements(conn);
+        sqlite3_close_v2(conn->db);
+        conn->db = NULL;
+    }
+
+    pool.count = 0;
+    pthread_mutex_unlock(&pool.mutex);
+
+    log_info("Database read pool stopped");
+}
+
+db_read_conn_t *db_read_acquire(void) {
+    pthread_mutex_lock(&pool.mutex);
+
+    if (pool.running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += DB_READ_ACQUIRE_TIMEOUT_SEC;
+
+        while (pool.running) {
+            db_read_conn_t *conn = NULL;
+
+            if (preferred_conn && !preferred_conn->in_use && preferred_conn->db) {
+                conn = preferred_conn;
+            } else {
+                for (int i = 0; i < pool.count; i++) {
+                    if (!pool.conns[i].in_use) {
+                        conn = &pool.conns[i];
+                        break;
+                    }
+                }
+            }
+
+            if (conn) {
+                conn->in_use = true;
+                preferred_conn = conn;
+                pthread_mutex_unlock(&pool.mutex);
+                return conn;
+            }
+
+            if (pthread_cond_timedwait(&pool.cond, &pool.mutex, &deadline) == ETIMEDOUT) {
+                log_warn("Timed out waiting for a read-only database connection");
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&pool.mutex);
+
+    // Pool not running or exhausted, read through the primary connection
+    sqlite3 *db = get_db_handle();
+    if (!db) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(get_db_mutex());
+    primary_conn.db = db;
+    return &primary_conn;
+}
+
+sqlite3 *db_read_handle(db_read_conn_t *conn) {
+    return conn ? conn->db : NULL;
+}
+
+sqlite3_stmt *db_read_prepare(db_read_conn_t *conn, const char *sql) {
+    if (!conn || !conn->db || !sql) {
+        return NULL;
+    }
+
+    // Reuse a cached statement for the same query
+    if (!conn->primary) {
+        for (int i = 0; i < DB_READ_STMT_CACHE_SIZE; i++) {
+            db_read_stmt_t *entry = &conn->stmts[i];
+            if (entry->sql && !entry->in_use && strcmp(entry->sql, sql) == 0) {
+                entry->in_use = true;
+                return entry->stmt;
+            }
+        }
+    }
+
+    // Find an empty slot, or evict one that is not in use
+    db_read_stmt_t *slot = NULL;
+    for (int i = 0; i < DB_READ_STMT_CACHE_SIZE && !slot; i++) {
+        if (!conn->stmts[i].stmt) {
+            slot = &conn->stmts[i];
+        }
+    }
+    for (int n = 0; n < DB_READ_STMT_CACHE_SIZE && !slot; n++) {
+        db_read_stmt_t *entry = &conn->stmts[conn->next_victim];
+        conn->next_victim = (conn->next_victim + 1) % DB_READ_STMT_CACHE_SIZE;
+        if (!entry->in_use) {
+            sqlite3_finalize(entry->stmt);
+            free(entry->sql);
+            entry->stmt = NULL;
+            entry->sql = NULL;
+            slot = entry;
+        }
+    }
+    if (!slot) {
+        log_error("Too many statements in use on one read connection");
+        return NULL;
+    }
+
+    sqlite3_stmt *stmt = NULL;
+    int rc = sqlite3_prepare_v3(conn->db, sql, -1, conn->primary ? 0 : SQLITE_PREPARE_PERSISTENT,
+                                &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        return NULL;
+    }
+
+    // Statements on the primary connection are finalized on release, not cached
+    slot->sql = conn->primary ? NULL : strdup(sql);
+    slot->stmt = stmt;
+    slot->in_use = true;
+
+    return stmt;
+}
+
+sqlite3_stmt *db_read_query(const char *sql, db_read_conn_t **conn) {
+    *conn = db_read_acquire();
+    if (!*conn) {
+        log_error("No database connection available for reading");
+        return NULL;
+    }
+
+    sqlite3_stmt *stmt = db_read_prepare(*conn, sql);
+    if (!stmt) {
+        log_error("Failed to prepare read query: %s", sqlite3_errmsg((*conn)->db));
+        db_read_release(*conn);
+        *conn = NULL;
+    }
+    return stmt;
+}
+
+void db_read_release(db_read_conn_t *conn) {
+    if (!conn) {
+        return;
+    }
+
+    for (int i = 0; i < DB_READ_STMT_CACHE_SIZE; i++) {
+        db_read_stmt_t *entry = &conn->stmts[i];
+        if (!entry->in_use) {
+            continue;
+        }
+
+        if (conn->primary || !entry->sql) {
+            sqlite3_finalize(entry->stmt);
+            free(entry->sql);
+            entry->stmt = NULL;
+            entry->sql = NULL;
+        } else {
+            sqlite3_reset(entry->stmt);
+            sqlite3_clear_bindings(entry->stmt);
+        }
+        entry->in_use = false;
+    }
+
+    if (conn->primary) {
+        pthread_mutex_unlock(get_db_mutex());
+        return;
+    }
+
+    pthread_mutex_lock(&pool.mutex);
+    conn->in_use = false;
+    pthread_cond_broadcast(&pool.cond);
+    pthread_mutex_unlock(&pool.mutex);
+}
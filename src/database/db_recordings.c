@@ -11,6 +11,9 @@
 
 #include "database/db_recordings.h"
 #include "database/db_core.h"
+#include "database/db_read_pool.h"
+#include "database/db_recordings_sync.h"
+#include "database/db_transaction.h"
 #include "core/logger.h"
 
 // Add recording metadata to the database
@@ -81,6 +84,11 @@ uint64_t add_recording_metadata(const recording_metadata_t *metadata) {
     // Finalize the prepared statement
     sqlite3_finalize(stmt);
     pthread_mutex_unlock(db_mutex);
+
+    // A recording still being written needs its size tracked by the sync thread
+    if (recording_id != 0 && !metadata->is_complete) {
+        mark_recording_dirty(recording_id);
+    }
     
     return recording_id;
 }
@@ -131,18 +139,161 @@ int update_recording_metadata(uint64_t id, time_t end_time,
     // Finalize the prepared statement
     sqlite3_finalize(stmt);
     pthread_mutex_unlock(db_mutex);
+
+    if (!is_complete) {
+        mark_recording_dirty(id);
+    }
     
     return 0;
 }
 
+// Update the size of a recording that is still being written
+int update_recording_size(uint64_t id, uint64_t size_bytes) {
+    int rc;
+    sqlite3_stmt *stmt;
+
+    sqlite3 *db = get_db_handle();
+    pthread_mutex_t *db_mutex = get_db_mutex();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    pthread_mutex_lock(db_mutex);
+
+    // Never overwrite the final size the muxer wrote when it completed the recording
+    const char *sql = "UPDATE recordings SET size_bytes = ? WHERE id = ? AND is_complete = 0;";
+
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)size_bytes);
+    sqlite3_bind_int64(stmt, 2, (sqlite3_int64)id);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        log_error("Failed to update recording size: %s", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+
+    sqlite3_finalize(stmt);
+    pthread_mutex_unlock(db_mutex);
+
+    return 0;
+}
+
+// Replace the size of a completed recording with the size of its file
+int correct_recording_size(uint64_t id, uint64_t size_bytes) {
+    int rc;
+    sqlite3_stmt *stmt;
+
+    sqlite3 *db = get_db_handle();
+    pthread_mutex_t *db_mutex = get_db_mutex();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    pthread_mutex_lock(db_mutex);
+
+    // Recordings still being written are kept current by update_recording_size
+    const char *sql = "UPDATE recordings SET size_bytes = ? WHERE id = ? AND is_complete = 1;";
+
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)size_bytes);
+    sqlite3_bind_int64(stmt, 2, (sqlite3_int64)id);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        log_error("Failed to correct recording size: %s", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+
+    sqlite3_finalize(stmt);
+    pthread_mutex_unlock(db_mutex);
+
+    return 0;
+}
+
+// Mark a recording complete with the metadata collected by the muxer
+int finalize_recording_metadata(uint64_t id, time_t end_time, uint64_t size_bytes,
+                                int width, int height, int fps, const char *codec) {
+    int rc;
+    sqlite3_stmt *stmt;
+
+    sqlite3 *db = get_db_handle();
+    pthread_mutex_t *db_mutex = get_db_mutex();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    pthread_mutex_lock(db_mutex);
+
+    // Zero/NULL parameters leave the stored values alone
+    const char *sql = "UPDATE recordings SET end_time = ?, size_bytes = ?, is_complete = 1, "
+                      "width = COALESCE(NULLIF(?, 0), width), "
+                      "height = COALESCE(NULLIF(?, 0), height), "
+                      "fps = COALESCE(NULLIF(?, 0), fps), "
+                      "codec = COALESCE(NULLIF(?, ''), codec) "
+                      "WHERE id = ?;";
+
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)end_time);
+    sqlite3_bind_int64(stmt, 2, (sqlite3_int64)size_bytes);
+    sqlite3_bind_int(stmt, 3, width);
+    sqlite3_bind_int(stmt, 4, height);
+    sqlite3_bind_int(stmt, 5, fps);
+    if (codec) {
+        sqlite3_bind_text(stmt, 6, codec, -1, SQLITE_TRANSIENT);
+    } else {
+        sqlite3_bind_null(stmt, 6);
+    }
+    sqlite3_bind_int64(stmt, 7, (sqlite3_int64)id);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        log_error("Failed to finalize recording metadata: %s", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+
+    sqlite3_finalize(stmt);
+    pthread_mutex_unlock(db_mutex);
+
+    return 0;
+}
+
 // Get recording metadata by ID
 int get_recording_metadata_by_id(uint64_t id, recording_metadata_t *metadata) {
-    int rc;
     sqlite3_stmt *stmt;
     int result = -1;
     
     sqlite3 *db = get_db_handle();
-    pthread_mutex_t *db_mutex = get_db_mutex();
     
     if (!db) {
         log_error("Database not initialized");
@@ -154,21 +305,16 @@ int get_recording_metadata_by_id(uint64_t id, recording_metadata_t *metadata) {
         return -1;
     }
     
-    pthread_mutex_lock(db_mutex);
-
     const char *sql = "SELECT id, stream_name, file_path, start_time, end_time, "
                       "size_bytes, width, height, fps, codec, is_complete, trigger_type "
                       "FROM recordings WHERE id = ?;";
 
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-        pthread_mutex_unlock(db_mutex);
+    db_read_conn_t *conn;
+    stmt = db_read_query(sql, &conn);
+    if (!stmt) {
         return -1;
     }
 
-    // No longer tracking statements - each function is responsible for finalizing its own statements
-
     // Bind parameters
     sqlite3_bind_int64(stmt, 1, (sqlite3_int64)id);
 
@@ -226,9 +372,7 @@ int get_recording_metadata_by_id(uint64_t id, recording_metadata_t *metadata) {
         result = 0; // Success
     }
     
-    // Finalize the prepared statement
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(db_mutex);
+    db_read_release(conn);
     
     return result;
 }
@@ -237,12 +381,10 @@ int get_recording_metadata_by_id(uint64_t id, recording_metadata_t *metadata) {
 int get_recording_metadata(time_t start_time, time_t end_time, 
                           const char *stream_name, recording_metadata_t *metadata, 
                           int max_count) {
-    int rc;
     sqlite3_stmt *stmt;
     int count = 0;
     
     sqlite3 *db = get_db_handle();
-    pthread_mutex_t *db_mutex = get_db_mutex();
     
     if (!db) {
         log_error("Database not initialized");
@@ -254,8 +396,6 @@ int get_recording_metadata(time_t start_time, time_t end_time,
         return -1;
     }
     
-    pthread_mutex_lock(db_mutex);
-    
     // Build query based on filters
     char sql[1024];
     strcpy(sql, "SELECT id, stream_name, file_path, start_time, end_time, "
@@ -276,14 +416,12 @@ int get_recording_metadata(time_t start_time, time_t end_time,
     
     strcat(sql, " ORDER BY start_time DESC LIMIT ?;");
     
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-        pthread_mutex_unlock(db_mutex);
+    db_read_conn_t *conn;
+    stmt = db_read_query(sql, &conn);
+    if (!stmt) {
         return -1;
     }
-    
-    // No longer tracking statements - each function is responsible for finalizing its own statements
+    db = db_read_handle(conn);
     
     // Bind parameters
     int param_index = 1;
@@ -356,9 +494,7 @@ int get_recording_metadata(time_t start_time, time_t end_time,
         log_error("Error while fetching recordings: %s", sqlite3_errmsg(db));
     }
     
-    // Finalize the prepared statement
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(db_mutex);
+    db_read_release(conn);
     
     log_info("Found %d recordings in database matching criteria", count);
     return count;
@@ -367,20 +503,16 @@ int get_recording_metadata(time_t start_time, time_t end_time,
 // Get total count of recordings matching filter criteria
 int get_recording_count(time_t start_time, time_t end_time, 
                        const char *stream_name, int has_detection) {
-    int rc;
     sqlite3_stmt *stmt;
     int count = 0;
     
     sqlite3 *db = get_db_handle();
-    pthread_mutex_t *db_mutex = get_db_mutex();
     
     if (!db) {
         log_error("Database not initialized");
         return -1;
     }
     
-    pthread_mutex_lock(db_mutex);
-    
     // Build query based on filters
     char sql[1024];
 
@@ -409,14 +541,12 @@ int get_recording_count(time_t start_time, time_t end_time,
     
     log_info("SQL query for get_recording_count: %s", sql);
     
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-        pthread_mutex_unlock(db_mutex);
+    db_read_conn_t *conn;
+    stmt = db_read_query(sql, &conn);
+    if (!stmt) {
         return -1;
     }
-    
-    // No longer tracking statements - each function is responsible for finalizing its own statements
+    db = db_read_handle(conn);
     
     // Bind parameters
     int param_index = 1;
@@ -441,9 +571,7 @@ int get_recording_count(time_t start_time, time_t end_time,
         count = -1;
     }
     
-    // Finalize the prepared statement
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(db_mutex);
+    db_read_release(conn);
     
     log_info("Total count of recordings matching criteria: %d", count);
     return count;
@@ -455,12 +583,10 @@ int get_recording_metadata_paginated(time_t start_time, time_t end_time,
                                    const char *sort_field, const char *sort_order,
                                    recording_metadata_t *metadata, 
                                    int limit, int offset) {
-    int rc;
     sqlite3_stmt *stmt;
     int count = 0;
     
     sqlite3 *db = get_db_handle();
-    pthread_mutex_t *db_mutex = get_db_mutex();
     
     if (!db) {
         log_error("Database not initialized");
@@ -472,8 +598,6 @@ int get_recording_metadata_paginated(time_t start_time, time_t end_time,
         return -1;
     }
     
-    pthread_mutex_lock(db_mutex);
-    
     // Validate and sanitize sort field to prevent SQL injection
     char safe_sort_field[32] = "start_time"; // Default sort field
     if (sort_field) {
@@ -542,14 +666,12 @@ int get_recording_metadata_paginated(time_t start_time, time_t end_time,
     
     log_info("SQL query for get_recording_metadata_paginated: %s", sql);
     
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-        pthread_mutex_unlock(db_mutex);
+    db_read_conn_t *conn;
+    stmt = db_read_query(sql, &conn);
+    if (!stmt) {
         return -1;
     }
-    
-    // No longer tracking statements - each function is responsible for finalizing its own statements
+    db = db_read_handle(conn);
     
     // Bind parameters
     int param_index = 1;
@@ -632,9 +754,7 @@ int get_recording_metadata_paginated(time_t start_time, time_t end_time,
         log_error("Error while fetching recordings: %s", sqlite3_errmsg(db));
     }
     
-    // Finalize the prepared statement
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(db_mutex);
+    db_read_release(conn);
     
     log_info("Found %d recordings in database matching criteria (page %d, limit %d)", 
              count, (offset / limit) + 1, limit);
@@ -733,3 +853,565 @@ int delete_old_recording_metadata(uint64_t max_age) {
     
     return deleted_count;
 }
+
+// Number of IDs bound per statement, below SQLite's oldest variable limit of 999
+#define DELETE_ID_CHUNK_SIZE 500
+
+// DELETE ... RETURNING needs SQLite 3.35
+#define SQLITE_RETURNING_VERSION 3035000
+
+/**
+ * Append a file path to a growing list
+ */
+static int append_recording_path(char ***paths, int *count, int *capacity, const char *path) {
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 256;
+        char **grown = realloc(*paths, new_capacity * sizeof(char *));
+        if (!grown) {
+            return -1;
+        }
+        *paths = grown;
+        *capacity = new_capacity;
+    }
+
+    (*paths)[*count] = strdup(path ? path : "");
+    if (!(*paths)[*count]) {
+        return -1;
+    }
+    (*count)++;
+    return 0;
+}
+
+/**
+ * Delete the recordings matched by a WHERE clause and collect their file paths,
+ * caller holds the transaction
+ *
+ * @param where WHERE clause with ? placeholders
+ * @param bind Binds the placeholders of a prepared statement
+ * @return 0 on success, -1 on error
+ */
+static int delete_recordings_where(const char *where, void (*bind)(sqlite3_stmt *, const void *),
+                                   const void *bind_data, char ***paths, int *count, int *capacity) {
+    sqlite3 *db = get_db_handle();
+    bool returning = sqlite3_libversion_number() >= SQLITE_RETURNING_VERSION;
+    sqlite3_stmt *stmt;
+    char sql[DELETE_ID_CHUNK_SIZE * 2 + 256];
+    int rc;
+
+    // Older SQLite reads the paths first, the transaction keeps both statements consistent
+    if (returning) {
+        snprintf(sql, sizeof(sql), "DELETE FROM recordings WHERE %s RETURNING file_path;", where);
+    } else {
+        snprintf(sql, sizeof(sql), "SELECT file_path FROM recordings WHERE %s;", where);
+    }
+
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+    bind(stmt, bind_data);
+
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (append_recording_path(paths, count, capacity, (const char *)sqlite3_column_text(stmt, 0)) != 0) {
+            log_error("Failed to allocate memory for recording paths");
+            sqlite3_finalize(stmt);
+            return -1;
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_DONE) {
+        log_error("Failed to delete recordings: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+
+    if (returning) {
+        return 0;
+    }
+
+    snprintf(sql, sizeof(sql), "DELETE FROM recordings WHERE %s;", where);
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+    bind(stmt, bind_data);
+
+    rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        log_error("Failed to delete recordings: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+
+    return 0;
+}
+
+typedef struct {
+    const uint64_t *ids;
+    int count;
+} id_chunk_t;
+
+static void bind_id_chunk(sqlite3_stmt *stmt, const void *data) {
+    const id_chunk_t *chunk = data;
+    for (int i = 0; i < chunk->count; i++) {
+        sqlite3_bind_int64(stmt, i + 1, (sqlite3_int64)chunk->ids[i]);
+    }
+}
+
+// Delete a list of recordings in one transaction
+int delete_recordings_by_ids(const uint64_t *ids, int id_count, char ***file_paths) {
+    char **paths = NULL;
+    int count = 0;
+    int capacity = 0;
+
+    if (!ids || id_count < 0 || !file_paths) {
+        log_error("Invalid parameters for delete_recordings_by_ids");
+        return -1;
+    }
+    *file_paths = NULL;
+
+    if (begin_transaction() != 0) {
+        log_error("Failed to begin transaction for deleting recordings");
+        return -1;
+    }
+
+    for (int offset = 0; offset < id_count; offset += DELETE_ID_CHUNK_SIZE) {
+        id_chunk_t chunk = {
+            .ids = ids + offset,
+            .count = id_count - offset < DELETE_ID_CHUNK_SIZE ? id_count - offset : DELETE_ID_CHUNK_SIZE
+        };
+
+        char where[DELETE_ID_CHUNK_SIZE * 2 + 16] = "id IN (";
+        size_t len = strlen(where);
+        for (int i = 0; i < chunk.count; i++) {
+            where[len++] = '?';
+            where[len++] = i + 1 < chunk.count ? ',' : ')';
+        }
+        where[len] = '\0';
+
+        if (delete_recordings_where(where, bind_id_chunk, &chunk, &paths, &count, &capacity) != 0) {
+            rollback_transaction();
+            free_recording_paths(paths, count);
+            return -1;
+        }
+    }
+
+    if (commit_transaction() != 0) {
+        free_recording_paths(paths, count);
+        return -1;
+    }
+
+    *file_paths = paths;
+    return count;
+}
+
+typedef struct {
+    time_t start_time;
+    time_t end_time;
+    const char *stream_name;
+} recording_filter_t;
+
+static void bind_recording_filter(sqlite3_stmt *stmt, const void *data) {
+    const recording_filter_t *filter = data;
+    int param_index = 1;
+
+    if (filter->start_time > 0) {
+        sqlite3_bind_int64(stmt, param_index++, (sqlite3_int64)filter->start_time);
+    }
+    if (filter->end_time > 0) {
+        sqlite3_bind_int64(stmt, param_index++, (sqlite3_int64)filter->end_time);
+    }
+    if (filter->stream_name) {
+        sqlite3_bind_text(stmt, param_index++, filter->stream_name, -1, SQLITE_STATIC);
+    }
+}
+
+// Delete the recordings matching a filter in one transaction
+int delete_recordings_by_filter(time_t start_time, time_t end_time, const char *stream_name,
+                                int has_detection, char ***file_paths) {
+    char **paths = NULL;
+    int count = 0;
+    int capacity = 0;
+
+    if (!file_paths) {
+        log_error("Invalid parameters for delete_recordings_by_filter");
+        return -1;
+    }
+    *file_paths = NULL;
+
+    // Same conditions as get_recording_count(), so the job total matches what is deleted
+    char where[256] = "is_complete = 1 AND end_time IS NOT NULL";
+    if (has_detection) {
+        strcat(where, " AND trigger_type = 'detection'");
+    }
+    if (start_time > 0) {
+        strcat(where, " AND start_time >= ?");
+    }
+    if (end_time > 0) {
+        strcat(where, " AND start_time <= ?");
+    }
+    if (stream_name) {
+        strcat(where, " AND stream_name = ?");
+    }
+
+    recording_filter_t filter = {
+        .start_time = start_time,
+        .end_time = end_time,
+        .stream_name = stream_name
+    };
+
+    if (begin_transaction() != 0) {
+        log_error("Failed to begin transaction for deleting recordings");
+        return -1;
+    }
+
+    if (delete_recordings_where(where, bind_recording_filter, &filter, &paths, &count, &capacity) != 0) {
+        rollback_transaction();
+        free_recording_paths(paths, count);
+        return -1;
+    }
+
+    if (commit_transaction() != 0) {
+        free_recording_paths(paths, count);
+        return -1;
+    }
+
+    *file_paths = paths;
+    return count;
+}
+
+// Free the paths returned by a batch delete
+void free_recording_paths(char **file_paths, int count) {
+    if (!file_paths) {
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        free(file_paths[i]);
+    }
+    free(file_paths);
+}
+
+// Get the oldest complete recordings, for retention
+int get_oldest_recordings(const char *stream_name, time_t before,
+                          recording_metadata_t *metadata, int max_count) {
+    int rc;
+    sqlite3_stmt *stmt;
+    int count = 0;
+
+    sqlite3 *db = get_db_handle();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    if (!metadata || max_count <= 0) {
+        log_error("Invalid parameters for get_oldest_recordings");
+        return -1;
+    }
+
+    // Both variants can walk a start_time index and stop after max_count rows
+    const char *sql = stream_name ?
+        "SELECT id, stream_name, file_path, start_time, end_time, size_bytes "
+        "FROM recordings "
+        "WHERE stream_name = ? AND start_time < ? AND is_complete = 1 "
+        "ORDER BY start_time ASC LIMIT ?;" :
+        "SELECT id, stream_name, file_path, start_time, end_time, size_bytes "
+        "FROM recordings "
+        "WHERE start_time < ? AND is_complete = 1 "
+        "ORDER BY start_time ASC LIMIT ?;";
+
+    db_read_conn_t *conn;
+    stmt = db_read_query(sql, &conn);
+    if (!stmt) {
+        return -1;
+    }
+
+    int param = 1;
+    if (stream_name) {
+        sqlite3_bind_text(stmt, param++, stream_name, -1, SQLITE_STATIC);
+    }
+    sqlite3_bind_int64(stmt, param++, before > 0 ? (sqlite3_int64)before : INT64_MAX);
+    sqlite3_bind_int(stmt, param++, max_count);
+
+    while (count < max_count && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        recording_metadata_t *m = &metadata[count];
+        memset(m, 0, sizeof(*m));
+
+        m->id = (uint64_t)sqlite3_column_int64(stmt, 0);
+
+        const char *stream = (const char *)sqlite3_column_text(stmt, 1);
+        if (stream) {
+            strncpy(m->stream_name, stream, sizeof(m->stream_name) - 1);
+        }
+
+        const char *path = (const char *)sqlite3_column_text(stmt, 2);
+        if (path) {
+            strncpy(m->file_path, path, sizeof(m->file_path) - 1);
+        }
+
+        m->start_time = (time_t)sqlite3_column_int64(stmt, 3);
+        m->end_time = (time_t)sqlite3_column_int64(stmt, 4);
+        m->size_bytes = (uint64_t)sqlite3_column_int64(stmt, 5);
+        m->is_complete = true;
+
+        count++;
+    }
+    db_read_release(conn);
+
+    return count;
+}
+
+// Get the total size of the recordings of a stream, or of all streams
+int64_t get_recordings_total_size(const char *stream_name) {
+    int rc;
+    sqlite3_stmt *stmt;
+    int64_t total = -1;
+
+    sqlite3 *db = get_db_handle();
+    pthread_mutex_t *db_mutex = get_db_mutex();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    pthread_mutex_lock(db_mutex);
+
+    // Read the trigger-maintained counters instead of summing the recordings
+    const char *sql = stream_name ?
+        "SELECT COALESCE(SUM(size_bytes), 0) FROM stream_storage_usage WHERE stream_name = ?;" :
+        "SELECT COALESCE(SUM(size_bytes), 0) FROM stream_storage_usage;";
+
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+
+    if (stream_name) {
+        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
+    }
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        total = sqlite3_column_int64(stmt, 0);
+    }
+
+    sqlite3_finalize(stmt);
+    pthread_mutex_unlock(db_mutex);
+
+    return total;
+}
+
+// Get the per-stream storage counters
+int get_recording_storage_usage(recording_storage_usage_t *usage, int max_count) {
+    sqlite3_stmt *stmt;
+    int count = 0;
+
+    sqlite3 *db = get_db_handle();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    if (!usage || max_count <= 0) {
+        log_error("Invalid parameters for get_recording_storage_usage");
+        return -1;
+    }
+
+    const char *sql =
+        "SELECT stream_name, size_bytes, recording_count FROM stream_storage_usage "
+        "WHERE recording_count > 0 ORDER BY stream_name LIMIT ?;";
+
+    db_read_conn_t *conn;
+    stmt = db_read_query(sql, &conn);
+    if (!stmt) {
+        return -1;
+    }
+
+    sqlite3_bind_int(stmt, 1, max_count);
+
+    while (count < max_count && sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *name = (const char *)sqlite3_column_text(stmt, 0);
+        if (!name) {
+            continue;
+        }
+
+        strncpy(usage[count].stream_name, name, sizeof(usage[count].stream_name) - 1);
+        usage[count].stream_name[sizeof(usage[count].stream_name) - 1] = '\0';
+        usage[count].size_bytes = (uint64_t)sqlite3_column_int64(stmt, 1);
+        usage[count].recording_count = sqlite3_column_int(stmt, 2);
+        count++;
+    }
+    db_read_release(conn);
+
+    return count;
+}
+
+// Rebuild the per-stream storage counters from the recordings table if they drifted
+int reconcile_recording_storage_usage(void) {
+    int rc;
+    sqlite3_stmt *stmt;
+    char *err_msg = NULL;
+    int drifted = -1;
+
+    sqlite3 *db = get_db_handle();
+    pthread_mutex_t *db_mutex = get_db_mutex();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    // Count the streams whose counters disagree with the recordings, in either direction
+    const char *check_sql =
+        "WITH actual AS ("
+        "  SELECT stream_name, COALESCE(SUM(size_bytes), 0) AS size_bytes, COUNT(*) AS recording_count "
+        "  FROM recordings WHERE stream_name IS NOT NULL GROUP BY stream_name) "
+        "SELECT "
+        "  (SELECT COUNT(*) FROM actual a LEFT JOIN stream_storage_usage u ON u.stream_name = a.stream_name "
+        "   WHERE u.stream_name IS NULL OR u.size_bytes != a.size_bytes OR u.recording_count != a.recording_count) + "
+        "  (SELECT COUNT(*) FROM stream_storage_usage u "
+        "   WHERE (u.size_bytes != 0 OR u.recording_count != 0) "
+        "   AND NOT EXISTS (SELECT 1 FROM actual a WHERE a.stream_name = u.stream_name));";
+
+    const char *rebuild_sql =
+        "BEGIN TRANSACTION;"
+        "DELETE FROM stream_storage_usage;"
+        "INSERT INTO stream_storage_usage (stream_name, size_bytes, recording_count) "
+        "SELECT stream_name, COALESCE(SUM(size_bytes), 0), COUNT(*) FROM recordings "
+        "WHERE stream_name IS NOT NULL GROUP BY stream_name;"
+        "COMMIT;";
+
+    // The aggregate scans the whole table, so it runs beside the writer rather than under its lock
+    db_read_conn_t *conn;
+    stmt = db_read_query(check_sql, &conn);
+    if (!stmt) {
+        return -1;
+    }
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        drifted = sqlite3_column_int(stmt, 0);
+    }
+    db_read_release(conn);
+
+    if (drifted > 0) {
+        // Only a drift, which is rare, takes the writer lock for the rebuild
+        pthread_mutex_lock(db_mutex);
+        rc = sqlite3_exec(db, rebuild_sql, NULL, NULL, &err_msg);
+        if (rc != SQLITE_OK) {
+            log_error("Failed to rebuild storage counters: %s", err_msg);
+            if (err_msg) {
+                sqlite3_free(err_msg);
+            }
+            sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+            drifted = -1;
+        } else {
+            log_warn("Storage counters for %d stream(s) had drifted and were rebuilt", drifted);
+        }
+        pthread_mutex_unlock(db_mutex);
+    }
+
+    return drifted;
+}
+
+// Get the names of the streams that have recordings
+int get_recording_stream_names(char (*names)[64], int max_count) {
+    sqlite3_stmt *stmt;
+    int count = 0;
+
+    sqlite3 *db = get_db_handle();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    if (!names || max_count <= 0) {
+        log_error("Invalid parameters for get_recording_stream_names");
+        return -1;
+    }
+
+    // One index seek per name instead of a DISTINCT scan over every recording
+    const char *sql = "SELECT MIN(stream_name) FROM recordings WHERE stream_name > ?;";
+
+    db_read_conn_t *conn;
+    stmt = db_read_query(sql, &conn);
+    if (!stmt) {
+        return -1;
+    }
+
+    char previous[256] = "";
+    while (count < max_count) {
+        sqlite3_bind_text(stmt, 1, previous, -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) != SQLITE_ROW || sqlite3_column_type(stmt, 0) == SQLITE_NULL) {
+            break;
+        }
+
+        const char *name = (const char *)sqlite3_column_text(stmt, 0);
+        strncpy(previous, name, sizeof(previous) - 1);
+        previous[sizeof(previous) - 1] = '\0';
+        strncpy(names[count], name, 63);
+        names[count][63] = '\0';
+        count++;
+
+        sqlite3_reset(stmt);
+    }
+    db_read_release(conn);
+
+    return count;
+}
+
+// Get a page of recording files ordered by ID, starting after a cursor
+int get_recording_files_after_id(uint64_t after_id, recording_file_info_t *files, int max_count) {
+    sqlite3_stmt *stmt;
+    int count = 0;
+
+    sqlite3 *db = get_db_handle();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    if (!files || max_count <= 0) {
+        log_error("Invalid parameters for get_recording_files_after_id");
+        return -1;
+    }
+
+    // Primary key range scan, the cost is bounded by the page size not the table size
+    const char *sql = "SELECT id, file_path, size_bytes, is_complete FROM recordings "
+                      "WHERE id > ? ORDER BY id LIMIT ?;";
+
+    db_read_conn_t *conn;
+    stmt = db_read_query(sql, &conn);
+    if (!stmt) {
+        return -1;
+    }
+
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)after_id);
+    sqlite3_bind_int(stmt, 2, max_count);
+
+    while (count < max_count && sqlite3_step(stmt) == SQLITE_ROW) {
+        recording_file_info_t *file = &files[count];
+        memset(file, 0, sizeof(*file));
+
+        file->id = (uint64_t)sqlite3_column_int64(stmt, 0);
+
+        const char *path = (const char *)sqlite3_column_text(stmt, 1);
+        if (path) {
+            strncpy(file->file_path, path, sizeof(file->file_path) - 1);
+        }
+
+        file->size_bytes = (uint64_t)sqlite3_column_int64(stmt, 2);
+        file->is_complete = sqlite3_column_int(stmt, 3) != 0;
+        count++;
+    }
+    db_read_release(conn);
+
+    return count;
+}
@@ -2,8 +2,13 @@
  * Database Recordings Synchronization
  * 
  * This module provides functionality to synchronize recording metadata in the database
- * with actual file sizes on disk. This ensures that the web interface displays accurate
- * file sizes even if the database wasn't updated during recording.
+ * with actual file sizes on disk. Completed recordings get their final size from the
+ * muxer when they are closed, so only recordings still being written are checked.
+ *
+ * Writers mark the recordings they create or extend as dirty, and each interval
+ * the sync thread only visits the dirty set. A slow background verification
+ * walks the table by ID one page per interval to pick up recordings left
+ * incomplete by a crash, so neither memory nor I/O grows with the archive.
  */
 
 #include <stdio.h>
@@ -17,6 +22,13 @@
 #include "core/logger.h"
 #include "database/database_manager.h"
 #include "database/db_recordings.h"
+#include "database/db_recordings_sync.h"
+
+// Recordings checked by the background verification per interval
+#define SYNC_VERIFY_PAGE_SIZE 256
+
+// Initial capacity of the dirty set, a power of two
+#define DIRTY_SET_INITIAL_CAPACITY 64
 
 // Thread state
 static struct {
@@ -24,15 +36,108 @@ static struct {
     bool running;
     int interval_seconds;
     pthread_mutex_t mutex;
+    uint64_t verify_cursor;
 } sync_thread = {
     .running = false,
     .interval_seconds = 60, // Default to 1 minute
+    .verify_cursor = 0,
+};
+
+// Open-addressed set of recording IDs waiting to be synced, 0 marks a free slot
+static struct {
+    pthread_mutex_t mutex;
+    uint64_t *ids;
+    size_t capacity;
+    size_t count;
+} dirty_set = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .ids = NULL,
+    .capacity = 0,
+    .count = 0,
 };
 
+static size_t dirty_slot(uint64_t id, size_t capacity) {
+    return (size_t)((id * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity - 1);
+}
+
+/**
+ * Insert an ID into a table known to have a free slot
+ */
+static bool dirty_insert(uint64_t *ids, size_t capacity, uint64_t id) {
+    size_t slot = dirty_slot(id, capacity);
+    while (ids[slot] != 0) {
+        if (ids[slot] == id) {
+            return false;
+        }
+        slot = (slot + 1) & (capacity - 1);
+    }
+    ids[slot] = id;
+    return true;
+}
+
+/**
+ * Mark a recording as needing a size sync
+ */
+void mark_recording_dirty(uint64_t recording_id) {
+    if (recording_id == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&dirty_set.mutex);
+
+    // Keep the load factor at or below one half
+    if ((dirty_set.count + 1) * 2 > dirty_set.capacity) {
+        size_t capacity = dirty_set.capacity ? dirty_set.capacity * 2 : DIRTY_SET_INITIAL_CAPACITY;
+        uint64_t *ids = calloc(capacity, sizeof(uint64_t));
+        if (!ids) {
+            pthread_mutex_unlock(&dirty_set.mutex);
+            log_error("Failed to grow recording dirty set, recording %llu left to verification",
+                     (unsigned long long)recording_id);
+            return;
+        }
+        for (size_t i = 0; i < dirty_set.capacity; i++) {
+            if (dirty_set.ids[i] != 0) {
+                dirty_insert(ids, capacity, dirty_set.ids[i]);
+            }
+        }
+        free(dirty_set.ids);
+        dirty_set.ids = ids;
+        dirty_set.capacity = capacity;
+    }
+
+    if (dirty_insert(dirty_set.ids, dirty_set.capacity, recording_id)) {
+        dirty_set.count++;
+    }
+
+    pthread_mutex_unlock(&dirty_set.mutex);
+}
+
+/**
+ * Take the whole dirty set, leaving it empty for writers
+ *
+ * @param capacity Receives the number of slots in the returned table
+ * @return Table of IDs (free slots are 0) to be freed by the caller, or NULL if empty
+ */
+static uint64_t *take_dirty_set(size_t *capacity) {
+    pthread_mutex_lock(&dirty_set.mutex);
+    uint64_t *ids = dirty_set.count > 0 ? dirty_set.ids : NULL;
+    *capacity = ids ? dirty_set.capacity : 0;
+    if (ids) {
+        dirty_set.ids = NULL;
+        dirty_set.capacity = 0;
+        dirty_set.count = 0;
+    }
+    pthread_mutex_unlock(&dirty_set.mutex);
+    return ids;
+}
+
 /**
  * Synchronize a single recording's file size with the database
+ *
+ * @return 1 if updated, 0 if unchanged, -1 if the file is missing or the update failed
  */
-static int sync_recording_file_size(uint64_t recording_id, const char *file_path) {
+static int sync_recording_file_size(uint64_t recording_id, const char *file_path,
+                                    uint64_t stored_size) {
     struct stat st;
     
     // Check if file exists and get its size
@@ -42,87 +147,138 @@ static int sync_recording_file_size(uint64_t recording_id, const char *file_path
         return -1;
     }
     
-    // Only update if file has non-zero size
-    if (st.st_size > 0) {
-        // Get current metadata from database
-        recording_metadata_t metadata;
-        if (get_recording_metadata_by_id(recording_id, &metadata) != 0) {
-            log_error("Failed to get metadata for recording %llu", 
+    // Only update if file has non-zero size and the size in database is different
+    if (st.st_size > 0 && stored_size != (uint64_t)st.st_size) {
+        log_info("Syncing file size for recording %llu: %llu bytes (was %llu bytes)",
+                (unsigned long long)recording_id, 
+                (unsigned long long)st.st_size,
+                (unsigned long long)stored_size);
+        
+        if (update_recording_size(recording_id, (uint64_t)st.st_size) != 0) {
+            log_error("Failed to update file size for recording %llu", 
                      (unsigned long long)recording_id);
             return -1;
         }
         
-        // Only update if the size in database is different
-        if (metadata.size_bytes != (uint64_t)st.st_size) {
-            log_info("Syncing file size for recording %llu: %llu bytes (was %llu bytes)",
-                    (unsigned long long)recording_id, 
-                    (unsigned long long)st.st_size,
-                    (unsigned long long)metadata.size_bytes);
-            
-            // Update the database with the actual file size
-            // Don't change end_time or is_complete status
-            if (update_recording_metadata(recording_id, metadata.end_time, 
-                                        (uint64_t)st.st_size, metadata.is_complete) != 0) {
-                log_error("Failed to update file size for recording %llu", 
-                         (unsigned long long)recording_id);
-                return -1;
-            }
-            
-            return 1; // Updated
-        }
+        return 1; // Updated
     }
     
     return 0; // No update needed
 }
 
 /**
- * Synchronize all recordings in the database with their file sizes
+ * Synchronize the recordings marked dirty since the last pass
+ *
+ * Recordings still being written stay in the set until they complete.
  */
-static int sync_all_recordings(void) {
+static int sync_dirty_recordings(int *error_count) {
+    size_t capacity = 0;
+    uint64_t *ids = take_dirty_set(&capacity);
     int updated_count = 0;
-    int error_count = 0;
 
-    // First get the count of recordings
-    int total_count = get_recording_count(0, 0, NULL, 0);
+    for (size_t i = 0; i < capacity; i++) {
+        if (ids[i] == 0) {
+            continue;
+        }
 
-    if (total_count < 0) {
-        log_error("Failed to get recording count from database for sync");
-        return -1;
-    }
+        // Deleted or completed recordings drop out of the set
+        recording_metadata_t metadata;
+        if (get_recording_metadata_by_id(ids[i], &metadata) != 0 || metadata.is_complete) {
+            continue;
+        }
 
-    if (total_count == 0) {
-        log_debug("No recordings to sync");
-        return 0;
+        int result = sync_recording_file_size(metadata.id, metadata.file_path, metadata.size_bytes);
+        if (result > 0) {
+            updated_count++;
+        } else if (result < 0) {
+            (*error_count)++;
+            continue;
+        }
+        mark_recording_dirty(metadata.id);
     }
 
-    // Allocate memory for recordings
-    recording_metadata_t *recordings = (recording_metadata_t *)malloc(total_count * sizeof(recording_metadata_t));
-    if (!recordings) {
+    free(ids);
+    return updated_count;
+}
+
+/**
+ * Verify one page of the recordings table after the cursor
+ *
+ * @param cursor ID to continue after, advanced past the page (reset to 0 at the end)
+ * @return Number of recordings updated, or -1 on error
+ */
+static int verify_recording_page(uint64_t *cursor, int *error_count) {
+    int updated_count = 0;
+
+    recording_file_info_t *files = malloc(SYNC_VERIFY_PAGE_SIZE * sizeof(recording_file_info_t));
+    if (!files) {
         log_error("Failed to allocate memory for recordings sync");
         return -1;
     }
 
-    // Get recordings with allocated memory
-    int count = get_recording_metadata_paginated(0, 0, NULL, 0, "id", "asc",
-                                                recordings, total_count, 0);
-
+    int count = get_recording_files_after_id(*cursor, files, SYNC_VERIFY_PAGE_SIZE);
     if (count < 0) {
         log_error("Failed to get recordings from database for sync");
-        free(recordings);
+        free(files);
         return -1;
     }
 
-    // Sync each recording
     for (int i = 0; i < count; i++) {
-        int result = sync_recording_file_size(recordings[i].id, recordings[i].file_path);
+        if (files[i].is_complete) {
+            continue;
+        }
+
+        int result = sync_recording_file_size(files[i].id, files[i].file_path, files[i].size_bytes);
         if (result > 0) {
             updated_count++;
         } else if (result < 0) {
-            error_count++;
+            (*error_count)++;
+            continue;
         }
+        // Track it like any other recording in progress from now on
+        mark_recording_dirty(files[i].id);
+    }
+
+    *cursor = (count < SYNC_VERIFY_PAGE_SIZE) ? 0 : files[count - 1].id;
+    free(files);
+    return updated_count;
+}
+
+/**
+ * One sync pass: the dirty set, then one verification page
+ */
+static int sync_recordings_pass(void) {
+    int error_count = 0;
+    int updated_count = sync_dirty_recordings(&error_count);
+
+    int verified = verify_recording_page(&sync_thread.verify_cursor, &error_count);
+    if (verified > 0) {
+        updated_count += verified;
+    }
+
+    if (updated_count > 0 || error_count > 0) {
+        log_info("Recording sync complete: %d updated, %d errors",
+                updated_count, error_count);
     }
 
-    free(recordings);
+    return updated_count;
+}
+
+/**
+ * Synchronize the dirty set and verify the whole table page by page
+ */
+static int sync_all_recordings(void) {
+    int error_count = 0;
+    int updated_count = sync_dirty_recordings(&error_count);
+    uint64_t cursor = 0;
+
+    do {
+        int verified = verify_recording_page(&cursor, &error_count);
+        if (verified < 0) {
+            return -1;
+        }
+        updated_count += verified;
+    } while (cursor != 0);
 
     if (updated_count > 0 || error_count > 0) {
         log_info("Recording sync complete: %d updated, %d errors",
@@ -139,7 +295,7 @@ static void *sync_thread_func(void *arg) {
     log_info("Recording sync thread started with interval: %d seconds", 
             sync_thread.interval_seconds);
     
-    // Initial sync
+    // Initial sync walks the whole table once to pick up recordings a crash left incomplete
     log_info("Performing initial recording sync");
     sync_all_recordings();
     
@@ -153,8 +309,8 @@ static void *sync_thread_func(void *arg) {
             break;
         }
         
-        // Sync recordings
-        sync_all_recordings();
+        // Sync dirty recordings and advance the verification cursor
+        sync_recordings_pass();
     }
     
     log_info("Recording sync thread exiting");
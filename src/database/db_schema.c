@@ -16,7 +16,7 @@
 #include "core/logger.h"
 
 // Current schema version - increment this when adding new migrations
-#define CURRENT_SCHEMA_VERSION 10
+#define CURRENT_SCHEMA_VERSION 12
 
 // Migration function type
 typedef int (*migration_func_t)(void);
@@ -31,6 +31,8 @@ static int migration_v6_to_v7(void);
 static int migration_v7_to_v8(void);
 static int migration_v8_to_v9(void);
 static int migration_v9_to_v10(void);
+static int migration_v10_to_v11(void);
+static int migration_v11_to_v12(void);
 
 // Array of migration functions
 static migration_func_t migrations[] = {
@@ -43,7 +45,9 @@ static migration_func_t migrations[] = {
     migration_v6_to_v7, // v6->v7
     migration_v7_to_v8, // v7->v8
     migration_v8_to_v9, // v8->v9
-    migration_v9_to_v10 // v9->v10
+    migration_v9_to_v10, // v9->v10
+    migration_v10_to_v11, // v10->v11
+    migration_v11_to_v12 // v11->v12
 };
 
 /**
@@ -849,3 +853,111 @@ static int migration_v9_to_v10(void) {
     log_info("Completed migration v9 to v10 successfully");
     return 0;
 }
+
+/**
+ * Migration from version 10 to 11
+ * - Add per-stream retention columns to streams table
+ *
+ * Oldest-first retention lookups use idx_recordings_complete_stream_start.
+ */
+static int migration_v10_to_v11(void) {
+    log_info("Running migration from v10 to v11: Adding per-stream retention settings");
+
+    int rc = 0;
+
+    sqlite3 *db = get_db_handle();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    // 0 means use the global retention_days setting
+    log_info("Adding retention_days column to streams table");
+    rc |= add_column_if_not_exists("streams", "retention_days", "INTEGER DEFAULT 0");
+
+    // 0 means no per-stream quota
+    log_info("Adding max_storage_mb column to streams table");
+    rc |= add_column_if_not_exists("streams", "max_storage_mb", "INTEGER DEFAULT 0");
+
+    if (rc != 0) {
+        log_error("Failed to add retention columns to streams table");
+        return -1;
+    }
+
+    log_info("Completed migration v10 to v11 successfully");
+    return 0;
+}
+
+/**
+ * Migration from version 11 to 12
+ * - Add stream_storage_usage table with per-stream byte and recording counters
+ * - Add triggers keeping the counters in step with the recordings table
+ * - Seed the counters from the existing recordings
+ */
+static int migration_v11_to_v12(void) {
+    log_info("Running migration from v11 to v12: Adding per-stream storage counters");
+
+    char *err_msg = NULL;
+
+    sqlite3 *db = get_db_handle();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    // The triggers run inside the statement that changes the recording, so the
+    // counters can never miss a finalized or deleted segment
+    const char *statements[] = {
+        "CREATE TABLE IF NOT EXISTS stream_storage_usage ("
+        "stream_name TEXT PRIMARY KEY,"
+        "size_bytes INTEGER NOT NULL DEFAULT 0,"
+        "recording_count INTEGER NOT NULL DEFAULT 0"
+        ");",
+
+        "CREATE TRIGGER IF NOT EXISTS trg_recordings_usage_insert AFTER INSERT ON recordings "
+        "BEGIN "
+        "INSERT OR IGNORE INTO stream_storage_usage (stream_name) VALUES (NEW.stream_name); "
+        "UPDATE stream_storage_usage SET size_bytes = size_bytes + COALESCE(NEW.size_bytes, 0), "
+        "recording_count = recording_count + 1 WHERE stream_name = NEW.stream_name; "
+        "END;",
+
+        "CREATE TRIGGER IF NOT EXISTS trg_recordings_usage_update AFTER UPDATE OF size_bytes, stream_name ON recordings "
+        "WHEN OLD.size_bytes IS NOT NEW.size_bytes OR OLD.stream_name IS NOT NEW.stream_name "
+        "BEGIN "
+        "UPDATE stream_storage_usage SET size_bytes = size_bytes - COALESCE(OLD.size_bytes, 0), "
+        "recording_count = recording_count - 1 WHERE stream_name = OLD.stream_name; "
+        "INSERT OR IGNORE INTO stream_storage_usage (stream_name) VALUES (NEW.stream_name); "
+        "UPDATE stream_storage_usage SET size_bytes = size_bytes + COALESCE(NEW.size_bytes, 0), "
+        "recording_count = recording_count + 1 WHERE stream_name = NEW.stream_name; "
+        "END;",
+
+        "CREATE TRIGGER IF NOT EXISTS trg_recordings_usage_delete AFTER DELETE ON recordings "
+        "BEGIN "
+        "UPDATE stream_storage_usage SET size_bytes = size_bytes - COALESCE(OLD.size_bytes, 0), "
+        "recording_count = recording_count - 1 WHERE stream_name = OLD.stream_name; "
+        "END;",
+
+        "DELETE FROM stream_storage_usage;",
+
+        "INSERT INTO stream_storage_usage (stream_name, size_bytes, recording_count) "
+        "SELECT stream_name, COALESCE(SUM(size_bytes), 0), COUNT(*) FROM recordings "
+        "WHERE stream_name IS NOT NULL GROUP BY stream_name;"
+    };
+
+    for (size_t i = 0; i < sizeof(statements) / sizeof(statements[0]); i++) {
+        int rc = sqlite3_exec(db, statements[i], NULL, NULL, &err_msg);
+        if (rc != SQLITE_OK) {
+            log_error("Failed to create storage counters: %s", err_msg);
+            if (err_msg) {
+                sqlite3_free(err_msg);
+                err_msg = NULL;
+            }
+            return -1;
+        }
+    }
+
+    log_info("Completed migration v11 to v12 successfully");
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "database/db_stream_registry.h"
+#include "database/db_streams.h"
+#include "core/logger.h"
+
+// Serializes loading and reloading, taken before the database mutex
+static pthread_mutex_t registry_write_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Protects the table itself, writers hold it only while copying
+static pthread_rwlock_t registry_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static stream_config_t *registry_streams = NULL;
+static int registry_count = 0;
+static int registry_capacity = 0;
+
+static atomic_bool registry_loaded;
+static _Atomic uint64_t registry_generation;
+
+static int registry_find(const char *name) {
+    for (int i = 0; i < registry_count; i++) {
+        if (strcmp(registry_streams[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void registry_bump_generation(void) {
+    atomic_fetch_add_explicit(&registry_generation, 1, memory_order_release);
+}
+
+/**
+ * Load the whole streams table, caller holds registry_write_mutex
+ */
+static void registry_load_locked(void) {
+    if (atomic_load_explicit(&registry_loaded, memory_order_acquire)) {
+        return;
+    }
+
+    int total = count_stream_configs();
+    if (total < 0) {
+        return;
+    }
+
+    // Leave room for streams added later without reallocating right away
+    int capacity = total + MAX_STREAMS;
+    stream_config_t *streams = calloc(capacity, sizeof(stream_config_t));
+    if (!streams) {
+        log_error("Failed to allocate stream registry");
+        return;
+    }
+
+    int count = total > 0 ? get_all_stream_configs(streams, total) : 0;
+    if (count < 0) {
+        free(streams);
+        return;
+    }
+
+    pthread_rwlock_wrlock(&registry_lock);
+    free(registry_streams);
+    registry_streams = streams;
+    registry_count = count;
+    registry_capacity = capacity;
+    registry_bump_generation();
+    atomic_store_explicit(&registry_loaded, true, memory_order_release);
+    pthread_rwlock_unlock(&registry_lock);
+
+    log_info("Loaded %d stream configurations into the stream registry", count);
+}
+
+static bool registry_ensure_loaded(void) {
+    if (atomic_load_explicit(&registry_loaded, memory_order_acquire)) {
+        return true;
+    }
+
+    pthread_mutex_lock(&registry_write_mutex);
+    registry_load_locked();
+    pthread_mutex_unlock(&registry_write_mutex);
+
+    return atomic_load_explicit(&registry_loaded, memory_order_acquire);
+}
+
+uint64_t stream_registry_generation(void) {
+    return atomic_load_explicit(&registry_generation, memory_order_acquire);
+}
+
+int stream_registry_get(const char *name, stream_config_t *config) {
+    if (!name || !config) {
+        return -1;
+    }
+
+    if (!registry_ensure_loaded()) {
+        // Database not ready for a full load yet, answer this lookup directly
+        return get_stream_config_from_db(name, config);
+    }
+
+    int result = -1;
+    pthread_rwlock_rdlock(&registry_lock);
+    int index = registry_find(name);
+    if (index >= 0) {
+        memcpy(config, &registry_streams[index], sizeof(stream_config_t));
+        result = 0;
+    }
+    pthread_rwlock_unlock(&registry_lock);
+
+    return result;
+}
+
+int stream_registry_refresh(const char *name, stream_config_t *config, uint64_t *generation) {
+    if (!name || !config || !generation) {
+        return -1;
+    }
+
+    uint64_t current = atomic_load_explicit(&registry_generation, memory_order_acquire);
+    if (current != 0 && current == *generation) {
+        return 0;
+    }
+
+    if (!registry_ensure_loaded()) {
+        *generation = 0;
+        return get_stream_config_from_db(name, config) == 0 ? 1 : -1;
+    }
+
+    int result = -1;
+    pthread_rwlock_rdlock(&registry_lock);
+    int index = registry_find(name);
+    if (index >= 0) {
+        memcpy(config, &registry_streams[index], sizeof(stream_config_t));
+        result = 1;
+    }
+    // Writers bump the generation while holding the write lock
+    *generation = atomic_load_explicit(&registry_generation, memory_order_relaxed);
+    pthread_rwlock_unlock(&registry_lock);
+
+    return result;
+}
+
+void stream_registry_reload(const char *name) {
+    stream_config_t config;
+
+    if (!name || name[0] == '\0') {
+        return;
+    }
+
+    pthread_mutex_lock(&registry_write_mutex);
+
+    // Nothing to update before the first load, which reads the current table
+    if (!atomic_load_explicit(&registry_loaded, memory_order_acquire)) {
+        pthread_mutex_unlock(&registry_write_mutex);
+        return;
+    }
+
+    bool exists = get_stream_config_from_db(name, &config) == 0;
+
+    pthread_rwlock_wrlock(&registry_lock);
+    int index = registry_find(name);
+    if (exists) {
+        if (index < 0 && registry_count == registry_capacity) {
+            int capacity = registry_capacity + MAX_STREAMS;
+            stream_config_t *streams = realloc(registry_streams, capacity * sizeof(stream_config_t));
+            if (!streams) {
+                // Force a full reload on the next lookup rather than serve stale data
+                log_error("Failed to grow stream registry for %s", name);
+                atomic_store_explicit(&registry_loaded, false, memory_order_release);
+                registry_bump_generation();
+                pthread_rwlock_unlock(&registry_lock);
+                pthread_mutex_unlock(&registry_write_mutex);
+                return;
+            }
+            registry_streams = streams;
+            registry_capacity = capacity;
+        }
+        if (index < 0) {
+            index = registry_count++;
+        }
+        memcpy(&registry_streams[index], &config, sizeof(stream_config_t));
+    } else if (index >= 0) {
+        registry_streams[index] = registry_streams[registry_count - 1];
+        registry_count--;
+    }
+    registry_bump_generation();
+    pthread_rwlock_unlock(&registry_lock);
+
+    pthread_mutex_unlock(&registry_write_mutex);
+
+    log_debug("Stream registry %s %s (generation %llu)", exists ? "updated" : "dropped", name,
+              (unsigned long long)stream_registry_generation());
+}
+
+void stream_registry_clear(void) {
+    pthread_mutex_lock(&registry_write_mutex);
+    pthread_rwlock_wrlock(&registry_lock);
+
+    free(registry_streams);
+    registry_streams = NULL;
+    registry_count = 0;
+    registry_capacity = 0;
+    atomic_store_explicit(&registry_loaded, false, memory_order_release);
+    registry_bump_generation();
+
+    pthread_rwlock_unlock(&registry_lock);
+    pthread_mutex_unlock(&registry_write_mutex);
+}
@@ -13,6 +13,7 @@
 #include "database/db_core.h"
 #include "database/db_schema.h"
 #include "database/db_schema_cache.h"
+#include "database/db_stream_registry.h"
 #include "core/logger.h"
 #include "core/config.h"
 
@@ -139,6 +140,7 @@ uint64_t add_stream_config(const stream_config_t *stream) {
                 stream->detection_model);
 
         pthread_mutex_unlock(db_mutex);
+        stream_registry_reload(stream->name);
         return existing_id;
     }
 
@@ -215,6 +217,10 @@ uint64_t add_stream_config(const stream_config_t *stream) {
     }
     pthread_mutex_unlock(db_mutex);
 
+    if (stream_id != 0) {
+        stream_registry_reload(stream->name);
+    }
+
     return stream_id;
 }
 
@@ -325,6 +331,12 @@ int update_stream_config(const char *name, const stream_config_t *stream) {
 
     pthread_mutex_unlock(db_mutex);
 
+    // A rename drops the old registry entry and adds the new one
+    stream_registry_reload(name);
+    if (strcmp(name, stream->name) != 0) {
+        stream_registry_reload(stream->name);
+    }
+
     return 0;
 }
 
@@ -415,17 +427,32 @@ int delete_stream_config_internal(const char *name, bool permanent) {
 
     pthread_mutex_unlock(db_mutex);
 
+    stream_registry_reload(name);
+
     return 0;
 }
 
 /**
- * Get a stream configuration from the database
+ * Get a stream configuration
+ *
+ * Served from the stream registry, which mirrors the streams table.
  *
  * @param name Stream name to get
  * @param stream Stream configuration to fill
  * @return 0 on success, non-zero on failure
  */
 int get_stream_config_by_name(const char *name, stream_config_t *stream) {
+    return stream_registry_get(name, stream);
+}
+
+/**
+ * Get a stream configuration from the database, bypassing the registry
+ *
+ * @param name Stream name to get
+ * @param stream Stream configuration to fill
+ * @return 0 on success, non-zero on failure
+ */
+int get_stream_config_from_db(const char *name, stream_config_t *stream) {
     int rc;
     sqlite3_stmt *stmt;
     int result = -1;
@@ -891,3 +918,108 @@ int count_stream_configs(void) {
 
     return count;
 }
+
+/**
+ * Get the retention settings of a stream
+ *
+ * @param name Stream name
+ * @param retention_days Receives the retention in days (0 = use the global setting)
+ * @param max_storage_mb Receives the storage quota in MB (0 = no quota)
+ * @return 0 on success, non-zero on failure
+ */
+int get_stream_retention_config(const char *name, int *retention_days, int *max_storage_mb) {
+    int rc;
+    sqlite3_stmt *stmt;
+    int result = -1;
+
+    sqlite3 *db = get_db_handle();
+    pthread_mutex_t *db_mutex = get_db_mutex();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    if (!name || !retention_days || !max_storage_mb) {
+        log_error("Invalid parameters for get_stream_retention_config");
+        return -1;
+    }
+
+    pthread_mutex_lock(db_mutex);
+
+    const char *sql = "SELECT retention_days, max_storage_mb FROM streams WHERE name = ?;";
+
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+
+    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        *retention_days = sqlite3_column_int(stmt, 0);
+        *max_storage_mb = sqlite3_column_int(stmt, 1);
+        result = 0;
+    }
+
+    sqlite3_finalize(stmt);
+    pthread_mutex_unlock(db_mutex);
+
+    return result;
+}
+
+/**
+ * Set the retention settings of a stream
+ *
+ * @param name Stream name
+ * @param retention_days Retention in days (0 = use the global setting)
+ * @param max_storage_mb Storage quota in MB (0 = no quota)
+ * @return 0 on success, non-zero on failure
+ */
+int set_stream_retention_config(const char *name, int retention_days, int max_storage_mb) {
+    int rc;
+    sqlite3_stmt *stmt;
+
+    sqlite3 *db = get_db_handle();
+    pthread_mutex_t *db_mutex = get_db_mutex();
+
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
+
+    if (!name || retention_days < 0 || max_storage_mb < 0) {
+        log_error("Invalid parameters for set_stream_retention_config");
+        return -1;
+    }
+
+    pthread_mutex_lock(db_mutex);
+
+    const char *sql = "UPDATE streams SET retention_days = ?, max_storage_mb = ? WHERE name = ?;";
+
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+
+    sqlite3_bind_int(stmt, 1, retention_days);
+    sqlite3_bind_int(stmt, 2, max_storage_mb);
+    sqlite3_bind_text(stmt, 3, name, -1, SQLITE_STATIC);
+
+    rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    pthread_mutex_unlock(db_mutex);
+
+    if (rc != SQLITE_DONE) {
+        log_error("Failed to update retention settings for stream %s", name);
+        return -1;
+    }
+
+    log_info("Updated retention settings for stream %s: retention_days=%d, max_storage_mb=%d",
+             name, retention_days, max_storage_mb);
+    return 0;
+}
@@ -63,6 +63,7 @@
 #include <limits.h>
 /* Local includes */
 #include "sod/sod.h"
+#include "sod/sod_gemm.h"
 /* Forward declaration */
 typedef struct SySet SySet;
 typedef struct SyBlob SyBlob;
@@ -4588,46 +4589,16 @@ static inline void binarize_cpu(float *input, int n, float *binary)
 }
 #define convolutional_out_height(l) ((l.h + 2 * l.pad - l.size) / l.stride + 1)
 #define convolutional_out_width(l) ((l.w + 2 * l.pad - l.size) / l.stride + 1)
-static inline float im2col_get_pixel(float *im, int height, int width,
-	int row, int col, int channel, int pad)
-{
-	row -= pad;
-	col -= pad;
-
-	if (row < 0 || col < 0 ||
-		row >= height || col >= width) return 0;
-	return im[col + width * (row + height * channel)];
-}
 /*
 * From Berkeley Vision's Caffe!
 * https://github.com/BVLC/caffe/blob/master/LICENSE
+* Row-copying, multithreaded implementation in sod_gemm.c
 */
 static inline void im2col_cpu(float* data_im,
 	int channels, int height, int width,
 	int ksize, int stride, int pad, float* data_col)
 {
-	int c, h, w;
-	int height_col = (height + 2 * pad - ksize) / stride + 1;
-	int width_col = (width + 2 * pad - ksize) / stride + 1;
-	int channels_col = channels * ksize * ksize;
-	int w_offset, h_offset, c_im, im_row, im_col, col_index;
-	c = 0;
-	for (;;) {
-		if (c >= channels_col) break;
-		w_offset = c % ksize;
-		h_offset = (c / ksize) % ksize;
-		c_im = c / ksize / ksize;
-		for (h = 0; h < height_col; ++h) {
-			for (w = 0; w < width_col; ++w) {
-				im_row = h_offset + h * stride;
-				im_col = w_offset + w * stride;
-				col_index = (c * height_col + h) * width_col + w;
-				data_col[col_index] = im2col_get_pixel(data_im, height, width,
-					im_row, im_col, c_im, pad);
-			}
-		}
-		c++;
-	}
+	sod_im2col(data_im, channels, height, width, ksize, stride, pad, data_col);
 }
 #ifdef SOD_EMBEDDED_COMMERCIAL_LICENSE
 /* 
@@ -4644,27 +4615,13 @@ static inline void im2col_cpu(float* data_im,
  */
 #include "sod_threads.h"
 #else
+/* Packed, cache-blocked and multithreaded, see sod_gemm.c */
 static inline void gemm_nn(int M, int N, int K, float ALPHA,
 	float *A, int lda,
 	float *B, int ldb,
 	float *C, int ldc)
 {
-	register int i, j, k;
-	i = 0;
-	for (;;) {
-		if (i >= M)break;
-		k = 0;
-		for (;;) {
-			register float A_PART;
-			if (k >= K)break;
-			A_PART = ALPHA * A[i*lda + k];
-			for (j = 0; j < N; ++j) {
-				C[i*ldc + j] += A_PART * B[k*ldb + j];
-			}
-			k++;
-		}
-		i++;
-	}
+	sod_gemm_nn(M, N, K, ALPHA, A, lda, B, ldb, C, ldc);
 }
 #endif /*  SOD_EMBEDDED_COMMERCIAL_LICENSE */
 static inline void gemm_nt(int M, int N, int K, float ALPHA,
@@ -0,0 +1,646 @@
+/**
+ * Convolution backend for the SOD CNN
+ *
+ * The GEMM follows the usual packed layout: C is cut into MC x NC tiles that
+ * are computed independently (one task each), and every tile walks K in KC
+ * steps, packing an MC x KC block of A into MR-row panels and a KC x NC block
+ * of B into NR-column panels so the micro-kernel reads both sequentially from
+ * L1/L2.  Tiles are distributed over a fixed pool of worker threads; the
+ * caller always works on its own job too.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "sod/sod_gemm.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SOD_GEMM_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SOD_GEMM_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Micro-kernel tile: MR rows of A times NR columns of B
+#define GEMM_MR 4
+#define GEMM_NR 16
+
+// Cache blocking: a packed A block (MC x KC) stays in L2, a B panel (KC x NR) in L1
+#define GEMM_MC 64
+#define GEMM_NC 256
+#define GEMM_KC 256
+
+// Below this many multiply-adds a job is not worth waking the workers for
+#define GEMM_PARALLEL_MIN_FLOPS (1 << 18)
+#define IM2COL_PARALLEL_MIN_SIZE (1 << 16)
+
+// Upper bound on worker threads, whatever the CPU count
+#define SOD_MAX_THREADS 64
+
+typedef void (*gemm_kernel_fn)(int kc, const float *a, const float *b, float *c, int ldc, int mr, int nr);
+
+/* ------------------------------------------------------------------------- */
+/* Micro-kernels                                                             */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Add an MR x NR accumulator tile to the valid mr x nr corner of C
+ */
+static inline void store_partial_tile(const float *acc, float *c, int ldc, int mr, int nr) {
+    for (int i = 0; i < mr; i++) {
+        for (int j = 0; j < nr; j++) {
+            c[i * ldc + j] += acc[i * GEMM_NR + j];
+        }
+    }
+}
+
+/**
+ * Portable micro-kernel, written so the compiler can vectorize the inner loop
+ */
+static void kernel_generic(int kc, const float *a, const float *b, float *c, int ldc, int mr, int nr) {
+    float acc[GEMM_MR * GEMM_NR];
+    memset(acc, 0, sizeof(acc));
+
+    for (int p = 0; p < kc; p++) {
+        for (int i = 0; i < GEMM_MR; i++) {
+            const float ai = a[i];
+            for (int j = 0; j < GEMM_NR; j++) {
+                acc[i * GEMM_NR + j] += ai * b[j];
+            }
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    store_partial_tile(acc, c, ldc, mr, nr);
+}
+
+#ifdef SOD_GEMM_X86
+/**
+ * AVX2/FMA micro-kernel: 4 rows x 2 vectors of 8 accumulators
+ */
+__attribute__((target("avx2,fma")))
+static void kernel_avx2(int kc, const float *a, const float *b, float *c, int ldc, int mr, int nr) {
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+
+    for (int p = 0; p < kc; p++) {
+        __m256 b0 = _mm256_load_ps(b);
+        __m256 b1 = _mm256_load_ps(b + 8);
+        __m256 av;
+
+        av = _mm256_broadcast_ss(a);
+        c00 = _mm256_fmadd_ps(av, b0, c00);
+        c01 = _mm256_fmadd_ps(av, b1, c01);
+        av = _mm256_broadcast_ss(a + 1);
+        c10 = _mm256_fmadd_ps(av, b0, c10);
+        c11 = _mm256_fmadd_ps(av, b1, c11);
+        av = _mm256_broadcast_ss(a + 2);
+        c20 = _mm256_fmadd_ps(av, b0, c20);
+        c21 = _mm256_fmadd_ps(av, b1, c21);
+        av = _mm256_broadcast_ss(a + 3);
+        c30 = _mm256_fmadd_ps(av, b0, c30);
+        c31 = _mm256_fmadd_ps(av, b1, c31);
+
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    if (mr == GEMM_MR && nr == GEMM_NR) {
+        float *r0 = c, *r1 = c + ldc, *r2 = c + 2 * ldc, *r3 = c + 3 * ldc;
+        _mm256_storeu_ps(r0, _mm256_add_ps(_mm256_loadu_ps(r0), c00));
+        _mm256_storeu_ps(r0 + 8, _mm256_add_ps(_mm256_loadu_ps(r0 + 8), c01));
+        _mm256_storeu_ps(r1, _mm256_add_ps(_mm256_loadu_ps(r1), c10));
+        _mm256_storeu_ps(r1 + 8, _mm256_add_ps(_mm256_loadu_ps(r1 + 8), c11));
+        _mm256_storeu_ps(r2, _mm256_add_ps(_mm256_loadu_ps(r2), c20));
+        _mm256_storeu_ps(r2 + 8, _mm256_add_ps(_mm256_loadu_ps(r2 + 8), c21));
+        _mm256_storeu_ps(r3, _mm256_add_ps(_mm256_loadu_ps(r3), c30));
+        _mm256_storeu_ps(r3 + 8, _mm256_add_ps(_mm256_loadu_ps(r3 + 8), c31));
+        return;
+    }
+
+    float acc[GEMM_MR * GEMM_NR] __attribute__((aligned(32)));
+    _mm256_store_ps(acc, c00);
+    _mm256_store_ps(acc + 8, c01);
+    _mm256_store_ps(acc + 16, c10);
+    _mm256_store_ps(acc + 24, c11);
+    _mm256_store_ps(acc + 32, c20);
+    _mm256_store_ps(acc + 40, c21);
+    _mm256_store_ps(acc + 48, c30);
+    _mm256_store_ps(acc + 56, c31);
+    store_partial_tile(acc, c, ldc, mr, nr);
+}
+#endif /* SOD_GEMM_X86 */
+
+#ifdef SOD_GEMM_NEON
+#if defined(__aarch64__)
+#define NEON_MLA(acc, b, s) vfmaq_n_f32(acc, b, s)
+#else
+#define NEON_MLA(acc, b, s) vmlaq_n_f32(acc, b, s)
+#endif
+
+/**
+ * NEON micro-kernel: 4 rows x 4 vectors of 4 accumulators
+ */
+static void kernel_neon(int kc, const float *a, const float *b, float *c, int ldc, int mr, int nr) {
+    float32x4_t acc[GEMM_MR][4];
+    for (int i = 0; i < GEMM_MR; i++) {
+        for (int v = 0; v < 4; v++) {
+            acc[i][v] = vdupq_n_f32(0.0f);
+        }
+    }
+
+    for (int p = 0; p < kc; p++) {
+        float32x4_t b0 = vld1q_f32(b);
+        float32x4_t b1 = vld1q_f32(b + 4);
+        float32x4_t b2 = vld1q_f32(b + 8);
+        float32x4_t b3 = vld1q_f32(b + 12);
+
+        for (int i = 0; i < GEMM_MR; i++) {
+            acc[i][0] = NEON_MLA(acc[i][0], b0, a[i]);
+            acc[i][1] = NEON_MLA(acc[i][1], b1, a[i]);
+            acc[i][2] = NEON_MLA(acc[i][2], b2, a[i]);
+            acc[i][3] = NEON_MLA(acc[i][3], b3, a[i]);
+        }
+
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    if (mr == GEMM_MR && nr == GEMM_NR) {
+        for (int i = 0; i < GEMM_MR; i++) {
+            float *row = c + i * ldc;
+            for (int v = 0; v < 4; v++) {
+                vst1q_f32(row + 4 * v, vaddq_f32(vld1q_f32(row + 4 * v), acc[i][v]));
+            }
+        }
+        return;
+    }
+
+    float tile[GEMM_MR * GEMM_NR];
+    for (int i = 0; i < GEMM_MR; i++) {
+        for (int v = 0; v < 4; v++) {
+            vst1q_f32(tile + i * GEMM_NR + 4 * v, acc[i][v]);
+        }
+    }
+    store_partial_tile(tile, c, ldc, mr, nr);
+}
+#endif /* SOD_GEMM_NEON */
+
+static gemm_kernel_fn gemm_kernel = kernel_generic;
+static const char *gemm_kernel_label = "generic";
+
+/* ------------------------------------------------------------------------- */
+/* Worker pool                                                               */
+/* ------------------------------------------------------------------------- */
+
+typedef void (*task_fn)(void *arg, int task);
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+
+    // Held by the caller that owns the current job
+    pthread_mutex_t busy;
+
+    pthread_t threads[SOD_MAX_THREADS];
+    int nworkers;
+
+    // Current job; a new generation wakes the workers
+    unsigned generation;
+    task_fn fn;
+    void *arg;
+    int ntasks;
+    atomic_int next_task;
+    atomic_int done_tasks;
+
+    // Workers still inside the current job, and how many may join it
+    int active;
+    int max_active;
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_cond = PTHREAD_COND_INITIALIZER,
+    .done_cond = PTHREAD_COND_INITIALIZER,
+    .busy = PTHREAD_MUTEX_INITIALIZER,
+};
+
+// Threads requested through sod_gemm_set_threads() (0 = one per CPU) and started
+static int requested_threads = 0;
+static int pool_threads = 1;
+static pthread_once_t backend_once = PTHREAD_ONCE_INIT;
+static pthread_key_t pack_key;
+
+/**
+ * Take tasks of the current job until none are left
+ */
+static void drain_tasks(task_fn fn, void *arg, int ntasks) {
+    for (;;) {
+        int task = atomic_fetch_add(&pool.next_task, 1);
+        if (task >= ntasks) {
+            break;
+        }
+
+        fn(arg, task);
+
+        if (atomic_fetch_add(&pool.done_tasks, 1) + 1 == ntasks) {
+            pthread_mutex_lock(&pool.lock);
+            pthread_cond_broadcast(&pool.done_cond);
+            pthread_mutex_unlock(&pool.lock);
+        }
+    }
+}
+
+static void *pool_worker(void *unused) {
+    (void)unused;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (pool.generation == seen) {
+            pthread_cond_wait(&pool.work_cond, &pool.lock);
+        }
+        seen = pool.generation;
+        if (pool.active >= pool.max_active) {
+            continue;
+        }
+
+        task_fn fn = pool.fn;
+        void *arg = pool.arg;
+        int ntasks = pool.ntasks;
+        pool.active++;
+        pthread_mutex_unlock(&pool.lock);
+
+        drain_tasks(fn, arg, ntasks);
+
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.active == 0) {
+            pthread_cond_broadcast(&pool.done_cond);
+        }
+    }
+
+    return NULL;
+}
+
+static void free_pack_buffers(void *buffers) {
+    free(buffers);
+}
+
+static void init_backend(void) {
+#ifdef SOD_GEMM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        gemm_kernel = kernel_avx2;
+        gemm_kernel_label = "avx2";
+    }
+#endif
+#ifdef SOD_GEMM_NEON
+    gemm_kernel = kernel_neon;
+    gemm_kernel_label = "neon";
+#endif
+
+    pthread_key_create(&pack_key, free_pack_buffers);
+
+    int threads = requested_threads;
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > SOD_MAX_THREADS) {
+        threads = SOD_MAX_THREADS;
+    }
+
+    // The calling thread is one of the threads
+    for (int i = 0; i < threads - 1; i++) {
+        if (pthread_create(&pool.threads[pool.nworkers], NULL, pool_worker, NULL) != 0) {
+            break;
+        }
+        pthread_detach(pool.threads[pool.nworkers]);
+        pool.nworkers++;
+    }
+    pool_threads = pool.nworkers + 1;
+}
+
+/**
+ * Threads a job may use, including the caller
+ */
+static int effective_threads(void) {
+    int threads = requested_threads;
+    return threads > 0 && threads < pool_threads ? threads : pool_threads;
+}
+
+/**
+ * Run fn(arg, 0 .. ntasks - 1) on the pool and the calling thread
+ *
+ * Falls back to running every task on the caller when the pool is owned by
+ * another job, so concurrent networks degrade to one thread each rather than
+ * queueing behind each other.
+ */
+static void parallel_for(task_fn fn, void *arg, int ntasks, int parallel) {
+    int threads = effective_threads();
+    if (!parallel || ntasks <= 1 || threads <= 1 || pthread_mutex_trylock(&pool.busy) != 0) {
+        for (int task = 0; task < ntasks; task++) {
+            fn(arg, task);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+
+    // Workers still leaving the previous job would otherwise take our tasks
+    while (pool.active > 0) {
+        pthread_cond_wait(&pool.done_cond, &pool.lock);
+    }
+
+    pool.fn = fn;
+    pool.arg = arg;
+    pool.ntasks = ntasks;
+    pool.max_active = threads - 1;
+    atomic_store(&pool.next_task, 0);
+    atomic_store(&pool.done_tasks, 0);
+    pool.generation++;
+    pthread_cond_broadcast(&pool.work_cond);
+    pthread_mutex_unlock(&pool.lock);
+
+    drain_tasks(fn, arg, ntasks);
+
+    pthread_mutex_lock(&pool.lock);
+    while (atomic_load(&pool.done_tasks) < ntasks) {
+        pthread_cond_wait(&pool.done_cond, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_mutex_unlock(&pool.busy);
+}
+
+/* ------------------------------------------------------------------------- */
+/* GEMM                                                                      */
+/* ------------------------------------------------------------------------- */
+
+typedef struct {
+    int M, N, K;
+    float alpha;
+    const float *A;
+    int lda;
+    const float *B;
+    int ldb;
+    float *C;
+    int ldc;
+    int tiles_n;
+} gemm_job_t;
+
+/**
+ * Per-thread packing buffers, allocated on first use
+ */
+static float *get_pack_buffers(void) {
+    float *buffers = pthread_getspecific(pack_key);
+    if (!buffers) {
+        size_t size = (size_t)(GEMM_MC * GEMM_KC + GEMM_KC * GEMM_NC) * sizeof(float);
+        if (posix_memalign((void **)&buffers, 64, size) != 0) {
+            return NULL;
+        }
+        pthread_setspecific(pack_key, buffers);
+    }
+    return buffers;
+}
+
+/**
+ * Pack ALPHA * A[0:mc, 0:kc] into MR-row panels, zero padding the last panel
+ */
+static void pack_a(int mc, int kc, float alpha, const float *A, int lda, float *dst) {
+    for (int ir = 0; ir < mc; ir += GEMM_MR) {
+        int mr = mc - ir < GEMM_MR ? mc - ir : GEMM_MR;
+        const float *src = A + (size_t)ir * lda;
+
+        for (int p = 0; p < kc; p++) {
+            int i = 0;
+            for (; i < mr; i++) {
+                dst[i] = alpha * src[(size_t)i * lda + p];
+            }
+            for (; i < GEMM_MR; i++) {
+                dst[i] = 0.0f;
+            }
+            dst += GEMM_MR;
+        }
+    }
+}
+
+/**
+ * Pack B[0:kc, 0:nc] into NR-column panels, zero padding the last panel
+ */
+static void pack_b(int kc, int nc, const float *B, int ldb, float *dst) {
+    for (int jr = 0; jr < nc; jr += GEMM_NR) {
+        int nr = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+        const float *src = B + jr;
+
+        for (int p = 0; p < kc; p++) {
+            memcpy(dst, src + (size_t)p * ldb, nr * sizeof(float));
+            if (nr < GEMM_NR) {
+                memset(dst + nr, 0, (GEMM_NR - nr) * sizeof(float));
+            }
+            dst += GEMM_NR;
+        }
+    }
+}
+
+/**
+ * Plain loop for when the packing buffers cannot be allocated
+ */
+static void gemm_nn_reference(int M, int N, int K, float alpha, const float *A, int lda,
+                              const float *B, int ldb, float *C, int ldc) {
+    for (int i = 0; i < M; i++) {
+        for (int k = 0; k < K; k++) {
+            float a_part = alpha * A[(size_t)i * lda + k];
+            for (int j = 0; j < N; j++) {
+                C[(size_t)i * ldc + j] += a_part * B[(size_t)k * ldb + j];
+            }
+        }
+    }
+}
+
+/**
+ * Compute one MC x NC tile of C
+ */
+static void gemm_tile(void *arg, int task) {
+    const gemm_job_t *job = arg;
+    int i0 = (task / job->tiles_n) * GEMM_MC;
+    int j0 = (task % job->tiles_n) * GEMM_NC;
+    int mc = job->M - i0 < GEMM_MC ? job->M - i0 : GEMM_MC;
+    int nc = job->N - j0 < GEMM_NC ? job->N - j0 : GEMM_NC;
+
+    const float *A = job->A + (size_t)i0 * job->lda;
+    const float *B = job->B + j0;
+    float *C = job->C + (size_t)i0 * job->ldc + j0;
+
+    float *packed_a = get_pack_buffers();
+    if (!packed_a) {
+        gemm_nn_reference(mc, nc, job->K, job->alpha, A, job->lda, B, job->ldb, C, job->ldc);
+        return;
+    }
+    float *packed_b = packed_a + GEMM_MC * GEMM_KC;
+
+    for (int p0 = 0; p0 < job->K; p0 += GEMM_KC) {
+        int kc = job->K - p0 < GEMM_KC ? job->K - p0 : GEMM_KC;
+
+        pack_a(mc, kc, job->alpha, A + p0, job->lda, packed_a);
+        pack_b(kc, nc, B + (size_t)p0 * job->ldb, job->ldb, packed_b);
+
+        for (int jr = 0; jr < nc; jr += GEMM_NR) {
+            int nr = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+            const float *b_panel = packed_b + (size_t)jr * kc;
+
+            for (int ir = 0; ir < mc; ir += GEMM_MR) {
+                int mr = mc - ir < GEMM_MR ? mc - ir : GEMM_MR;
+                gemm_kernel(kc, packed_a + (size_t)ir * kc, b_panel,
+                            C + (size_t)ir * job->ldc + jr, job->ldc, mr, nr);
+            }
+        }
+    }
+}
+
+/**
+ * C += ALPHA * A * B with row-major A (M x K), B (K x N) and C (M x N)
+ */
+void sod_gemm_nn(int M, int N, int K, float ALPHA,
+                 const float *A, int lda,
+                 const float *B, int ldb,
+                 float *C, int ldc) {
+    if (M <= 0 || N <= 0 || K <= 0) {
+        return;
+    }
+
+    pthread_once(&backend_once, init_backend);
+
+    gemm_job_t job = {
+        .M = M, .N = N, .K = K, .alpha = ALPHA,
+        .A = A, .lda = lda, .B = B, .ldb = ldb, .C = C, .ldc = ldc,
+        .tiles_n = (N + GEMM_NC - 1) / GEMM_NC,
+    };
+    int tiles_m = (M + GEMM_MC - 1) / GEMM_MC;
+    int parallel = (double)M * N * K >= GEMM_PARALLEL_MIN_FLOPS;
+
+    parallel_for(gemm_tile, &job, tiles_m * job.tiles_n, parallel);
+}
+
+/* ------------------------------------------------------------------------- */
+/* im2col                                                                    */
+/* ------------------------------------------------------------------------- */
+
+typedef struct {
+    const float *data_im;
+    int height, width;
+    int ksize, stride, pad;
+    int height_col, width_col;
+    int channels_col;
+    int rows_per_task;
+    float *data_col;
+} im2col_job_t;
+
+/**
+ * Unfold a range of rows of the column matrix (one row per channel and kernel offset)
+ */
+static void im2col_rows(void *arg, int task) {
+    const im2col_job_t *job = arg;
+    int c_start = task * job->rows_per_task;
+    int c_end = c_start + job->rows_per_task;
+    if (c_end > job->channels_col) {
+        c_end = job->channels_col;
+    }
+
+    for (int c = c_start; c < c_end; c++) {
+        int w_offset = c % job->ksize;
+        int h_offset = (c / job->ksize) % job->ksize;
+        int c_im = c / job->ksize / job->ksize;
+        const float *im = job->data_im + (size_t)c_im * job->height * job->width;
+        float *col = job->data_col + (size_t)c * job->height_col * job->width_col;
+
+        // Output columns whose input column falls inside the image
+        int col_offset = w_offset - job->pad;
+        int w_lo = col_offset >= 0 ? 0 : (-col_offset + job->stride - 1) / job->stride;
+        int w_hi = job->width - 1 - col_offset >= 0 ? (job->width - 1 - col_offset) / job->stride + 1 : 0;
+        if (w_lo > job->width_col) w_lo = job->width_col;
+        if (w_hi > job->width_col) w_hi = job->width_col;
+        if (w_hi < w_lo) w_hi = w_lo;
+
+        for (int h = 0; h < job->height_col; h++, col += job->width_col) {
+            int im_row = h_offset + h * job->stride - job->pad;
+            if (im_row < 0 || im_row >= job->height) {
+                memset(col, 0, job->width_col * sizeof(float));
+                continue;
+            }
+
+            const float *src = im + (size_t)im_row * job->width + col_offset;
+            memset(col, 0, w_lo * sizeof(float));
+            if (job->stride == 1) {
+                memcpy(col + w_lo, src + w_lo, (w_hi - w_lo) * sizeof(float));
+            } else {
+                for (int w = w_lo; w < w_hi; w++) {
+                    col[w] = src[w * job->stride];
+                }
+            }
+            memset(col + w_hi, 0, (job->width_col - w_hi) * sizeof(float));
+        }
+    }
+}
+
+/**
+ * Unfold an image into the column matrix used by the convolution GEMM
+ */
+void sod_im2col(const float *data_im, int channels, int height, int width,
+                int ksize, int stride, int pad, float *data_col) {
+    pthread_once(&backend_once, init_backend);
+
+    im2col_job_t job = {
+        .data_im = data_im,
+        .height = height, .width = width,
+        .ksize = ksize, .stride = stride, .pad = pad,
+        .height_col = (height + 2 * pad - ksize) / stride + 1,
+        .width_col = (width + 2 * pad - ksize) / stride + 1,
+        .channels_col = channels * ksize * ksize,
+        .data_col = data_col,
+    };
+    if (job.height_col <= 0 || job.width_col <= 0 || job.channels_col <= 0) {
+        return;
+    }
+
+    // A few tasks per thread so uneven rows still balance
+    int ntasks = effective_threads() * 4;
+    if (ntasks > job.channels_col) {
+        ntasks = job.channels_col;
+    }
+    job.rows_per_task = (job.channels_col + ntasks - 1) / ntasks;
+    ntasks = (job.channels_col + job.rows_per_task - 1) / job.rows_per_task;
+
+    size_t size = (size_t)job.channels_col * job.height_col * job.width_col;
+    parallel_for(im2col_rows, &job, ntasks, size >= IM2COL_PARALLEL_MIN_SIZE);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Configuration                                                             */
+/* ------------------------------------------------------------------------- */
+
+void sod_gemm_set_threads(int threads) {
+    if (threads < 0) {
+        threads = 0;
+    }
+    requested_threads = threads > SOD_MAX_THREADS ? SOD_MAX_THREADS : threads;
+}
+
+int sod_gemm_get_threads(void) {
+    pthread_once(&backend_once, init_backend);
+    return effective_threads();
+}
+
+const char *sod_gemm_kernel_name(void) {
+    pthread_once(&backend_once, init_backend);
+    return gemm_kernel_label;
+}
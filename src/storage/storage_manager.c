@@ -1,3 +1,5 @@
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,6 +7,8 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/statvfs.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <dirent.h>
 #include <unistd.h>
 #include <errno.h>
@@ -12,7 +16,11 @@
 
 #include "storage/storage_manager.h"
 #include "storage/storage_manager_streams_cache.h"
+#include "database/db_recordings.h"
+#include "database/db_streams.h"
+#include "core/config.h"
 #include "core/logger.h"
+#include "video/recording_preview.h"
 
 // Storage manager state
 static struct {
@@ -219,165 +227,171 @@ int delete_recording(const char *path) {
         return -1;
     }
 
+    recording_preview_remove(path);
+
     log_info("Successfully deleted recording file: %s", path);
     return 0;
 }
 
-// Apply retention policy
-int apply_retention_policy(void) {
-    log_info("Applying retention policy (max size: %lu bytes, retention days: %d)",
-             storage_manager.max_size, storage_manager.retention_days);
-
-    // Get current storage stats
-    storage_stats_t stats;
-    if (get_storage_stats(&stats) != 0) {
-        log_error("Failed to get storage statistics");
-        return -1;
+// Recordings read and deleted per retention batch
+#define RETENTION_BATCH_SIZE 100
+
+// Smallest global storage limit that is enforced (1 MB)
+#define RETENTION_MIN_STORAGE_SIZE (1024 * 1024)
+
+// Most streams looked at in one retention pass, including removed streams that still have recordings
+#define RETENTION_MAX_STREAMS (MAX_STREAMS * 4)
+
+/**
+ * Delete the file and the metadata of a recording
+ *
+ * A file that is already gone still has its metadata removed.  If the file
+ * cannot be deleted the metadata is kept so a later pass can retry.
+ */
+static bool delete_recording_and_metadata(const recording_metadata_t *recording) {
+    if (recording->file_path[0] != '\0' && unlink(recording->file_path) != 0 && errno != ENOENT) {
+        log_error("Failed to delete recording: %s (error: %s)", recording->file_path, strerror(errno));
+        return false;
     }
-
-    // Check if we need to apply retention policy
-    bool need_cleanup_size = (storage_manager.max_size > 0 && stats.used_space > storage_manager.max_size);
-    bool need_cleanup_days = (storage_manager.retention_days > 0);
-
-    if (!need_cleanup_size && !need_cleanup_days) {
-        log_debug("No retention policy to apply");
-        return 0;
+    if (recording->file_path[0] != '\0') {
+        recording_preview_remove(recording->file_path);
     }
 
-    // Calculate cutoff time for retention days
-    time_t now = time(NULL);
-    time_t cutoff_time = now - (storage_manager.retention_days * 86400); // 86400 seconds in a day
-
-    // Track deleted files
-    int deleted_count = 0;
-    uint64_t freed_space = 0;
-
-    // Scan the storage directory
-    DIR *dir = opendir(storage_manager.storage_path);
-    if (!dir) {
-        log_error("Failed to open storage directory: %s", strerror(errno));
-        return -1;
+    if (delete_recording_metadata(recording->id) != 0) {
+        log_error("Failed to delete metadata for recording %llu", (unsigned long long)recording->id);
+        return false;
     }
 
-    // First pass: collect all recording files with their timestamps and sizes
-    typedef struct {
-        char path[768];
-        time_t mtime;
-        off_t size;
-    } recording_file_t;
+    return true;
+}
 
-    recording_file_t *files = NULL;
-    int file_count = 0;
-    int file_capacity = 0;
+/**
+ * Delete recordings that started before a cutoff, oldest first, in batches
+ *
+ * @param stream_name Stream to clean up (NULL for all streams)
+ */
+static void apply_age_retention(const char *stream_name, time_t cutoff_time, recording_metadata_t *batch,
+                                int *deleted_count, uint64_t *freed_space) {
+    for (;;) {
+        int count = get_oldest_recordings(stream_name, cutoff_time, batch, RETENTION_BATCH_SIZE);
+        if (count <= 0) {
+            break;
+        }
 
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
-        // Skip . and ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
+        int deleted = 0;
+        for (int i = 0; i < count; i++) {
+            if (delete_recording_and_metadata(&batch[i])) {
+                deleted++;
+                *freed_space += batch[i].size_bytes;
+                log_debug("Deleted old recording: %s", batch[i].file_path);
+            }
         }
+        *deleted_count += deleted;
 
-        // Check if it's a directory (stream directory)
-        char stream_path[512];
-        snprintf(stream_path, sizeof(stream_path), "%s/%s", storage_manager.storage_path, entry->d_name);
+        // Stop on a short batch, or when nothing could be deleted to avoid spinning
+        if (count < RETENTION_BATCH_SIZE || deleted == 0) {
+            break;
+        }
+    }
+}
 
-        struct stat st;
-        if (stat(stream_path, &st) == 0 && S_ISDIR(st.st_mode)) {
-            // Scan stream directory for recordings
-            DIR *stream_dir = opendir(stream_path);
-            if (stream_dir) {
-                struct dirent *rec_entry;
-
-                while ((rec_entry = readdir(stream_dir)) != NULL) {
-                    // Skip . and ..
-                    if (strcmp(rec_entry->d_name, ".") == 0 || strcmp(rec_entry->d_name, "..") == 0) {
-                        continue;
-                    }
+/**
+ * Delete the oldest recordings, in batches, until their total size fits a quota
+ *
+ * @param stream_name Stream to clean up (NULL for all streams)
+ */
+static void apply_size_quota(const char *stream_name, uint64_t quota, recording_metadata_t *batch,
+                             int *deleted_count, uint64_t *freed_space) {
+    int64_t used = get_recordings_total_size(stream_name);
+    if (used < 0 || (uint64_t)used <= quota) {
+        return;
+    }
 
-                    // Check if it's a file
-                    char rec_path[768];
-                    snprintf(rec_path, sizeof(rec_path), "%s/%s", stream_path, rec_entry->d_name);
-
-                    struct stat rec_st;
-                    if (stat(rec_path, &rec_st) == 0 && S_ISREG(rec_st.st_mode)) {
-                        // Check if file is older than retention days
-                        if (need_cleanup_days && rec_st.st_mtime < cutoff_time) {
-                            // Delete file directly if it's older than retention days
-                            if (unlink(rec_path) == 0) {
-                                log_debug("Deleted old recording: %s (age: %ld days)",
-                                         rec_path, (now - rec_st.st_mtime) / 86400);
-                                deleted_count++;
-                                freed_space += rec_st.st_size;
-                            } else {
-                                log_error("Failed to delete old recording: %s (error: %s)",
-                                         rec_path, strerror(errno));
-                            }
-                        } else if (need_cleanup_size) {
-                            // Add to files array for size-based cleanup
-                            if (file_count >= file_capacity) {
-                                file_capacity = file_capacity == 0 ? 1000 : file_capacity * 2;
-                                recording_file_t *new_files = realloc(files, file_capacity * sizeof(recording_file_t));
-                                if (!new_files) {
-                                    log_error("Memory allocation failed for recording files array");
-                                    free(files);
-                                    closedir(stream_dir);
-                                    closedir(dir);
-                                    return -1;
-                                }
-                                files = new_files;
-                            }
+    log_info("Recordings%s%s use %llu bytes, %llu over the limit",
+             stream_name ? " of stream " : "", stream_name ? stream_name : "",
+             (unsigned long long)used, (unsigned long long)(used - quota));
 
-                            strncpy(files[file_count].path, rec_path, sizeof(files[file_count].path) - 1);
-                            files[file_count].path[sizeof(files[file_count].path) - 1] = '\0';
-                            files[file_count].mtime = rec_st.st_mtime;
-                            files[file_count].size = rec_st.st_size;
-                            file_count++;
-                        }
-                    }
-                }
+    while ((uint64_t)used > quota) {
+        int count = get_oldest_recordings(stream_name, 0, batch, RETENTION_BATCH_SIZE);
+        if (count <= 0) {
+            break;
+        }
 
-                closedir(stream_dir);
+        int deleted = 0;
+        for (int i = 0; i < count && (uint64_t)used > quota; i++) {
+            if (delete_recording_and_metadata(&batch[i])) {
+                deleted++;
+                used -= (int64_t)batch[i].size_bytes;
+                *freed_space += batch[i].size_bytes;
+                log_debug("Deleted recording to free space: %s", batch[i].file_path);
             }
         }
+        *deleted_count += deleted;
+
+        if (count < RETENTION_BATCH_SIZE || deleted == 0) {
+            break;
+        }
     }
+}
 
-    closedir(dir);
+// Apply retention policy
+int apply_retention_policy(void) {
+    log_info("Applying retention policy (max size: %lu bytes, retention days: %d)",
+             storage_manager.max_size, storage_manager.retention_days);
 
-    // If we need to clean up by size and we still have too much used space
-    if (need_cleanup_size && stats.used_space - freed_space > storage_manager.max_size && file_count > 0) {
-        log_info("Need to free more space: %lu bytes over limit",
-                (stats.used_space - freed_space) - storage_manager.max_size);
+    recording_metadata_t *batch = malloc(RETENTION_BATCH_SIZE * sizeof(recording_metadata_t));
+    char (*stream_names)[64] = malloc(RETENTION_MAX_STREAMS * sizeof(*stream_names));
+    if (!batch || !stream_names) {
+        log_error("Memory allocation failed for retention policy");
+        free(batch);
+        free(stream_names);
+        return -1;
+    }
 
-        // Sort files by modification time (oldest first)
-        for (int i = 0; i < file_count - 1; i++) {
-            for (int j = 0; j < file_count - i - 1; j++) {
-                if (files[j].mtime > files[j + 1].mtime) {
-                    recording_file_t temp = files[j];
-                    files[j] = files[j + 1];
-                    files[j + 1] = temp;
-                }
-            }
+    // Streams are looked up through the recordings index, so streams that
+    // have been removed from the configuration are still cleaned up
+    int stream_count = get_recording_stream_names(stream_names, RETENTION_MAX_STREAMS);
+    if (stream_count < 0) {
+        log_error("Failed to get streams with recordings");
+        free(batch);
+        free(stream_names);
+        return -1;
+    }
+
+    time_t now = time(NULL);
+    int deleted_count = 0;
+    uint64_t freed_space = 0;
+
+    for (int i = 0; i < stream_count; i++) {
+        // Per-stream settings override the global retention; 0 means not set
+        int retention_days = 0;
+        int max_storage_mb = 0;
+        get_stream_retention_config(stream_names[i], &retention_days, &max_storage_mb);
+        if (retention_days <= 0) {
+            retention_days = storage_manager.retention_days;
         }
 
-        // Delete oldest files until we're under the limit
-        for (int i = 0; i < file_count; i++) {
-            if (stats.used_space - freed_space <= storage_manager.max_size) {
-                break;
-            }
+        if (retention_days > 0) {
+            time_t cutoff_time = now - ((time_t)retention_days * 86400); // 86400 seconds in a day
+            apply_age_retention(stream_names[i], cutoff_time, batch, &deleted_count, &freed_space);
+        }
 
-            if (unlink(files[i].path) == 0) {
-                log_debug("Deleted recording to free space: %s", files[i].path);
-                deleted_count++;
-                freed_space += files[i].size;
-            } else {
-                log_error("Failed to delete recording: %s (error: %s)",
-                         files[i].path, strerror(errno));
-            }
+        if (max_storage_mb > 0) {
+            apply_size_quota(stream_names[i], (uint64_t)max_storage_mb * 1024 * 1024,
+                             batch, &deleted_count, &freed_space);
         }
     }
 
-    // Free memory
-    free(files);
+    // Global size limit across all streams; a limit this small is a unit mix-up, not a real quota
+    if (storage_manager.max_size > 0 && storage_manager.max_size < RETENTION_MIN_STORAGE_SIZE) {
+        log_warn("Ignoring max storage size of %lu bytes, expected a size in bytes of at least %d",
+                 storage_manager.max_size, RETENTION_MIN_STORAGE_SIZE);
+    } else if (storage_manager.max_size > 0 && storage_manager.auto_delete_oldest) {
+        apply_size_quota(NULL, storage_manager.max_size, batch, &deleted_count, &freed_space);
+    }
+
+    free(batch);
+    free(stream_names);
 
     log_info("Retention policy applied: deleted %d files, freed %lu bytes",
              deleted_count, freed_space);
@@ -401,6 +415,11 @@ int set_retention_days(int days) {
     return 0;
 }
 
+// Set whether the oldest recordings are deleted when the storage limit is reached
+void set_auto_delete_oldest(bool enabled) {
+    storage_manager.auto_delete_oldest = enabled;
+}
+
 // Check if storage is available
 bool is_storage_available(void) {
     struct stat st;
@@ -448,31 +467,126 @@ static struct {
     bool running;
     int interval_seconds;
     pthread_mutex_t mutex;
-    time_t last_cache_refresh;
-    int cache_refresh_interval; // in seconds
+    time_t last_reconcile;
+    int reconcile_interval; // in seconds
+    uint64_t disk_audit_cursor; // Last recording ID checked against the disk
 } storage_manager_thread = {
     .running = false,
     .interval_seconds = 3600, // Default to 1 hour
-    .last_cache_refresh = 0,
-    .cache_refresh_interval = 900 // Default to 15 minutes
+    .last_reconcile = 0,
+    .reconcile_interval = 900 // Default to 15 minutes
 };
 
-// Forward declaration for the cache refresh function
-extern int force_refresh_cache(void);
+// Recordings compared with their files per reconcile, the table is covered over successive runs
+#define DISK_AUDIT_PAGE_SIZE 256
+
+/**
+ * Bring one page of complete recordings in line with their files on disk
+ *
+ * The storage counters follow the recordings table through its triggers, so
+ * rows whose file was deleted outside the database are removed and rows whose
+ * file changed size are corrected, and the counters move with them.  If no
+ * file of the page exists the storage is more likely unmounted than emptied,
+ * and nothing is changed.
+ *
+ * @param cursor Last recording ID checked, advanced and wrapped to 0 at the end of the table
+ * @return Number of recordings corrected, or -1 on error
+ */
+static int audit_recording_files(uint64_t *cursor) {
+    recording_file_info_t *files = malloc(DISK_AUDIT_PAGE_SIZE * sizeof(recording_file_info_t));
+    if (!files) {
+        log_error("Failed to allocate memory for disk audit");
+        return -1;
+    }
+
+    int count = get_recording_files_after_id(*cursor, files, DISK_AUDIT_PAGE_SIZE);
+    if (count < 0) {
+        free(files);
+        return -1;
+    }
+
+    // Size on disk of each complete recording, -1 if its file is gone
+    int64_t *disk_sizes = malloc((size_t)(count > 0 ? count : 1) * sizeof(int64_t));
+    if (!disk_sizes) {
+        log_error("Failed to allocate memory for disk audit");
+        free(files);
+        return -1;
+    }
+
+    int checked = 0;
+    int missing = 0;
+    for (int i = 0; i < count; i++) {
+        disk_sizes[i] = (int64_t)files[i].size_bytes;
+
+        // Recordings being written are tracked by the size sync instead
+        if (!files[i].is_complete) {
+            continue;
+        }
+
+        checked++;
+        struct stat st;
+        if (stat(files[i].file_path, &st) == 0) {
+            disk_sizes[i] = (int64_t)st.st_size;
+        } else if (errno == ENOENT) {
+            disk_sizes[i] = -1;
+            missing++;
+        }
+    }
+
+    int removed = 0;
+    int resized = 0;
+    if (missing > 0 && missing == checked) {
+        log_warn("Disk audit: none of %d recording files (IDs %llu-%llu) exist, "
+                 "leaving them alone in case the storage is not mounted",
+                 checked, (unsigned long long)*cursor + 1,
+                 (unsigned long long)files[count - 1].id);
+    } else {
+        for (int i = 0; i < count; i++) {
+            if (!files[i].is_complete) {
+                continue;
+            }
+
+            if (disk_sizes[i] < 0) {
+                if (delete_recording_metadata(files[i].id) == 0) {
+                    recording_preview_remove(files[i].file_path);
+                    removed++;
+                }
+            } else if ((uint64_t)disk_sizes[i] != files[i].size_bytes) {
+                if (correct_recording_size(files[i].id, (uint64_t)disk_sizes[i]) == 0) {
+                    resized++;
+                }
+            }
+        }
+    }
+
+    if (removed > 0 || resized > 0) {
+        log_info("Disk audit: removed %d recording(s) whose file was deleted and corrected "
+                 "the size of %d (IDs %llu-%llu)",
+                 removed, resized, (unsigned long long)*cursor + 1,
+                 (unsigned long long)files[count - 1].id);
+    }
+
+    *cursor = (count < DISK_AUDIT_PAGE_SIZE) ? 0 : files[count - 1].id;
+    free(disk_sizes);
+    free(files);
+    return removed + resized;
+}
 
 // Storage manager thread function
 static void* storage_manager_thread_func(void *arg) {
     log_info("Storage manager thread started with interval: %d seconds", storage_manager_thread.interval_seconds);
-    log_info("Cache refresh interval: %d seconds", storage_manager_thread.cache_refresh_interval);
+    log_info("Storage counter reconcile interval: %d seconds", storage_manager_thread.reconcile_interval);
 
-    // Initialize last cache refresh time
-    storage_manager_thread.last_cache_refresh = time(NULL);
+    // Retention and reconciliation are housekeeping, keep them out of the way
+    // of the recording and detection threads (nice applies per thread on Linux)
+    if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 10) != 0) {
+        log_debug("Could not lower storage manager thread priority: %s", strerror(errno));
+    }
 
-    // Initial cache refresh
-    if (force_refresh_cache() == 0) {
-        log_info("Initial cache refresh successful");
-    } else {
-        log_warn("Initial cache refresh failed");
+    // Initial reconcile, counters may be stale after an unclean shutdown
+    storage_manager_thread.last_reconcile = time(NULL);
+    if (reconcile_recording_storage_usage() < 0) {
+        log_warn("Initial storage counter reconcile failed");
     }
 
     while (storage_manager_thread.running) {
@@ -486,15 +600,15 @@ static void* storage_manager_thread_func(void *arg) {
             log_error("Storage manager thread encountered an error applying retention policy");
         }
 
-        // Check if it's time to refresh the cache
-        if (now - storage_manager_thread.last_cache_refresh >= storage_manager_thread.cache_refresh_interval) {
-            log_info("Refreshing storage cache");
-            if (force_refresh_cache() == 0) {
-                log_info("Cache refresh successful");
-            } else {
-                log_warn("Cache refresh failed");
+        // Check if it's time to reconcile the storage counters
+        if (now - storage_manager_thread.last_reconcile >= storage_manager_thread.reconcile_interval) {
+            if (reconcile_recording_storage_usage() < 0) {
+                log_warn("Storage counter reconcile failed");
+            }
+            if (audit_recording_files(&storage_manager_thread.disk_audit_cursor) < 0) {
+                log_warn("Disk audit of recording files failed");
             }
-            storage_manager_thread.last_cache_refresh = now;
+            storage_manager_thread.last_reconcile = now;
         }
 
         // Sleep for 1 second at a time to be responsive to shutdown requests
@@ -6,92 +6,51 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <dirent.h>
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <unistd.h>
-#include <errno.h>
 
 #include "storage/storage_manager.h"
 #include "storage/storage_manager_streams.h"
 #include "core/logger.h"
 #include "core/config.h"
+#include "database/db_recordings.h"
 #include <cjson/cJSON.h>
 
+// Upper bound on streams reported, including streams removed from the configuration
+#define STREAM_STORAGE_MAX_STREAMS (MAX_STREAMS * 4)
+
 /**
  * Get storage usage per stream
  * 
- * @param storage_path Base storage path
+ * Reads the per-stream counters that the database keeps up to date whenever a
+ * recording is added, finalized or deleted, so nothing on disk is touched.
+ * 
+ * @param storage_path Base storage path (unused, kept for compatibility)
  * @param stream_info Array to fill with stream storage information
  * @param max_streams Maximum number of streams to return
  * @return Number of streams found, or -1 on error
  */
 int get_stream_storage_usage(const char *storage_path, stream_storage_info_t *stream_info, int max_streams) {
-    if (!storage_path || !stream_info || max_streams <= 0) {
+    (void)storage_path;
+
+    if (!stream_info || max_streams <= 0) {
         log_error("Invalid parameters for get_stream_storage_usage");
         return -1;
     }
-    
-    // Based on user feedback, the recordings are in /var/lib/lightnvr/recordings/mp4/[stream_name]/
-    // Construct the mp4 directory path
-    char mp4_path[512];
-    snprintf(mp4_path, sizeof(mp4_path), "%s/mp4", storage_path);
-    
-    // Open the mp4 directory
-    DIR *dir = opendir(mp4_path);
-    if (!dir) {
-        log_error("Failed to open mp4 directory: %s (error: %s)", mp4_path, strerror(errno));
+
+    recording_storage_usage_t *usage = malloc(max_streams * sizeof(recording_storage_usage_t));
+    if (!usage) {
+        log_error("Failed to allocate memory for stream storage counters");
         return -1;
     }
-    
-    // Initialize stream count
-    int stream_count = 0;
-    
-    // Iterate through directory entries (stream directories)
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL && stream_count < max_streams) {
-        // Skip . and ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-        
-        // Check if it's a directory (stream directory)
-        char stream_path[512];
-        snprintf(stream_path, sizeof(stream_path), "%s/%s", mp4_path, entry->d_name);
-        
-        struct stat st;
-        if (stat(stream_path, &st) == 0 && S_ISDIR(st.st_mode)) {
-            // Initialize stream info
-            strncpy(stream_info[stream_count].name, entry->d_name, sizeof(stream_info[stream_count].name) - 1);
-            stream_info[stream_count].name[sizeof(stream_info[stream_count].name) - 1] = '\0';
-            stream_info[stream_count].size_bytes = 0;
-            stream_info[stream_count].recording_count = 0;
-            
-            // Use du command to get directory size
-            char du_cmd[768];
-            snprintf(du_cmd, sizeof(du_cmd), "du -sb %s 2>/dev/null | cut -f1", stream_path);
-            FILE *fp = popen(du_cmd, "r");
-            if (fp) {
-                if (fscanf(fp, "%lu", &stream_info[stream_count].size_bytes) == 1) {
-                    // Use find to count MP4 files
-                    char find_cmd[768];
-                    snprintf(find_cmd, sizeof(find_cmd), "find %s -type f -name \"*.mp4\" | wc -l", stream_path);
-                    FILE *fp_count = popen(find_cmd, "r");
-                    if (fp_count) {
-                        if (fscanf(fp_count, "%d", &stream_info[stream_count].recording_count) == 1) {
-                            if (stream_info[stream_count].recording_count > 0) {
-                                stream_count++;
-                            }
-                        }
-                        pclose(fp_count);
-                    }
-                }
-                pclose(fp);
-            }
-        }
+
+    int stream_count = get_recording_storage_usage(usage, max_streams);
+    for (int i = 0; i < stream_count; i++) {
+        strncpy(stream_info[i].name, usage[i].stream_name, sizeof(stream_info[i].name) - 1);
+        stream_info[i].name[sizeof(stream_info[i].name) - 1] = '\0';
+        stream_info[i].size_bytes = (unsigned long)usage[i].size_bytes;
+        stream_info[i].recording_count = usage[i].recording_count;
     }
-    
-    closedir(dir);
+
+    free(usage);
     return stream_count;
 }
 
@@ -106,61 +65,22 @@ int get_all_stream_storage_usage(stream_storage_info_t **stream_info) {
         log_error("Invalid parameter for get_all_stream_storage_usage");
         return -1;
     }
-    
-    // Get storage path from config
-    const char *storage_path = g_config.storage_path;
-    if (!storage_path || storage_path[0] == '\0') {
-        log_error("Storage path not configured");
-        return -1;
-    }
-    
-    // Construct the mp4 directory path
-    char mp4_path[512];
-    snprintf(mp4_path, sizeof(mp4_path), "%s/mp4", storage_path);
-    
-    // First, count the number of stream directories in the mp4 directory
-    DIR *dir = opendir(mp4_path);
-    if (!dir) {
-        log_error("Failed to open mp4 directory: %s (error: %s)", mp4_path, strerror(errno));
-        return -1;
-    }
-    
-    int stream_count = 0;
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
-        // Skip . and ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-        
-        // Check if it's a directory (stream directory)
-        char stream_path[512];
-        snprintf(stream_path, sizeof(stream_path), "%s/%s", mp4_path, entry->d_name);
-        
-        struct stat st;
-        if (stat(stream_path, &st) == 0 && S_ISDIR(st.st_mode)) {
-            stream_count++;
-        }
-    }
-    
-    closedir(dir);
-    
-    // Allocate memory for stream info array
-    *stream_info = (stream_storage_info_t *)malloc(stream_count * sizeof(stream_storage_info_t));
+
+    // Removed streams keep their counters until their recordings are gone
+    *stream_info = (stream_storage_info_t *)malloc(STREAM_STORAGE_MAX_STREAMS * sizeof(stream_storage_info_t));
     if (!*stream_info) {
         log_error("Failed to allocate memory for stream storage info");
         return -1;
     }
-    
-    // Get stream storage usage
-    int actual_count = get_stream_storage_usage(storage_path, *stream_info, stream_count);
-    
+
+    int actual_count = get_stream_storage_usage(g_config.storage_path, *stream_info, STREAM_STORAGE_MAX_STREAMS);
+
     // If no streams found, free memory
     if (actual_count <= 0) {
         free(*stream_info);
         *stream_info = NULL;
     }
-    
+
     return actual_count;
 }
 
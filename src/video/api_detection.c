@@ -3,8 +3,7 @@
 #include <string.h>
 #include <stdbool.h>
 #include <errno.h>
-#include <unistd.h>
-#include <sys/stat.h>
+#include <time.h>
 #include <curl/curl.h>
 #include <cJSON.h>
 #include <pthread.h>
@@ -14,16 +13,48 @@
 #include "core/shutdown_coordinator.h"
 #include "video/api_detection.h"
 #include "video/detection_result.h"
+#include "video/jpeg_encoder.h"
 #include "video/stream_manager.h"
 #include "video/stream_state.h"
 #include "video/zone_filter.h"
+#include "video/live_events.h"
 #include "database/db_detections.h"
 #include "video/go2rtc/go2rtc_snapshot.h"
 
-// Global variables
-static bool initialized = false;
-static CURL *curl_handle = NULL;
-static pthread_mutex_t curl_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Number of requests that can be in flight to the detection API at once
+#define API_DETECTION_POOL_SIZE 8
+
+// How long a stream waits for a free client before skipping the frame
+#define API_DETECTION_ACQUIRE_TIMEOUT_SEC 10
+
+// Quality of JPEGs encoded from raw frames
+#define API_DETECTION_JPEG_QUALITY 85
+
+typedef struct {
+    CURL *handle;
+    bool in_use;
+} api_client_t;
+
+/**
+ * Pool of curl easy handles
+ *
+ * Each handle carries one request at a time; all of them share the DNS
+ * cache, the connection cache and TLS sessions through a share handle, so
+ * a request goes out on whichever kept-alive connection to the detection
+ * server is free.  The pool mutex is only held to check a handle in or out.
+ */
+static struct {
+    api_client_t clients[API_DETECTION_POOL_SIZE];
+    CURLSH *share;
+    pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool initialized;
+} api_pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .initialized = false,
+};
 
 // Structure to hold memory for curl response
 typedef struct {
@@ -50,383 +81,304 @@ static size_t write_memory_callback(void *contents, size_t size, size_t nmemb, v
     return realsize;
 }
 
-/**
- * Initialize the API detection system
- */
-int init_api_detection_system(void) {
-    if (initialized && curl_handle) {
-        log_info("API detection system already initialized");
-        return 0;  // Already initialized and curl handle is valid
-    }
+static void share_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr) {
+    (void)handle;
+    (void)access;
+    (void)userptr;
+    pthread_mutex_lock(&api_pool.share_locks[data]);
+}
 
-    // If we have a curl handle but initialized is false, clean it up first
-    if (curl_handle) {
-        log_warn("API detection system has a curl handle but is marked as uninitialized, cleaning up");
-        curl_easy_cleanup(curl_handle);
-        curl_handle = NULL;
-    }
+static void share_unlock(CURL *handle, curl_lock_data data, void *userptr) {
+    (void)handle;
+    (void)userptr;
+    pthread_mutex_unlock(&api_pool.share_locks[data]);
+}
 
-    // Initialize curl
-    CURLcode global_init_result = curl_global_init(CURL_GLOBAL_ALL);
-    if (global_init_result != CURLE_OK) {
-        log_error("Failed to initialize curl global: %s", curl_easy_strerror(global_init_result));
-        return -1;
+/**
+ * Create an easy handle attached to the share handle
+ */
+static CURL *create_client_handle(void) {
+    CURL *handle = curl_easy_init();
+    if (!handle) {
+        return NULL;
     }
 
-    curl_handle = curl_easy_init();
-    if (!curl_handle) {
-        log_error("Failed to initialize curl handle");
-        curl_global_cleanup();
-        return -1;
-    }
+    curl_easy_setopt(handle, CURLOPT_SHARE, api_pool.share);
+    // Timeouts must not use signals when several threads run requests
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT, 10L);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, write_memory_callback);
 
-    initialized = true;
-    log_info("API detection system initialized successfully");
-    return 0;
+    return handle;
 }
 
 /**
- * Shutdown the API detection system
+ * Check out a client, waiting while all of them are busy
+ *
+ * @return Client, or NULL if the system is not initialized or the wait timed out
  */
-void shutdown_api_detection_system(void) {
-    // CRITICAL FIX: Always attempt to clean up resources, even if not marked as initialized
-    log_info("Shutting down API detection system (initialized: %s, curl_handle: %p)",
-             initialized ? "yes" : "no", (void*)curl_handle);
+static api_client_t *acquire_client(void) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += API_DETECTION_ACQUIRE_TIMEOUT_SEC;
+
+    pthread_mutex_lock(&api_pool.mutex);
+    while (api_pool.initialized) {
+        for (int i = 0; i < API_DETECTION_POOL_SIZE; i++) {
+            api_client_t *client = &api_pool.clients[i];
+            if (client->in_use) {
+                continue;
+            }
 
-    // Cleanup curl handle if it exists
-    if (curl_handle) {
-        log_info("Cleaning up curl handle");
-        curl_easy_cleanup(curl_handle);
-        curl_handle = NULL;
-    }
+            // Replace handles dropped after a failure
+            if (!client->handle) {
+                client->handle = create_client_handle();
+                if (!client->handle) {
+                    continue;
+                }
+            }
 
-    // Only call global cleanup if we were initialized
-    if (initialized) {
-        log_info("Cleaning up curl global resources");
-        curl_global_cleanup();
+            client->in_use = true;
+            pthread_mutex_unlock(&api_pool.mutex);
+            return client;
+        }
+
+        if (pthread_cond_timedwait(&api_pool.cond, &api_pool.mutex, &deadline) == ETIMEDOUT) {
+            log_warn("API Detection: Timed out waiting for a free HTTP client");
+            break;
+        }
     }
+    pthread_mutex_unlock(&api_pool.mutex);
 
-    initialized = false;
-    log_info("API detection system shutdown complete");
+    return NULL;
 }
 
 /**
- * Detect objects using the API with go2rtc snapshot
+ * Return a client to the pool
+ *
+ * @param discard Drop the handle instead of reusing it (after a curl init failure)
  */
-int detect_objects_api(const char *api_url, const unsigned char *frame_data,
-                      int width, int height, int channels, detection_result_t *result,
-                      const char *stream_name) {
-    // CRITICAL FIX: Check if we're in shutdown mode or if the stream has been stopped
-    if (is_shutdown_initiated()) {
-        log_info("API Detection: System shutdown in progress, skipping detection");
-        return -1;
+static void release_client(api_client_t *client, bool discard) {
+    // Do not keep pointers to the caller's request data on the handle
+    curl_easy_setopt(client->handle, CURLOPT_MIMEPOST, NULL);
+    curl_easy_setopt(client->handle, CURLOPT_HTTPHEADER, NULL);
+    curl_easy_setopt(client->handle, CURLOPT_WRITEDATA, NULL);
+
+    pthread_mutex_lock(&api_pool.mutex);
+    if (discard) {
+        curl_easy_cleanup(client->handle);
+        client->handle = NULL;
     }
+    client->in_use = false;
+    pthread_cond_broadcast(&api_pool.cond);
+    pthread_mutex_unlock(&api_pool.mutex);
+}
 
-    // CRITICAL FIX: Add thread safety for curl operations
-    pthread_mutex_lock(&curl_mutex);
-
-    // Initialize result to empty at the beginning to prevent segmentation fault
-    if (result) {
-        memset(result, 0, sizeof(detection_result_t));
-    } else {
-        log_error("API Detection: NULL result pointer provided");
-        pthread_mutex_unlock(&curl_mutex);
-        return -1;
-    }
+/**
+ * Initialize the API detection system
+ */
+int init_api_detection_system(void) {
+    pthread_mutex_lock(&api_pool.mutex);
 
-    // CRITICAL FIX: Check if api_url is the special "api-detection" string
-    // If so, get the actual URL from the global config
-    const char *actual_api_url = api_url;
-    if (api_url && strcmp(api_url, "api-detection") == 0) {
-        // Get the API URL from the global config
-        extern config_t g_config;
-        actual_api_url = g_config.api_detection_url;
-        log_info("API Detection: Using API URL from config: %s", actual_api_url ? actual_api_url : "NULL");
+    if (api_pool.initialized) {
+        pthread_mutex_unlock(&api_pool.mutex);
+        log_info("API detection system already initialized");
+        return 0;
     }
 
-    log_info("API Detection: Starting detection with API URL: %s", actual_api_url);
-    log_info("API Detection: Stream name: %s", stream_name ? stream_name : "NULL");
-
-    if (!initialized || !curl_handle) {
-        log_error("API detection system not initialized");
-        pthread_mutex_unlock(&curl_mutex);
+    // Initialize curl
+    CURLcode global_init_result = curl_global_init(CURL_GLOBAL_ALL);
+    if (global_init_result != CURLE_OK) {
+        pthread_mutex_unlock(&api_pool.mutex);
+        log_error("Failed to initialize curl global: %s", curl_easy_strerror(global_init_result));
         return -1;
     }
 
-    if (!actual_api_url || !result) {
-        log_error("Invalid parameters for detect_objects_api");
-        pthread_mutex_unlock(&curl_mutex);
+    api_pool.share = curl_share_init();
+    if (!api_pool.share) {
+        curl_global_cleanup();
+        pthread_mutex_unlock(&api_pool.mutex);
+        log_error("Failed to initialize curl share handle");
         return -1;
     }
 
-    // Check if the URL is valid (must start with http:// or https://)
-    if (strncmp(actual_api_url, "http://", 7) != 0 && strncmp(actual_api_url, "https://", 8) != 0) {
-        log_error("API Detection: Invalid URL format: %s (must start with http:// or https://)", actual_api_url);
-        pthread_mutex_unlock(&curl_mutex);
-        return -1;
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&api_pool.share_locks[i], NULL);
+    }
+    curl_share_setopt(api_pool.share, CURLSHOPT_LOCKFUNC, share_lock);
+    curl_share_setopt(api_pool.share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+    curl_share_setopt(api_pool.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(api_pool.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    if (curl_share_setopt(api_pool.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT) != CURLSHE_OK) {
+        // Older libcurl, each handle keeps its own connections
+        log_warn("API Detection: libcurl cannot share connections between handles");
     }
 
-    // NEW APPROACH: Use go2rtc to get a JPEG snapshot directly
-    // This eliminates the need for ffmpeg conversion and all the associated logs
-    unsigned char *jpeg_data = NULL;
-    size_t jpeg_size = 0;
-    char temp_filename[256] = {0};
+    // Handles are created on first use
+    for (int i = 0; i < API_DETECTION_POOL_SIZE; i++) {
+        api_pool.clients[i].handle = NULL;
+        api_pool.clients[i].in_use = false;
+    }
 
-    if (stream_name && go2rtc_get_snapshot(stream_name, &jpeg_data, &jpeg_size)) {
-        log_info("API Detection: Successfully fetched snapshot from go2rtc: %zu bytes", jpeg_size);
+    api_pool.initialized = true;
+    pthread_mutex_unlock(&api_pool.mutex);
 
-        // Write the JPEG data to a temporary file for curl to upload
-        snprintf(temp_filename, sizeof(temp_filename), "/tmp/lightnvr_go2rtc_snapshot_%s_XXXXXX", stream_name);
-        int temp_fd = mkstemp(temp_filename);
-        if (temp_fd >= 0) {
-            ssize_t written = write(temp_fd, jpeg_data, jpeg_size);
-            close(temp_fd);
-
-            if (written != (ssize_t)jpeg_size) {
-                log_error("API Detection: Failed to write snapshot to temp file");
-                free(jpeg_data);
-                unlink(temp_filename);
-                pthread_mutex_unlock(&curl_mutex);
-                return -1;
-            }
-        } else {
-            log_error("API Detection: Failed to create temp file for snapshot");
-            free(jpeg_data);
-            pthread_mutex_unlock(&curl_mutex);
-            return -1;
-        }
+    log_info("API detection system initialized successfully (%d concurrent requests)",
+             API_DETECTION_POOL_SIZE);
+    return 0;
+}
 
-        // Free the JPEG data as we've written it to file
-        free(jpeg_data);
-        jpeg_data = NULL;
-    } else {
-        log_warn("API Detection: Failed to get snapshot from go2rtc, falling back to ffmpeg conversion");
-
-        // FALLBACK: Use the old ffmpeg-based approach
-        // Create a temporary file for the raw image data
-        char raw_temp_filename[] = "/tmp/lightnvr_api_detection_XXXXXX";
-        int temp_fd = mkstemp(raw_temp_filename);
-        if (temp_fd < 0) {
-            log_error("Failed to create temporary file: %s", strerror(errno));
-            pthread_mutex_unlock(&curl_mutex);
-            return -1;
-        }
+/**
+ * Shutdown the API detection system
+ */
+void shutdown_api_detection_system(void) {
+    pthread_mutex_lock(&api_pool.mutex);
 
-        // Convert file descriptor to FILE pointer
-        FILE *temp_file = fdopen(temp_fd, "wb");
-        if (!temp_file) {
-            log_error("Failed to open temporary file for writing: %s", strerror(errno));
-            close(temp_fd);
-            unlink(raw_temp_filename);
-            pthread_mutex_unlock(&curl_mutex);
-            return -1;
-        }
+    if (!api_pool.initialized) {
+        pthread_mutex_unlock(&api_pool.mutex);
+        return;
+    }
 
-        // Write the raw image data to the file
-        size_t bytes_written = fwrite(frame_data, 1, width * height * channels, temp_file);
-        fclose(temp_file);
+    log_info("Shutting down API detection system");
 
-        if (bytes_written != (size_t)(width * height * channels)) {
-            log_error("Failed to write image data to temporary file");
-            unlink(raw_temp_filename);
-            pthread_mutex_unlock(&curl_mutex);
-            return -1;
-        }
+    // New requests fail from here on, wait for the ones in flight
+    api_pool.initialized = false;
+    pthread_cond_broadcast(&api_pool.cond);
 
-        // Convert using ffmpeg
-        snprintf(temp_filename, sizeof(temp_filename), "%s.jpg", raw_temp_filename);
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += API_DETECTION_ACQUIRE_TIMEOUT_SEC;
 
-        const char *ffmpeg_pixel_format = (channels == 1) ? "gray" : (channels == 3) ? "rgb24" : "rgba";
-        char ffmpeg_cmd[1024];
-        snprintf(ffmpeg_cmd, sizeof(ffmpeg_cmd),
-                "ffmpeg -loglevel quiet -f rawvideo -pixel_format %s -video_size %dx%d -i %s -y %s 2>/dev/null",
-                ffmpeg_pixel_format, width, height, raw_temp_filename, temp_filename);
+    bool busy = false;
+    for (int i = 0; i < API_DETECTION_POOL_SIZE; i++) {
+        api_client_t *client = &api_pool.clients[i];
+        while (client->in_use) {
+            if (pthread_cond_timedwait(&api_pool.cond, &api_pool.mutex, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
 
-        int ffmpeg_result = system(ffmpeg_cmd);
-        unlink(raw_temp_filename); // Clean up raw file
+        if (client->in_use) {
+            // Leak it rather than free it under a running request
+            log_warn("API Detection: HTTP client %d still in use at shutdown", i);
+            busy = true;
+            continue;
+        }
 
-        if (ffmpeg_result != 0) {
-            log_error("API Detection: Failed to convert with ffmpeg");
-            pthread_mutex_unlock(&curl_mutex);
-            return -1;
+        if (client->handle) {
+            curl_easy_cleanup(client->handle);
+            client->handle = NULL;
         }
     }
 
-    // Set up curl for multipart/form-data
-    struct curl_httppost *formpost = NULL;
-    struct curl_httppost *lastptr = NULL;
-
-    // Add the JPEG file to the form
-    struct stat image_stat;
-    memory_struct_t chunk = {0};
-    chunk.memory = NULL;
-    struct curl_slist *headers = NULL;
-
-    if (stat(temp_filename, &image_stat) == 0 && image_stat.st_size > 0) {
-        CURLFORMcode form_result = curl_formadd(&formpost, &lastptr,
-                    CURLFORM_COPYNAME, "file",
-                    CURLFORM_FILE, temp_filename,
-                    CURLFORM_CONTENTTYPE, "image/jpeg",
-                    CURLFORM_END);
-
-        if (form_result != CURL_FORMADD_OK) {
-            log_error("API Detection: Failed to add JPEG file to form (error code: %d)", form_result);
-            free(chunk.memory);
-            curl_formfree(formpost);
-            curl_slist_free_all(headers);
-            unlink(temp_filename);
-            result->count = 0;
-            pthread_mutex_unlock(&curl_mutex);
-            return -1;
+    // The share handle and curl itself can only go once no easy handle uses them
+    if (!busy) {
+        curl_share_cleanup(api_pool.share);
+        api_pool.share = NULL;
+        for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+            pthread_mutex_destroy(&api_pool.share_locks[i]);
         }
+        curl_global_cleanup();
+    }
 
-        log_info("API Detection: Successfully added JPEG file to form: %s", temp_filename);
-    } else {
-        log_error("API Detection: JPEG file missing or empty: %s", temp_filename);
-        // Now we can safely free them
-        if (chunk.memory) free(chunk.memory);
-        if (formpost) curl_formfree(formpost);
-        if (headers) curl_slist_free_all(headers);
+    pthread_mutex_unlock(&api_pool.mutex);
+    log_info("API detection system shutdown complete");
+}
 
-        unlink(temp_filename);
-        result->count = 0;
-        pthread_mutex_unlock(&curl_mutex);
+/**
+ * Upload a JPEG to the detection API
+ *
+ * @param url Request URL including query parameters
+ * @param jpeg_data JPEG image
+ * @param jpeg_size Size of the JPEG image
+ * @param response Receives the response body (caller frees response->memory)
+ * @return 0 on HTTP 200, -1 otherwise
+ */
+static int send_detection_request(const char *url, const unsigned char *jpeg_data, size_t jpeg_size,
+                                  memory_struct_t *response) {
+    api_client_t *client = acquire_client();
+    if (!client) {
+        log_error("API Detection: No HTTP client available");
         return -1;
     }
 
-    // Get the backend from config (default to "onnx" if not set)
-    extern config_t g_config;
-    const char *backend = g_config.api_detection_backend;
-    if (!backend || strlen(backend) == 0) {
-        backend = "onnx";
+    CURL *handle = client->handle;
+
+    // Build the multipart body straight from the in-memory JPEG
+    curl_mime *mime = curl_mime_init(handle);
+    curl_mimepart *part = mime ? curl_mime_addpart(mime) : NULL;
+    if (!part ||
+        curl_mime_name(part, "file") != CURLE_OK ||
+        curl_mime_filename(part, "frame.jpg") != CURLE_OK ||
+        curl_mime_type(part, "image/jpeg") != CURLE_OK ||
+        curl_mime_data(part, (const char *)jpeg_data, jpeg_size) != CURLE_OK) {
+        log_error("API Detection: Failed to build multipart request");
+        curl_mime_free(mime);
+        release_client(client, false);
+        return -1;
     }
 
-    // Construct the URL with query parameters
-    char url_with_params[1024];
-    snprintf(url_with_params, sizeof(url_with_params),
-             "%s?backend=%s&confidence_threshold=0.5&return_image=false",
-             actual_api_url, backend);
-    log_info("API Detection: Using URL with parameters: %s (backend: %s)", url_with_params, backend);
-
-    // Set up the request with the URL including query parameters
-    curl_easy_setopt(curl_handle, CURLOPT_URL, url_with_params);
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPPOST, formpost);
-
-    // Add the accept header
-    headers = curl_slist_append(headers, "accept: application/json");
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
-
-    // Set up the response buffer
-    chunk.memory = malloc(1);
-    chunk.size = 0;
+    struct curl_slist *headers = curl_slist_append(NULL, "accept: application/json");
 
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_memory_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *)&chunk);
+    curl_easy_setopt(handle, CURLOPT_URL, url);
+    curl_easy_setopt(handle, CURLOPT_MIMEPOST, mime);
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, (void *)response);
 
-    // Set a timeout
-    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, 10);
+    log_info("API Detection: Sending %zu byte JPEG to %s", jpeg_size, url);
+    CURLcode res = curl_easy_perform(handle);
 
-    // Perform the request
-    log_info("API Detection: Sending request to %s", url_with_params);
-
-    // CRITICAL FIX: Check if curl handle is still valid before performing the request
-    if (!curl_handle || !initialized) {
-        log_error("API Detection: curl handle is invalid or API detection system not initialized");
-        free(chunk.memory);
-        curl_formfree(formpost);
-        curl_slist_free_all(headers);
-
-        // Clean up the temporary file
-        unlink(temp_filename);
-
-        // Initialize result to empty to prevent segmentation fault
-        result->count = 0;
-        pthread_mutex_unlock(&curl_mutex);
-        return -1;
+    long http_code = 0;
+    if (res == CURLE_OK) {
+        curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &http_code);
     }
 
-    CURLcode res = curl_easy_perform(curl_handle);
+    // Free the request data before another thread can pick up the handle
+    curl_mime_free(mime);
+    curl_slist_free_all(headers);
+    release_client(client, res == CURLE_FAILED_INIT);
 
-    // Check for errors
     if (res != CURLE_OK) {
         log_error("API Detection: curl_easy_perform() failed: %s", curl_easy_strerror(res));
 
         // Check if it's a connection error
         if (res == CURLE_COULDNT_CONNECT) {
-            log_error("API Detection: Could not connect to server at %s. Is the API server running?", url_with_params);
+            log_error("API Detection: Could not connect to server at %s. Is the API server running?", url);
         } else if (res == CURLE_OPERATION_TIMEDOUT) {
-            log_error("API Detection: Connection to %s timed out. Server might be slow or unreachable.", url_with_params);
+            log_error("API Detection: Connection to %s timed out. Server might be slow or unreachable.", url);
         } else if (res == CURLE_COULDNT_RESOLVE_HOST) {
-            log_error("API Detection: Could not resolve host %s. Check your network connection and DNS settings.", url_with_params);
+            log_error("API Detection: Could not resolve host %s. Check your network connection and DNS settings.", url);
         } else if (res == CURLE_FAILED_INIT) {
-            log_error("API Detection: Curl initialization failed. Reinitializing curl handle...");
-
-            // Attempt to reinitialize curl
-            if (curl_handle) {
-                curl_easy_cleanup(curl_handle);
-                curl_handle = NULL;
-            }
-
-            curl_handle = curl_easy_init();
-            if (!curl_handle) {
-                log_error("API Detection: Failed to reinitialize curl handle");
-                initialized = false; // Mark as uninitialized to force reinitialization next time
-            } else {
-                log_info("API Detection: Successfully reinitialized curl handle");
-            }
+            log_error("API Detection: Curl initialization failed, the handle will be recreated");
         }
-
-        free(chunk.memory);
-        curl_formfree(formpost);
-        curl_slist_free_all(headers);
-
-        // Clean up the temporary file
-        unlink(temp_filename);
-
-        // Initialize result to empty to prevent segmentation fault
-        result->count = 0;
-        pthread_mutex_unlock(&curl_mutex);
         return -1;
     }
 
-    // Get the HTTP response code
-    long http_code = 0;
-    curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &http_code);
-
     if (http_code != 200) {
         log_error("API request failed with HTTP code %ld", http_code);
-        free(chunk.memory);
-        curl_formfree(formpost);
-        curl_slist_free_all(headers);
-
-        // Clean up the temporary file
-        unlink(temp_filename);
-
-        pthread_mutex_unlock(&curl_mutex);
         return -1;
     }
 
-    // Parse the JSON response
+    return 0;
+}
+
+/**
+ * Parse the detection API response into a result
+ *
+ * @return 0 on success, -1 if the response is not valid
+ */
+static int parse_detection_response(const memory_struct_t *chunk, detection_result_t *result) {
     // CRITICAL FIX: Add additional logging and validation for JSON parsing
-    if (!chunk.memory || chunk.size == 0) {
+    if (!chunk->memory || chunk->size == 0) {
         log_error("API Detection: Empty response from server");
-        free(chunk.memory);
-        curl_formfree(formpost);
-        curl_slist_free_all(headers);
-
-        // Clean up the temporary file
-        unlink(temp_filename);
-
-        // Initialize result to empty to prevent segmentation fault
-        result->count = 0;
-        pthread_mutex_unlock(&curl_mutex);
         return -1;
     }
 
     // Log the first few bytes of the response for debugging
     char preview[64] = {0};
-    int preview_len = chunk.size < 63 ? chunk.size : 63;
-    memcpy(preview, chunk.memory, preview_len);
+    int preview_len = chunk->size < 63 ? chunk->size : 63;
+    memcpy(preview, chunk->memory, preview_len);
     preview[preview_len] = '\0';
     // Replace non-printable characters with dots
     for (int i = 0; i < preview_len; i++) {
@@ -436,24 +388,14 @@ int detect_objects_api(const char *api_url, const unsigned char *frame_data,
     }
     log_info("API Detection: Response preview: %s", preview);
 
-    cJSON *root = cJSON_Parse(chunk.memory);
+    cJSON *root = cJSON_Parse(chunk->memory);
 
     if (!root) {
         const char *error_ptr = cJSON_GetErrorPtr();
         log_error("Failed to parse JSON response: %s", error_ptr ? error_ptr : "Unknown error");
         // Log more details about the response
-        log_error("API Detection: Response size: %zu bytes", chunk.size);
+        log_error("API Detection: Response size: %zu bytes", chunk->size);
         log_error("API Detection: Response preview: %s", preview);
-        free(chunk.memory);
-        curl_formfree(formpost);
-        curl_slist_free_all(headers);
-
-        // Clean up the temporary file
-        unlink(temp_filename);
-
-        // Initialize result to empty to prevent segmentation fault
-        result->count = 0;
-        pthread_mutex_unlock(&curl_mutex);
         return -1;
     }
 
@@ -468,16 +410,6 @@ int detect_objects_api(const char *api_url, const unsigned char *frame_data,
             free(json_str);
         }
         cJSON_Delete(root);
-        free(chunk.memory);
-        curl_formfree(formpost);
-        curl_slist_free_all(headers);
-
-        // Clean up the temporary file
-        unlink(temp_filename);
-
-        // Initialize result to empty to prevent segmentation fault
-        result->count = 0;
-        pthread_mutex_unlock(&curl_mutex);
         return -1;
     }
 
@@ -564,6 +496,98 @@ int detect_objects_api(const char *api_url, const unsigned char *frame_data,
         result->count++;
     }
 
+    cJSON_Delete(root);
+    return 0;
+}
+
+/**
+ * Detect objects using the API with go2rtc snapshot
+ */
+int detect_objects_api(const char *api_url, const unsigned char *frame_data,
+                      int width, int height, int channels, detection_result_t *result,
+                      const char *stream_name) {
+    // CRITICAL FIX: Check if we're in shutdown mode or if the stream has been stopped
+    if (is_shutdown_initiated()) {
+        log_info("API Detection: System shutdown in progress, skipping detection");
+        return -1;
+    }
+
+    // Initialize result to empty at the beginning to prevent segmentation fault
+    if (result) {
+        memset(result, 0, sizeof(detection_result_t));
+    } else {
+        log_error("API Detection: NULL result pointer provided");
+        return -1;
+    }
+
+    // CRITICAL FIX: Check if api_url is the special "api-detection" string
+    // If so, get the actual URL from the global config
+    extern config_t g_config;
+    const char *actual_api_url = api_url;
+    if (api_url && strcmp(api_url, "api-detection") == 0) {
+        // Get the API URL from the global config
+        actual_api_url = g_config.api_detection_url;
+        log_info("API Detection: Using API URL from config: %s", actual_api_url ? actual_api_url : "NULL");
+    }
+
+    log_info("API Detection: Starting detection with API URL: %s", actual_api_url);
+    log_info("API Detection: Stream name: %s", stream_name ? stream_name : "NULL");
+
+    if (!actual_api_url) {
+        log_error("Invalid parameters for detect_objects_api");
+        return -1;
+    }
+
+    // Check if the URL is valid (must start with http:// or https://)
+    if (strncmp(actual_api_url, "http://", 7) != 0 && strncmp(actual_api_url, "https://", 8) != 0) {
+        log_error("API Detection: Invalid URL format: %s (must start with http:// or https://)", actual_api_url);
+        return -1;
+    }
+
+    // Prefer a JPEG snapshot straight from go2rtc, it needs no encoding here
+    unsigned char *jpeg_data = NULL;
+    size_t jpeg_size = 0;
+
+    if (stream_name && go2rtc_get_snapshot(stream_name, &jpeg_data, &jpeg_size)) {
+        log_info("API Detection: Successfully fetched snapshot from go2rtc: %zu bytes", jpeg_size);
+    } else {
+        log_warn("API Detection: Failed to get snapshot from go2rtc, encoding the frame in-process");
+
+        if (!frame_data ||
+            jpeg_encode_frame(frame_data, width, height, channels, API_DETECTION_JPEG_QUALITY,
+                              &jpeg_data, &jpeg_size) != 0) {
+            log_error("API Detection: Failed to encode frame as JPEG");
+            return -1;
+        }
+    }
+
+    // Get the backend from config (default to "onnx" if not set)
+    const char *backend = g_config.api_detection_backend;
+    if (!backend || strlen(backend) == 0) {
+        backend = "onnx";
+    }
+
+    // Construct the URL with query parameters
+    char url_with_params[1024];
+    snprintf(url_with_params, sizeof(url_with_params),
+             "%s?backend=%s&confidence_threshold=0.5&return_image=false",
+             actual_api_url, backend);
+
+    memory_struct_t chunk = {0};
+    int ret = send_detection_request(url_with_params, jpeg_data, jpeg_size, &chunk);
+    free(jpeg_data);
+
+    if (ret == 0) {
+        ret = parse_detection_response(&chunk, result);
+    }
+    free(chunk.memory);
+
+    if (ret != 0) {
+        // Initialize result to empty to prevent segmentation fault
+        result->count = 0;
+        return -1;
+    }
+
     // Filter detections by zones before storing
     if (stream_name && stream_name[0] != '\0') {
         log_info("API Detection: Filtering %d detections by zones for stream %s", result->count, stream_name);
@@ -572,21 +596,14 @@ int detect_objects_api(const char *api_url, const unsigned char *frame_data,
             log_warn("Failed to filter detections by zones, storing all detections");
         }
 
+        // Push to live viewers before the database write
+        live_events_publish_detections(stream_name, result, 0);
+
         // Store the detections in the database
         store_detections_in_db(stream_name, result, 0); // 0 means use current time
     } else {
         log_warn("No stream name provided, skipping database storage");
     }
 
-    // Clean up
-    cJSON_Delete(root);
-    free(chunk.memory);
-    curl_formfree(formpost);
-    curl_slist_free_all(headers);
-
-    // Clean up the temporary file AFTER all curl operations are complete
-    unlink(temp_filename);
-
-    pthread_mutex_unlock(&curl_mutex);
     return 0;
 }
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+
+#include "core/logger.h"
+#include "video/detection_frame_cache.h"
+#include "video/detection_embedded.h"
+#include "video/detection_model.h"
+
+/**
+ * Pick the size frames are converted to for a model
+ */
+static void choose_target_size(detection_model_t model, int src_width, int src_height,
+                               int *dst_width, int *dst_height) {
+    // Models with a fixed input get frames at exactly that size
+    if (get_model_input_size(model, dst_width, dst_height) == 0 &&
+        *dst_width > 0 && *dst_height > 0) {
+        return;
+    }
+
+    int downscale_factor = get_downscale_factor(get_model_type_from_handle(model));
+    if (downscale_factor < 1) {
+        downscale_factor = 1;
+    }
+
+    // Ensure dimensions are even (required by some codecs)
+    *dst_width = ((src_width / downscale_factor) / 2) * 2;
+    *dst_height = ((src_height / downscale_factor) / 2) * 2;
+}
+
+/**
+ * Rebuild the scaler and buffer for a new source or model
+ */
+static int rebuild_cache(detection_frame_cache_t *cache, const AVFrame *frame, detection_model_t model) {
+    detection_frame_cache_free(cache);
+
+    int dst_width = 0;
+    int dst_height = 0;
+    choose_target_size(model, frame->width, frame->height, &dst_width, &dst_height);
+    if (dst_width <= 0 || dst_height <= 0) {
+        log_error("Invalid detection frame size %dx%d for %dx%d source",
+                  dst_width, dst_height, frame->width, frame->height);
+        return -1;
+    }
+
+    cache->sws_ctx = sws_getContext(frame->width, frame->height, frame->format,
+                                    dst_width, dst_height, AV_PIX_FMT_RGB24,
+                                    SWS_BILINEAR, NULL, NULL, NULL);
+    if (!cache->sws_ctx) {
+        log_error("Failed to create SwsContext for %dx%d -> %dx%d",
+                  frame->width, frame->height, dst_width, dst_height);
+        return -1;
+    }
+
+    cache->channels = 3;
+    cache->buffer = malloc((size_t)dst_width * dst_height * cache->channels);
+    if (!cache->buffer) {
+        log_error("Failed to allocate detection frame buffer");
+        detection_frame_cache_free(cache);
+        return -1;
+    }
+
+    cache->model = model;
+    cache->src_width = frame->width;
+    cache->src_height = frame->height;
+    cache->src_format = frame->format;
+    cache->dst_width = dst_width;
+    cache->dst_height = dst_height;
+
+    log_info("Detection frame conversion set up: %dx%d -> %dx%d RGB (model: %s)",
+             frame->width, frame->height, dst_width, dst_height,
+             get_model_type_from_handle(model));
+    return 0;
+}
+
+const uint8_t *detection_frame_cache_convert(detection_frame_cache_t *cache, const AVFrame *frame,
+                                             detection_model_t model,
+                                             int *width, int *height, int *channels) {
+    if (!cache || !frame || !model || !width || !height || !channels ||
+        frame->width <= 0 || frame->height <= 0) {
+        return NULL;
+    }
+
+    if (!cache->sws_ctx || cache->model != model ||
+        cache->src_width != frame->width || cache->src_height != frame->height ||
+        cache->src_format != frame->format) {
+        if (rebuild_cache(cache, frame, model) != 0) {
+            return NULL;
+        }
+    }
+
+    uint8_t *dst_data[4] = {cache->buffer, NULL, NULL, NULL};
+    int dst_linesize[4] = {cache->dst_width * cache->channels, 0, 0, 0};
+    sws_scale(cache->sws_ctx, (const uint8_t * const *)frame->data, frame->linesize, 0,
+              frame->height, dst_data, dst_linesize);
+
+    *width = cache->dst_width;
+    *height = cache->dst_height;
+    *channels = cache->channels;
+    return cache->buffer;
+}
+
+void detection_frame_cache_free(detection_frame_cache_t *cache) {
+    if (!cache) {
+        return;
+    }
+
+    if (cache->sws_ctx) {
+        sws_freeContext(cache->sws_ctx);
+    }
+    free(cache->buffer);
+    memset(cache, 0, sizeof(*cache));
+}
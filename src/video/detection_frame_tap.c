@@ -0,0 +1,249 @@
+/**
+ * Live keyframe tap for object detection
+ *
+ * The tap owns a keyframes-only packet bus subscriber with a small queue and
+ * one decoder that lives as long as the tap.  Each keyframe is decoded on its
+ * own (send, drain, flush) so a picture is returned as soon as the keyframe
+ * arrives instead of after the HLS segment containing it has been closed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+
+#include "core/logger.h"
+#include "core/config.h"
+#include "video/stream_manager.h"
+#include "video/stream_protocol.h"
+#include "video/packet_bus.h"
+#include "video/detection_frame_tap.h"
+#include "video/go2rtc/go2rtc_integration.h"
+
+extern bool go2rtc_get_rtsp_url(const char *stream_name, char *url, size_t url_size);
+
+// How long to wait for the ingest to publish its stream layout
+#define DETECTION_FRAME_TAP_CONNECT_TIMEOUT_MS 5000
+
+struct detection_frame_tap {
+    char stream_name[MAX_STREAM_NAME];
+    packet_bus_subscriber_t *sub;
+    AVCodecContext *codec_ctx;
+    AVPacket *pkt;
+    int video_stream_idx;
+};
+
+/**
+ * Resolve the URL the HLS writer reads so the tap joins the same ingest
+ */
+static int resolve_ingest_url(const char *stream_name, char *url, size_t url_size, int *protocol) {
+    stream_handle_t stream = get_stream_by_name(stream_name);
+    if (!stream) {
+        log_error("Stream %s not found for detection frame tap", stream_name);
+        return -1;
+    }
+
+    stream_config_t config;
+    if (get_stream_config(stream, &config) != 0) {
+        log_error("Failed to get config for stream %s", stream_name);
+        return -1;
+    }
+
+    strncpy(url, config.url, url_size - 1);
+    url[url_size - 1] = '\0';
+    *protocol = config.protocol;
+
+    if (go2rtc_integration_is_using_go2rtc_for_hls(stream_name) &&
+        !go2rtc_get_rtsp_url(stream_name, url, url_size)) {
+        log_warn("Failed to get go2rtc RTSP URL for detection on stream %s, using original URL", stream_name);
+        strncpy(url, config.url, url_size - 1);
+        url[url_size - 1] = '\0';
+    }
+
+    return 0;
+}
+
+/**
+ * (Re)create the decoder from the current ingest layout
+ */
+static int open_decoder(detection_frame_tap_t *tap) {
+    AVFormatContext *layout = NULL;
+
+    avcodec_free_context(&tap->codec_ctx);
+    tap->video_stream_idx = -1;
+
+    int ret = packet_bus_copy_streams(tap->sub, &layout, DETECTION_FRAME_TAP_CONNECT_TIMEOUT_MS);
+    if (ret < 0) {
+        return ret;
+    }
+
+    int video_stream_idx = find_video_stream_index(layout);
+    if (video_stream_idx < 0) {
+        log_error("[Stream %s] No video stream available for detection frame tap", tap->stream_name);
+        avformat_close_input(&layout);
+        return AVERROR_STREAM_NOT_FOUND;
+    }
+
+    AVCodecParameters *codecpar = layout->streams[video_stream_idx]->codecpar;
+    const AVCodec *codec = avcodec_find_decoder(codecpar->codec_id);
+    if (!codec) {
+        log_error("[Stream %s] No decoder for codec id %d", tap->stream_name, codecpar->codec_id);
+        avformat_close_input(&layout);
+        return AVERROR_DECODER_NOT_FOUND;
+    }
+
+    tap->codec_ctx = avcodec_alloc_context3(codec);
+    if (!tap->codec_ctx) {
+        avformat_close_input(&layout);
+        return AVERROR(ENOMEM);
+    }
+
+    ret = avcodec_parameters_to_context(tap->codec_ctx, codecpar);
+    avformat_close_input(&layout);
+    if (ret < 0) {
+        avcodec_free_context(&tap->codec_ctx);
+        return ret;
+    }
+
+    // Every packet is an independent keyframe; do not hold pictures back for reordering
+    tap->codec_ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+
+    ret = avcodec_open2(tap->codec_ctx, codec, NULL);
+    if (ret < 0) {
+        char err_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+        av_strerror(ret, err_buf, sizeof(err_buf));
+        log_error("[Stream %s] Could not open decoder for detection frame tap: %s", tap->stream_name, err_buf);
+        avcodec_free_context(&tap->codec_ctx);
+        return ret;
+    }
+
+    tap->video_stream_idx = video_stream_idx;
+    log_info("[Stream %s] Detection frame tap decoding %s %dx%d",
+             tap->stream_name, codec->name, tap->codec_ctx->width, tap->codec_ctx->height);
+    return 0;
+}
+
+/**
+ * Open a keyframe tap on the live ingest of a stream
+ */
+detection_frame_tap_t *detection_frame_tap_open(const char *stream_name) {
+    if (!stream_name || !packet_bus_is_enabled()) {
+        return NULL;
+    }
+
+    char url[MAX_URL_LENGTH];
+    int protocol = STREAM_PROTOCOL_TCP;
+    if (resolve_ingest_url(stream_name, url, sizeof(url), &protocol) != 0) {
+        return NULL;
+    }
+
+    detection_frame_tap_t *tap = calloc(1, sizeof(detection_frame_tap_t));
+    if (!tap) {
+        log_error("Failed to allocate detection frame tap for stream %s", stream_name);
+        return NULL;
+    }
+
+    strncpy(tap->stream_name, stream_name, MAX_STREAM_NAME - 1);
+    tap->stream_name[MAX_STREAM_NAME - 1] = '\0';
+    tap->video_stream_idx = -1;
+
+    tap->pkt = av_packet_alloc();
+    tap->sub = packet_bus_subscribe(stream_name, url, protocol, "detection",
+                                    PACKET_BUS_SUB_KEYFRAMES_ONLY, DETECTION_FRAME_TAP_QUEUE_SIZE);
+    if (!tap->pkt || !tap->sub) {
+        log_error("Failed to attach detection frame tap to stream %s", stream_name);
+        detection_frame_tap_close(tap);
+        return NULL;
+    }
+
+    if (open_decoder(tap) < 0) {
+        log_warn("[Stream %s] Ingest not ready for detection frame tap", stream_name);
+        detection_frame_tap_close(tap);
+        return NULL;
+    }
+
+    log_info("[Stream %s] Detection reading keyframes from the live ingest", stream_name);
+    return tap;
+}
+
+/**
+ * Close a keyframe tap
+ */
+void detection_frame_tap_close(detection_frame_tap_t *tap) {
+    if (!tap) {
+        return;
+    }
+
+    packet_bus_unsubscribe(tap->sub);
+    avcodec_free_context(&tap->codec_ctx);
+    av_packet_free(&tap->pkt);
+    free(tap);
+}
+
+/**
+ * Wait for the next keyframe and decode it
+ */
+int detection_frame_tap_read(detection_frame_tap_t *tap, AVFrame *frame, int timeout_ms) {
+    if (!tap || !frame) {
+        return AVERROR(EINVAL);
+    }
+
+    int ret;
+
+    // A previous reopen timed out while the ingest was reconnecting
+    if (!tap->codec_ctx) {
+        ret = open_decoder(tap);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    ret = packet_bus_read(tap->sub, tap->pkt, timeout_ms);
+    if (ret == PACKET_BUS_ERR_RESET) {
+        // The camera reconnected; codec parameters may have changed
+        log_info("[Stream %s] Ingest reconnected, reopening detection decoder", tap->stream_name);
+        ret = open_decoder(tap);
+        return ret < 0 ? ret : AVERROR(EAGAIN);
+    }
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (tap->pkt->stream_index != tap->video_stream_idx) {
+        av_packet_unref(tap->pkt);
+        return AVERROR(EAGAIN);
+    }
+
+    ret = avcodec_send_packet(tap->codec_ctx, tap->pkt);
+    av_packet_unref(tap->pkt);
+    if (ret < 0) {
+        avcodec_flush_buffers(tap->codec_ctx);
+        return ret;
+    }
+
+    // Drain so the keyframe comes out now rather than when the next packet arrives
+    avcodec_send_packet(tap->codec_ctx, NULL);
+    av_frame_unref(frame);
+    ret = avcodec_receive_frame(tap->codec_ctx, frame);
+
+    // Leave draining mode so the next keyframe can be decoded
+    avcodec_flush_buffers(tap->codec_ctx);
+
+    if (ret == AVERROR_EOF) {
+        return AVERROR(EAGAIN);
+    }
+    return ret;
+}
+
+/**
+ * Discard keyframes queued while detection was not due
+ */
+void detection_frame_tap_flush(detection_frame_tap_t *tap) {
+    if (tap) {
+        packet_bus_flush(tap->sub);
+    }
+}
@@ -292,6 +292,23 @@ const char* get_model_type_from_handle(detection_model_t model) {
     return m->type;
 }
 
+/**
+ * Get the fixed input size of a model
+ */
+int get_model_input_size(detection_model_t model, int *width, int *height) {
+    if (!model || !width || !height) {
+        return -1;
+    }
+
+    model_t *m = (model_t *)model;
+    if (strcmp(m->type, MODEL_TYPE_SOD) == 0) {
+        return get_sod_model_input_size(model, width, height);
+    }
+
+    // RealNet, TFLite and remote models take frames of any size
+    return -1;
+}
+
 /**
  * Clean up old models in the global cache
  *
@@ -18,6 +18,8 @@
 #include "video/detection_result.h"
 #include "video/detection_stream.h"
 #include "video/detection_stream_thread.h"
+#include "video/segment_remux.h"
+#include "video/hls_memory_store.h"
 #include "database/database_manager.h"
 #include "database/db_recordings.h"
 #include "web/api_handlers_detection_results.h"
@@ -121,6 +123,65 @@ void shutdown_detection_recording_system(void) {
     log_info("Detection-based recording system shutdown");
 }
 
+/**
+ * Create a directory and any missing parents
+ */
+static void create_directory_path(const char *path) {
+    char temp_path[MAX_PATH_LENGTH];
+    strncpy(temp_path, path, MAX_PATH_LENGTH - 1);
+    temp_path[MAX_PATH_LENGTH - 1] = '\0';
+
+    for (char *p = temp_path + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(temp_path, 0755) != 0 && errno != EEXIST) {
+                log_warn("Failed to create parent directory: %s (error: %s)",
+                        temp_path, strerror(errno));
+            }
+            *p = '/';
+        }
+    }
+
+    if (mkdir(temp_path, 0755) != 0 && errno != EEXIST) {
+        log_warn("Failed to create directory: %s (error: %s)", temp_path, strerror(errno));
+    }
+}
+
+/**
+ * Copy a segment file, used when it cannot be hard linked
+ */
+static int copy_segment_file(const char *src_path, const char *dst_path) {
+    FILE *src = fopen(src_path, "rb");
+    if (!src) {
+        return -1;
+    }
+
+    FILE *dst = fopen(dst_path, "wb");
+    if (!dst) {
+        fclose(src);
+        return -1;
+    }
+
+    char buffer[65536];
+    size_t bytes;
+    int result = 0;
+    while ((bytes = fread(buffer, 1, sizeof(buffer), src)) > 0) {
+        if (fwrite(buffer, 1, bytes, dst) != bytes) {
+            result = -1;
+            break;
+        }
+    }
+
+    fclose(src);
+    if (fclose(dst) != 0) {
+        result = -1;
+    }
+    if (result != 0) {
+        unlink(dst_path);
+    }
+    return result;
+}
+
 /**
  * Add an HLS segment to the pre-detection buffer
  * This maintains a circular buffer of the most recent segments
@@ -147,34 +208,39 @@ static void add_segment_to_buffer(detection_recording_t *rec, const char *segmen
         rec->buffer_count--;
     }
 
-    // Copy the new segment to the buffer directory
+    // Hold the segment through a hard link to the same file, no bytes are copied.
+    // The link keeps the data alive after the HLS writer deletes its own name.
     char buffer_segment_path[MAX_PATH_LENGTH];
     snprintf(buffer_segment_path, MAX_PATH_LENGTH, "%s/buffer_%d.ts",
              rec->buffer_dir, slot);
+    unlink(buffer_segment_path);
+
+    // With HLS kept in memory the segment is only in the store, write it out
+    const char *file_name = strrchr(segment_path, '/');
+    bool held = (hls_memory_store_save(rec->stream_name, file_name ? file_name + 1 : segment_path,
+                                       buffer_segment_path) == 0);
+    if (!held) {
+        held = (link(segment_path, buffer_segment_path) == 0);
+        if (!held && (errno == EXDEV || errno == EPERM || errno == EMLINK)) {
+            // Buffer directory on another filesystem (or links not supported), copy instead
+            held = (copy_segment_file(segment_path, buffer_segment_path) == 0);
+        }
+    }
 
-    // Copy the file
-    FILE *src = fopen(segment_path, "rb");
-    if (src) {
-        FILE *dst = fopen(buffer_segment_path, "wb");
-        if (dst) {
-            char buffer[8192];
-            size_t bytes;
-            while ((bytes = fread(buffer, 1, sizeof(buffer), src)) > 0) {
-                fwrite(buffer, 1, bytes, dst);
-            }
-            fclose(dst);
-
-            // Store segment info
-            strncpy(rec->segment_buffer[slot].path, buffer_segment_path, MAX_PATH_LENGTH - 1);
-            rec->segment_buffer[slot].path[MAX_PATH_LENGTH - 1] = '\0';
-            rec->segment_buffer[slot].timestamp = time(NULL);
-            rec->segment_buffer[slot].is_valid = true;
-            rec->buffer_count++;
+    if (held) {
+        // Store segment info
+        strncpy(rec->segment_buffer[slot].path, buffer_segment_path, MAX_PATH_LENGTH - 1);
+        rec->segment_buffer[slot].path[MAX_PATH_LENGTH - 1] = '\0';
+        rec->segment_buffer[slot].timestamp = time(NULL);
+        rec->segment_buffer[slot].is_valid = true;
+        rec->buffer_count++;
 
-            log_debug("Added segment to buffer for stream %s: %s (slot %d, count %d)",
-                     rec->stream_name, buffer_segment_path, slot, rec->buffer_count);
-        }
-        fclose(src);
+        log_debug("Added segment to buffer for stream %s: %s (slot %d, count %d)",
+                 rec->stream_name, buffer_segment_path, slot, rec->buffer_count);
+    } else {
+        log_warn("Failed to buffer segment %s for stream %s: %s",
+                 segment_path, rec->stream_name, strerror(errno));
+        rec->segment_buffer[slot].is_valid = false;
     }
 
     // Move head to next position
@@ -185,102 +251,96 @@ static void add_segment_to_buffer(detection_recording_t *rec, const char *segmen
 
 /**
  * Flush the segment buffer to the beginning of a recording
- * Returns the path to a concatenated file containing all buffered segments
+ *
+ * The buffered segments are taken out of the buffer and remuxed in-process
+ * into one MP4, so the next detection event starts a fresh pre-roll.
+ *
+ * @param rec Detection recording state (its mutex must not be held)
+ * @param output_path Receives the path of the pre-detection MP4
+ * @param output_size Size of output_path
+ * @param duration Receives the duration of the MP4 in seconds
+ * @return 0 on success, -1 if nothing was buffered or the remux failed
  */
-static char* flush_segment_buffer(detection_recording_t *rec) {
-    if (!rec) {
-        return NULL;
+static int flush_segment_buffer(detection_recording_t *rec, char *output_path, size_t output_size,
+                                double *duration) {
+    if (!rec || !output_path || !duration) {
+        return -1;
     }
 
+    *duration = 0.0;
+
     pthread_mutex_lock(&rec->mutex);
 
     if (rec->buffer_count == 0) {
         pthread_mutex_unlock(&rec->mutex);
         log_info("No buffered segments to flush for stream %s", rec->stream_name);
-        return NULL;
+        return -1;
+    }
+
+    // Move the buffered segments aside (oldest to newest) so new segments
+    // can be buffered while this pre-roll is being written
+    char flush_paths[MAX_PRE_BUFFER_SEGMENTS][MAX_PATH_LENGTH];
+    const char *segments[MAX_PRE_BUFFER_SEGMENTS];
+    int count = 0;
+    long flush_id = (long)time(NULL);
+
+    int start_idx = (rec->buffer_head - rec->buffer_count + MAX_PRE_BUFFER_SEGMENTS) % MAX_PRE_BUFFER_SEGMENTS;
+    for (int i = 0; i < rec->buffer_count; i++) {
+        int idx = (start_idx + i) % MAX_PRE_BUFFER_SEGMENTS;
+        if (!rec->segment_buffer[idx].is_valid) {
+            continue;
+        }
+
+        snprintf(flush_paths[count], MAX_PATH_LENGTH, "%s/flush_%ld_%d.ts",
+                 rec->buffer_dir, flush_id, count);
+        if (rename(rec->segment_buffer[idx].path, flush_paths[count]) == 0) {
+            segments[count] = flush_paths[count];
+            count++;
+        }
+        rec->segment_buffer[idx].is_valid = false;
+    }
+    rec->buffer_count = 0;
+
+    pthread_mutex_unlock(&rec->mutex);
+
+    if (count == 0) {
+        log_warn("Buffered segments for stream %s are gone, nothing to flush", rec->stream_name);
+        return -1;
     }
 
     // Create output path for the pre-detection MP4 file
     // Use the recordings directory structure
     extern config_t g_config;
     time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
+    struct tm tm_info;
+    localtime_r(&now, &tm_info);
 
     char date_dir[MAX_PATH_LENGTH];
     snprintf(date_dir, MAX_PATH_LENGTH, "%s/mp4/%s/%04d/%02d/%02d",
              g_config.storage_path, rec->stream_name,
-             tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday);
-
-    // Create directory if it doesn't exist
-    char mkdir_cmd[MAX_PATH_LENGTH + 20];
-    snprintf(mkdir_cmd, sizeof(mkdir_cmd), "mkdir -p '%s'", date_dir);
-    system(mkdir_cmd);
+             tm_info.tm_year + 1900, tm_info.tm_mon + 1, tm_info.tm_mday);
+    create_directory_path(date_dir);
 
     // Create output MP4 file path with "predetection" prefix
-    static char concat_path[MAX_PATH_LENGTH];
     char timestamp_str[32];
-    strftime(timestamp_str, sizeof(timestamp_str), "%Y%m%d_%H%M%S", tm_info);
-    snprintf(concat_path, MAX_PATH_LENGTH, "%s/predetection_%s.mp4",
-             date_dir, timestamp_str);
-
-    // Create concat demuxer file list
-    char concat_list_path[MAX_PATH_LENGTH];
-    snprintf(concat_list_path, MAX_PATH_LENGTH, "%s/concat_list_%ld.txt",
-             rec->buffer_dir, (long)time(NULL));
-
-    FILE *concat_list = fopen(concat_list_path, "w");
-    if (!concat_list) {
-        pthread_mutex_unlock(&rec->mutex);
-        log_error("Failed to create concat list file for stream %s", rec->stream_name);
-        return NULL;
-    }
-
-    // Write all valid segments to the concat list in order (oldest to newest)
-    int start_idx = (rec->buffer_head - rec->buffer_count + MAX_PRE_BUFFER_SEGMENTS) % MAX_PRE_BUFFER_SEGMENTS;
-    for (int i = 0; i < rec->buffer_count; i++) {
-        int idx = (start_idx + i) % MAX_PRE_BUFFER_SEGMENTS;
-        if (rec->segment_buffer[idx].is_valid) {
-            fprintf(concat_list, "file '%s'\n", rec->segment_buffer[idx].path);
-        }
-    }
-    fclose(concat_list);
-
-    pthread_mutex_unlock(&rec->mutex);
+    strftime(timestamp_str, sizeof(timestamp_str), "%Y%m%d_%H%M%S", &tm_info);
+    snprintf(output_path, output_size, "%s/predetection_%s.mp4", date_dir, timestamp_str);
 
-    // Use ffmpeg to concatenate the TS segments into an MP4 file with proper timestamp handling
-    // -f concat: Use concat demuxer
-    // -safe 0: Allow absolute paths
-    // -fflags +genpts: Generate presentation timestamps to fix discontinuities
-    // -c copy: Copy streams without re-encoding
-    // -movflags +faststart: Move moov atom to beginning for better compatibility
-    // -avoid_negative_ts make_zero: Shift timestamps to start at 0
-    char cmd[MAX_PATH_LENGTH * 3];
-    snprintf(cmd, sizeof(cmd),
-             "ffmpeg -f concat -safe 0 -fflags +genpts -i '%s' "
-             "-c copy -movflags +faststart -avoid_negative_ts make_zero "
-             "'%s' -y 2>&1 | grep -v 'deprecated pixel format'",
-             concat_list_path, concat_path);
-
-    int ret = system(cmd);
-    unlink(concat_list_path);
+    int written = remux_segments_to_mp4(segments, count, output_path, duration);
 
-    if (ret != 0) {
-        log_error("Failed to concatenate buffered segments for stream %s (exit code: %d)",
-                 rec->stream_name, ret);
-        return NULL;
+    for (int i = 0; i < count; i++) {
+        unlink(flush_paths[i]);
     }
 
-    // Verify the output file was created
-    struct stat st;
-    if (stat(concat_path, &st) != 0 || st.st_size == 0) {
-        log_error("Pre-detection MP4 file was not created or is empty: %s", concat_path);
-        return NULL;
+    if (written <= 0) {
+        log_error("Failed to remux %d buffered segments for stream %s", count, rec->stream_name);
+        return -1;
     }
 
-    log_info("Flushed %d buffered segments for stream %s to MP4: %s (%ld bytes)",
-             rec->buffer_count, rec->stream_name, concat_path, (long)st.st_size);
+    log_info("Flushed %d buffered segments for stream %s to MP4: %s (%.1f seconds)",
+             written, rec->stream_name, output_path, *duration);
 
-    return concat_path;
+    return 0;
 }
 
 /**
@@ -417,9 +477,7 @@ int start_detection_recording(const char *stream_name, const char *model_path, f
                  "%s/detection_buffer/%s", g_config.storage_path, stream_name);
 
         // Create directory if it doesn't exist
-        char mkdir_cmd[MAX_PATH_LENGTH + 20];
-        snprintf(mkdir_cmd, sizeof(mkdir_cmd), "mkdir -p '%s'", detection_recordings[slot].buffer_dir);
-        system(mkdir_cmd);
+        create_directory_path(detection_recordings[slot].buffer_dir);
 
         log_info("Enabled pre-detection buffering for stream %s (%d seconds, buffer dir: %s)",
                  stream_name, pre_buffer, detection_recordings[slot].buffer_dir);
@@ -747,47 +805,37 @@ int process_frame_for_recording(const char *stream_name, const unsigned char *fr
             int pre_buffer = config.pre_detection_buffer;
 
             // Flush pre-detection buffer if enabled
-            char *buffer_file = NULL;
+            detection_recording_t *buffer_rec = NULL;
             pthread_mutex_lock(&detection_recordings_mutex);
             for (int i = 0; i < MAX_STREAMS; i++) {
                 if (detection_recordings[i].stream_name[0] != '\0' &&
                     strcmp(detection_recordings[i].stream_name, stream_name) == 0) {
                     if (detection_recordings[i].buffer_enabled && detection_recordings[i].buffer_count > 0) {
-                        buffer_file = flush_segment_buffer(&detection_recordings[i]);
-                        if (buffer_file) {
-                            log_info("Flushed pre-detection buffer for stream %s: %s",
-                                     stream_name, buffer_file);
-                        }
+                        buffer_rec = &detection_recordings[i];
                     }
                     break;
                 }
             }
             pthread_mutex_unlock(&detection_recordings_mutex);
 
-            // If we have a buffer file, save it as a separate pre-detection recording
-            if (buffer_file) {
-                // Get file size
+            // Remux outside the global lock so other streams are not held up
+            char buffer_file[MAX_PATH_LENGTH];
+            double buffer_duration = 0.0;
+            if (buffer_rec &&
+                flush_segment_buffer(buffer_rec, buffer_file, sizeof(buffer_file), &buffer_duration) == 0) {
+                log_info("Flushed pre-detection buffer for stream %s: %s", stream_name, buffer_file);
+
+                // Save it as a separate pre-detection recording
                 struct stat st;
                 if (stat(buffer_file, &st) == 0) {
-                    // Calculate duration (estimate based on typical HLS segment duration)
-                    // Assume 2-6 second segments, use buffer_count * 4 as estimate
-                    int estimated_duration = 0;
-                    pthread_mutex_lock(&detection_recordings_mutex);
-                    for (int i = 0; i < MAX_STREAMS; i++) {
-                        if (detection_recordings[i].stream_name[0] != '\0' &&
-                            strcmp(detection_recordings[i].stream_name, stream_name) == 0) {
-                            estimated_duration = detection_recordings[i].buffer_count * 4; // 4 seconds per segment estimate
-                            break;
-                        }
-                    }
-                    pthread_mutex_unlock(&detection_recordings_mutex);
+                    int duration = (int)(buffer_duration + 0.5);
 
                     // Save to database as a detection recording
                     recording_metadata_t metadata;
                     memset(&metadata, 0, sizeof(recording_metadata_t));
                     strncpy(metadata.stream_name, stream_name, sizeof(metadata.stream_name) - 1);
                     strncpy(metadata.file_path, buffer_file, sizeof(metadata.file_path) - 1);
-                    metadata.start_time = time(NULL) - estimated_duration; // Approximate start time
+                    metadata.start_time = time(NULL) - duration;
                     metadata.end_time = time(NULL);
                     metadata.size_bytes = st.st_size;
                     metadata.is_complete = true; // Pre-detection buffer is already complete
@@ -797,7 +845,7 @@ int process_frame_for_recording(const char *stream_name, const unsigned char *fr
                     uint64_t recording_id = add_recording_metadata(&metadata);
                     if (recording_id > 0) {
                         log_info("Saved pre-detection buffer as recording ID %llu: %s (%d seconds, %ld bytes)",
-                                 (unsigned long long)recording_id, buffer_file, estimated_duration, (long)st.st_size);
+                                 (unsigned long long)recording_id, buffer_file, duration, (long)st.st_size);
                     } else {
                         log_error("Failed to save pre-detection buffer to database: %s", buffer_file);
                     }
@@ -1078,52 +1126,58 @@ int monitor_hls_segments_for_detection(const char *stream_name) {
         }
     }
 
-    // Check if directory exists
-    struct stat st;
-    if (stat(hls_dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
-        log_warn("HLS directory does not exist for stream %s: %s", stream_name, hls_dir);
-        return -1;
-    }
-
-    // Open the directory
-    DIR *dir = opendir(hls_dir);
-    if (!dir) {
-        log_error("Failed to open HLS directory for stream %s: %s", stream_name, hls_dir);
-        return -1;
-    }
-
     // Keep track of the newest segment file
     char newest_segment[MAX_PATH_LENGTH] = {0};
     time_t newest_time = 0;
 
-    // Read directory entries
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
-        // Skip non-segment files (look for .ts or .m4s files)
-        if (strstr(entry->d_name, ".ts") == NULL && strstr(entry->d_name, ".m4s") == NULL) {
-            continue;
+    // With HLS kept in memory the newest segment comes from the store
+    char memory_segment[HLS_MEMORY_MAX_FILE_NAME];
+    if (hls_memory_store_newest_segment(stream_name, memory_segment, sizeof(memory_segment), NULL, NULL)) {
+        snprintf(newest_segment, MAX_PATH_LENGTH, "%s/%s", hls_dir, memory_segment);
+    } else {
+        // Check if directory exists
+        struct stat st;
+        if (stat(hls_dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+            log_warn("HLS directory does not exist for stream %s: %s", stream_name, hls_dir);
+            return -1;
         }
 
-        // Get file stats
-        char segment_path[MAX_PATH_LENGTH];
-        snprintf(segment_path, MAX_PATH_LENGTH, "%s/%s", hls_dir, entry->d_name);
-
-        struct stat segment_stat;
-        if (stat(segment_path, &segment_stat) != 0) {
-            log_warn("Failed to stat segment file: %s", segment_path);
-            continue;
+        // Open the directory
+        DIR *dir = opendir(hls_dir);
+        if (!dir) {
+            log_error("Failed to open HLS directory for stream %s: %s", stream_name, hls_dir);
+            return -1;
         }
 
-        // Check if this is the newest segment
-        if (segment_stat.st_mtime > newest_time) {
-            newest_time = segment_stat.st_mtime;
-            strncpy(newest_segment, segment_path, MAX_PATH_LENGTH - 1);
-            newest_segment[MAX_PATH_LENGTH - 1] = '\0';
+        // Read directory entries
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            // Skip non-segment files (look for .ts or .m4s files)
+            if (strstr(entry->d_name, ".ts") == NULL && strstr(entry->d_name, ".m4s") == NULL) {
+                continue;
+            }
+
+            // Get file stats
+            char segment_path[MAX_PATH_LENGTH];
+            snprintf(segment_path, MAX_PATH_LENGTH, "%s/%s", hls_dir, entry->d_name);
+
+            struct stat segment_stat;
+            if (stat(segment_path, &segment_stat) != 0) {
+                log_warn("Failed to stat segment file: %s", segment_path);
+                continue;
+            }
+
+            // Check if this is the newest segment
+            if (segment_stat.st_mtime > newest_time) {
+                newest_time = segment_stat.st_mtime;
+                strncpy(newest_segment, segment_path, MAX_PATH_LENGTH - 1);
+                newest_segment[MAX_PATH_LENGTH - 1] = '\0';
+            }
         }
-    }
 
-    // Close the directory
-    closedir(dir);
+        // Close the directory
+        closedir(dir);
+    }
 
     // If we found a segment file, submit it to the detection thread pool
     if (newest_segment[0] != '\0') {
@@ -1254,9 +1308,12 @@ int monitor_hls_segments_for_detection(const char *stream_name) {
             log_info("Using alternative HLS directory path with extra 'hls' for segment check: %s", hls_dir);
         }
 
-    // Check if the HLS directory has any segments
-    DIR *segment_dir = opendir(hls_dir);
+    // Check if the HLS directory (or the in-memory store) has any segments
     int segment_count = 0;
+    char memory_segment_name[HLS_MEMORY_MAX_FILE_NAME];
+    hls_memory_store_newest_segment(stream_name, memory_segment_name, sizeof(memory_segment_name),
+                                    NULL, &segment_count);
+    DIR *segment_dir = segment_count > 0 ? NULL : opendir(hls_dir);
 
     if (segment_dir) {
         struct dirent *segment_entry;
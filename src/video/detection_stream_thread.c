@@ -31,10 +31,13 @@
 #include "video/detection_embedded.h"
 #include "video/streams.h"
 #include "video/hls_writer.h"
+#include "video/hls_memory_store.h"
 #include "video/hls/hls_unified_thread.h"
 #include "video/api_detection.h"
 #include "video/onvif_detection.h"
 #include "video/go2rtc/go2rtc_stream.h"
+#include "video/packet_bus.h"
+#include "video/detection_frame_tap.h"
 
 // Add signal handler to catch floating point exceptions
 #include <fenv.h>
@@ -192,24 +195,136 @@ int process_frame_for_stream_detection(const char *stream_name, const uint8_t *f
 }
 
 
-// Forward declarations for functions from other modules
-
 /**
- * Process an HLS segment file for detection
+ * Convert a decoded frame to RGB and run the thread's model on it
+ * Caller must hold thread->mutex and have checked that thread->model is set
  */
-int process_segment_for_detection(stream_detection_thread_t *thread, const char *segment_path) {
-    // CRITICAL FIX: Add safety checks to prevent memory corruption
-    if (!thread || !segment_path || segment_path[0] == '\0') {
-        log_error("Invalid parameters for process_segment_for_detection");
+static int run_detection_on_frame(stream_detection_thread_t *thread, const AVFrame *frame,
+                                  int frame_count, time_t frame_timestamp) {
+    // Resize and convert to RGB in one pass, with the scaler and buffer kept across frames
+    const char *model_type = get_model_type_from_handle(thread->model);
+    int target_width = 0;
+    int target_height = 0;
+    int channels = 0;
+    const uint8_t *rgb_buffer = detection_frame_cache_convert(&thread->frame_cache, frame, thread->model,
+                                                              &target_width, &target_height, &channels);
+    if (!rgb_buffer) {
+        log_error("[Stream %s] Failed to convert frame for detection", thread->stream_name);
         return -1;
     }
 
+    // Create detection result structure
+    detection_result_t result;
+    memset(&result, 0, sizeof(detection_result_t));
+
+    // Log before running detection
+    log_info("[Stream %s] Running detection on frame %d (dimensions: %dx%d, channels: %d, model: %s)",
+            thread->stream_name, frame_count, target_width, target_height, channels,
+            model_type ? model_type : "unknown");
+
+    // Run detection on the RGB frame
+    int detect_ret;
+
+    // Check if this is an API model
+    const char *api_model_type = get_model_type_from_handle(thread->model);
+    log_info("[Stream %s] Model type: %s", thread->stream_name, api_model_type);
+
+    if (strcmp(api_model_type, MODEL_TYPE_API) == 0) {
+        // For API models, we need to pass the stream name
+        const char *model_path = get_model_path(thread->model);
+
+        // Get the API URL - either from the model path if it's a URL,
+        // or from the global config if it's the special "api-detection" string
+        const char *api_url = NULL;
+        if (model_path && ends_with(model_path, "api-detection")) {
+            // Get the API URL from the global config
+            api_url = g_config.api_detection_url;
+            log_info("[Stream %s] Using API detection URL from config: %s",
+                    thread->stream_name, api_url ? api_url : "NULL");
+        } else {
+            // Use the model path directly as the URL
+            api_url = model_path;
+            log_info("[Stream %s] Using API detection with URL from model path: %s",
+                    thread->stream_name, api_url ? api_url : "NULL");
+        }
+
+        if (!api_url || api_url[0] == '\0') {
+            log_error("[Stream %s] Failed to get API URL from model or config", thread->stream_name);
+            detect_ret = -1;
+            // Initialize result to empty to prevent segmentation fault
+            memset(&result, 0, sizeof(detection_result_t));
+        } else {
+            log_info("[Stream %s] Calling detect_objects_api with URL: %s", thread->stream_name, api_url);
+            // CRITICAL FIX: Initialize result to empty before calling API detection
+            memset(&result, 0, sizeof(detection_result_t));
+            detect_ret = detect_objects_api(api_url, rgb_buffer, target_width, target_height, channels, &result, thread->stream_name);
+            log_info("[Stream %s] detect_objects_api returned: %d", thread->stream_name, detect_ret);
+        }
+    } else {
+        // For other models, use the standard detect_objects function
+        log_info("[Stream %s] Using standard detect_objects function", thread->stream_name);
+        // CRITICAL FIX: Initialize result to empty before calling detection
+        memset(&result, 0, sizeof(detection_result_t));
+        detect_ret = detect_objects(thread->model, rgb_buffer, target_width, target_height, channels, &result);
+        log_info("[Stream %s] detect_objects returned: %d", thread->stream_name, detect_ret);
+    }
+
+    if (detect_ret == 0) {
+        // Process detection results
+        if (result.count > 0) {
+            log_info("[Stream %s] Detection found %d objects in frame %d",
+                    thread->stream_name, result.count, frame_count);
+
+            // Log each detected object
+            for (int i = 0; i < result.count && i < MAX_DETECTIONS; i++) {
+                log_info("[Stream %s] Object %d: class=%s, confidence=%.2f, box=[%.2f,%.2f,%.2f,%.2f]",
+                        thread->stream_name, i, result.detections[i].label,
+                        result.detections[i].confidence,
+                        result.detections[i].x, result.detections[i].y,
+                        result.detections[i].width, result.detections[i].height);
+            }
+
+            // Process the detection results for recording
+            int record_ret = process_frame_for_recording(thread->stream_name, rgb_buffer, target_width,
+                                                       target_height, channels, frame_timestamp, &result);
+
+            if (record_ret != 0) {
+                log_error("[Stream %s] Failed to process frame for recording (error code: %d)",
+                         thread->stream_name, record_ret);
+            } else {
+                log_info("[Stream %s] Successfully processed frame for recording", thread->stream_name);
+            }
+        } else {
+            log_debug("[Stream %s] No objects detected in frame %d", thread->stream_name, frame_count);
+        }
+    } else {
+        log_error("[Stream %s] Detection failed for frame %d (error code: %d)",
+                 thread->stream_name, frame_count, detect_ret);
+        // Continue execution despite detection failure
+        log_info("[Stream %s] Continuing detection thread despite detection failure", thread->stream_name);
+        // Set result.count to 0 to indicate no detections
+        result.count = 0;
+    }
+
+    // Update last detection time
+    thread->last_detection_time = time(NULL);
+
+    return detect_ret;
+}
+
+// Forward declarations for functions from other modules
+
+/**
+ * Process an HLS segment for detection, read from disk or from memory_pb
+ */
+static int process_segment_input(stream_detection_thread_t *thread, const char *segment_path,
+                                 AVIOContext *memory_pb) {
+
     // CRITICAL FIX: Initialize all pointers to NULL to prevent use-after-free and double-free issues
     AVFormatContext *format_ctx = NULL;
     AVCodecContext *codec_ctx = NULL;
     AVFrame *frame = NULL;
     AVPacket *pkt = NULL;
-    struct SwsContext *sws_ctx = NULL;
     int video_stream_idx = -1;
     int ret = -1;
 
@@ -221,7 +336,7 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
 
     // CRITICAL FIX: Double-check that the segment still exists and is valid before trying to open it
     // This prevents segmentation faults when trying to open deleted or corrupt segments
-    if (access(segment_path, F_OK) != 0) {
+    if (!memory_pb && access(segment_path, F_OK) != 0) {
         log_warn("[Stream %s] Segment no longer exists before processing: %s",
                 thread->stream_name, segment_path);
         // Don't return error, just indicate no detections were found
@@ -231,7 +346,7 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
 
     // Check if the segment file is valid (non-zero size)
     struct stat st;
-    if (stat(segment_path, &st) != 0 || st.st_size == 0) {
+    if (!memory_pb && (stat(segment_path, &st) != 0 || st.st_size == 0)) {
         log_warn("[Stream %s] Segment file is empty or cannot be accessed: %s (size: %ld bytes)",
                 thread->stream_name, segment_path, (long)(stat(segment_path, &st) == 0 ? st.st_size : 0));
         log_info("[Stream %s] Continuing detection thread despite invalid segment", thread->stream_name);
@@ -242,6 +357,18 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
     // This prevents potential double-free issues if avformat_open_input fails
     format_ctx = NULL;
 
+    // Segments held by the in-memory HLS store are read through their own AVIOContext
+    if (memory_pb) {
+        format_ctx = avformat_alloc_context();
+        if (!format_ctx) {
+            log_error("[Stream %s] Could not allocate format context for segment: %s",
+                     thread->stream_name, segment_path);
+            return 0;
+        }
+        format_ctx->pb = memory_pb;
+        format_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+
     // Open input file with safety checks
     int open_result = avformat_open_input(&format_ctx, segment_path, NULL, NULL);
     if (open_result != 0) {
@@ -551,153 +678,7 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
 
                 // Process the frame for detection using our dedicated model
                 if (thread->model) {
-                    // Convert frame to RGB format
-                    int width = frame->width;
-                    int height = frame->height;
-                    int channels = 3; // RGB
-
-                    // Determine if we should downscale the frame based on model type
-                    const char *model_type = get_model_type_from_handle(thread->model);
-                    int downscale_factor = get_downscale_factor(model_type);
-
-                    // Calculate dimensions after downscaling
-                    int target_width = width / downscale_factor;
-                    int target_height = height / downscale_factor;
-
-                    // Ensure dimensions are even (required by some codecs)
-                    target_width = (target_width / 2) * 2;
-                    target_height = (target_height / 2) * 2;
-
-                    // Convert frame to RGB format with downscaling
-                    sws_ctx = sws_getContext(
-                        width, height, frame->format,
-                        target_width, target_height, AV_PIX_FMT_RGB24,
-                        SWS_BILINEAR, NULL, NULL, NULL);
-
-                    if (!sws_ctx) {
-                        log_error("[Stream %s] Failed to create SwsContext", thread->stream_name);
-                        av_packet_unref(pkt);
-                        continue;
-                    }
-
-                    // SwsContext is now allocated
-
-                    // Allocate buffer for RGB frame
-                    uint8_t *rgb_buffer = (uint8_t *)malloc(target_width * target_height * channels);
-                    if (!rgb_buffer) {
-                        log_error("[Stream %s] Failed to allocate RGB buffer", thread->stream_name);
-                        sws_freeContext(sws_ctx);
-                        av_packet_unref(pkt);
-                        continue;
-                    }
-
-                    // Setup RGB frame
-                    uint8_t *rgb_data[4] = {rgb_buffer, NULL, NULL, NULL};
-                    int rgb_linesize[4] = {target_width * channels, 0, 0, 0};
-
-                    // Convert frame to RGB
-                    sws_scale(sws_ctx, (const uint8_t * const *)frame->data, frame->linesize, 0,
-                             height, rgb_data, rgb_linesize);
-
-                    // Create detection result structure
-                    detection_result_t result;
-                    memset(&result, 0, sizeof(detection_result_t));
-
-                    // Log before running detection
-                    log_info("[Stream %s] Running detection on frame %d (dimensions: %dx%d, channels: %d, model: %s)",
-                            thread->stream_name, frame_count, target_width, target_height, channels,
-                            model_type ? model_type : "unknown");
-
-                    // Run detection on the RGB frame
-                    int detect_ret;
-
-                    // Check if this is an API model
-                    const char *api_model_type = get_model_type_from_handle(thread->model);
-                    log_info("[Stream %s] Model type: %s", thread->stream_name, api_model_type);
-
-                    if (strcmp(api_model_type, MODEL_TYPE_API) == 0) {
-                        // For API models, we need to pass the stream name
-                        const char *model_path = get_model_path(thread->model);
-
-                        // Get the API URL - either from the model path if it's a URL,
-                        // or from the global config if it's the special "api-detection" string
-                        const char *api_url = NULL;
-                        if (model_path && ends_with(model_path, "api-detection")) {
-                            // Get the API URL from the global config
-                            api_url = g_config.api_detection_url;
-                            log_info("[Stream %s] Using API detection URL from config: %s",
-                                    thread->stream_name, api_url ? api_url : "NULL");
-                        } else {
-                            // Use the model path directly as the URL
-                            api_url = model_path;
-                            log_info("[Stream %s] Using API detection with URL from model path: %s",
-                                    thread->stream_name, api_url ? api_url : "NULL");
-                        }
-
-                        if (!api_url || api_url[0] == '\0') {
-                            log_error("[Stream %s] Failed to get API URL from model or config", thread->stream_name);
-                            detect_ret = -1;
-                            // Initialize result to empty to prevent segmentation fault
-                            memset(&result, 0, sizeof(detection_result_t));
-                        } else {
-                            log_info("[Stream %s] Calling detect_objects_api with URL: %s", thread->stream_name, api_url);
-                            // CRITICAL FIX: Initialize result to empty before calling API detection
-                            memset(&result, 0, sizeof(detection_result_t));
-                            detect_ret = detect_objects_api(api_url, rgb_buffer, target_width, target_height, channels, &result, thread->stream_name);
-                            log_info("[Stream %s] detect_objects_api returned: %d", thread->stream_name, detect_ret);
-                        }
-                    } else {
-                        // For other models, use the standard detect_objects function
-                        log_info("[Stream %s] Using standard detect_objects function", thread->stream_name);
-                        // CRITICAL FIX: Initialize result to empty before calling detection
-                        memset(&result, 0, sizeof(detection_result_t));
-                        detect_ret = detect_objects(thread->model, rgb_buffer, target_width, target_height, channels, &result);
-                        log_info("[Stream %s] detect_objects returned: %d", thread->stream_name, detect_ret);
-                    }
-
-                    if (detect_ret == 0) {
-                        // Process detection results
-                        if (result.count > 0) {
-                            log_info("[Stream %s] Detection found %d objects in frame %d",
-                                    thread->stream_name, result.count, frame_count);
-
-                            // Log each detected object
-                            for (int i = 0; i < result.count && i < MAX_DETECTIONS; i++) {
-                                log_info("[Stream %s] Object %d: class=%s, confidence=%.2f, box=[%.2f,%.2f,%.2f,%.2f]",
-                                        thread->stream_name, i, result.detections[i].label,
-                                        result.detections[i].confidence,
-                                        result.detections[i].x, result.detections[i].y,
-                                        result.detections[i].width, result.detections[i].height);
-                            }
-
-                            // Process the detection results for recording
-                            int record_ret = process_frame_for_recording(thread->stream_name, rgb_buffer, target_width,
-                                                                       target_height, channels, frame_timestamp, &result);
-
-                            if (record_ret != 0) {
-                                log_error("[Stream %s] Failed to process frame for recording (error code: %d)",
-                                         thread->stream_name, record_ret);
-                            } else {
-                                log_info("[Stream %s] Successfully processed frame for recording", thread->stream_name);
-                            }
-                        } else {
-                            log_debug("[Stream %s] No objects detected in frame %d", thread->stream_name, frame_count);
-                        }
-                    } else {
-                        log_error("[Stream %s] Detection failed for frame %d (error code: %d)",
-                                 thread->stream_name, frame_count, detect_ret);
-                        // Continue execution despite detection failure
-                        log_info("[Stream %s] Continuing detection thread despite detection failure", thread->stream_name);
-                        // Set result.count to 0 to indicate no detections
-                        result.count = 0;
-                    }
-
-                    // Free resources
-                    free(rgb_buffer);
-                    sws_freeContext(sws_ctx);
-
-                    // Update last detection time
-                    thread->last_detection_time = time(NULL);
+                    run_detection_on_frame(thread, frame, frame_count, frame_timestamp);
                 }
 
                 // CRITICAL FIX: Release the mutex after detection is complete
@@ -744,6 +725,37 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
     return 0;
 }
 
+/**
+ * Process an HLS segment file for detection
+ */
+int process_segment_for_detection(stream_detection_thread_t *thread, const char *segment_path) {
+    // CRITICAL FIX: Add safety checks to prevent memory corruption
+    if (!thread || !segment_path || segment_path[0] == '\0') {
+        log_error("Invalid parameters for process_segment_for_detection");
+        return -1;
+    }
+
+    // With HLS kept in memory the segment is never written to disk
+    const char *file_name = strrchr(segment_path, '/');
+    file_name = file_name ? file_name + 1 : segment_path;
+
+    hls_memory_file_t *memory_file = hls_memory_store_get(thread->stream_name, file_name);
+    if (!memory_file) {
+        return process_segment_input(thread, segment_path, NULL);
+    }
+
+    AVIOContext *memory_pb = hls_memory_file_open_read(memory_file);
+    if (!memory_pb) {
+        hls_memory_file_release(memory_file);
+        return 0;
+    }
+
+    // Closing the input leaves a custom AVIOContext to its owner
+    int ret = process_segment_input(thread, segment_path, memory_pb);
+    hls_memory_file_close_read(&memory_pb);
+    return ret;
+}
+
 /**
  * Check for new HLS segments in the stream's HLS directory
  * This function has been refactored to ensure each detection thread only monitors its own stream
@@ -811,6 +823,65 @@ static void check_for_new_segments(stream_detection_thread_t *thread) {
     first_check = false;
 }
 
+/**
+ * Check whether the thread's model can consume keyframes from the live ingest
+ * ONVIF detection asks the camera for events and keeps using the segment path
+ */
+static bool frame_tap_usable(stream_detection_thread_t *thread) {
+    bool usable = false;
+
+    pthread_mutex_lock(&thread->mutex);
+    if (thread->model) {
+        const char *model_type = get_model_type_from_handle(thread->model);
+        usable = model_type && strcmp(model_type, MODEL_TYPE_ONVIF) != 0;
+    }
+    pthread_mutex_unlock(&thread->mutex);
+
+    return usable;
+}
+
+/**
+ * Run detection on the next live keyframe if a detection is due
+ * Returns false if the tap has stopped and should be closed
+ */
+static bool process_frame_tap(stream_detection_thread_t *thread, detection_frame_tap_t *tap,
+                              AVFrame *frame, int *frame_count) {
+    if (!should_run_detection_check(thread, time(NULL))) {
+        // Drop keyframes that arrived in the meantime so the next detection sees a current picture
+        detection_frame_tap_flush(tap);
+        usleep(500000);
+        return true;
+    }
+
+    int ret = detection_frame_tap_read(tap, frame, 1000);
+    if (ret == AVERROR(EAGAIN)) {
+        return true;
+    }
+    if (ret < 0) {
+        char err_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+        av_strerror(ret, err_buf, sizeof(err_buf));
+        log_warn("[Stream %s] Live keyframe tap error: %s", thread->stream_name, err_buf);
+        if (ret == AVERROR_EOF) {
+            return false;
+        }
+        usleep(500000);
+        return true;
+    }
+
+    (*frame_count)++;
+
+    atomic_store(&thread->detection_in_progress, 1);
+    pthread_mutex_lock(&thread->mutex);
+    if (thread->model) {
+        run_detection_on_frame(thread, frame, *frame_count, time(NULL));
+    }
+    pthread_mutex_unlock(&thread->mutex);
+    atomic_store(&thread->detection_in_progress, 0);
+
+    av_frame_unref(frame);
+    return true;
+}
+
 /**
  * Stream detection thread function
  * Improved with better error handling and retry logic
@@ -943,6 +1014,12 @@ static void *stream_detection_thread_func(void *arg) {
     // This gives the system time to initialize without blocking the main thread
     global_startup_delay_end = startup_time + 10;
 
+    // Live keyframe tap, used instead of HLS segments when shared ingest is enabled
+    detection_frame_tap_t *frame_tap = NULL;
+    AVFrame *tap_frame = av_frame_alloc();
+    time_t last_tap_attempt = 0;
+    int tap_frame_count = 0;
+
     while (thread->running) {
         // CRITICAL FIX: Add safety check for thread validity
         if (!thread || !thread->stream_name[0]) {
@@ -958,6 +1035,29 @@ static void *stream_detection_thread_func(void *arg) {
             break;
         }
 
+        // CRITICAL: Check if active recordings should be stopped (every 5 seconds)
+        if (time(NULL) - last_recording_check >= 5) {
+            extern int check_detection_recording_timeout(const char *stream_name);
+            check_detection_recording_timeout(thread->stream_name);
+            last_recording_check = time(NULL);
+        }
+
+        // Take keyframes straight from the live ingest when it is shared
+        if (!frame_tap && tap_frame && packet_bus_is_enabled() &&
+            time(NULL) - last_tap_attempt >= 10 && frame_tap_usable(thread)) {
+            last_tap_attempt = time(NULL);
+            frame_tap = detection_frame_tap_open(thread->stream_name);
+        }
+
+        if (frame_tap) {
+            if (!process_frame_tap(thread, frame_tap, tap_frame, &tap_frame_count)) {
+                log_info("[Stream %s] Live ingest stopped, falling back to HLS segments", thread->stream_name);
+                detection_frame_tap_close(frame_tap);
+                frame_tap = NULL;
+            }
+            continue;
+        }
+
         // CRITICAL FIX: Check if HLS directory exists and is accessible
         if (!thread->hls_dir[0]) {
             log_error("[Stream %s] HLS directory path is empty", thread->stream_name);
@@ -976,13 +1076,6 @@ static void *stream_detection_thread_func(void *arg) {
 
         time_t current_time = time(NULL);
 
-        // CRITICAL: Check if active recordings should be stopped (every 5 seconds)
-        if (current_time - last_recording_check >= 5) {
-            extern int check_detection_recording_timeout(const char *stream_name);
-            check_detection_recording_timeout(thread->stream_name);
-            last_recording_check = current_time;
-        }
-
         // Log status periodically - always use log_info to ensure visibility
         if (current_time - last_log_time > 10) { // Log every 10 seconds
             log_info("[Stream %s] Detection thread is running, checking for new segments (consecutive empty checks: %d, errors: %d)",
@@ -1048,6 +1141,9 @@ static void *stream_detection_thread_func(void *arg) {
         usleep(sleep_time);
     }
 
+    detection_frame_tap_close(frame_tap);
+    av_frame_free(&tap_frame);
+
     // Update component state in shutdown coordinator
     if (thread->component_id >= 0) {
         update_component_state(thread->component_id, COMPONENT_STOPPED);
@@ -1078,6 +1174,7 @@ static void *stream_detection_thread_func(void *arg) {
 
         thread->model = NULL;
     }
+    detection_frame_cache_free(&thread->frame_cache);
     pthread_mutex_unlock(&thread->mutex);
 
     log_info("[Stream %s] Detection thread exiting", thread->stream_name);
@@ -23,6 +23,7 @@
 #include "video/detection_stream_thread_helpers.h"
 #include "video/streams.h"
 #include "video/hls_writer.h"
+#include "video/hls_memory_store.h"
 #include "utils/strings.h"
 #include "video/detection_model.h"
 #include "video/onvif_detection.h"
@@ -357,6 +358,19 @@ bool find_hls_directory(stream_detection_thread_t *thread, time_t current_time,
     return true;
 }
 
+/**
+ * Check that a segment is still held in memory or on disk
+ */
+static bool segment_available(const char *stream_name, const char *segment_path) {
+    const char *file_name = strrchr(segment_path, '/');
+    hls_memory_file_t *memory_file = hls_memory_store_get(stream_name, file_name ? file_name + 1 : segment_path);
+    if (memory_file) {
+        hls_memory_file_release(memory_file);
+        return true;
+    }
+    return access(segment_path, F_OK) == 0;
+}
+
 /**
  * Find the newest segment file in the HLS directory
  * Returns true if a segment was found, false otherwise
@@ -395,6 +409,14 @@ bool find_newest_segment(stream_detection_thread_t *thread, char *newest_segment
     *newest_time = 0;
     newest_segment[0] = '\0';
 
+    // With HLS kept in memory the newest segment comes from the store
+    char memory_segment[HLS_MEMORY_MAX_FILE_NAME];
+    if (hls_memory_store_newest_segment(thread->stream_name, memory_segment, sizeof(memory_segment),
+                                        newest_time, segment_count)) {
+        snprintf(newest_segment, MAX_PATH_LENGTH, "%s/%s", thread->hls_dir, memory_segment);
+        return true;
+    }
+
     dir = opendir(thread->hls_dir);
     if (!dir) {
         log_error("[Stream %s] Failed to open HLS directory: %s (error: %s)",
@@ -877,7 +899,7 @@ int process_segment_if_needed(stream_detection_thread_t *thread,
                     }
                 } else {
                     // For other detection models, process the HLS segment as usual
-                    if (access(newest_segment, F_OK) == 0) {
+                    if (segment_available(thread->stream_name, newest_segment)) {
                         log_info("[Stream %s] Processing HLS segment for detection: %s", thread->stream_name, newest_segment);
                         result = process_segment_for_detection(thread, newest_segment);
                     } else {
@@ -887,7 +909,7 @@ int process_segment_if_needed(stream_detection_thread_t *thread,
                 }
             } else {
                 // No model loaded, try to process the segment anyway
-                if (access(newest_segment, F_OK) == 0) {
+                if (segment_available(thread->stream_name, newest_segment)) {
                     log_info("[Stream %s] Processing HLS segment for detection (no model loaded): %s",
                             thread->stream_name, newest_segment);
                     result = process_segment_for_detection(thread, newest_segment);
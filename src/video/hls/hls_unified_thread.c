@@ -119,6 +119,7 @@ static void global_ffmpeg_cleanup(void) {
 #include "video/hls/hls_directory.h"
 #include "video/hls/hls_unified_thread.h"
 #include "video/ffmpeg_utils.h"
+#include "video/packet_bus.h"
 
 // Maximum time (in seconds) without receiving a packet before considering the connection dead
 #define MAX_PACKET_TIMEOUT 5
@@ -865,6 +866,28 @@ static int check_rtsp_connection(const char *rtsp_url, char *host, int *port) {
     return 0;
 }
 
+/**
+ * Open the input for an HLS thread
+ * Reads the camera directly, or attaches to the shared ingest when it is enabled
+ * so HLS does not need a camera session of its own.
+ */
+static int hls_open_input(const char *stream_name, AVFormatContext **input_ctx, const char *url,
+                          int protocol, packet_bus_subscriber_t **bus_sub) {
+    if (!packet_bus_is_enabled()) {
+        return open_input_stream(input_ctx, url, protocol);
+    }
+
+    if (!*bus_sub) {
+        // HLS only muxes video, so don't queue audio for it
+        *bus_sub = packet_bus_subscribe(stream_name, url, protocol, "hls", PACKET_BUS_SUB_VIDEO_ONLY, 0);
+        if (!*bus_sub) {
+            return AVERROR(ENOMEM);
+        }
+    }
+
+    return packet_bus_copy_streams(*bus_sub, input_ctx, 10000);
+}
+
 /**
  * Unified HLS thread function
  * This function handles all HLS streaming operations for a single stream
@@ -873,6 +896,7 @@ void *hls_unified_thread_func(void *arg) {
     hls_unified_thread_ctx_t *ctx = (hls_unified_thread_ctx_t *)arg;
     AVFormatContext *input_ctx = NULL;
     AVPacket *pkt = NULL;
+    packet_bus_subscriber_t *bus_sub = NULL;
     int video_stream_idx = -1;
     int ret;
     hls_thread_state_t thread_state = HLS_THREAD_INITIALIZING;
@@ -1041,7 +1065,8 @@ void *hls_unified_thread_func(void *arg) {
                 safe_cleanup_resources(&input_ctx, NULL, NULL);
 
                 // Check if the RTSP URL exists before trying to connect
-                if (strncmp(ctx->rtsp_url, "rtsp://", 7) == 0) {
+                // (the shared ingest does its own connection handling)
+                if (!packet_bus_is_enabled() && strncmp(ctx->rtsp_url, "rtsp://", 7) == 0) {
                     char host[256] = {0};
                     int port = 554; // Default RTSP port
 
@@ -1122,7 +1147,7 @@ void *hls_unified_thread_func(void *arg) {
                 // This ensures all previous memory operations are completed
                 __sync_synchronize();
 
-                ret = open_input_stream(&input_ctx, local_rtsp_url, local_protocol);
+                ret = hls_open_input(stream_name, &input_ctx, local_rtsp_url, local_protocol, &bus_sub);
                 if (ret < 0) {
                     char error_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
                     av_strerror(ret, error_buf, AV_ERROR_MAX_STRING_SIZE);
@@ -1351,7 +1376,12 @@ void *hls_unified_thread_func(void *arg) {
                 }
 
                 // Read packet
-                ret = av_read_frame(input_ctx, pkt);
+                ret = bus_sub ? packet_bus_read(bus_sub, pkt, 1000) : av_read_frame(input_ctx, pkt);
+
+                // No packet from the shared ingest yet; it handles camera reconnects itself
+                if (bus_sub && ret == AVERROR(EAGAIN)) {
+                    break;
+                }
 
                 if (ret < 0) {
                     // Handle read errors
@@ -1568,7 +1598,7 @@ void *hls_unified_thread_func(void *arg) {
                 // This ensures all previous memory operations are completed
                 __sync_synchronize();
 
-                ret = open_input_stream(&input_ctx, reconnect_rtsp_url, reconnect_protocol);
+                ret = hls_open_input(stream_name, &input_ctx, reconnect_rtsp_url, reconnect_protocol, &bus_sub);
                 if (ret < 0) {
                     char error_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
                     av_strerror(ret, error_buf, AV_ERROR_MAX_STRING_SIZE);
@@ -1759,6 +1789,12 @@ void *hls_unified_thread_func(void *arg) {
         safe_cleanup_resources(&input_ctx, &pkt, NULL);
     }
 
+    // Leave the shared ingest so it can stop when no other consumer needs it
+    if (bus_sub) {
+        packet_bus_unsubscribe(bus_sub);
+        bus_sub = NULL;
+    }
+
     if (ctx_for_exit) {
         // Use the pre-computed context validity flag
         // CRITICAL FIX: Only access writer if context is still valid
@@ -0,0 +1,460 @@
+/**
+ * In-memory live HLS segment store
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <libavformat/avformat.h>
+#include <libavutil/mem.h>
+
+#include "core/logger.h"
+#include "core/config.h"
+#include "video/hls_memory_store.h"
+
+// Read buffer size of the AVIOContext handed to readers
+#define HLS_MEMORY_READ_BUFFER_SIZE 32768
+
+typedef struct {
+    bool used;
+    char stream_name[MAX_STREAM_NAME];
+    hls_memory_file_t *pinned[HLS_MEMORY_MAX_PINNED];
+    hls_memory_file_t *segments[HLS_MEMORY_MAX_SEGMENTS];
+    int next_segment;             // Ring slot the next new segment goes into
+    int64_t last_sequence;        // Media sequence number of the newest listed segment, -1 if none
+    int target_duration;
+} hls_memory_stream_t;
+
+static hls_memory_stream_t memory_streams[MAX_STREAMS];
+static pthread_mutex_t memory_store_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t memory_store_serial = 0;
+
+typedef struct {
+    hls_memory_file_t *file;
+    size_t pos;
+} hls_memory_reader_t;
+
+/**
+ * Free a file once the last reference is gone, called with the store lock held
+ */
+static void release_locked(hls_memory_file_t *file) {
+    if (file && --file->refcount == 0) {
+        av_free(file->data);
+        free(file);
+    }
+}
+
+static hls_memory_stream_t *find_stream_locked(const char *stream_name, bool create) {
+    hls_memory_stream_t *free_slot = NULL;
+
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        if (memory_streams[i].used) {
+            if (strcmp(memory_streams[i].stream_name, stream_name) == 0) {
+                return &memory_streams[i];
+            }
+        } else if (!free_slot) {
+            free_slot = &memory_streams[i];
+        }
+    }
+
+    if (!create || !free_slot) {
+        return NULL;
+    }
+
+    memset(free_slot, 0, sizeof(*free_slot));
+    free_slot->used = true;
+    strncpy(free_slot->stream_name, stream_name, MAX_STREAM_NAME - 1);
+    free_slot->last_sequence = -1;
+    return free_slot;
+}
+
+static void clear_stream_locked(hls_memory_stream_t *stream) {
+    for (int i = 0; i < HLS_MEMORY_MAX_PINNED; i++) {
+        release_locked(stream->pinned[i]);
+    }
+    for (int i = 0; i < HLS_MEMORY_MAX_SEGMENTS; i++) {
+        release_locked(stream->segments[i]);
+    }
+    memset(stream, 0, sizeof(*stream));
+}
+
+/**
+ * Playlists and initialization segments are kept until replaced,
+ * everything else is a media segment in the ring
+ */
+static bool is_pinned_file(const char *file_name) {
+    return strstr(file_name, ".m3u8") != NULL || strncmp(file_name, "init", 4) == 0;
+}
+
+/**
+ * Read the media sequence position and target duration from a playlist
+ */
+static void parse_playlist_locked(hls_memory_stream_t *stream, const hls_memory_file_t *file) {
+    long long media_sequence = 0;
+    int target_duration = 0;
+    int segment_count = 0;
+    const char *text = (const char *)file->data;
+    const char *end = text + file->size;
+
+    while (text < end) {
+        const char *line_end = memchr(text, '\n', end - text);
+        size_t len = line_end ? (size_t)(line_end - text) : (size_t)(end - text);
+
+        if (len > 8 && strncmp(text, "#EXTINF:", 8) == 0) {
+            segment_count++;
+        } else if (len > 22 && strncmp(text, "#EXT-X-MEDIA-SEQUENCE:", 22) == 0) {
+            media_sequence = strtoll(text + 22, NULL, 10);
+        } else if (len > 22 && strncmp(text, "#EXT-X-TARGETDURATION:", 22) == 0) {
+            target_duration = atoi(text + 22);
+        }
+
+        text += len + 1;
+    }
+
+    stream->last_sequence = segment_count > 0 ? media_sequence + segment_count - 1 : -1;
+    if (target_duration > 0) {
+        stream->target_duration = target_duration;
+    }
+}
+
+/**
+ * Store a finished playlist or segment
+ */
+int hls_memory_store_put(const char *stream_name, const char *file_name, uint8_t *data, size_t size) {
+    if (!stream_name || !file_name || strlen(file_name) >= HLS_MEMORY_MAX_FILE_NAME) {
+        log_error("Invalid parameters for hls_memory_store_put");
+        av_free(data);
+        return -1;
+    }
+
+    hls_memory_file_t *file = calloc(1, sizeof(hls_memory_file_t));
+    if (!file) {
+        log_error("Failed to allocate in-memory HLS file %s for stream %s", file_name, stream_name);
+        av_free(data);
+        return -1;
+    }
+
+    strncpy(file->name, file_name, sizeof(file->name) - 1);
+    file->data = data;
+    file->size = size;
+    file->created = time(NULL);
+    file->refcount = 1;
+
+    pthread_mutex_lock(&memory_store_mutex);
+
+    hls_memory_stream_t *stream = find_stream_locked(stream_name, true);
+    if (!stream) {
+        pthread_mutex_unlock(&memory_store_mutex);
+        log_error("No free in-memory HLS slot for stream %s", stream_name);
+        av_free(data);
+        free(file);
+        return -1;
+    }
+
+    file->serial = ++memory_store_serial;
+
+    hls_memory_file_t **slots = stream->segments;
+    int slot_count = HLS_MEMORY_MAX_SEGMENTS;
+    if (is_pinned_file(file_name)) {
+        slots = stream->pinned;
+        slot_count = HLS_MEMORY_MAX_PINNED;
+    }
+
+    // Replace a file of the same name in place
+    int slot = -1;
+    for (int i = 0; i < slot_count; i++) {
+        if (slots[i] && strcmp(slots[i]->name, file_name) == 0) {
+            slot = i;
+            break;
+        }
+    }
+
+    if (slot < 0) {
+        if (slots == stream->segments) {
+            slot = stream->next_segment;
+            stream->next_segment = (stream->next_segment + 1) % HLS_MEMORY_MAX_SEGMENTS;
+        } else {
+            for (int i = 0; i < slot_count && slot < 0; i++) {
+                if (!slots[i]) {
+                    slot = i;
+                }
+            }
+            if (slot < 0) {
+                slot = 0;
+            }
+        }
+    }
+
+    release_locked(slots[slot]);
+    slots[slot] = file;
+
+    if (strstr(file_name, ".m3u8")) {
+        parse_playlist_locked(stream, file);
+    }
+
+    pthread_mutex_unlock(&memory_store_mutex);
+
+    log_debug("Stored in-memory HLS file %s for stream %s (%zu bytes)", file_name, stream_name, size);
+    return 0;
+}
+
+/**
+ * Look up a file
+ */
+hls_memory_file_t *hls_memory_store_get(const char *stream_name, const char *file_name) {
+    if (!stream_name || !file_name) {
+        return NULL;
+    }
+
+    hls_memory_file_t *found = NULL;
+
+    pthread_mutex_lock(&memory_store_mutex);
+    hls_memory_stream_t *stream = find_stream_locked(stream_name, false);
+    if (stream) {
+        for (int i = 0; i < HLS_MEMORY_MAX_PINNED && !found; i++) {
+            if (stream->pinned[i] && strcmp(stream->pinned[i]->name, file_name) == 0) {
+                found = stream->pinned[i];
+            }
+        }
+        for (int i = 0; i < HLS_MEMORY_MAX_SEGMENTS && !found; i++) {
+            if (stream->segments[i] && strcmp(stream->segments[i]->name, file_name) == 0) {
+                found = stream->segments[i];
+            }
+        }
+        if (found) {
+            found->refcount++;
+        }
+    }
+    pthread_mutex_unlock(&memory_store_mutex);
+
+    return found;
+}
+
+/**
+ * Release a file returned by hls_memory_store_get()
+ */
+void hls_memory_file_release(hls_memory_file_t *file) {
+    if (!file) {
+        return;
+    }
+
+    pthread_mutex_lock(&memory_store_mutex);
+    release_locked(file);
+    pthread_mutex_unlock(&memory_store_mutex);
+}
+
+/**
+ * Write a copy of a stored file to disk
+ */
+int hls_memory_store_save(const char *stream_name, const char *file_name, const char *path) {
+    if (!path) {
+        return -1;
+    }
+
+    // The reference keeps the contents alive while writing outside the lock
+    hls_memory_file_t *file = hls_memory_store_get(stream_name, file_name);
+    if (!file) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    int result = -1;
+    FILE *out = fopen(path, "wb");
+    if (out) {
+        bool written = fwrite(file->data, 1, file->size, out) == file->size;
+        if (fclose(out) == 0 && written) {
+            result = 0;
+        } else {
+            unlink(path);
+        }
+    }
+
+    hls_memory_file_release(file);
+    return result;
+}
+
+/**
+ * Get the live playlist position of a stream
+ */
+bool hls_memory_store_playlist_state(const char *stream_name, int64_t *last_sequence,
+                                     int *target_duration) {
+    bool found = false;
+
+    pthread_mutex_lock(&memory_store_mutex);
+    hls_memory_stream_t *stream = stream_name ? find_stream_locked(stream_name, false) : NULL;
+    if (stream && stream->last_sequence >= 0) {
+        if (last_sequence) {
+            *last_sequence = stream->last_sequence;
+        }
+        if (target_duration) {
+            *target_duration = stream->target_duration;
+        }
+        found = true;
+    }
+    pthread_mutex_unlock(&memory_store_mutex);
+
+    return found;
+}
+
+/**
+ * Get the newest media segment of a stream
+ */
+bool hls_memory_store_newest_segment(const char *stream_name, char *file_name, size_t file_name_size,
+                                     time_t *created, int *segment_count) {
+    if (!stream_name || !file_name || file_name_size == 0) {
+        return false;
+    }
+
+    bool found = false;
+
+    pthread_mutex_lock(&memory_store_mutex);
+    hls_memory_stream_t *stream = find_stream_locked(stream_name, false);
+    if (stream) {
+        int newest = (stream->next_segment + HLS_MEMORY_MAX_SEGMENTS - 1) % HLS_MEMORY_MAX_SEGMENTS;
+        hls_memory_file_t *file = stream->segments[newest];
+        if (file) {
+            strncpy(file_name, file->name, file_name_size - 1);
+            file_name[file_name_size - 1] = '\0';
+            if (created) {
+                *created = file->created;
+            }
+            found = true;
+        }
+
+        if (segment_count) {
+            *segment_count = 0;
+            for (int i = 0; i < HLS_MEMORY_MAX_SEGMENTS; i++) {
+                if (stream->segments[i]) {
+                    (*segment_count)++;
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&memory_store_mutex);
+
+    return found;
+}
+
+/**
+ * Drop every file of a stream
+ */
+void hls_memory_store_remove(const char *stream_name) {
+    if (!stream_name) {
+        return;
+    }
+
+    pthread_mutex_lock(&memory_store_mutex);
+    hls_memory_stream_t *stream = find_stream_locked(stream_name, false);
+    if (stream) {
+        clear_stream_locked(stream);
+    }
+    pthread_mutex_unlock(&memory_store_mutex);
+}
+
+/**
+ * Drop every stored file
+ */
+void hls_memory_store_clear(void) {
+    pthread_mutex_lock(&memory_store_mutex);
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        if (memory_streams[i].used) {
+            clear_stream_locked(&memory_streams[i]);
+        }
+    }
+    pthread_mutex_unlock(&memory_store_mutex);
+}
+
+static int memory_read_packet(void *opaque, uint8_t *buf, int buf_size) {
+    hls_memory_reader_t *reader = (hls_memory_reader_t *)opaque;
+    size_t remaining = reader->file->size - reader->pos;
+
+    if (remaining == 0) {
+        return AVERROR_EOF;
+    }
+
+    size_t len = (size_t)buf_size < remaining ? (size_t)buf_size : remaining;
+    memcpy(buf, reader->file->data + reader->pos, len);
+    reader->pos += len;
+    return (int)len;
+}
+
+static int64_t memory_seek(void *opaque, int64_t offset, int whence) {
+    hls_memory_reader_t *reader = (hls_memory_reader_t *)opaque;
+    int64_t position;
+
+    switch (whence & ~AVSEEK_FORCE) {
+        case AVSEEK_SIZE:
+            return (int64_t)reader->file->size;
+        case SEEK_SET:
+            position = offset;
+            break;
+        case SEEK_CUR:
+            position = (int64_t)reader->pos + offset;
+            break;
+        case SEEK_END:
+            position = (int64_t)reader->file->size + offset;
+            break;
+        default:
+            return AVERROR(EINVAL);
+    }
+
+    if (position < 0 || position > (int64_t)reader->file->size) {
+        return AVERROR(EINVAL);
+    }
+
+    reader->pos = (size_t)position;
+    return position;
+}
+
+/**
+ * Open a read-only, seekable AVIOContext over a stored file
+ */
+AVIOContext *hls_memory_file_open_read(hls_memory_file_t *file) {
+    if (!file) {
+        return NULL;
+    }
+
+    hls_memory_reader_t *reader = calloc(1, sizeof(hls_memory_reader_t));
+    unsigned char *buffer = av_malloc(HLS_MEMORY_READ_BUFFER_SIZE);
+    if (!reader || !buffer) {
+        log_error("Failed to allocate reader for in-memory HLS file %s", file->name);
+        free(reader);
+        av_free(buffer);
+        return NULL;
+    }
+    reader->file = file;
+
+    AVIOContext *pb = avio_alloc_context(buffer, HLS_MEMORY_READ_BUFFER_SIZE, 0, reader,
+                                         memory_read_packet, NULL, memory_seek);
+    if (!pb) {
+        log_error("Failed to allocate AVIOContext for in-memory HLS file %s", file->name);
+        free(reader);
+        av_free(buffer);
+        return NULL;
+    }
+
+    return pb;
+}
+
+/**
+ * Close a context from hls_memory_file_open_read() and release its file
+ */
+void hls_memory_file_close_read(AVIOContext **pb) {
+    if (!pb || !*pb) {
+        return;
+    }
+
+    hls_memory_reader_t *reader = (hls_memory_reader_t *)(*pb)->opaque;
+
+    // The context may have replaced its buffer, free whatever it holds now
+    av_freep(&(*pb)->buffer);
+    avio_context_free(pb);
+
+    if (reader) {
+        hls_memory_file_release(reader->file);
+        free(reader);
+    }
+}
@@ -34,6 +34,78 @@ static int ensure_output_directory(hls_writer_t *writer);
 static void register_hls_writer(hls_writer_t *writer);
 static void unregister_hls_writer(hls_writer_t *writer);
 
+/**
+ * Open callback of the HLS muxer in memory mode: every playlist and segment
+ * is written into a dynamic buffer instead of a file
+ */
+static int hls_memory_io_open(AVFormatContext *s, AVIOContext **pb, const char *url,
+                              int flags, AVDictionary **options) {
+    hls_writer_t *writer = (hls_writer_t *)s->opaque;
+    (void)options;
+
+    if (!writer || !(flags & AVIO_FLAG_WRITE)) {
+        return AVERROR(ENOSYS);
+    }
+
+    // Playlists reference their segments by file name only
+    const char *name = strrchr(url, '/');
+    name = name ? name + 1 : url;
+    if (strlen(name) >= HLS_MEMORY_MAX_FILE_NAME) {
+        log_error("In-memory HLS file name too long for stream %s: %s", writer->stream_name, name);
+        return AVERROR(EINVAL);
+    }
+
+    for (int i = 0; i < HLS_MEMORY_MAX_OPEN_OUTPUTS; i++) {
+        if (writer->memory_outputs[i].pb) {
+            continue;
+        }
+
+        int ret = avio_open_dyn_buf(pb);
+        if (ret < 0) {
+            return ret;
+        }
+        writer->memory_outputs[i].pb = *pb;
+        strncpy(writer->memory_outputs[i].name, name, HLS_MEMORY_MAX_FILE_NAME - 1);
+        writer->memory_outputs[i].name[HLS_MEMORY_MAX_FILE_NAME - 1] = '\0';
+        return 0;
+    }
+
+    log_error("Too many open in-memory HLS outputs for stream %s", writer->stream_name);
+    return AVERROR(ENOMEM);
+}
+
+/**
+ * Close callback of the HLS muxer in memory mode: publishes the finished file
+ */
+static int hls_memory_io_close(AVFormatContext *s, AVIOContext *pb) {
+    hls_writer_t *writer = (hls_writer_t *)s->opaque;
+    uint8_t *data = NULL;
+    int size = avio_close_dyn_buf(pb, &data);
+
+    if (writer) {
+        for (int i = 0; i < HLS_MEMORY_MAX_OPEN_OUTPUTS; i++) {
+            if (writer->memory_outputs[i].pb == pb) {
+                writer->memory_outputs[i].pb = NULL;
+                if (size < 0) {
+                    break;
+                }
+                // The store takes ownership of the buffer
+                return hls_memory_store_put(writer->stream_name, writer->memory_outputs[i].name,
+                                            data, (size_t)size) == 0 ? 0 : AVERROR(ENOMEM);
+            }
+        }
+    }
+
+    av_free(data);
+    return size < 0 ? size : 0;
+}
+
+#if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(59, 17, 100)
+static void hls_memory_io_close_legacy(AVFormatContext *s, AVIOContext *pb) {
+    hls_memory_io_close(s, pb);
+}
+#endif
+
 /**
  * Clean up old HLS segments that are no longer in the playlist
  */
@@ -179,6 +251,9 @@ hls_writer_t *hls_writer_create(const char *output_dir, const char *stream_name,
     writer->segment_duration = segment_duration;
     writer->last_cleanup_time = time(NULL);
 
+    config_t *streaming_config = get_streaming_config();
+    writer->in_memory = streaming_config && streaming_config->hls_memory_enabled;
+
     // Initialize mutex
     pthread_mutex_init(&writer->mutex, NULL);
 
@@ -256,6 +331,29 @@ hls_writer_t *hls_writer_create(const char *output_dir, const char *stream_name,
     log_info("  start_number: 0");
     log_info("  hls_segment_filename: %s", segment_format);
 
+    if (writer->in_memory) {
+        // The ring in the memory store evicts old segments, there are no files to delete
+        av_dict_set(&options, "hls_flags", "independent_segments+program_date_time", 0);
+
+        // The muxer opens and closes every playlist and segment through these callbacks
+        writer->output_ctx->opaque = writer;
+        writer->output_ctx->io_open = hls_memory_io_open;
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(59, 17, 100)
+        writer->output_ctx->io_close2 = hls_memory_io_close;
+#else
+        writer->output_ctx->io_close = hls_memory_io_close_legacy;
+#endif
+
+        // Handed to the muxer when the header is written
+        writer->muxer_options = options;
+
+        log_info("Created in-memory HLS writer for stream %s with segment duration %d seconds",
+                stream_name, segment_duration);
+
+        register_hls_writer(writer);
+        return writer;
+    }
+
     // Open output file
     ret = avio_open2(&writer->output_ctx->pb, output_path,
                     AVIO_FLAG_WRITE, NULL, &options);
@@ -335,7 +433,8 @@ int hls_writer_initialize(hls_writer_t *writer, const AVStream *input_stream) {
     }
 
     // Write the header
-    AVDictionary *options = NULL;
+    AVDictionary *options = writer->muxer_options;
+    writer->muxer_options = NULL;
     ret = avformat_write_header(writer->output_ctx, &options);
     if (ret < 0) {
         char error_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
@@ -974,6 +1073,9 @@ void cleanup_all_hls_writers(void) {
         }
     }
 
+    // Drop whatever live HLS is still held in memory
+    hls_memory_store_clear();
+
     log_info("Completed cleanup of %d HLS writers", writers_count);
 }
 
@@ -1102,7 +1204,8 @@ void hls_writer_close(hls_writer_t *writer) {
         // Check if the context is valid and has streams
         if (local_output_ctx->nb_streams > 0) {
             // Verify all critical pointers are valid
-            if (local_output_ctx->oformat && local_output_ctx->pb) {
+            // In memory mode the muxer has no main AVIO context, it writes through callbacks
+            if (local_output_ctx->oformat && (local_output_ctx->pb || writer->in_memory)) {
                 // Additional validation of each stream
                 bool all_streams_valid = true;
                 for (unsigned int i = 0; i < local_output_ctx->nb_streams; i++) {
@@ -1187,6 +1290,20 @@ void hls_writer_close(hls_writer_t *writer) {
         log_info("Successfully freed format context for HLS writer for stream %s", stream_name);
     }
 
+    if (writer->in_memory) {
+        // Drop outputs a failed trailer left open, then the stream's files
+        for (int i = 0; i < HLS_MEMORY_MAX_OPEN_OUTPUTS; i++) {
+            if (writer->memory_outputs[i].pb) {
+                uint8_t *data = NULL;
+                avio_close_dyn_buf(writer->memory_outputs[i].pb, &data);
+                av_free(data);
+                writer->memory_outputs[i].pb = NULL;
+            }
+        }
+        hls_memory_store_remove(stream_name);
+    }
+    av_dict_free(&writer->muxer_options);
+
     // Free bitstream filter context if it exists
     if (writer->bsf_ctx) {
         log_info("Freeing bitstream filter context for HLS writer for stream %s", stream_name);
@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+
+#include "core/logger.h"
+#include "video/jpeg_encoder.h"
+
+// Per-thread encoder state, rebuilt only when the input changes
+typedef struct {
+    AVCodecContext *codec_ctx;
+    struct SwsContext *sws_ctx;
+    AVFrame *frame;
+    AVPacket *packet;
+    int width;
+    int height;
+    int channels;
+    int quality;
+} jpeg_encoder_t;
+
+static pthread_key_t encoder_key;
+static pthread_once_t encoder_key_once = PTHREAD_ONCE_INIT;
+
+static void free_encoder(jpeg_encoder_t *enc) {
+    if (!enc) {
+        return;
+    }
+
+    if (enc->codec_ctx) {
+        avcodec_free_context(&enc->codec_ctx);
+    }
+    if (enc->sws_ctx) {
+        sws_freeContext(enc->sws_ctx);
+        enc->sws_ctx = NULL;
+    }
+    if (enc->frame) {
+        av_frame_free(&enc->frame);
+    }
+    if (enc->packet) {
+        av_packet_free(&enc->packet);
+    }
+    enc->width = 0;
+    enc->height = 0;
+    enc->channels = 0;
+    enc->quality = 0;
+}
+
+static void encoder_destructor(void *ptr) {
+    jpeg_encoder_t *enc = ptr;
+    free_encoder(enc);
+    free(enc);
+}
+
+static void create_encoder_key(void) {
+    pthread_key_create(&encoder_key, encoder_destructor);
+}
+
+static jpeg_encoder_t *get_thread_encoder(void) {
+    pthread_once(&encoder_key_once, create_encoder_key);
+
+    jpeg_encoder_t *enc = pthread_getspecific(encoder_key);
+    if (!enc) {
+        enc = calloc(1, sizeof(jpeg_encoder_t));
+        if (!enc) {
+            return NULL;
+        }
+        pthread_setspecific(encoder_key, enc);
+    }
+    return enc;
+}
+
+/**
+ * Map a 1-100 JPEG quality to an MJPEG quantizer scale (2 best, 31 worst)
+ */
+static int quality_to_qscale(int quality) {
+    if (quality < 1) quality = 1;
+    if (quality > 100) quality = 100;
+    return 2 + ((100 - quality) * 29) / 99;
+}
+
+/**
+ * (Re)open the encoder for a frame size, pixel layout and quality
+ */
+static int open_encoder(jpeg_encoder_t *enc, int width, int height, int channels, int quality) {
+    free_encoder(enc);
+
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    if (!codec) {
+        log_error("MJPEG encoder not available");
+        return -1;
+    }
+
+    enc->codec_ctx = avcodec_alloc_context3(codec);
+    if (!enc->codec_ctx) {
+        log_error("Failed to allocate MJPEG encoder context");
+        return -1;
+    }
+
+    int qscale = quality_to_qscale(quality);
+    enc->codec_ctx->width = width;
+    enc->codec_ctx->height = height;
+    enc->codec_ctx->pix_fmt = AV_PIX_FMT_YUVJ420P;
+    enc->codec_ctx->time_base = (AVRational){1, 25};
+    enc->codec_ctx->flags |= AV_CODEC_FLAG_QSCALE;
+    enc->codec_ctx->global_quality = FF_QP2LAMBDA * qscale;
+    enc->codec_ctx->qmin = qscale;
+    enc->codec_ctx->qmax = qscale;
+    // Detection threads already run in parallel, one encoder thread each is enough
+    enc->codec_ctx->thread_count = 1;
+
+    int ret = avcodec_open2(enc->codec_ctx, codec, NULL);
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        log_error("Failed to open MJPEG encoder: %s", errbuf);
+        free_encoder(enc);
+        return -1;
+    }
+
+    enum AVPixelFormat src_fmt = (channels == 1) ? AV_PIX_FMT_GRAY8 :
+                                 (channels == 3) ? AV_PIX_FMT_RGB24 : AV_PIX_FMT_RGBA;
+    enc->sws_ctx = sws_getContext(width, height, src_fmt,
+                                  width, height, AV_PIX_FMT_YUVJ420P,
+                                  SWS_BILINEAR, NULL, NULL, NULL);
+    enc->frame = av_frame_alloc();
+    enc->packet = av_packet_alloc();
+    if (!enc->sws_ctx || !enc->frame || !enc->packet) {
+        log_error("Failed to allocate JPEG conversion context");
+        free_encoder(enc);
+        return -1;
+    }
+
+    enc->frame->format = AV_PIX_FMT_YUVJ420P;
+    enc->frame->width = width;
+    enc->frame->height = height;
+    if (av_frame_get_buffer(enc->frame, 0) < 0) {
+        log_error("Failed to allocate JPEG conversion frame");
+        free_encoder(enc);
+        return -1;
+    }
+
+    enc->width = width;
+    enc->height = height;
+    enc->channels = channels;
+    enc->quality = quality;
+
+    log_debug("Opened MJPEG encoder for %dx%d (%d channels, qscale %d)",
+              width, height, channels, qscale);
+    return 0;
+}
+
+int jpeg_encode_frame(const unsigned char *frame_data, int width, int height, int channels,
+                      int quality, unsigned char **jpeg_data, size_t *jpeg_size) {
+    if (!frame_data || !jpeg_data || !jpeg_size || width <= 0 || height <= 0 ||
+        (channels != 1 && channels != 3 && channels != 4)) {
+        log_error("Invalid parameters for jpeg_encode_frame");
+        return -1;
+    }
+
+    *jpeg_data = NULL;
+    *jpeg_size = 0;
+
+    jpeg_encoder_t *enc = get_thread_encoder();
+    if (!enc) {
+        log_error("Failed to allocate JPEG encoder state");
+        return -1;
+    }
+
+    if (!enc->codec_ctx || enc->width != width || enc->height != height ||
+        enc->channels != channels || enc->quality != quality) {
+        if (open_encoder(enc, width, height, channels, quality) != 0) {
+            return -1;
+        }
+    }
+
+    // The encoder may still reference the previous frame's buffer
+    if (av_frame_make_writable(enc->frame) < 0) {
+        log_error("Failed to make JPEG conversion frame writable");
+        return -1;
+    }
+
+    const uint8_t *src_data[4] = { frame_data, NULL, NULL, NULL };
+    int src_linesize[4] = { width * channels, 0, 0, 0 };
+    sws_scale(enc->sws_ctx, src_data, src_linesize, 0, height,
+              enc->frame->data, enc->frame->linesize);
+
+    enc->frame->pts = 0;
+    enc->frame->quality = enc->codec_ctx->global_quality;
+
+    int ret = avcodec_send_frame(enc->codec_ctx, enc->frame);
+    if (ret >= 0) {
+        ret = avcodec_receive_packet(enc->codec_ctx, enc->packet);
+    }
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        log_error("Failed to encode JPEG: %s", errbuf);
+        // Start from a clean encoder next time
+        free_encoder(enc);
+        return -1;
+    }
+
+    unsigned char *data = malloc(enc->packet->size);
+    if (!data) {
+        log_error("Failed to allocate %d bytes for JPEG data", enc->packet->size);
+        av_packet_unref(enc->packet);
+        return -1;
+    }
+
+    memcpy(data, enc->packet->data, enc->packet->size);
+    *jpeg_data = data;
+    *jpeg_size = enc->packet->size;
+    av_packet_unref(enc->packet);
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "video/live_events.h"
+#include "core/logger.h"
+
+// Latest detection result and motion state of one stream
+typedef struct {
+    bool used;
+    char stream_name[MAX_STREAM_NAME];
+    detection_result_t result;
+    time_t timestamp;
+    uint64_t sequence;          // Event that published the result, 0 before the first one
+    uint64_t last_update;       // Newest event of the stream, for evicting stale slots
+    bool motion_active;
+} stream_slot_t;
+
+static pthread_mutex_t events_mutex = PTHREAD_MUTEX_INITIALIZER;
+static live_event_t event_ring[LIVE_EVENTS_RING_SIZE];
+static stream_slot_t stream_slots[MAX_STREAMS];
+
+// Written under events_mutex, read without it by pollers
+static _Atomic uint64_t newest_sequence;
+
+/**
+ * Append an event, caller holds events_mutex
+ */
+static uint64_t append_event(live_event_type_t type, const char *stream_name, time_t timestamp, bool active) {
+    uint64_t sequence = atomic_load_explicit(&newest_sequence, memory_order_relaxed) + 1;
+    live_event_t *event = &event_ring[sequence % LIVE_EVENTS_RING_SIZE];
+
+    event->sequence = sequence;
+    event->type = type;
+    strncpy(event->stream_name, stream_name, MAX_STREAM_NAME - 1);
+    event->stream_name[MAX_STREAM_NAME - 1] = '\0';
+    event->timestamp = timestamp ? timestamp : time(NULL);
+    event->active = active;
+
+    atomic_store_explicit(&newest_sequence, sequence, memory_order_release);
+    return sequence;
+}
+
+/**
+ * Find or claim the slot of a stream, caller holds events_mutex
+ */
+static stream_slot_t *stream_slot(const char *stream_name, bool create) {
+    stream_slot_t *free_slot = NULL;
+    stream_slot_t *oldest = NULL;
+
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        stream_slot_t *slot = &stream_slots[i];
+        if (!slot->used) {
+            if (!free_slot) {
+                free_slot = slot;
+            }
+            continue;
+        }
+        if (strcmp(slot->stream_name, stream_name) == 0) {
+            return slot;
+        }
+        if (!oldest || slot->last_update < oldest->last_update) {
+            oldest = slot;
+        }
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    // Streams that were deleted leave stale slots, reuse the least recently updated
+    stream_slot_t *slot = free_slot ? free_slot : oldest;
+    memset(slot, 0, sizeof(*slot));
+    slot->used = true;
+    strncpy(slot->stream_name, stream_name, MAX_STREAM_NAME - 1);
+    return slot;
+}
+
+void live_events_publish_detections(const char *stream_name, const detection_result_t *result,
+                                    time_t timestamp) {
+    if (!stream_name || stream_name[0] == '\0' || !result) {
+        return;
+    }
+
+    if (timestamp == 0) {
+        timestamp = time(NULL);
+    }
+
+    pthread_mutex_lock(&events_mutex);
+
+    stream_slot_t *slot = stream_slot(stream_name, true);
+
+    // Nothing to tell subscribers when an empty result follows an empty result
+    if (result->count == 0 && slot->sequence != 0 && slot->result.count == 0) {
+        pthread_mutex_unlock(&events_mutex);
+        return;
+    }
+
+    memcpy(&slot->result, result, sizeof(detection_result_t));
+    if (slot->result.count > MAX_DETECTIONS) {
+        slot->result.count = MAX_DETECTIONS;
+    }
+    slot->timestamp = timestamp;
+    slot->sequence = append_event(LIVE_EVENT_DETECTION, stream_name, timestamp, result->count > 0);
+    slot->last_update = slot->sequence;
+
+    pthread_mutex_unlock(&events_mutex);
+}
+
+void live_events_publish_motion(const char *stream_name, bool active, time_t timestamp) {
+    if (!stream_name || stream_name[0] == '\0') {
+        return;
+    }
+
+    pthread_mutex_lock(&events_mutex);
+
+    // Detectors report motion on every frame that has some, only changes are events
+    stream_slot_t *slot = stream_slot(stream_name, true);
+    if (slot->motion_active != active) {
+        slot->motion_active = active;
+        slot->last_update = append_event(LIVE_EVENT_MOTION, stream_name, timestamp, active);
+    }
+
+    pthread_mutex_unlock(&events_mutex);
+}
+
+void live_events_publish_recording(const char *stream_name, bool active) {
+    if (!stream_name || stream_name[0] == '\0') {
+        return;
+    }
+
+    pthread_mutex_lock(&events_mutex);
+    append_event(LIVE_EVENT_RECORDING, stream_name, 0, active);
+    pthread_mutex_unlock(&events_mutex);
+}
+
+uint64_t live_events_sequence(void) {
+    return atomic_load_explicit(&newest_sequence, memory_order_acquire);
+}
+
+int live_events_read(uint64_t after, live_event_t *events, int max_events) {
+    if (!events || max_events <= 0) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&events_mutex);
+
+    uint64_t newest = atomic_load_explicit(&newest_sequence, memory_order_relaxed);
+    uint64_t first = after + 1;
+    if (newest >= LIVE_EVENTS_RING_SIZE && first <= newest - LIVE_EVENTS_RING_SIZE) {
+        first = newest - LIVE_EVENTS_RING_SIZE + 1;
+    }
+
+    int count = 0;
+    for (uint64_t sequence = first; sequence <= newest && count < max_events; sequence++) {
+        events[count++] = event_ring[sequence % LIVE_EVENTS_RING_SIZE];
+    }
+
+    pthread_mutex_unlock(&events_mutex);
+
+    return count;
+}
+
+bool live_events_get_detections(const char *stream_name, detection_result_t *result,
+                                time_t *timestamp, uint64_t *sequence) {
+    if (!stream_name || !result) {
+        return false;
+    }
+
+    pthread_mutex_lock(&events_mutex);
+
+    stream_slot_t *slot = stream_slot(stream_name, false);
+    if (slot && slot->sequence == 0) {
+        slot = NULL;
+    }
+    if (slot) {
+        memcpy(result, &slot->result, sizeof(detection_result_t));
+        if (timestamp) {
+            *timestamp = slot->timestamp;
+        }
+        if (sequence) {
+            *sequence = slot->sequence;
+        }
+    }
+
+    pthread_mutex_unlock(&events_mutex);
+
+    return slot != NULL;
+}
@@ -18,6 +18,7 @@
 #include "video/motion_detection.h"
 #include "video/streams.h"
 #include "video/detection_result.h"
+#include "video/motion_kernels.h"
 #include "utils/memory.h"
 
 #define MAX_MOTION_STREAMS MAX_STREAMS
@@ -32,7 +33,6 @@
 #define DEFAULT_DOWNSCALE_ENABLED true   // Enable downscaling for embedded devices
 #define DEFAULT_DOWNSCALE_FACTOR 2       // Downscale factor (2 = half size)
 #define MOTION_LABEL "motion"
-#define EMBEDDED_DEVICE_OPTIMIZATION 1   // Enable embedded device optimizations
 
 // Structure to store frame data for temporal filtering
 typedef struct {
@@ -50,6 +50,11 @@ typedef struct {
     int history_size;                    // Size of frame history buffer
     int history_index;                   // Current index in history buffer
     float *grid_scores;                  // Array to store grid cell motion scores
+    unsigned char *gray_frame;           // Grayscale conversion of RGB input, kept between frames
+    size_t gray_frame_size;
+    unsigned char *work_frame;           // Downscaled luma being processed, kept between frames
+    size_t work_frame_size;
+    unsigned char *blur_temp;            // Scratch for the separable blur
     int width;
     int height;
     int channels;
@@ -101,44 +106,59 @@ motion_stream_t* allocate_motion_stream(void) {
 }
 
 /**
- * Free a motion stream structure
+ * Free the buffers sized for the processing resolution
+ * Caller must hold stream->mutex
  */
-void free_motion_stream(motion_stream_t* stream) {
-    if (!stream) return;
-    
-    pthread_mutex_lock(&stream->mutex);
-    
-    if (stream->prev_frame) {
-        free(stream->prev_frame);
-        stream->prev_frame = NULL;
-    }
+static void release_processing_buffers(motion_stream_t *stream) {
+    free(stream->prev_frame);
+    stream->prev_frame = NULL;
 
-    if (stream->blur_buffer) {
-        free(stream->blur_buffer);
-        stream->blur_buffer = NULL;
-    }
+    free(stream->blur_buffer);
+    stream->blur_buffer = NULL;
 
-    if (stream->background) {
-        free(stream->background);
-        stream->background = NULL;
-    }
+    free(stream->blur_temp);
+    stream->blur_temp = NULL;
 
-    if (stream->grid_scores) {
-        free(stream->grid_scores);
-        stream->grid_scores = NULL;
-    }
+    free(stream->background);
+    stream->background = NULL;
+
+    free(stream->grid_scores);
+    stream->grid_scores = NULL;
 
     if (stream->frame_history) {
         for (int j = 0; j < stream->history_size; j++) {
-            if (stream->frame_history[j].frame) {
-                free(stream->frame_history[j].frame);
-                stream->frame_history[j].frame = NULL;  // Set to NULL after freeing to prevent double-free
-            }
+            free(stream->frame_history[j].frame);
+            stream->frame_history[j].frame = NULL;  // Set to NULL after freeing to prevent double-free
         }
         free(stream->frame_history);
         stream->frame_history = NULL;
     }
+}
+
+/**
+ * Free every frame buffer of a stream
+ * Caller must hold stream->mutex
+ */
+static void release_motion_buffers(motion_stream_t *stream) {
+    release_processing_buffers(stream);
+
+    free(stream->gray_frame);
+    stream->gray_frame = NULL;
+    stream->gray_frame_size = 0;
+
+    free(stream->work_frame);
+    stream->work_frame = NULL;
+    stream->work_frame_size = 0;
+}
+
+/**
+ * Free a motion stream structure
+ */
+void free_motion_stream(motion_stream_t* stream) {
+    if (!stream) return;
     
+    pthread_mutex_lock(&stream->mutex);
+    release_motion_buffers(stream);
     pthread_mutex_unlock(&stream->mutex);
     pthread_mutex_destroy(&stream->mutex);
     
@@ -146,16 +166,14 @@ void free_motion_stream(motion_stream_t* stream) {
 }
 
 // Forward declarations for helper functions
-static void apply_box_blur(unsigned char *src, unsigned char *dst, int width, int height, int radius);
+static void apply_box_blur(motion_stream_t *stream, const unsigned char *src, unsigned char *dst,
+                           int width, int height, int radius);
 static void update_background_model(unsigned char *background, const unsigned char *current,
                                     int width, int height, float learning_rate);
 static float calculate_grid_motion(const unsigned char *curr_frame, const unsigned char *prev_frame,
                                   const unsigned char *background, int width, int height,
                                   float sensitivity, int noise_threshold, int grid_size,
                                   float *grid_scores, float *motion_area);
-static unsigned char *rgb_to_grayscale(const unsigned char *rgb_data, int width, int height);
-static unsigned char *downscale_grayscale(const unsigned char *src, int width, int height, int factor, 
-                                         int *out_width, int *out_height);
 
 /**
  * Initialize the motion detection system - optimized for embedded devices
@@ -427,36 +445,7 @@ int set_motion_detection_enabled(const char *stream_name, bool enabled) {
 
     // If disabling, free resources
     if (!enabled && stream->enabled) {
-        if (stream->prev_frame) {
-            free(stream->prev_frame);
-            stream->prev_frame = NULL;
-        }
-
-        if (stream->blur_buffer) {
-            free(stream->blur_buffer);
-            stream->blur_buffer = NULL;
-        }
-
-        if (stream->background) {
-            free(stream->background);
-            stream->background = NULL;
-        }
-
-        if (stream->grid_scores) {
-            free(stream->grid_scores);
-            stream->grid_scores = NULL;
-        }
-
-        if (stream->frame_history) {
-            for (int i = 0; i < stream->history_size; i++) {
-                if (stream->frame_history[i].frame) {
-                    free(stream->frame_history[i].frame);
-                    stream->frame_history[i].frame = NULL;  // Set to NULL after freeing to prevent double-free
-                }
-            }
-            free(stream->frame_history);
-            stream->frame_history = NULL;
-        }
+        release_motion_buffers(stream);
 
         stream->width = 0;
         stream->height = 0;
@@ -496,234 +485,33 @@ bool is_motion_detection_enabled(const char *stream_name) {
 }
 
 /**
- * Convert RGB frame to grayscale - optimized for embedded devices
+ * Make sure a persistent frame buffer can hold size bytes
+ * The contents are not preserved when the buffer has to grow
  */
-static unsigned char *rgb_to_grayscale(const unsigned char *rgb_data, int width, int height) {
-    unsigned char *gray_data = (unsigned char *)malloc(width * height);
-    if (!gray_data) {
-        log_error("Failed to allocate memory for grayscale conversion");
-        return NULL;
-    }
-
-    #if EMBEDDED_DEVICE_OPTIMIZATION
-    // Use integer arithmetic for faster conversion
-    // Pre-compute fixed-point coefficients (8-bit fraction)
-    const int r_coeff = (int)(0.299f * 256);
-    const int g_coeff = (int)(0.587f * 256);
-    const int b_coeff = (int)(0.114f * 256);
-    
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int rgb_idx = (y * width + x) * 3;
-            int gray_idx = y * width + x;
-
-            // Convert RGB to grayscale using integer arithmetic
-            int gray_value = (r_coeff * rgb_data[rgb_idx] + 
-                             g_coeff * rgb_data[rgb_idx + 1] + 
-                             b_coeff * rgb_data[rgb_idx + 2]) >> 8;
-                             
-            // Clamp to 0-255 range
-            if (gray_value > 255) gray_value = 255;
-            
-            gray_data[gray_idx] = (unsigned char)gray_value;
-        }
-    }
-    #else
-    // Original implementation for non-embedded devices
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int rgb_idx = (y * width + x) * 3;
-            int gray_idx = y * width + x;
-
-            // Convert RGB to grayscale using standard luminance formula
-            gray_data[gray_idx] = (unsigned char)(
-                0.299f * rgb_data[rgb_idx] +      // R
-                0.587f * rgb_data[rgb_idx + 1] +  // G
-                0.114f * rgb_data[rgb_idx + 2]    // B
-            );
-        }
+static unsigned char *ensure_frame_buffer(unsigned char **buffer, size_t *capacity, size_t size) {
+    if (*buffer && *capacity >= size) {
+        return *buffer;
     }
-    #endif
 
-    return gray_data;
-}
-
-/**
- * Downscale a grayscale image for faster processing
- */
-static unsigned char *downscale_grayscale(const unsigned char *src, int width, int height, int factor, 
-                                         int *out_width, int *out_height) {
-    if (factor <= 1) {
-        // No downscaling needed
-        unsigned char *copy = (unsigned char *)malloc(width * height);
-        if (!copy) {
-            log_error("Failed to allocate memory for image copy");
-            return NULL;
-        }
-        memcpy(copy, src, width * height);
-        *out_width = width;
-        *out_height = height;
-        return copy;
-    }
-    
-    // Calculate new dimensions
-    int new_width = width / factor;
-    int new_height = height / factor;
-    
-    // Ensure minimum size
-    if (new_width < 32) new_width = 32;
-    if (new_height < 32) new_height = 32;
-    
-    // Allocate memory for downscaled image
-    unsigned char *dst = (unsigned char *)malloc(new_width * new_height);
-    if (!dst) {
-        log_error("Failed to allocate memory for downscaled image");
-        return NULL;
-    }
-    
-    // Perform downscaling by averaging blocks of pixels
-    for (int y = 0; y < new_height; y++) {
-        for (int x = 0; x < new_width; x++) {
-            int sum = 0;
-            int count = 0;
-            
-            // Average the pixels in the block
-            for (int dy = 0; dy < factor && (y * factor + dy) < height; dy++) {
-                for (int dx = 0; dx < factor && (x * factor + dx) < width; dx++) {
-                    sum += src[(y * factor + dy) * width + (x * factor + dx)];
-                    count++;
-                }
-            }
-            
-            // Store the average
-            dst[y * new_width + x] = (unsigned char)(sum / count);
-        }
-    }
-    
-    *out_width = new_width;
-    *out_height = new_height;
-    return dst;
+    free(*buffer);
+    *buffer = (unsigned char *)malloc(size);
+    *capacity = *buffer ? size : 0;
+    return *buffer;
 }
 
 /**
  * Apply a fast box blur to reduce noise - optimized for embedded devices
  */
-static void apply_box_blur(unsigned char *src, unsigned char *dst, int width, int height, int radius) {
+static void apply_box_blur(motion_stream_t *stream, const unsigned char *src, unsigned char *dst,
+                           int width, int height, int radius) {
     // Skip if radius is 0
-    if (radius <= 0) {
+    if (radius <= 0 || !stream->blur_temp) {
         memcpy(dst, src, width * height);
         return;
     }
 
-    // For embedded devices, use a faster approximation with reduced radius
-    #if EMBEDDED_DEVICE_OPTIMIZATION
-    // Use a simplified blur for embedded devices - horizontal and vertical passes
-    // Horizontal pass
-    for (int y = 0; y < height; y++) {
-        int row_offset = y * width;
-        
-        // Initialize sliding window sum for the row
-        int sum = 0;
-        int count = 0;
-        
-        // Initialize the sum with the first radius+1 pixels
-        for (int i = 0; i <= radius && i < width; i++) {
-            sum += src[row_offset + i];
-            count++;
-        }
-        
-        // Process first pixel
-        dst[row_offset] = (unsigned char)(sum / count);
-        
-        // Slide the window for the rest of the row
-        for (int x = 1; x < width; x++) {
-            // Add new pixel to the right
-            if (x + radius < width) {
-                sum += src[row_offset + x + radius];
-                count++;
-            }
-            
-            // Remove pixel from the left
-            if (x - radius - 1 >= 0) {
-                sum -= src[row_offset + x - radius - 1];
-                count--;
-            }
-            
-            dst[row_offset + x] = (unsigned char)(sum / count);
-        }
-    }
-    
-    // Vertical pass (using dst as source and writing back to dst)
-    unsigned char *temp = (unsigned char *)malloc(width * height);
-    if (!temp) {
-        // If memory allocation fails, just return the horizontal blur
-        return;
-    }
-    
-    memcpy(temp, dst, width * height);
-    
-    for (int x = 0; x < width; x++) {
-        // Initialize sliding window sum for the column
-        int sum = 0;
-        int count = 0;
-        
-        // Initialize the sum with the first radius+1 pixels
-        for (int i = 0; i <= radius && i < height; i++) {
-            sum += temp[i * width + x];
-            count++;
-        }
-        
-        // Process first pixel
-        dst[x] = (unsigned char)(sum / count);
-        
-        // Slide the window for the rest of the column
-        for (int y = 1; y < height; y++) {
-            // Add new pixel below
-            if (y + radius < height) {
-                sum += temp[(y + radius) * width + x];
-                count++;
-            }
-            
-            // Remove pixel from above
-            if (y - radius - 1 >= 0) {
-                sum -= temp[(y - radius - 1) * width + x];
-                count--;
-            }
-            
-            dst[y * width + x] = (unsigned char)(sum / count);
-        }
-    }
-    
-    free(temp);
-    temp = NULL;  // Set to NULL after freeing to prevent use-after-free
-    #else
-    // Original implementation for non-embedded devices
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int sum = 0;
-            int count = 0;
-
-            // Calculate average of pixels in the radius
-            for (int dy = -radius; dy <= radius; dy++) {
-                for (int dx = -radius; dx <= radius; dx++) {
-                    int nx = x + dx;
-                    int ny = y + dy;
-
-                    // Skip out of bounds pixels
-                    if (nx < 0 || nx >= width || ny < 0 || ny >= height) {
-                        continue;
-                    }
-
-                    sum += src[ny * width + nx];
-                    count++;
-                }
-            }
-
-            // Set pixel to average value
-            dst[y * width + x] = (unsigned char)(sum / count);
-        }
-    }
-    #endif
+    // Separable blur: horizontal pass into the scratch buffer, vertical pass into dst
+    motion_kernels_get()->box_blur(src, dst, width, height, radius, stream->blur_temp);
 }
 
 /**
@@ -735,25 +523,10 @@ static void update_background_model(unsigned char *background, const unsigned ch
         return;
     }
 
-    #if EMBEDDED_DEVICE_OPTIMIZATION
-    // For embedded devices, use integer arithmetic for speed
-    // Convert learning_rate to fixed-point (8-bit fraction)
+    // background = (1-alpha) * background + alpha * current
+    // Using fixed-point arithmetic (8-bit fraction)
     int alpha = (int)(learning_rate * 256);
-    int inv_alpha = 256 - alpha;
-    
-    for (int i = 0; i < width * height; i++) {
-        // background = (1-alpha) * background + alpha * current
-        // Using fixed-point arithmetic (8-bit fraction)
-        background[i] = (unsigned char)((inv_alpha * background[i] + alpha * current[i]) >> 8);
-    }
-    #else
-    // Original implementation for non-embedded devices
-    for (int i = 0; i < width * height; i++) {
-        // background = (1-alpha) * background + alpha * current
-        background[i] = (unsigned char)((1.0f - learning_rate) * background[i] +
-                                       learning_rate * current[i]);
-    }
-    #endif
+    motion_kernels_get()->update_background(background, current, width * height, alpha);
 }
 
 /**
@@ -767,16 +540,17 @@ static float calculate_grid_motion(const unsigned char *curr_frame, const unsign
         return 0.0f;
     }
 
+    const motion_kernels_t *kernels = motion_kernels_get();
     int cell_width = width / grid_size;
     int cell_height = height / grid_size;
     int total_cells = grid_size * grid_size;
     int cells_with_motion = 0;
     float max_cell_score = 0.0f;
 
-    #if EMBEDDED_DEVICE_OPTIMIZATION
-    // Convert sensitivity to fixed-point for faster comparison
+    // A pixel counts when its difference exceeds both the noise and the sensitivity threshold
     int sensitivity_threshold = (int)(sensitivity * 255.0f);
-    
+    int threshold = noise_threshold > sensitivity_threshold ? noise_threshold : sensitivity_threshold;
+
     // Calculate motion for each grid cell
     for (int gy = 0; gy < grid_size; gy++) {
         for (int gx = 0; gx < grid_size; gx++) {
@@ -789,98 +563,13 @@ static float calculate_grid_motion(const unsigned char *curr_frame, const unsign
             if (cell_end_x > width) cell_end_x = width;
             if (cell_end_y > height) cell_end_y = height;
 
-            int cell_pixels = 0;
-            int changed_pixels = 0;
-            int total_diff = 0;
-
-            // Process each pixel in the cell - use sampling for better performance
             // Sample every other pixel in both dimensions
-            for (int y = cell_start_y; y < cell_end_y; y += 2) {
-                for (int x = cell_start_x; x < cell_end_x; x += 2) {
-                    int idx = y * width + x;
-
-                    // Calculate differences from previous frame and background
-                    int frame_diff = abs((int)curr_frame[idx] - (int)prev_frame[idx]);
-                    int bg_diff = abs((int)curr_frame[idx] - (int)background[idx]);
-
-                    // Use the larger of the two differences
-                    int diff = (frame_diff > bg_diff) ? frame_diff : bg_diff;
-
-                    // Apply noise threshold
-                    if (diff > noise_threshold) {
-                        // Pixel difference exceeds sensitivity threshold
-                        if (diff > sensitivity_threshold) {
-                            changed_pixels++;
-                            total_diff += diff;
-                        }
-                    }
-
-                    cell_pixels++;
-                }
-            }
-
-            // Calculate cell motion score
-            float cell_area = (float)changed_pixels / (float)cell_pixels;
-            float cell_score = (float)total_diff / (float)(cell_pixels * 255);
-
-            // Store cell score
-            int cell_idx = gy * grid_size + gx;
-            grid_scores[cell_idx] = cell_score;
-
-            // Track overall motion
-            if (cell_score > 0.01f) {  // Cell has meaningful motion
-                cells_with_motion++;
-                if (cell_score > max_cell_score) {
-                    max_cell_score = cell_score;
-                }
-            }
-        }
-    }
-    #else
-    // Original implementation for non-embedded devices
-    for (int gy = 0; gy < grid_size; gy++) {
-        for (int gx = 0; gx < grid_size; gx++) {
-            int cell_start_x = gx * cell_width;
-            int cell_start_y = gy * cell_height;
-            int cell_end_x = (gx + 1) * cell_width;
-            int cell_end_y = (gy + 1) * cell_height;
-
-            // Ensure we don't go out of bounds
-            if (cell_end_x > width) cell_end_x = width;
-            if (cell_end_y > height) cell_end_y = height;
-
-            int cell_pixels = 0;
-            int changed_pixels = 0;
-            int total_diff = 0;
-
-            // Process each pixel in the cell
-            for (int y = cell_start_y; y < cell_end_y; y++) {
-                for (int x = cell_start_x; x < cell_end_x; x++) {
-                    int idx = y * width + x;
-
-                    // Calculate differences from previous frame and background
-                    int frame_diff = abs((int)curr_frame[idx] - (int)prev_frame[idx]);
-                    int bg_diff = abs((int)curr_frame[idx] - (int)background[idx]);
-
-                    // Use the larger of the two differences
-                    int diff = (frame_diff > bg_diff) ? frame_diff : bg_diff;
-
-                    // Apply noise threshold
-                    if (diff > noise_threshold) {
-                        // Pixel difference exceeds sensitivity threshold
-                        if (diff > (sensitivity * 255.0f)) {
-                            changed_pixels++;
-                            total_diff += diff;
-                        }
-                    }
-
-                    cell_pixels++;
-                }
-            }
+            motion_cell_stats_t stats;
+            kernels->cell_stats(curr_frame, prev_frame, background, width,
+                                cell_start_x, cell_start_y, cell_end_x, cell_end_y, threshold, &stats);
 
             // Calculate cell motion score
-            float cell_area = (float)changed_pixels / (float)cell_pixels;
-            float cell_score = (float)total_diff / (float)(cell_pixels * 255);
+            float cell_score = (float)stats.total_diff / (float)(stats.samples * 255);
 
             // Store cell score
             int cell_idx = gy * grid_size + gx;
@@ -895,7 +584,6 @@ static float calculate_grid_motion(const unsigned char *curr_frame, const unsign
             }
         }
     }
-    #endif
 
     // Calculate overall motion metrics
     *motion_area = (float)cells_with_motion / (float)total_cells;
@@ -913,16 +601,13 @@ static void add_frame_to_history(motion_stream_t *stream, const unsigned char *f
         return;
     }
 
-    // Free the old frame if it exists
-    if (stream->frame_history[stream->history_index].frame) {
-        free(stream->frame_history[stream->history_index].frame);
-    }
-
-    // Allocate and copy new frame
-    stream->frame_history[stream->history_index].frame = (unsigned char *)malloc(stream->width * stream->height);
+    // Slots are allocated on first use and reused until the resolution changes
     if (!stream->frame_history[stream->history_index].frame) {
-        log_error("Failed to allocate memory for frame history");
-        return;
+        stream->frame_history[stream->history_index].frame = (unsigned char *)malloc(stream->width * stream->height);
+        if (!stream->frame_history[stream->history_index].frame) {
+            log_error("Failed to allocate memory for frame history");
+            return;
+        }
     }
 
     memcpy(stream->frame_history[stream->history_index].frame, frame, stream->width * stream->height);
@@ -954,171 +639,116 @@ static void update_memory_usage(motion_stream_t *stream, size_t allocated) {
 }
 
 /**
- * Process a frame for motion detection - optimized for embedded devices
+ * Look up a stream and lock it if a frame should be processed now
+ *
+ * @return The locked stream, or NULL if detection is disabled, cooling down or failed
  */
-int detect_motion(const char *stream_name, const unsigned char *frame_data,
-                 int width, int height, int channels, time_t frame_time,
-                 detection_result_t *result) {
-    if (!stream_name || !frame_data || !result || width <= 0 || height <= 0 || channels <= 0) {
-        log_error("Invalid parameters for detect_motion");
-        return -1;
-    }
-
-    // Initialize result
-    memset(result, 0, sizeof(detection_result_t));
-
-    // Get motion stream
+static motion_stream_t *begin_motion_frame(const char *stream_name, time_t frame_time, int *ret,
+                                           struct timespec *start_time) {
     motion_stream_t *stream = get_motion_stream(stream_name);
     if (!stream) {
         log_error("Failed to get motion stream for %s", stream_name);
-        return -1;
+        *ret = -1;
+        return NULL;
     }
 
     pthread_mutex_lock(&stream->mutex);
-    
+
     // Start performance monitoring
-    struct timespec start_time;
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    stream->last_frame_start = start_time;
-    
-    // Track memory usage
-    size_t current_memory = 0;
+    clock_gettime(CLOCK_MONOTONIC, start_time);
+    stream->last_frame_start = *start_time;
+
+    *ret = 0;
 
     // Check if motion detection is enabled
     if (!stream->enabled) {
         pthread_mutex_unlock(&stream->mutex);
-        return 0;
+        return NULL;
     }
 
     // Check cooldown period
     if (stream->last_detection_time > 0 &&
         (frame_time - stream->last_detection_time) < stream->cooldown_time) {
         pthread_mutex_unlock(&stream->mutex);
-        return 0;
+        return NULL;
     }
 
-    // Convert to grayscale if needed
-    unsigned char *gray_frame = NULL;
-    if (channels == 3) {
-        gray_frame = rgb_to_grayscale(frame_data, width, height);
-        if (!gray_frame) {
-            pthread_mutex_unlock(&stream->mutex);
-            return -1;
-        }
-        current_memory += width * height;
-    } else if (channels == 1) {
-        // If input is already grayscale, just make a copy
-        gray_frame = (unsigned char *)malloc(width * height);
-        if (!gray_frame) {
-            log_error("Failed to allocate memory for gray frame");
-            pthread_mutex_unlock(&stream->mutex);
-            return -1;
-        }
-        memcpy(gray_frame, frame_data, width * height);
-        current_memory += width * height;
-    } else {
-        log_error("Unsupported number of channels: %d", channels);
-        pthread_mutex_unlock(&stream->mutex);
-        return -1;
-    }
+    return stream;
+}
 
-    // Downscale the frame if enabled
-    unsigned char *processing_frame = gray_frame;
+/**
+ * Run motion detection on an 8-bit luma plane
+ * Caller must hold stream->mutex
+ */
+static int detect_motion_luma(motion_stream_t *stream, const char *stream_name,
+                              const unsigned char *luma, int stride, int width, int height,
+                              time_t frame_time, const struct timespec *start_time,
+                              detection_result_t *result) {
+    // Downscale into the persistent work buffer, or process the plane in place
+    const unsigned char *processing_frame = luma;
     int processing_width = width;
     int processing_height = height;
-    
+
     if (stream->downscale_enabled && stream->downscale_factor > 1) {
-        unsigned char *downscaled = downscale_grayscale(gray_frame, width, height, 
-                                                      stream->downscale_factor,
-                                                      &processing_width, &processing_height);
-        if (downscaled) {
-            // Use the downscaled frame for processing
-            free(gray_frame);
-            gray_frame = NULL;
-            processing_frame = downscaled;
-            
-            // Update memory tracking
-            current_memory = current_memory - (width * height) + (processing_width * processing_height);
-            
-            log_debug("Downscaled frame from %dx%d to %dx%d for motion detection",
-                     width, height, processing_width, processing_height);
-        } else {
-            log_warn("Failed to downscale frame, using original resolution");
-        }
-    }
+        processing_width = width / stream->downscale_factor;
+        processing_height = height / stream->downscale_factor;
 
-    // Check if we need to allocate or reallocate resources
-    if (!stream->prev_frame || stream->width != processing_width || stream->height != processing_height) {
-        // Free old resources if they exist
-        if (stream->prev_frame) {
-            free(stream->prev_frame);
-            stream->prev_frame = NULL;
-        }
+        // Ensure minimum size
+        if (processing_width < 32) processing_width = 32;
+        if (processing_height < 32) processing_height = 32;
 
-        if (stream->blur_buffer) {
-            free(stream->blur_buffer);
-            stream->blur_buffer = NULL;
+        unsigned char *work = ensure_frame_buffer(&stream->work_frame, &stream->work_frame_size,
+                                                  (size_t)processing_width * processing_height);
+        if (!work) {
+            log_error("Failed to allocate memory for downscaled image");
+            return -1;
         }
 
-        if (stream->background) {
-            free(stream->background);
-            stream->background = NULL;
+        motion_kernels_get()->downscale(luma, stride, width, height, stream->downscale_factor,
+                                        work, processing_width, processing_height);
+        processing_frame = work;
+    } else if (stride != width) {
+        // The blur and the frame history expect tightly packed rows
+        unsigned char *work = ensure_frame_buffer(&stream->work_frame, &stream->work_frame_size,
+                                                  (size_t)width * height);
+        if (!work) {
+            log_error("Failed to allocate memory for image copy");
+            return -1;
         }
 
-        if (stream->grid_scores) {
-            free(stream->grid_scores);
-            stream->grid_scores = NULL;
+        for (int y = 0; y < height; y++) {
+            memcpy(work + (size_t)y * width, luma + (size_t)y * stride, width);
         }
+        processing_frame = work;
+    }
 
-        if (stream->frame_history) {
-            for (int i = 0; i < stream->history_size; i++) {
-                if (stream->frame_history[i].frame) {
-                    free(stream->frame_history[i].frame);
-                }
-            }
-            free(stream->frame_history);
-            stream->frame_history = NULL;
-        }
+    // Check if we need to allocate or reallocate resources
+    if (!stream->prev_frame || stream->width != processing_width || stream->height != processing_height) {
+        // Free old resources if they exist
+        release_processing_buffers(stream);
 
         // Allocate new resources
-        stream->prev_frame = (unsigned char *)malloc(processing_width * processing_height);
-        stream->blur_buffer = (unsigned char *)malloc(processing_width * processing_height);
-        stream->background = (unsigned char *)malloc(processing_width * processing_height);
+        size_t plane_size = (size_t)processing_width * processing_height;
+        stream->prev_frame = (unsigned char *)malloc(plane_size);
+        stream->blur_buffer = (unsigned char *)malloc(plane_size);
+        stream->blur_temp = (unsigned char *)malloc(plane_size);
+        stream->background = (unsigned char *)malloc(plane_size);
 
-        if (!stream->prev_frame || !stream->blur_buffer || !stream->background) {
+        if (!stream->prev_frame || !stream->blur_buffer || !stream->blur_temp || !stream->background) {
             log_error("Failed to allocate memory for motion detection buffers");
-
-            if (stream->prev_frame) {
-                free(stream->prev_frame);
-                stream->prev_frame = NULL;
-            }
-
-            if (stream->blur_buffer) {
-                free(stream->blur_buffer);
-                stream->blur_buffer = NULL;
-            }
-
-            if (stream->background) {
-                free(stream->background);
-                stream->background = NULL;
-            }
-
-            free(processing_frame);
-            pthread_mutex_unlock(&stream->mutex);
+            release_processing_buffers(stream);
             return -1;
         }
 
         // Initialize the background with the current frame
-        memcpy(stream->background, processing_frame, processing_width * processing_height);
-        memcpy(stream->prev_frame, processing_frame, processing_width * processing_height);
+        memcpy(stream->background, processing_frame, plane_size);
+        memcpy(stream->prev_frame, processing_frame, plane_size);
 
         // Allocate grid scores array
         if (stream->use_grid_detection) {
             stream->grid_scores = (float *)malloc(stream->grid_size * stream->grid_size * sizeof(float));
             if (!stream->grid_scores) {
                 log_error("Failed to allocate memory for grid scores");
-                free(processing_frame);
-                pthread_mutex_unlock(&stream->mutex);
                 return -1;
             }
             memset(stream->grid_scores, 0, stream->grid_size * stream->grid_size * sizeof(float));
@@ -1128,8 +758,6 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
         stream->frame_history = (frame_history_t *)malloc(stream->history_size * sizeof(frame_history_t));
         if (!stream->frame_history) {
             log_error("Failed to allocate memory for frame history");
-            free(processing_frame);
-            pthread_mutex_unlock(&stream->mutex);
             return -1;
         }
         memset(stream->frame_history, 0, stream->history_size * sizeof(frame_history_t));
@@ -1142,13 +770,24 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
         stream->downscaled_width = processing_width;
         stream->downscaled_height = processing_height;
 
-        free(processing_frame);
-        pthread_mutex_unlock(&stream->mutex);
         return 0;  // Skip motion detection on first frame
     }
 
+    // Grid scores and history are dropped when their sizes are reconfigured
+    if (stream->use_grid_detection && !stream->grid_scores) {
+        stream->grid_scores = (float *)calloc(stream->grid_size * stream->grid_size, sizeof(float));
+        if (!stream->grid_scores) {
+            log_error("Failed to allocate memory for grid scores");
+            return -1;
+        }
+    }
+    if (!stream->frame_history) {
+        stream->frame_history = (frame_history_t *)calloc(stream->history_size, sizeof(frame_history_t));
+        stream->history_index = 0;
+    }
+
     // Apply blur to reduce noise
-    apply_box_blur(processing_frame, stream->blur_buffer, processing_width, processing_height, stream->blur_radius);
+    apply_box_blur(stream, processing_frame, stream->blur_buffer, processing_width, processing_height, stream->blur_radius);
 
     bool motion_detected = false;
     float motion_score = 0.0f;
@@ -1167,57 +806,20 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
         motion_detected = (motion_area >= stream->min_motion_area) && (motion_score > 0.01f);
     } else {
         // Simple frame differencing (original approach with improvements)
-        int pixel_count = processing_width * processing_height;
-        int changed_pixels = 0;
-        int total_diff = 0;
-
-        #if EMBEDDED_DEVICE_OPTIMIZATION
-        // For embedded devices, use sampling to reduce computation
-        // Process every other pixel in both dimensions
-        for (int y = 0; y < processing_height; y += 2) {
-            for (int x = 0; x < processing_width; x += 2) {
-                int idx = y * processing_width + x;
-                
-                // Calculate differences from previous frame and background
-                int frame_diff = abs((int)stream->blur_buffer[idx] - (int)stream->prev_frame[idx]);
-                int bg_diff = abs((int)stream->blur_buffer[idx] - (int)stream->background[idx]);
-
-                // Use the larger of the two differences
-                int diff = (frame_diff > bg_diff) ? frame_diff : bg_diff;
-
-                // Apply noise threshold
-                if (diff > stream->noise_threshold) {
-                    // Count pixels that changed more than the sensitivity threshold
-                    if (diff > (stream->sensitivity * 255.0f)) {
-                        changed_pixels++;
-                        total_diff += diff;
-                    }
-                }
-            }
-        }
-        
+        // Process every other pixel in both dimensions to reduce computation
+        int sensitivity_threshold = (int)(stream->sensitivity * 255.0f);
+        int threshold = stream->noise_threshold > sensitivity_threshold ?
+                        stream->noise_threshold : sensitivity_threshold;
+
+        motion_cell_stats_t stats;
+        motion_kernels_get()->cell_stats(stream->blur_buffer, stream->prev_frame, stream->background,
+                                         processing_width, 0, 0, processing_width, processing_height,
+                                         threshold, &stats);
+        int changed_pixels = stats.changed;
+        int total_diff = stats.total_diff;
+
         // Adjust for sampling (we only processed 1/4 of the pixels)
-        pixel_count = (processing_width * processing_height) / 4;
-        #else
-        // Original implementation for non-embedded devices
-        for (int i = 0; i < pixel_count; i++) {
-            // Calculate differences from previous frame and background
-            int frame_diff = abs((int)stream->blur_buffer[i] - (int)stream->prev_frame[i]);
-            int bg_diff = abs((int)stream->blur_buffer[i] - (int)stream->background[i]);
-
-            // Use the larger of the two differences
-            int diff = (frame_diff > bg_diff) ? frame_diff : bg_diff;
-
-            // Apply noise threshold
-            if (diff > stream->noise_threshold) {
-                // Count pixels that changed more than the sensitivity threshold
-                if (diff > (stream->sensitivity * 255.0f)) {
-                    changed_pixels++;
-                    total_diff += diff;
-                }
-            }
-        }
-        #endif
+        int pixel_count = (processing_width * processing_height) / 4;
 
         // Calculate motion metrics
         motion_area = (float)changed_pixels / (float)pixel_count;
@@ -1262,17 +864,14 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
                  stream_name, motion_score, motion_area * 100.0f, stream->min_motion_area);
     }
 
-    // Clean up
-    free(processing_frame);
-    
     // End performance monitoring
     struct timespec end_time;
     clock_gettime(CLOCK_MONOTONIC, &end_time);
     
     // Calculate processing time in milliseconds
     float processing_time = 
-        (end_time.tv_sec - start_time.tv_sec) * 1000.0f + 
-        (end_time.tv_nsec - start_time.tv_nsec) / 1000000.0f;
+        (end_time.tv_sec - start_time->tv_sec) * 1000.0f + 
+        (end_time.tv_nsec - start_time->tv_nsec) / 1000000.0f;
     
     // Update performance statistics
     stream->last_processing_time = processing_time;
@@ -1289,11 +888,84 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
     }
     
     // Update memory usage statistics
-    update_memory_usage(stream, current_memory);
+    size_t plane_size = (size_t)processing_width * processing_height;
+    update_memory_usage(stream, plane_size * (4 + stream->history_size) +
+                                stream->gray_frame_size + stream->work_frame_size);
     
+    return 0;
+}
+
+/**
+ * Process a frame for motion detection - optimized for embedded devices
+ */
+int detect_motion(const char *stream_name, const unsigned char *frame_data,
+                 int width, int height, int channels, time_t frame_time,
+                 detection_result_t *result) {
+    if (!stream_name || !frame_data || !result || width <= 0 || height <= 0 || channels <= 0) {
+        log_error("Invalid parameters for detect_motion");
+        return -1;
+    }
+
+    // Initialize result
+    memset(result, 0, sizeof(detection_result_t));
+
+    if (channels != 1 && channels != 3) {
+        log_error("Unsupported number of channels: %d", channels);
+        return -1;
+    }
+
+    int ret;
+    struct timespec start_time;
+    motion_stream_t *stream = begin_motion_frame(stream_name, frame_time, &ret, &start_time);
+    if (!stream) {
+        return ret;
+    }
+
+    // Grayscale input is used as is; RGB is converted into a buffer kept with the stream
+    const unsigned char *luma = frame_data;
+    if (channels == 3) {
+        unsigned char *gray = ensure_frame_buffer(&stream->gray_frame, &stream->gray_frame_size,
+                                                  (size_t)width * height);
+        if (!gray) {
+            log_error("Failed to allocate memory for grayscale conversion");
+            pthread_mutex_unlock(&stream->mutex);
+            return -1;
+        }
+
+        motion_kernels_get()->rgb_to_gray(frame_data, width * 3, gray, width, width, height);
+        luma = gray;
+    }
+
+    ret = detect_motion_luma(stream, stream_name, luma, width, width, height, frame_time, &start_time, result);
+
     pthread_mutex_unlock(&stream->mutex);
+    return ret;
+}
 
-    return 0;
+/**
+ * Process the luma plane of a decoded YUV frame for motion detection
+ */
+int detect_motion_yuv(const char *stream_name, const uint8_t *y_plane, int linesize,
+                      int width, int height, time_t frame_time, detection_result_t *result) {
+    if (!stream_name || !y_plane || !result || width <= 0 || height <= 0 || linesize < width) {
+        log_error("Invalid parameters for detect_motion_yuv");
+        return -1;
+    }
+
+    // Initialize result
+    memset(result, 0, sizeof(detection_result_t));
+
+    int ret;
+    struct timespec start_time;
+    motion_stream_t *stream = begin_motion_frame(stream_name, frame_time, &ret, &start_time);
+    if (!stream) {
+        return ret;
+    }
+
+    ret = detect_motion_luma(stream, stream_name, y_plane, linesize, width, height, frame_time, &start_time, result);
+
+    pthread_mutex_unlock(&stream->mutex);
+    return ret;
 }
 
 /**
@@ -0,0 +1,893 @@
+/**
+ * Motion detection pixel kernels with runtime CPU dispatch
+ *
+ * The scalar functions are the reference implementation (they are the loops
+ * that used to live in motion_detection.c).  The SSE2, AVX2 and NEON variants
+ * vectorize the regular interior of each operation and fall back to the
+ * scalar code for edges and tails, so their output is bit-exact.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "core/logger.h"
+#include "video/motion_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MOTION_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MOTION_KERNELS_NEON 1
+#include <arm_neon.h>
+#if defined(__arm__) && defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+#endif
+
+// Fixed-point luma coefficients (8-bit fraction)
+#define GRAY_R_COEFF 76     // (int)(0.299f * 256)
+#define GRAY_G_COEFF 150    // (int)(0.587f * 256)
+#define GRAY_B_COEFF 29     // (int)(0.114f * 256)
+
+// Largest blur radius handled by the vector paths; the 16-bit window sums and
+// the reciprocal division below are exact up to this size
+#define MAX_SIMD_BLUR_RADIUS 5
+
+/* ------------------------------------------------------------------------ */
+/* Scalar reference                                                          */
+/* ------------------------------------------------------------------------ */
+
+static void rgb_to_gray_scalar(const uint8_t *rgb, int rgb_stride, uint8_t *gray, int gray_stride,
+                               int width, int height) {
+    for (int y = 0; y < height; y++) {
+        const uint8_t *src = rgb + (size_t)y * rgb_stride;
+        uint8_t *dst = gray + (size_t)y * gray_stride;
+
+        for (int x = 0; x < width; x++) {
+            int gray_value = (GRAY_R_COEFF * src[x * 3] +
+                              GRAY_G_COEFF * src[x * 3 + 1] +
+                              GRAY_B_COEFF * src[x * 3 + 2]) >> 8;
+            dst[x] = (uint8_t)(gray_value > 255 ? 255 : gray_value);
+        }
+    }
+}
+
+static void downscale_row_scalar(const uint8_t *src, int src_stride, int src_width, int src_height,
+                                 int factor, uint8_t *dst, int dst_width, int y, int x_start) {
+    for (int x = x_start; x < dst_width; x++) {
+        int sum = 0;
+        int count = 0;
+
+        for (int dy = 0; dy < factor && (y * factor + dy) < src_height; dy++) {
+            for (int dx = 0; dx < factor && (x * factor + dx) < src_width; dx++) {
+                sum += src[(size_t)(y * factor + dy) * src_stride + (x * factor + dx)];
+                count++;
+            }
+        }
+
+        // Blocks entirely outside the source only occur when the output was padded to a minimum size
+        dst[(size_t)y * dst_width + x] = (uint8_t)(count > 0 ? sum / count : 0);
+    }
+}
+
+static void downscale_scalar(const uint8_t *src, int src_stride, int src_width, int src_height, int factor,
+                             uint8_t *dst, int dst_width, int dst_height) {
+    for (int y = 0; y < dst_height; y++) {
+        downscale_row_scalar(src, src_stride, src_width, src_height, factor, dst, dst_width, y, 0);
+    }
+}
+
+/**
+ * Average of the edge-clipped horizontal window around x
+ */
+static inline uint8_t blur_h_pixel(const uint8_t *row, int width, int x, int radius) {
+    int start = x - radius < 0 ? 0 : x - radius;
+    int end = x + radius >= width ? width - 1 : x + radius;
+    int sum = 0;
+
+    for (int i = start; i <= end; i++) {
+        sum += row[i];
+    }
+    return (uint8_t)(sum / (end - start + 1));
+}
+
+static void box_blur_h_scalar(const uint8_t *src, uint8_t *dst, int width, int height, int radius) {
+    for (int y = 0; y < height; y++) {
+        const uint8_t *row = src + (size_t)y * width;
+        uint8_t *out = dst + (size_t)y * width;
+
+        // Sliding window sum over the row
+        int sum = 0;
+        int count = 0;
+        for (int i = 0; i <= radius && i < width; i++) {
+            sum += row[i];
+            count++;
+        }
+        out[0] = (uint8_t)(sum / count);
+
+        for (int x = 1; x < width; x++) {
+            if (x + radius < width) {
+                sum += row[x + radius];
+                count++;
+            }
+            if (x - radius - 1 >= 0) {
+                sum -= row[x - radius - 1];
+                count--;
+            }
+            out[x] = (uint8_t)(sum / count);
+        }
+    }
+}
+
+static void box_blur_v_scalar(const uint8_t *src, uint8_t *dst, int width, int height, int radius) {
+    for (int x = 0; x < width; x++) {
+        int sum = 0;
+        int count = 0;
+        for (int i = 0; i <= radius && i < height; i++) {
+            sum += src[(size_t)i * width + x];
+            count++;
+        }
+        dst[x] = (uint8_t)(sum / count);
+
+        for (int y = 1; y < height; y++) {
+            if (y + radius < height) {
+                sum += src[(size_t)(y + radius) * width + x];
+                count++;
+            }
+            if (y - radius - 1 >= 0) {
+                sum -= src[(size_t)(y - radius - 1) * width + x];
+                count--;
+            }
+            dst[(size_t)y * width + x] = (uint8_t)(sum / count);
+        }
+    }
+}
+
+static void box_blur_scalar(const uint8_t *src, uint8_t *dst, int width, int height, int radius, uint8_t *tmp) {
+    if (radius <= 0) {
+        memmove(dst, src, (size_t)width * height);
+        return;
+    }
+
+    box_blur_h_scalar(src, tmp, width, height, radius);
+    box_blur_v_scalar(tmp, dst, width, height, radius);
+}
+
+static void update_background_scalar(uint8_t *bg, const uint8_t *cur, int count, int alpha) {
+    int inv_alpha = 256 - alpha;
+
+    for (int i = 0; i < count; i++) {
+        bg[i] = (uint8_t)((inv_alpha * bg[i] + alpha * cur[i]) >> 8);
+    }
+}
+
+/**
+ * Accumulate samples x, x + 2, ... < x1 of one row
+ */
+static inline void cell_stats_row_scalar(const uint8_t *curr, const uint8_t *prev, const uint8_t *bg,
+                                         int x, int x1, int threshold, motion_cell_stats_t *stats) {
+    for (; x < x1; x += 2) {
+        int frame_diff = abs((int)curr[x] - (int)prev[x]);
+        int bg_diff = abs((int)curr[x] - (int)bg[x]);
+        int diff = (frame_diff > bg_diff) ? frame_diff : bg_diff;
+
+        if (diff > threshold) {
+            stats->changed++;
+            stats->total_diff += diff;
+        }
+    }
+}
+
+static inline int sampled_count(int start, int end) {
+    return end > start ? (end - start + 1) / 2 : 0;
+}
+
+static void cell_stats_scalar(const uint8_t *curr, const uint8_t *prev, const uint8_t *bg, int stride,
+                              int x0, int y0, int x1, int y1, int threshold, motion_cell_stats_t *stats) {
+    stats->samples = sampled_count(x0, x1) * sampled_count(y0, y1);
+    stats->changed = 0;
+    stats->total_diff = 0;
+
+    for (int y = y0; y < y1; y += 2) {
+        size_t off = (size_t)y * stride;
+        cell_stats_row_scalar(curr + off, prev + off, bg + off, x0, x1, threshold, stats);
+    }
+}
+
+/**
+ * Reciprocal such that (n * m) >> 16 == n / d for every n <= d * 255 and d <= 11
+ */
+static inline uint16_t blur_reciprocal(int d) {
+    return (uint16_t)((65536 + d - 1) / d);
+}
+
+/* ------------------------------------------------------------------------ */
+/* SSE2 / AVX2                                                               */
+/* ------------------------------------------------------------------------ */
+
+#ifdef MOTION_KERNELS_X86
+
+__attribute__((target("sse2")))
+static void downscale_sse2(const uint8_t *src, int src_stride, int src_width, int src_height, int factor,
+                           uint8_t *dst, int dst_width, int dst_height) {
+    // Only 2x2 blocks that lie entirely inside the source are vectorized
+    if (factor != 2 || dst_width * 2 > src_width || dst_height * 2 > src_height) {
+        downscale_scalar(src, src_stride, src_width, src_height, factor, dst, dst_width, dst_height);
+        return;
+    }
+
+    const __m128i low_mask = _mm_set1_epi16(0x00FF);
+
+    for (int y = 0; y < dst_height; y++) {
+        const uint8_t *r0 = src + (size_t)(y * 2) * src_stride;
+        const uint8_t *r1 = r0 + src_stride;
+        uint8_t *out = dst + (size_t)y * dst_width;
+        int x = 0;
+
+        for (; x + 8 <= dst_width; x += 8) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(r0 + x * 2));
+            __m128i b = _mm_loadu_si128((const __m128i *)(r1 + x * 2));
+            __m128i sum = _mm_add_epi16(_mm_and_si128(a, low_mask), _mm_srli_epi16(a, 8));
+            sum = _mm_add_epi16(sum, _mm_and_si128(b, low_mask));
+            sum = _mm_add_epi16(sum, _mm_srli_epi16(b, 8));
+            sum = _mm_srli_epi16(sum, 2);
+            _mm_storel_epi64((__m128i *)(out + x), _mm_packus_epi16(sum, sum));
+        }
+
+        downscale_row_scalar(src, src_stride, src_width, src_height, factor, dst, dst_width, y, x);
+    }
+}
+
+__attribute__((target("sse2")))
+static void box_blur_sse2(const uint8_t *src, uint8_t *dst, int width, int height, int radius, uint8_t *tmp) {
+    if (radius <= 0 || radius > MAX_SIMD_BLUR_RADIUS || height < 2) {
+        box_blur_scalar(src, dst, width, height, radius, tmp);
+        return;
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const int window = 2 * radius + 1;
+    const __m128i h_recip = _mm_set1_epi16((short)blur_reciprocal(window));
+
+    // Horizontal pass: the interior has a full window, the edges are clipped
+    for (int y = 0; y < height; y++) {
+        const uint8_t *row = src + (size_t)y * width;
+        uint8_t *out = tmp + (size_t)y * width;
+        int x = 0;
+
+        for (; x < radius && x < width; x++) {
+            out[x] = blur_h_pixel(row, width, x, radius);
+        }
+        for (; x + 16 <= width - radius; x += 16) {
+            __m128i lo = zero;
+            __m128i hi = zero;
+            for (int k = -radius; k <= radius; k++) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(row + x + k));
+                lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+                hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+            }
+            lo = _mm_mulhi_epu16(lo, h_recip);
+            hi = _mm_mulhi_epu16(hi, h_recip);
+            _mm_storeu_si128((__m128i *)(out + x), _mm_packus_epi16(lo, hi));
+        }
+        for (; x < width; x++) {
+            out[x] = blur_h_pixel(row, width, x, radius);
+        }
+    }
+
+    // Vertical pass: every column of a row shares the same clipped window
+    for (int y = 0; y < height; y++) {
+        int start = y - radius < 0 ? 0 : y - radius;
+        int end = y + radius >= height ? height - 1 : y + radius;
+        int count = end - start + 1;
+        const __m128i v_recip = _mm_set1_epi16((short)blur_reciprocal(count));
+        uint8_t *out = dst + (size_t)y * width;
+        int x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            __m128i lo = zero;
+            __m128i hi = zero;
+            for (int i = start; i <= end; i++) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(tmp + (size_t)i * width + x));
+                lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+                hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+            }
+            lo = _mm_mulhi_epu16(lo, v_recip);
+            hi = _mm_mulhi_epu16(hi, v_recip);
+            _mm_storeu_si128((__m128i *)(out + x), _mm_packus_epi16(lo, hi));
+        }
+        for (; x < width; x++) {
+            int sum = 0;
+            for (int i = start; i <= end; i++) {
+                sum += tmp[(size_t)i * width + x];
+            }
+            out[x] = (uint8_t)(sum / count);
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+static void update_background_sse2(uint8_t *bg, const uint8_t *cur, int count, int alpha) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i a = _mm_set1_epi16((short)alpha);
+    const __m128i inv = _mm_set1_epi16((short)(256 - alpha));
+    int i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m128i b = _mm_loadu_si128((const __m128i *)(bg + i));
+        __m128i c = _mm_loadu_si128((const __m128i *)(cur + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), inv),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(c, zero), a));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), inv),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(c, zero), a));
+        lo = _mm_srli_epi16(lo, 8);
+        hi = _mm_srli_epi16(hi, 8);
+        _mm_storeu_si128((__m128i *)(bg + i), _mm_packus_epi16(lo, hi));
+    }
+
+    update_background_scalar(bg + i, cur + i, count - i, alpha);
+}
+
+__attribute__((target("sse2")))
+static inline __m128i abs_diff_epu8_sse2(__m128i a, __m128i b) {
+    return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+}
+
+__attribute__((target("sse2")))
+static inline int hsum_epi32_sse2(__m128i v) {
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+
+__attribute__((target("sse2")))
+static void cell_stats_sse2(const uint8_t *curr, const uint8_t *prev, const uint8_t *bg, int stride,
+                            int x0, int y0, int x1, int y1, int threshold, motion_cell_stats_t *stats) {
+    const __m128i low_mask = _mm_set1_epi16(0x00FF);
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i thr = _mm_set1_epi16((short)threshold);
+    __m128i changed = _mm_setzero_si128();
+    __m128i total = _mm_setzero_si128();
+
+    stats->samples = sampled_count(x0, x1) * sampled_count(y0, y1);
+    stats->changed = 0;
+    stats->total_diff = 0;
+
+    for (int y = y0; y < y1; y += 2) {
+        size_t off = (size_t)y * stride;
+        const uint8_t *c = curr + off;
+        const uint8_t *p = prev + off;
+        const uint8_t *b = bg + off;
+        int x = x0;
+
+        // The even bytes of each 16-byte load are the sampled pixels
+        for (; x + 16 <= x1; x += 16) {
+            __m128i cv = _mm_loadu_si128((const __m128i *)(c + x));
+            __m128i frame_diff = abs_diff_epu8_sse2(cv, _mm_loadu_si128((const __m128i *)(p + x)));
+            __m128i bg_diff = abs_diff_epu8_sse2(cv, _mm_loadu_si128((const __m128i *)(b + x)));
+            __m128i diff = _mm_and_si128(_mm_max_epu8(frame_diff, bg_diff), low_mask);
+            __m128i hit = _mm_cmpgt_epi16(diff, thr);
+
+            changed = _mm_add_epi32(changed, _mm_madd_epi16(_mm_and_si128(hit, ones), ones));
+            total = _mm_add_epi32(total, _mm_madd_epi16(_mm_and_si128(diff, hit), ones));
+        }
+
+        cell_stats_row_scalar(c, p, b, x, x1, threshold, stats);
+    }
+
+    stats->changed += hsum_epi32_sse2(changed);
+    stats->total_diff += hsum_epi32_sse2(total);
+}
+
+__attribute__((target("avx2")))
+static void downscale_avx2(const uint8_t *src, int src_stride, int src_width, int src_height, int factor,
+                           uint8_t *dst, int dst_width, int dst_height) {
+    if (factor != 2 || dst_width * 2 > src_width || dst_height * 2 > src_height) {
+        downscale_scalar(src, src_stride, src_width, src_height, factor, dst, dst_width, dst_height);
+        return;
+    }
+
+    const __m256i low_mask = _mm256_set1_epi16(0x00FF);
+
+    for (int y = 0; y < dst_height; y++) {
+        const uint8_t *r0 = src + (size_t)(y * 2) * src_stride;
+        const uint8_t *r1 = r0 + src_stride;
+        uint8_t *out = dst + (size_t)y * dst_width;
+        int x = 0;
+
+        for (; x + 16 <= dst_width; x += 16) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(r0 + x * 2));
+            __m256i b = _mm256_loadu_si256((const __m256i *)(r1 + x * 2));
+            __m256i sum = _mm256_add_epi16(_mm256_and_si256(a, low_mask), _mm256_srli_epi16(a, 8));
+            sum = _mm256_add_epi16(sum, _mm256_and_si256(b, low_mask));
+            sum = _mm256_add_epi16(sum, _mm256_srli_epi16(b, 8));
+            sum = _mm256_srli_epi16(sum, 2);
+
+            // packus works per 128-bit lane; gather the two low quadwords
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i *)(out + x), _mm256_castsi256_si128(packed));
+        }
+
+        downscale_row_scalar(src, src_stride, src_width, src_height, factor, dst, dst_width, y, x);
+    }
+}
+
+__attribute__((target("avx2")))
+static void box_blur_avx2(const uint8_t *src, uint8_t *dst, int width, int height, int radius, uint8_t *tmp) {
+    if (radius <= 0 || radius > MAX_SIMD_BLUR_RADIUS || height < 2) {
+        box_blur_scalar(src, dst, width, height, radius, tmp);
+        return;
+    }
+
+    const int window = 2 * radius + 1;
+    const __m256i h_recip = _mm256_set1_epi16((short)blur_reciprocal(window));
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t *row = src + (size_t)y * width;
+        uint8_t *out = tmp + (size_t)y * width;
+        int x = 0;
+
+        for (; x < radius && x < width; x++) {
+            out[x] = blur_h_pixel(row, width, x, radius);
+        }
+        for (; x + 16 <= width - radius; x += 16) {
+            __m256i sum = _mm256_setzero_si256();
+            for (int k = -radius; k <= radius; k++) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(row + x + k));
+                sum = _mm256_add_epi16(sum, _mm256_cvtepu8_epi16(v));
+            }
+            sum = _mm256_mulhi_epu16(sum, h_recip);
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i *)(out + x), _mm256_castsi256_si128(packed));
+        }
+        for (; x < width; x++) {
+            out[x] = blur_h_pixel(row, width, x, radius);
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        int start = y - radius < 0 ? 0 : y - radius;
+        int end = y + radius >= height ? height - 1 : y + radius;
+        int count = end - start + 1;
+        const __m256i v_recip = _mm256_set1_epi16((short)blur_reciprocal(count));
+        uint8_t *out = dst + (size_t)y * width;
+        int x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            __m256i sum = _mm256_setzero_si256();
+            for (int i = start; i <= end; i++) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(tmp + (size_t)i * width + x));
+                sum = _mm256_add_epi16(sum, _mm256_cvtepu8_epi16(v));
+            }
+            sum = _mm256_mulhi_epu16(sum, v_recip);
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i *)(out + x), _mm256_castsi256_si128(packed));
+        }
+        for (; x < width; x++) {
+            int sum = 0;
+            for (int i = start; i <= end; i++) {
+                sum += tmp[(size_t)i * width + x];
+            }
+            out[x] = (uint8_t)(sum / count);
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static void update_background_avx2(uint8_t *bg, const uint8_t *cur, int count, int alpha) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i a = _mm256_set1_epi16((short)alpha);
+    const __m256i inv = _mm256_set1_epi16((short)(256 - alpha));
+    int i = 0;
+
+    // unpack and pack both work per 128-bit lane, so the byte order is preserved
+    for (; i + 32 <= count; i += 32) {
+        __m256i b = _mm256_loadu_si256((const __m256i *)(bg + i));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(cur + i));
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), inv),
+                                      _mm256_mullo_epi16(_mm256_unpacklo_epi8(c, zero), a));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), inv),
+                                      _mm256_mullo_epi16(_mm256_unpackhi_epi8(c, zero), a));
+        lo = _mm256_srli_epi16(lo, 8);
+        hi = _mm256_srli_epi16(hi, 8);
+        _mm256_storeu_si256((__m256i *)(bg + i), _mm256_packus_epi16(lo, hi));
+    }
+
+    update_background_scalar(bg + i, cur + i, count - i, alpha);
+}
+
+__attribute__((target("avx2")))
+static void cell_stats_avx2(const uint8_t *curr, const uint8_t *prev, const uint8_t *bg, int stride,
+                            int x0, int y0, int x1, int y1, int threshold, motion_cell_stats_t *stats) {
+    const __m256i low_mask = _mm256_set1_epi16(0x00FF);
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i thr = _mm256_set1_epi16((short)threshold);
+    __m256i changed = _mm256_setzero_si256();
+    __m256i total = _mm256_setzero_si256();
+
+    stats->samples = sampled_count(x0, x1) * sampled_count(y0, y1);
+    stats->changed = 0;
+    stats->total_diff = 0;
+
+    for (int y = y0; y < y1; y += 2) {
+        size_t off = (size_t)y * stride;
+        const uint8_t *c = curr + off;
+        const uint8_t *p = prev + off;
+        const uint8_t *b = bg + off;
+        int x = x0;
+
+        for (; x + 32 <= x1; x += 32) {
+            __m256i cv = _mm256_loadu_si256((const __m256i *)(c + x));
+            __m256i pv = _mm256_loadu_si256((const __m256i *)(p + x));
+            __m256i bv = _mm256_loadu_si256((const __m256i *)(b + x));
+            __m256i frame_diff = _mm256_or_si256(_mm256_subs_epu8(cv, pv), _mm256_subs_epu8(pv, cv));
+            __m256i bg_diff = _mm256_or_si256(_mm256_subs_epu8(cv, bv), _mm256_subs_epu8(bv, cv));
+            __m256i diff = _mm256_and_si256(_mm256_max_epu8(frame_diff, bg_diff), low_mask);
+            __m256i hit = _mm256_cmpgt_epi16(diff, thr);
+
+            changed = _mm256_add_epi32(changed, _mm256_madd_epi16(_mm256_and_si256(hit, ones), ones));
+            total = _mm256_add_epi32(total, _mm256_madd_epi16(_mm256_and_si256(diff, hit), ones));
+        }
+
+        cell_stats_row_scalar(c, p, b, x, x1, threshold, stats);
+    }
+
+    __m128i changed128 = _mm_add_epi32(_mm256_castsi256_si128(changed), _mm256_extracti128_si256(changed, 1));
+    __m128i total128 = _mm_add_epi32(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+    stats->changed += hsum_epi32_sse2(changed128);
+    stats->total_diff += hsum_epi32_sse2(total128);
+}
+
+__attribute__((target("avx2")))
+static void rgb_to_gray_avx2(const uint8_t *rgb, int rgb_stride, uint8_t *gray, int gray_stride,
+                             int width, int height) {
+    // Byte shuffles that gather the R, G and B channels of 16 packed pixels
+    const __m128i r0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i b0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+    const __m256i rc = _mm256_set1_epi16(GRAY_R_COEFF);
+    const __m256i gc = _mm256_set1_epi16(GRAY_G_COEFF);
+    const __m256i bc = _mm256_set1_epi16(GRAY_B_COEFF);
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t *src = rgb + (size_t)y * rgb_stride;
+        uint8_t *dst = gray + (size_t)y * gray_stride;
+        int x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            __m128i v0 = _mm_loadu_si128((const __m128i *)(src + x * 3));
+            __m128i v1 = _mm_loadu_si128((const __m128i *)(src + x * 3 + 16));
+            __m128i v2 = _mm_loadu_si128((const __m128i *)(src + x * 3 + 32));
+
+            __m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, r0), _mm_shuffle_epi8(v1, r1)),
+                                     _mm_shuffle_epi8(v2, r2));
+            __m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, g0), _mm_shuffle_epi8(v1, g1)),
+                                     _mm_shuffle_epi8(v2, g2));
+            __m128i b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, b0), _mm_shuffle_epi8(v1, b1)),
+                                     _mm_shuffle_epi8(v2, b2));
+
+            // The weighted sum is at most 255 * 255 and fits an unsigned 16-bit lane
+            __m256i sum = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(r), rc);
+            sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(_mm256_cvtepu8_epi16(g), gc));
+            sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(_mm256_cvtepu8_epi16(b), bc));
+            sum = _mm256_srli_epi16(sum, 8);
+
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i *)(dst + x), _mm256_castsi256_si128(packed));
+        }
+
+        rgb_to_gray_scalar(src + x * 3, 0, dst + x, 0, width - x, 1);
+    }
+}
+
+#endif /* MOTION_KERNELS_X86 */
+
+/* ------------------------------------------------------------------------ */
+/* NEON                                                                      */
+/* ------------------------------------------------------------------------ */
+
+#ifdef MOTION_KERNELS_NEON
+
+static inline int hsum_u32_neon(uint32x4_t v) {
+    uint64x2_t pairs = vpaddlq_u32(v);
+    return (int)(vgetq_lane_u64(pairs, 0) + vgetq_lane_u64(pairs, 1));
+}
+
+static void rgb_to_gray_neon(const uint8_t *rgb, int rgb_stride, uint8_t *gray, int gray_stride,
+                             int width, int height) {
+    const uint8x8_t rc = vdup_n_u8(GRAY_R_COEFF);
+    const uint8x8_t gc = vdup_n_u8(GRAY_G_COEFF);
+    const uint8x8_t bc = vdup_n_u8(GRAY_B_COEFF);
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t *src = rgb + (size_t)y * rgb_stride;
+        uint8_t *dst = gray + (size_t)y * gray_stride;
+        int x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            uint8x16x3_t px = vld3q_u8(src + x * 3);
+
+            uint16x8_t lo = vmull_u8(vget_low_u8(px.val[0]), rc);
+            lo = vmlal_u8(lo, vget_low_u8(px.val[1]), gc);
+            lo = vmlal_u8(lo, vget_low_u8(px.val[2]), bc);
+
+            uint16x8_t hi = vmull_u8(vget_high_u8(px.val[0]), rc);
+            hi = vmlal_u8(hi, vget_high_u8(px.val[1]), gc);
+            hi = vmlal_u8(hi, vget_high_u8(px.val[2]), bc);
+
+            vst1q_u8(dst + x, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+        }
+
+        rgb_to_gray_scalar(src + x * 3, 0, dst + x, 0, width - x, 1);
+    }
+}
+
+static void downscale_neon(const uint8_t *src, int src_stride, int src_width, int src_height, int factor,
+                           uint8_t *dst, int dst_width, int dst_height) {
+    if (factor != 2 || dst_width * 2 > src_width || dst_height * 2 > src_height) {
+        downscale_scalar(src, src_stride, src_width, src_height, factor, dst, dst_width, dst_height);
+        return;
+    }
+
+    for (int y = 0; y < dst_height; y++) {
+        const uint8_t *r0 = src + (size_t)(y * 2) * src_stride;
+        const uint8_t *r1 = r0 + src_stride;
+        uint8_t *out = dst + (size_t)y * dst_width;
+        int x = 0;
+
+        for (; x + 16 <= dst_width; x += 16) {
+            uint16x8_t s0 = vpaddlq_u8(vld1q_u8(r0 + x * 2));
+            uint16x8_t s1 = vpaddlq_u8(vld1q_u8(r0 + x * 2 + 16));
+            s0 = vpadalq_u8(s0, vld1q_u8(r1 + x * 2));
+            s1 = vpadalq_u8(s1, vld1q_u8(r1 + x * 2 + 16));
+            vst1q_u8(out + x, vcombine_u8(vshrn_n_u16(s0, 2), vshrn_n_u16(s1, 2)));
+        }
+
+        downscale_row_scalar(src, src_stride, src_width, src_height, factor, dst, dst_width, y, x);
+    }
+}
+
+/**
+ * (n * recip) >> 16 for eight 16-bit lanes
+ */
+static inline uint8x8_t div_recip_neon(uint16x8_t n, uint16_t recip) {
+    uint32x4_t lo = vmull_n_u16(vget_low_u16(n), recip);
+    uint32x4_t hi = vmull_n_u16(vget_high_u16(n), recip);
+    return vmovn_u16(vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16)));
+}
+
+static void box_blur_neon(const uint8_t *src, uint8_t *dst, int width, int height, int radius, uint8_t *tmp) {
+    if (radius <= 0 || radius > MAX_SIMD_BLUR_RADIUS || height < 2) {
+        box_blur_scalar(src, dst, width, height, radius, tmp);
+        return;
+    }
+
+    const uint16_t h_recip = blur_reciprocal(2 * radius + 1);
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t *row = src + (size_t)y * width;
+        uint8_t *out = tmp + (size_t)y * width;
+        int x = 0;
+
+        for (; x < radius && x < width; x++) {
+            out[x] = blur_h_pixel(row, width, x, radius);
+        }
+        for (; x + 16 <= width - radius; x += 16) {
+            uint16x8_t lo = vdupq_n_u16(0);
+            uint16x8_t hi = vdupq_n_u16(0);
+            for (int k = -radius; k <= radius; k++) {
+                uint8x16_t v = vld1q_u8(row + x + k);
+                lo = vaddw_u8(lo, vget_low_u8(v));
+                hi = vaddw_u8(hi, vget_high_u8(v));
+            }
+            vst1q_u8(out + x, vcombine_u8(div_recip_neon(lo, h_recip), div_recip_neon(hi, h_recip)));
+        }
+        for (; x < width; x++) {
+            out[x] = blur_h_pixel(row, width, x, radius);
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        int start = y - radius < 0 ? 0 : y - radius;
+        int end = y + radius >= height ? height - 1 : y + radius;
+        int count = end - start + 1;
+        const uint16_t v_recip = blur_reciprocal(count);
+        uint8_t *out = dst + (size_t)y * width;
+        int x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            uint16x8_t lo = vdupq_n_u16(0);
+            uint16x8_t hi = vdupq_n_u16(0);
+            for (int i = start; i <= end; i++) {
+                uint8x16_t v = vld1q_u8(tmp + (size_t)i * width + x);
+                lo = vaddw_u8(lo, vget_low_u8(v));
+                hi = vaddw_u8(hi, vget_high_u8(v));
+            }
+            vst1q_u8(out + x, vcombine_u8(div_recip_neon(lo, v_recip), div_recip_neon(hi, v_recip)));
+        }
+        for (; x < width; x++) {
+            int sum = 0;
+            for (int i = start; i <= end; i++) {
+                sum += tmp[(size_t)i * width + x];
+            }
+            out[x] = (uint8_t)(sum / count);
+        }
+    }
+}
+
+static void update_background_neon(uint8_t *bg, const uint8_t *cur, int count, int alpha) {
+    const uint16_t a = (uint16_t)alpha;
+    const uint16_t inv = (uint16_t)(256 - alpha);
+    int i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t b = vld1q_u8(bg + i);
+        uint8x16_t c = vld1q_u8(cur + i);
+        uint16x8_t lo = vmulq_n_u16(vmovl_u8(vget_low_u8(b)), inv);
+        uint16x8_t hi = vmulq_n_u16(vmovl_u8(vget_high_u8(b)), inv);
+        lo = vmlaq_n_u16(lo, vmovl_u8(vget_low_u8(c)), a);
+        hi = vmlaq_n_u16(hi, vmovl_u8(vget_high_u8(c)), a);
+        vst1q_u8(bg + i, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+    }
+
+    update_background_scalar(bg + i, cur + i, count - i, alpha);
+}
+
+static void cell_stats_neon(const uint8_t *curr, const uint8_t *prev, const uint8_t *bg, int stride,
+                            int x0, int y0, int x1, int y1, int threshold, motion_cell_stats_t *stats) {
+    // Thresholds outside the byte range cannot be compared lane-wise
+    if (threshold < 0 || threshold > 255) {
+        cell_stats_scalar(curr, prev, bg, stride, x0, y0, x1, y1, threshold, stats);
+        return;
+    }
+
+    const uint8x16_t thr = vdupq_n_u8((uint8_t)threshold);
+    const uint8x16_t one = vdupq_n_u8(1);
+    uint32x4_t changed = vdupq_n_u32(0);
+    uint32x4_t total = vdupq_n_u32(0);
+
+    stats->samples = sampled_count(x0, x1) * sampled_count(y0, y1);
+    stats->changed = 0;
+    stats->total_diff = 0;
+
+    for (int y = y0; y < y1; y += 2) {
+        size_t off = (size_t)y * stride;
+        const uint8_t *c = curr + off;
+        const uint8_t *p = prev + off;
+        const uint8_t *b = bg + off;
+        int x = x0;
+
+        // De-interleave 32 bytes; val[0] holds the 16 sampled pixels
+        for (; x + 32 <= x1; x += 32) {
+            uint8x16_t cv = vld2q_u8(c + x).val[0];
+            uint8x16_t pv = vld2q_u8(p + x).val[0];
+            uint8x16_t bv = vld2q_u8(b + x).val[0];
+            uint8x16_t diff = vmaxq_u8(vabdq_u8(cv, pv), vabdq_u8(cv, bv));
+            uint8x16_t hit = vcgtq_u8(diff, thr);
+
+            changed = vpadalq_u16(changed, vpaddlq_u8(vandq_u8(hit, one)));
+            total = vpadalq_u16(total, vpaddlq_u8(vandq_u8(diff, hit)));
+        }
+
+        cell_stats_row_scalar(c, p, b, x, x1, threshold, stats);
+    }
+
+    stats->changed += hsum_u32_neon(changed);
+    stats->total_diff += hsum_u32_neon(total);
+}
+
+#endif /* MOTION_KERNELS_NEON */
+
+/* ------------------------------------------------------------------------ */
+/* Dispatch                                                                  */
+/* ------------------------------------------------------------------------ */
+
+static const motion_kernels_t scalar_kernels = {
+    .isa = MOTION_ISA_SCALAR,
+    .name = "scalar",
+    .rgb_to_gray = rgb_to_gray_scalar,
+    .downscale = downscale_scalar,
+    .box_blur = box_blur_scalar,
+    .update_background = update_background_scalar,
+    .cell_stats = cell_stats_scalar,
+};
+
+#ifdef MOTION_KERNELS_X86
+static const motion_kernels_t sse2_kernels = {
+    .isa = MOTION_ISA_SSE2,
+    .name = "sse2",
+    .rgb_to_gray = rgb_to_gray_scalar,     // Packed RGB needs a byte shuffle (SSSE3)
+    .downscale = downscale_sse2,
+    .box_blur = box_blur_sse2,
+    .update_background = update_background_sse2,
+    .cell_stats = cell_stats_sse2,
+};
+
+static const motion_kernels_t avx2_kernels = {
+    .isa = MOTION_ISA_AVX2,
+    .name = "avx2",
+    .rgb_to_gray = rgb_to_gray_avx2,
+    .downscale = downscale_avx2,
+    .box_blur = box_blur_avx2,
+    .update_background = update_background_avx2,
+    .cell_stats = cell_stats_avx2,
+};
+#endif
+
+#ifdef MOTION_KERNELS_NEON
+static const motion_kernels_t neon_kernels = {
+    .isa = MOTION_ISA_NEON,
+    .name = "neon",
+    .rgb_to_gray = rgb_to_gray_neon,
+    .downscale = downscale_neon,
+    .box_blur = box_blur_neon,
+    .update_background = update_background_neon,
+    .cell_stats = cell_stats_neon,
+};
+#endif
+
+static const motion_kernels_t *best_kernels = &scalar_kernels;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Get the kernels for a specific instruction set
+ */
+const motion_kernels_t *motion_kernels_for_isa(motion_isa_t isa) {
+    switch (isa) {
+        case MOTION_ISA_SCALAR:
+            return &scalar_kernels;
+#ifdef MOTION_KERNELS_X86
+        case MOTION_ISA_SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2") ? &sse2_kernels : NULL;
+        case MOTION_ISA_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? &avx2_kernels : NULL;
+#endif
+#ifdef MOTION_KERNELS_NEON
+        case MOTION_ISA_NEON:
+#if defined(__arm__) && defined(__linux__)
+            return (getauxval(AT_HWCAP) & HWCAP_NEON) ? &neon_kernels : NULL;
+#else
+            return &neon_kernels;
+#endif
+#endif
+        default:
+            return NULL;
+    }
+}
+
+static void select_motion_kernels(void) {
+    static const motion_isa_t preference[] = { MOTION_ISA_AVX2, MOTION_ISA_NEON, MOTION_ISA_SSE2 };
+
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        const motion_kernels_t *kernels = motion_kernels_for_isa(preference[i]);
+        if (kernels) {
+            best_kernels = kernels;
+            break;
+        }
+    }
+
+    log_info("Motion detection kernels: %s", best_kernels->name);
+}
+
+/**
+ * Get the fastest kernels supported by this CPU
+ */
+const motion_kernels_t *motion_kernels_get(void) {
+    pthread_once(&kernels_once, select_motion_kernels);
+    return best_kernels;
+}
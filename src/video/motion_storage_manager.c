@@ -1,6 +1,7 @@
 #include "video/motion_storage_manager.h"
 #include "database/db_motion_config.h"
 #include "core/logger.h"
+#include "video/recording_preview.h"
 #include <pthread.h>
 #include <unistd.h>
 #include <sys/stat.h>
@@ -55,6 +56,8 @@ int delete_motion_recording(const char *file_path) {
         }
     }
     
+    recording_preview_remove(file_path);
+
     // Note: Database cleanup is handled by cleanup_old_motion_recordings
     log_debug("Deleted motion recording file: %s", file_path);
     return 0;
@@ -36,6 +36,7 @@
 #include "video/mp4_writer_thread.h"
 #include "video/mp4_segment_recorder.h"
 #include "video/stream_packet_processor.h"
+#include "video/live_events.h"
 
 
 // Hash map for tracking running MP4 recording contexts
@@ -471,6 +472,8 @@ int start_mp4_recording(const char *stream_name) {
 
     log_info("Started MP4 recording for %s in slot %d", stream_name, slot);
 
+    live_events_publish_recording(stream_name, true);
+
     return 0;
 }
 
@@ -614,6 +617,8 @@ int start_mp4_recording_with_url(const char *stream_name, const char *url) {
 
     log_info("Started MP4 recording for %s in slot %d using URL: %s", stream_name, slot, url);
 
+    live_events_publish_recording(stream_name, true);
+
     return 0;
 }
 
@@ -647,6 +652,7 @@ int stop_mp4_recording(const char *stream_name) {
     // Mark as not running first
     ctx->running = 0;
     log_info("Marked MP4 recording for stream %s as stopping (index: %d)", stream_name, index);
+    live_events_publish_recording(stream_name, false);
 
     // Join thread with timeout
     int join_result = pthread_join_with_timeout(ctx->thread, NULL, 5);
@@ -807,6 +813,8 @@ int start_mp4_recording_with_trigger(const char *stream_name, const char *trigge
 
     log_info("Started MP4 recording for %s in slot %d with trigger_type: %s", stream_name, slot, trigger_type);
 
+    live_events_publish_recording(stream_name, true);
+
     return 0;
 }
 
@@ -933,5 +941,7 @@ int start_mp4_recording_with_url_and_trigger(const char *stream_name, const char
     log_info("Started MP4 recording for %s in slot %d with URL %s and trigger_type: %s",
              stream_name, slot, url, trigger_type);
 
+    live_events_publish_recording(stream_name, true);
+
     return 0;
 }
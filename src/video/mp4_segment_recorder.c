@@ -31,6 +31,9 @@
 #include "video/mp4_writer.h"
 #include "video/mp4_writer_internal.h"
 #include "video/mp4_segment_recorder.h"
+#include "video/packet_bus.h"
+#include "video/recording_preview.h"
+#include "core/config.h"
 
 // Note: We can't directly access internal FFmpeg structures
 // So we'll use the public API for cleanup
@@ -59,6 +62,59 @@ void mp4_segment_recorder_init(void) {
     log_info("MP4 segment recorder initialized");
 }
 
+/**
+ * Account a successfully written video packet in the segment statistics
+ *
+ * Timestamps are in the video stream's time base, as written to the muxer.
+ */
+static void track_video_packet(segment_stats_t *stats, int64_t pts, int64_t duration, bool is_keyframe,
+                               int64_t *first_pts, int64_t *end_pts) {
+    stats->video_packets++;
+    if (is_keyframe) {
+        stats->keyframes++;
+    }
+
+    if (pts == AV_NOPTS_VALUE) {
+        return;
+    }
+
+    if (*first_pts == AV_NOPTS_VALUE || pts < *first_pts) {
+        *first_pts = pts;
+    }
+
+    int64_t end = pts + (duration > 0 ? duration : 0);
+    if (*end_pts == AV_NOPTS_VALUE || end > *end_pts) {
+        *end_pts = end;
+    }
+}
+
+/**
+ * Fill in the segment statistics once the trailer has been written
+ */
+static void finish_segment_stats(segment_stats_t *stats, AVFormatContext *output_ctx,
+                                 const AVStream *out_video_stream, AVRational video_time_base,
+                                 int64_t first_pts, int64_t end_pts) {
+    if (first_pts != AV_NOPTS_VALUE && end_pts != AV_NOPTS_VALUE && end_pts > first_pts) {
+        stats->duration_us = av_rescale_q(end_pts - first_pts, video_time_base, AV_TIME_BASE_Q);
+    }
+
+    // The trailer (and the faststart rewrite) is complete, so this is the final file size
+    avio_flush(output_ctx->pb);
+    int64_t size = avio_size(output_ctx->pb);
+    stats->size_bytes = size > 0 ? (uint64_t)size : 0;
+
+    stats->width = out_video_stream->codecpar->width;
+    stats->height = out_video_stream->codecpar->height;
+    if (stats->duration_us > 0) {
+        stats->fps = (int)((stats->video_packets * (int64_t)AV_TIME_BASE + stats->duration_us / 2) /
+                           stats->duration_us);
+    }
+    strncpy(stats->codec, avcodec_get_name(out_video_stream->codecpar->codec_id),
+            sizeof(stats->codec) - 1);
+    stats->codec[sizeof(stats->codec) - 1] = '\0';
+    stats->valid = true;
+}
+
 /**
  * Record an RTSP stream to an MP4 file for a specified duration
  *
@@ -114,10 +170,16 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
     int audio_packet_count = 0;
     int video_packet_count = 0;
     int64_t start_time = 0;  // CRITICAL FIX: Initialize to 0 to prevent using uninitialized value
+    int64_t stats_first_pts = AV_NOPTS_VALUE;  // Written video span, for the segment statistics
+    int64_t stats_end_pts = AV_NOPTS_VALUE;
     time_t last_progress = 0;
     int segment_index = 0;
     // Invoke-once guard for started callback
     bool started_cb_called = false;
+    // Keyframe index and thumbnails for the timeline, written once the file is closed
+    recording_preview_t *preview = NULL;
+    bool trailer_written = false;
+    bool ingest_reset = false;      // The shared ingest reconnected during this segment
 
 
     // CRITICAL FIX: Initialize static variable for tracking waiting time for keyframes
@@ -135,18 +197,34 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
     // BUGFIX: Use per-stream segment info instead of global static variable
     segment_index = segment_info_ptr->segment_index + 1;
 
+    // Statistics are collected from scratch for every segment
+    segment_stats_t *stats = &segment_info_ptr->stats;
+    memset(stats, 0, sizeof(*stats));
+
     log_info("Starting new segment with index %d", segment_index);
 
     log_info("Recording from %s", rtsp_url);
     log_info("Output file: %s", output_file);
     log_info("Duration: %d seconds", duration);
 
+    // Packets come from the shared ingest when the caller subscribed to it
+    packet_bus_subscriber_t *bus_sub = segment_info_ptr->bus_sub;
+
     // BUGFIX: Use per-stream input context instead of global static variable
     if (*input_ctx_ptr) {
         input_ctx = *input_ctx_ptr;
         // Clear the pointer to prevent double free
         *input_ctx_ptr = NULL;
         log_debug("Using existing input context");
+    } else if (bus_sub) {
+        // The shared ingest owns the camera connection, we only need its stream layout
+        ret = packet_bus_copy_streams(bus_sub, &input_ctx, 10000);
+        if (ret < 0) {
+            log_error("Shared ingest not ready for %s: %d", rtsp_url, ret);
+            input_ctx = NULL;
+            goto cleanup;
+        }
+        log_debug("Using stream layout from shared ingest");
     } else {
 
         // Set up RTSP options for low latency
@@ -186,7 +264,7 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
         goto cleanup;
     }
 
-    log_debug("Input format: %s", input_ctx->iformat->name);
+    log_debug("Input format: %s", input_ctx->iformat ? input_ctx->iformat->name : "shared ingest");
     log_debug("Number of streams: %d", input_ctx->nb_streams);
 
     // Find video and audio streams
@@ -421,6 +499,10 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
         goto cleanup;
     }
 
+    preview = recording_preview_begin(input_ctx->streams[video_stream_idx]->codecpar,
+                                      input_ctx->streams[video_stream_idx]->time_base,
+                                      g_config.mp4_preview_interval);
+
     // Initialize packet - ensure it's properly allocated and initialized
     pkt = av_packet_alloc();
     if (!pkt) {
@@ -483,11 +565,16 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
         }
 
         // Read packet
-        ret = av_read_frame(input_ctx, pkt);
+        ret = bus_sub ? packet_bus_read(bus_sub, pkt, 1000) : av_read_frame(input_ctx, pkt);
         if (ret < 0) {
             if (ret == AVERROR_EOF) {
                 log_info("End of stream reached");
                 break;
+            } else if (ret == PACKET_BUS_ERR_RESET) {
+                // The camera reconnected, the stream layout may have changed
+                log_info("Shared ingest reconnected, finishing segment");
+                ingest_reset = true;
+                break;
             } else if (ret != AVERROR(EAGAIN)) {
                 log_error("Error reading frame: %d", ret);
                 break;
@@ -518,6 +605,7 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
 
                     // Reset start time to when we found the first key frame
                     start_time = av_gettime();
+                    stats->start_time = time(NULL);
 
                     // Note if we had a keyframe at the end of the previous segment
                     if (segment_info_ptr->last_frame_was_key && segment_index > 0) {
@@ -675,10 +763,17 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
                     // Set output stream index
                     pkt->stream_index = out_video_stream->index;
 
+                    // The muxer takes the packet's contents, keep what the statistics need
+                    int64_t written_pts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+                    int64_t written_duration = pkt->duration;
+
                     // Write packet
                     ret = av_interleaved_write_frame(output_ctx, pkt);
                     if (ret < 0) {
                         log_error("Error writing video frame: %d", ret);
+                    } else {
+                        track_video_packet(stats, written_pts, written_duration, is_keyframe,
+                                           &stats_first_pts, &stats_end_pts);
                     }
 
                     // Break the loop after processing the final frame
@@ -780,6 +875,15 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
             // Set output stream index
             pkt->stream_index = out_video_stream->index;
 
+            // The muxer takes the packet's contents, keep what the statistics need
+            int64_t written_pts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+            int64_t written_duration = pkt->duration;
+
+            // Sample thumbnails before the muxer takes the packet
+            if (is_keyframe) {
+                recording_preview_add_keyframe(preview, pkt, written_pts);
+            }
+
             // Write packet
             ret = av_interleaved_write_frame(output_ctx, pkt);
             if (ret < 0) {
@@ -822,6 +926,9 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
                 // Reset consecutive error counter on success
                 consecutive_timestamp_errors = 0;
 
+                track_video_packet(stats, written_pts, written_duration, is_keyframe,
+                                   &stats_first_pts, &stats_end_pts);
+
                 video_packet_count++;
                 if (video_packet_count % 300 == 0) {
                     log_debug("Processed %d video packets", video_packet_count);
@@ -1047,9 +1154,6 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
     log_info("Recording segment complete (video packets: %d, audio packets: %d)",
             video_packet_count, audio_packet_count);
 
-    // Flag to track if trailer has been written
-    bool trailer_written = false;
-
     // Write trailer
     if (output_ctx && output_ctx->pb) {
         ret = av_write_trailer(output_ctx);
@@ -1058,6 +1162,13 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
         } else {
             trailer_written = true;
             log_debug("Successfully wrote trailer to output file");
+
+            finish_segment_stats(stats, output_ctx, out_video_stream,
+                                 input_ctx->streams[video_stream_idx]->time_base,
+                                 stats_first_pts, stats_end_pts);
+            log_info("Segment statistics: %.3f s, %llu bytes, %d keyframes, %dx%d %s",
+                     stats->duration_us / 1000000.0, (unsigned long long)stats->size_bytes,
+                     stats->keyframes, stats->width, stats->height, stats->codec);
         }
     }
 
@@ -1132,11 +1243,22 @@ cleanup:
         output_ctx = NULL;
     }
 
+    // Keyframe offsets are only final once the file is closed
+    if (preview) {
+        if (trailer_written) {
+            recording_preview_finish(preview, output_file);
+        } else {
+            recording_preview_free(preview);
+        }
+        preview = NULL;
+    }
+
     // CRITICAL FIX: Properly handle the input context to prevent memory leaks
     log_debug("Handling input context cleanup");
 
     // BUGFIX: Store the input context in the per-stream variable for reuse if recording was successful
-    if (ret >= 0) {
+    // After an ingest reconnect the next segment copies the new stream layout
+    if (ret >= 0 && !ingest_reset) {
         // Store the input context for reuse in the next segment
         // We can't directly access internal FFmpeg structures
         // Just store the context as is and rely on FFmpeg's internal reference counting
@@ -1146,7 +1268,7 @@ cleanup:
         log_debug("Stored input context for reuse in next segment");
     } else
     {
-        // If there was an error, close the input context
+        // If there was an error or the ingest reconnected, close the input context
         log_debug("Closing input context due to error");
 
         // CRITICAL FIX: Check if input_ctx is NULL before trying to access it
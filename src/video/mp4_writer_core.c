@@ -107,41 +107,50 @@ void mp4_writer_set_segment_duration(mp4_writer_t *writer, int segment_duration)
 }
 
 /**
- * Get the actual end time of a recording based on its start time and video duration
+ * Mark the writer's current recording complete in the database
  */
-static time_t get_recording_end_time(uint64_t recording_id, const char *file_path) {
-    // Get the recording metadata to find the start time
-    recording_metadata_t metadata;
-    if (get_recording_metadata_by_id(recording_id, &metadata) != 0) {
-        log_error("Failed to get recording metadata for ID %llu", (unsigned long long)recording_id);
-        return time(NULL); // Fallback to current time
+void mp4_writer_finalize_recording(mp4_writer_t *writer, const segment_stats_t *stats) {
+    if (!writer || writer->current_recording_id == 0) {
+        return;
     }
 
-    time_t start_time = metadata.start_time;
+    uint64_t recording_id = writer->current_recording_id;
+    writer->current_recording_id = 0;
 
-    // Try to get the actual duration from the MP4 file
-    AVFormatContext *format_ctx = NULL;
-    int64_t duration_seconds = 0;
+    if (stats && stats->valid) {
+        // Round to the nearest second, the same resolution as the start time
+        time_t end_time = stats->start_time + (time_t)((stats->duration_us + 500000) / 1000000);
 
-    if (avformat_open_input(&format_ctx, file_path, NULL, NULL) == 0) {
-        if (avformat_find_stream_info(format_ctx, NULL) >= 0) {
-            if (format_ctx->duration != AV_NOPTS_VALUE) {
-                // Duration is in AV_TIME_BASE units (microseconds)
-                duration_seconds = format_ctx->duration / AV_TIME_BASE;
-                log_info("Got actual duration from MP4 file %s: %ld seconds",
-                        file_path, (long)duration_seconds);
-            }
+        if (finalize_recording_metadata(recording_id, end_time, stats->size_bytes,
+                                        stats->width, stats->height, stats->fps, stats->codec) != 0) {
+            log_error("Failed to mark recording (ID: %llu) as complete",
+                      (unsigned long long)recording_id);
+            return;
         }
-        avformat_close_input(&format_ctx);
+
+        log_info("Marked recording (ID: %llu) as complete: %.3f s, %llu bytes, %d keyframes",
+                 (unsigned long long)recording_id, stats->duration_us / 1000000.0,
+                 (unsigned long long)stats->size_bytes, stats->keyframes);
+        return;
     }
 
-    // Calculate end time as start_time + duration
-    time_t end_time = start_time + duration_seconds;
+    // The muxer did not finish the file, take what is on disk
+    struct stat st;
+    uint64_t size_bytes = 0;
+    if (stat(writer->output_path, &st) == 0) {
+        size_bytes = st.st_size;
+    } else {
+        log_warn("Failed to get file size for %s", writer->output_path);
+    }
 
-    log_info("Calculated end_time for recording ID %llu: start=%ld, duration=%ld, end=%ld",
-            (unsigned long long)recording_id, (long)start_time, (long)duration_seconds, (long)end_time);
+    if (finalize_recording_metadata(recording_id, time(NULL), size_bytes, 0, 0, 0, NULL) != 0) {
+        log_error("Failed to mark recording (ID: %llu) as complete",
+                  (unsigned long long)recording_id);
+        return;
+    }
 
-    return end_time;
+    log_info("Marked recording (ID: %llu) as complete without muxer statistics (size: %llu bytes)",
+             (unsigned long long)recording_id, (unsigned long long)size_bytes);
 }
 
 /**
@@ -158,35 +167,6 @@ void mp4_writer_close(mp4_writer_t *writer) {
              writer->stream_name ? writer->stream_name : "unknown",
              writer->output_path ? writer->output_path : "unknown");
 
-    //  First, mark the recording as complete in the database if needed
-    if (writer->current_recording_id > 0) {
-        // Get the file size before marking as complete
-        struct stat st;
-        uint64_t size_bytes = 0;
-
-        if (writer->output_path && stat(writer->output_path, &st) == 0) {
-            size_bytes = st.st_size;
-            log_info("Final file size for %s: %llu bytes",
-                    writer->output_path, (unsigned long long)size_bytes);
-
-            // Get the actual end time based on the video duration
-            time_t end_time = get_recording_end_time(writer->current_recording_id, writer->output_path);
-
-            // Mark the recording as complete with the correct file size and end time
-            update_recording_metadata(writer->current_recording_id, end_time, size_bytes, true);
-            log_info("Marked recording (ID: %llu) as complete during writer close",
-                    (unsigned long long)writer->current_recording_id);
-        } else if (writer->output_path) {
-            log_warn("Failed to get file size for %s during close", writer->output_path);
-
-            // Still mark the recording as complete, but with size 0
-            // Use current time as fallback since we can't read the file
-            update_recording_metadata(writer->current_recording_id, time(NULL), 0, true);
-            log_info("Marked recording (ID: %llu) as complete during writer close (size unknown)",
-                    (unsigned long long)writer->current_recording_id);
-        }
-    }
-
     // First, stop any recording thread if it's running
     if (writer->thread_ctx) {
         log_info("Stopping recording thread for %s during writer close",
@@ -205,6 +185,10 @@ void mp4_writer_close(mp4_writer_t *writer) {
         }
     }
 
+    // The recording thread commits each segment it finishes, this only
+    // catches a recording it left open
+    mp4_writer_finalize_recording(writer, NULL);
+
     // MEMORY LEAK FIX: Ensure proper cleanup of FFmpeg resources
     // Close the output context if it exists
     if (writer->output_ctx) {
@@ -30,8 +30,10 @@
 #include "video/mp4_writer_internal.h"
 #include "video/mp4_writer_thread.h"
 #include "video/mp4_segment_recorder.h"
+#include "video/packet_bus.h"
 #include "database/database_manager.h"
 #include "database/db_recordings.h"
+#include "database/db_stream_registry.h"
 
 
 // Callback invoked by record_segment when the first keyframe is detected
@@ -51,7 +53,9 @@ static void on_segment_started_cb(void *user_ctx) {
         memset(&metadata, 0, sizeof(recording_metadata_t));
         strncpy(metadata.stream_name, stream_name, sizeof(metadata.stream_name) - 1);
         strncpy(metadata.file_path, thread_ctx->writer->output_path, sizeof(metadata.file_path) - 1);
-        metadata.start_time = time(NULL); // Align to keyframe time
+        // Align to keyframe time, the same clock the segment statistics use for the end time
+        metadata.start_time = thread_ctx->segment_info.stats.start_time ?
+                              thread_ctx->segment_info.stats.start_time : time(NULL);
         metadata.end_time = 0;
         metadata.size_bytes = 0;
         metadata.is_complete = false;
@@ -96,6 +100,7 @@ static void *mp4_writer_rtsp_thread(void *arg) {
     int audio_stream_idx = -1;
     int ret;
     time_t start_time = time(NULL);  // Record when we started
+    bool segment_finalized = false;  // The current output file is complete in the database
 
     // BUGFIX: Initialize per-stream context and segment info
     // These are now stored in the thread context instead of global static variables
@@ -103,6 +108,8 @@ static void *mp4_writer_rtsp_thread(void *arg) {
     thread_ctx->segment_info.segment_index = 0;
     thread_ctx->segment_info.has_audio = false;
     thread_ctx->segment_info.last_frame_was_key = false;
+    thread_ctx->segment_info.bus_sub = NULL;
+    memset(&thread_ctx->segment_info.stats, 0, sizeof(thread_ctx->segment_info.stats));
     pthread_mutex_init(&thread_ctx->context_mutex, NULL);
 
     // Initialize self-management fields
@@ -128,11 +135,32 @@ static void *mp4_writer_rtsp_thread(void *arg) {
         return NULL;
     }
 
+    // Share the camera connection with HLS and detection when enabled
+    if (packet_bus_is_enabled()) {
+        // The ingest session is shared by URL, so it must use the stream's configured transport
+        stream_config_t ingest_config;
+        stream_protocol_t protocol = STREAM_PROTOCOL_TCP;
+        if (stream_registry_get(stream_name, &ingest_config) == 0) {
+            protocol = ingest_config.protocol;
+        }
+
+        thread_ctx->segment_info.bus_sub = packet_bus_subscribe(stream_name, rtsp_url, protocol,
+                                                                "mp4", 0, 0);
+        if (!thread_ctx->segment_info.bus_sub) {
+            log_warn("Failed to subscribe to shared ingest for stream %s, reading the camera directly", stream_name);
+        }
+    }
+
     // BUGFIX: Segment info is already initialized in the thread context initialization above
     log_info("Initialized segment info: index=%d, has_audio=%d, last_frame_was_key=%d",
             thread_ctx->segment_info.segment_index, thread_ctx->segment_info.has_audio,
             thread_ctx->segment_info.last_frame_was_key);
 
+    // Private copy of the stream configuration, refreshed only when the registry changes
+    stream_config_t stream_config;
+    uint64_t config_generation = 0;
+    memset(&stream_config, 0, sizeof(stream_config));
+
     // Main loop to record segments
     while (thread_ctx->running && !thread_ctx->shutdown_requested) {
         // Check if shutdown has been initiated
@@ -145,31 +173,23 @@ static void *mp4_writer_rtsp_thread(void *arg) {
         // Get current time
         time_t current_time = time(NULL);
 
-        // Fetch the latest stream configuration from the database
-        stream_config_t db_stream_config;
-        int db_config_result = get_stream_config_by_name(stream_name, &db_stream_config);
-
-        // Define segment_duration variable outside the if block
-        int segment_duration = thread_ctx->writer->segment_duration;
+        // Pick up configuration changes, a no-op unless the stream registry changed
+        int config_changed = stream_registry_refresh(stream_name, &stream_config, &config_generation);
 
-        // Update configuration from database if available
-        if (db_config_result == 0) {
+        // Update configuration if it changed
+        if (config_changed > 0) {
             // Update segment duration if available
-            if (db_stream_config.segment_duration > 0) {
-                segment_duration = db_stream_config.segment_duration;
-
-                // Update the writer's segment duration if it has changed
-                if (thread_ctx->writer->segment_duration != segment_duration) {
-                    log_info("Updating segment duration for stream %s from %d to %d seconds (from database)",
-                            stream_name, thread_ctx->writer->segment_duration, segment_duration);
-                    thread_ctx->writer->segment_duration = segment_duration;
-                }
+            if (stream_config.segment_duration > 0 &&
+                thread_ctx->writer->segment_duration != stream_config.segment_duration) {
+                log_info("Updating segment duration for stream %s from %d to %d seconds (from configuration)",
+                        stream_name, thread_ctx->writer->segment_duration, stream_config.segment_duration);
+                thread_ctx->writer->segment_duration = stream_config.segment_duration;
             }
 
             // Update audio recording setting if it has changed
-            int has_audio = db_stream_config.record_audio ? 1 : 0;
+            int has_audio = stream_config.record_audio ? 1 : 0;
             if (thread_ctx->writer->has_audio != has_audio) {
-                log_info("Updating audio recording setting for stream %s from %s to %s (from database)",
+                log_info("Updating audio recording setting for stream %s from %s to %s (from configuration)",
                         stream_name,
                         thread_ctx->writer->has_audio ? "enabled" : "disabled",
                         has_audio ? "enabled" : "disabled");
@@ -177,11 +197,14 @@ static void *mp4_writer_rtsp_thread(void *arg) {
             }
         }
 
+        int segment_duration = thread_ctx->writer->segment_duration;
+
         // Check if it's time to create a new segment based on segment duration
         // Force segment rotation every segment_duration seconds
         if (segment_duration > 0) {
             time_t elapsed_time = current_time - thread_ctx->writer->last_rotation_time;
-            if (elapsed_time >= segment_duration) {
+            // A committed segment is never rewritten, even if it ended early
+            if (elapsed_time >= segment_duration || segment_finalized) {
                 log_info("Time to create new segment for stream %s (elapsed time: %ld seconds, segment duration: %d seconds)",
                          stream_name, (long)elapsed_time, segment_duration);
 
@@ -203,54 +226,8 @@ static void *mp4_writer_rtsp_thread(void *arg) {
                 // Defer creation of DB metadata for the new file until first keyframe via callback
                 // so that start_time aligns to a playable keyframe.
 
-                // Mark the previous recording as complete
-                if (thread_ctx->writer->current_recording_id > 0) {
-                    // Get the file size before marking as complete
-                    struct stat st;
-                    uint64_t size_bytes = 0;
-
-                    if (stat(current_path, &st) == 0) {
-                        size_bytes = st.st_size;
-                        log_info("File size for %s: %llu bytes",
-                                current_path, (unsigned long long)size_bytes);
-
-                        // Get the actual end time based on the video duration
-                        time_t end_time = current_time;
-
-                        // Try to get the actual duration from the MP4 file
-                        recording_metadata_t metadata;
-                        if (get_recording_metadata_by_id(thread_ctx->writer->current_recording_id, &metadata) == 0) {
-                            time_t start_time = metadata.start_time;
-
-                            AVFormatContext *format_ctx = NULL;
-                            if (avformat_open_input(&format_ctx, current_path, NULL, NULL) == 0) {
-                                if (avformat_find_stream_info(format_ctx, NULL) >= 0) {
-                                    if (format_ctx->duration != AV_NOPTS_VALUE) {
-                                        // Duration is in AV_TIME_BASE units (microseconds)
-                                        int64_t duration_seconds = format_ctx->duration / AV_TIME_BASE;
-                                        end_time = start_time + duration_seconds;
-                                        log_info("Calculated end_time from MP4 duration: start=%ld, duration=%ld, end=%ld",
-                                                (long)start_time, (long)duration_seconds, (long)end_time);
-                                    }
-                                }
-                                avformat_close_input(&format_ctx);
-                            }
-                        }
-
-                        // Mark the recording as complete with the correct file size and end time
-                        update_recording_metadata(thread_ctx->writer->current_recording_id, end_time, size_bytes, true);
-                        log_info("Marked previous recording (ID: %llu) as complete for stream %s (size: %llu bytes)",
-                                (unsigned long long)thread_ctx->writer->current_recording_id, stream_name, (unsigned long long)size_bytes);
-                    } else {
-                        log_warn("Failed to get file size for %s: %s",
-                                current_path, strerror(errno));
-
-                        // Still mark the recording as complete, but with size 0
-                        update_recording_metadata(thread_ctx->writer->current_recording_id, current_time, 0, true);
-                        log_info("Marked previous recording (ID: %llu) as complete for stream %s (size unknown)",
-                                (unsigned long long)thread_ctx->writer->current_recording_id, stream_name);
-                    }
-                }
+                // Mark the previous recording as complete if its segment was not committed yet
+                mp4_writer_finalize_recording(thread_ctx->writer, &thread_ctx->segment_info.stats);
 
                 // Update the output path
                 strncpy(thread_ctx->writer->output_path, new_path, MAX_PATH_LENGTH - 1);
@@ -259,20 +236,19 @@ static void *mp4_writer_rtsp_thread(void *arg) {
                 // Reset current recording ID; new ID will be assigned on first keyframe of next segment
                 thread_ctx->writer->current_recording_id = 0;
 
-
-
                 // Update rotation time
                 thread_ctx->writer->last_rotation_time = current_time;
+                segment_finalized = false;
             }
         }
 
         // Record a segment using the record_segment function
         log_info("Recording segment for stream %s to %s", stream_name, thread_ctx->writer->output_path);
-        // Use the segment duration from the database or writer
+        // Use the segment duration from the stream configuration or writer
         if (segment_duration > 0) {
             log_info("Using segment duration: %d seconds (from %s)",
                     segment_duration,
-                    (db_config_result == 0 && db_stream_config.segment_duration > 0) ? "database" : "writer context");
+                    (config_changed >= 0 && stream_config.segment_duration > 0) ? "configuration" : "writer context");
         } else {
             segment_duration = 30;
             log_info("No segment duration configured, using default: %d seconds", segment_duration);
@@ -412,20 +388,16 @@ static void *mp4_writer_rtsp_thread(void *arg) {
         // Update the last packet time for activity tracking
         thread_ctx->writer->last_packet_time = time(NULL);
 
-        // Update the recording metadata with the current file size
+        // The segment is finished, commit what the muxer collected in one update
         if (thread_ctx->writer->current_recording_id > 0) {
-            struct stat st;
-            if (stat(thread_ctx->writer->output_path, &st) == 0) {
-                uint64_t size_bytes = st.st_size;
-                // Update size but don't mark as complete yet
-                update_recording_metadata(thread_ctx->writer->current_recording_id, 0, size_bytes, false);
-                log_debug("Updated recording metadata for ID: %llu, size: %llu bytes",
-                        (unsigned long long)thread_ctx->writer->current_recording_id,
-                        (unsigned long long)size_bytes);
-            }
+            mp4_writer_finalize_recording(thread_ctx->writer, &thread_ctx->segment_info.stats);
+            segment_finalized = true;
         }
     }
 
+    // Commit a segment left open by a failed last attempt
+    mp4_writer_finalize_recording(thread_ctx->writer, &thread_ctx->segment_info.stats);
+
     // MEMORY LEAK FIX: Aggressive cleanup of all FFmpeg resources
     log_info("Performing aggressive cleanup of all FFmpeg resources for stream %s", stream_name);
 
@@ -475,6 +447,12 @@ static void *mp4_writer_rtsp_thread(void *arg) {
         log_info("Closed input context for stream %s to prevent memory leaks", stream_name);
     }
 
+    // 2a. Leave the shared ingest so it can stop when no other consumer needs it
+    if (thread_ctx->segment_info.bus_sub) {
+        packet_bus_unsubscribe(thread_ctx->segment_info.bus_sub);
+        thread_ctx->segment_info.bus_sub = NULL;
+    }
+
     // 2b. BUGFIX: Destroy the context mutex
     pthread_mutex_destroy(&thread_ctx->context_mutex);
 
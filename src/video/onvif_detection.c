@@ -21,6 +21,7 @@
 #include "video/detection_result.h"
 #include "video/onvif_motion_recording.h"
 #include "video/zone_filter.h"
+#include "video/live_events.h"
 #include "database/db_detections.h"
 
 // Global variables
@@ -626,6 +627,9 @@ int detect_motion_onvif(const char *onvif_url, const char *username, const char
                 log_warn("Failed to filter detections by zones, storing all detections");
             }
 
+            // Push to live viewers before the database write
+            live_events_publish_detections(stream_name, result, 0);
+
             // Store the detection in the database
             store_detections_in_db(stream_name, result, 0); // 0 means use current time
 
@@ -642,6 +646,7 @@ int detect_motion_onvif(const char *onvif_url, const char *username, const char
 
         // Notify motion recording that motion has ended
         if (stream_name && stream_name[0] != '\0') {
+            live_events_publish_detections(stream_name, result, 0);
             process_motion_event(stream_name, false, time(NULL));
         }
     }
@@ -6,6 +6,7 @@
 #include "video/onvif_discovery_network.h"
 #include "video/onvif_discovery_probe.h"
 #include "video/onvif_discovery_response.h"
+#include "video/onvif_discovery_scan.h"
 #include "video/onvif_discovery_thread.h"
 #include "video/onvif_device_management.h"
 #include "core/logger.h"
@@ -16,13 +17,11 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/time.h>
-#include <sys/select.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
 #include <time.h>
 #include <stdbool.h>
-#include <fcntl.h>
 #include <curl/curl.h>
 
 // Maximum number of networks to detect
@@ -31,6 +30,9 @@
 // Maximum number of discovered devices
 #define MAX_DISCOVERED_DEVICES 32
 
+// Maximum number of direct HTTP probes in flight
+#define MAX_HTTP_PROBES_IN_FLIGHT 64
+
 // Array of discovered devices
 static onvif_device_info_t g_discovered_devices[MAX_DISCOVERED_DEVICES];
 static int g_discovered_device_count = 0;
@@ -100,87 +102,83 @@ int get_discovered_onvif_devices(onvif_device_info_t *devices, int max_devices)
     return count;
 }
 
-// Check if a port is open on a given IP address
-static int is_port_open(const char *ip_addr, int port, int timeout_ms) {
-    int sock;
-    struct sockaddr_in addr;
-    struct timeval tv;
-    fd_set fdset;
-    int res;
-    
-    // Create socket
-    sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        return 0; // Failed to create socket
+// Fall back to broadcast and multicast probes with the long response wait
+static int discover_by_broadcast(uint32_t broadcast, onvif_device_info_t *devices, int max_devices) {
+    char ip_addr[16];
+    struct in_addr addr;
+    int broadcast_enabled = 1;
+    int count;
+
+    // Create a socket for discovery probes
+    int discovery_sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (discovery_sock < 0) {
+        log_error("Failed to create discovery socket: %s", strerror(errno));
+        return -1;
     }
-    
-    // Set non-blocking
-    long arg = fcntl(sock, F_GETFL, NULL);
-    arg |= O_NONBLOCK;
-    fcntl(sock, F_SETFL, arg);
-    
-    // Set up address
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    
-    // Convert IP address
-    if (inet_aton(ip_addr, &addr.sin_addr) == 0) {
-        close(sock);
-        return 0; // Invalid IP address
+
+    // Set socket options for broadcast
+    if (setsockopt(discovery_sock, SOL_SOCKET, SO_BROADCAST, &broadcast_enabled, sizeof(broadcast_enabled)) < 0) {
+        log_error("Failed to set SO_BROADCAST option: %s", strerror(errno));
+        close(discovery_sock);
+        return -1;
     }
-    
-    // Try to connect
-    res = connect(sock, (struct sockaddr *)&addr, sizeof(addr));
-    
-    if (res < 0) {
-        if (errno == EINPROGRESS) {
-            // Connection in progress, wait for result
-            tv.tv_sec = timeout_ms / 1000;
-            tv.tv_usec = (timeout_ms % 1000) * 1000;
-            
-            FD_ZERO(&fdset);
-            FD_SET(sock, &fdset);
-            
-            // Wait for socket to be writable (connected)
-            res = select(sock + 1, NULL, &fdset, NULL, &tv);
-            
-            if (res > 0) {
-                // Socket is writable, check if there was an error
-                int so_error;
-                socklen_t len = sizeof(so_error);
-                
-                getsockopt(sock, SOL_SOCKET, SO_ERROR, &so_error, &len);
-                
-                if (so_error == 0) {
-                    close(sock);
-                    return 1; // Port is open
-                }
-            }
-        }
-    } else {
-        // Connected immediately
-        close(sock);
-        return 1; // Port is open
+
+    // Try binding to any interface to improve reliability
+    struct sockaddr_in bind_addr;
+    memset(&bind_addr, 0, sizeof(bind_addr));
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    bind_addr.sin_port = htons(0);  // Use any available port for sending
+
+    if (bind(discovery_sock, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) < 0) {
+        log_warn("Failed to bind discovery socket: %s", strerror(errno));
+        // Continue anyway, might still work
     }
-    
-    close(sock);
-    return 0; // Port is closed or connection timed out
+
+    // Set up destination address structure
+    struct sockaddr_in dest_addr;
+    memset(&dest_addr, 0, sizeof(dest_addr));
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_port = htons(3702);  // WS-Discovery port
+
+    // Send probes to broadcast address
+    addr.s_addr = htonl(broadcast);
+    strcpy(ip_addr, inet_ntoa(addr));
+    log_info("Sending discovery probes to broadcast address: %s", ip_addr);
+
+    dest_addr.sin_addr.s_addr = htonl(broadcast);
+    send_all_discovery_probes(discovery_sock, ip_addr, &dest_addr);
+
+    // Send to multicast address
+    log_info("Sending discovery probes to ONVIF multicast address: 239.255.255.250");
+    inet_pton(AF_INET, "239.255.255.250", &dest_addr.sin_addr);
+    send_all_discovery_probes(discovery_sock, "239.255.255.250", &dest_addr);
+
+    // Close the sending socket
+    close(discovery_sock);
+
+    // Try to receive responses
+    log_info("Waiting for discovery responses...");
+    count = receive_discovery_responses(devices, max_devices);
+
+    // If no devices found, try with a slightly shorter timeout to speed up the process
+    if (count == 0) {
+        log_info("No devices found with standard timeout, trying with shorter timeout");
+        count = receive_extended_discovery_responses(devices, max_devices, 1, 2); // 1 sec timeout, 2 attempts
+    }
+
+    return count;
 }
 
 // Discover ONVIF devices on a specific network
 int discover_onvif_devices(const char *network, onvif_device_info_t *devices,
                           int max_devices) {
     uint32_t base_addr, subnet_mask;
-    char ip_addr[16];
-    struct in_addr addr;
     int count = 0;
     char detected_networks[MAX_DETECTED_NETWORKS][64];
     int network_count = 0;
     char selected_network[64] = {0};
-    int discovery_sock = -1;
-    int broadcast_enabled = 1;
-    int result = -1;
+    onvif_scan_result_t scan;
 
     if (!devices || max_devices <= 0) {
         log_error("Invalid parameters for discover_onvif_devices");
@@ -220,162 +218,48 @@ int discover_onvif_devices(const char *network, onvif_device_info_t *devices,
     // Calculate network range
     uint32_t network_addr = base_addr & subnet_mask;
     uint32_t broadcast = network_addr | ~subnet_mask;
-    
-    // First scan for open ports on the network
-    log_info("Scanning network for open ONVIF ports (3702 and 80)");
-    
-    // Array to store IPs with open ports
-    #define MAX_CANDIDATE_IPS 256
-    char candidate_ips[MAX_CANDIDATE_IPS][16];
-    int candidate_count = 0;
-    
-    // Scan all IPs in the range
-    for (uint32_t ip = network_addr + 1; ip < broadcast && candidate_count < MAX_CANDIDATE_IPS; ip++) {
-        // Skip addresses too close to network or broadcast addresses
-        if (ip == network_addr + 1 || ip == broadcast - 1) {
-            continue;
-        }
 
-        addr.s_addr = htonl(ip);
-        strcpy(ip_addr, inet_ntoa(addr));
-        
-        // Check if port 3702 (ONVIF) or port 80 (HTTP) is open with a shorter timeout
-        if (is_port_open(ip_addr, 3702, 25) || is_port_open(ip_addr, 80, 25)) {
-            log_debug("Found potential ONVIF device at %s", ip_addr);
-            
-            // Add to candidate list
-            strncpy(candidate_ips[candidate_count], ip_addr, 16);
-            candidate_count++;
-        }
+    // Connect to every host and send WS-Discovery probes, many at a time
+    if (onvif_scan_network(network_addr, broadcast, g_config.onvif_discovery_concurrency,
+                           devices, max_devices, &scan) != 0) {
+        log_error("Failed to scan network %s for ONVIF devices", network);
+        return -1;
     }
-    
-    log_info("Found %d potential ONVIF devices with open ports", candidate_count);
-    
-    // If no candidates found, try broadcast and multicast
-    if (candidate_count == 0) {
-        log_info("No devices with open ports found, trying broadcast and multicast");
-        
-        // Create a socket for discovery probes
-        discovery_sock = socket(AF_INET, SOCK_DGRAM, 0);
-        if (discovery_sock < 0) {
-            log_error("Failed to create discovery socket: %s", strerror(errno));
-            return -1;
-        }
-
-        // Set socket options for broadcast
-        if (setsockopt(discovery_sock, SOL_SOCKET, SO_BROADCAST, &broadcast_enabled, sizeof(broadcast_enabled)) < 0) {
-            log_error("Failed to set SO_BROADCAST option: %s", strerror(errno));
-            close(discovery_sock);
-            return -1;
-        }
-
-        // Try binding to any interface to improve reliability
-        struct sockaddr_in bind_addr;
-        memset(&bind_addr, 0, sizeof(bind_addr));
-        bind_addr.sin_family = AF_INET;
-        bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-        bind_addr.sin_port = htons(0);  // Use any available port for sending
-
-        if (bind(discovery_sock, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) < 0) {
-            log_warn("Failed to bind discovery socket: %s", strerror(errno));
-            // Continue anyway, might still work
-        }
-
-        // Set up destination address structure
-        struct sockaddr_in dest_addr;
-        memset(&dest_addr, 0, sizeof(dest_addr));
-        dest_addr.sin_family = AF_INET;
-        dest_addr.sin_port = htons(3702);  // WS-Discovery port
-
-        // Send probes to broadcast address
-        addr.s_addr = htonl(broadcast);
-        strcpy(ip_addr, inet_ntoa(addr));
-        log_info("Sending discovery probes to broadcast address: %s", ip_addr);
-
-        dest_addr.sin_addr.s_addr = htonl(broadcast);
-        send_all_discovery_probes(discovery_sock, ip_addr, &dest_addr);
-
-        // Send to multicast address
-        log_info("Sending discovery probes to ONVIF multicast address: 239.255.255.250");
-        inet_pton(AF_INET, "239.255.255.250", &dest_addr.sin_addr);
-        send_all_discovery_probes(discovery_sock, "239.255.255.250", &dest_addr);
-
-        // Close the sending socket
-        close(discovery_sock);
-        
-        // Try to receive responses
-        log_info("Waiting for discovery responses...");
-        count = receive_discovery_responses(devices, max_devices);
-        
-        // If no devices found, try with a slightly shorter timeout to speed up the process
-        if (count == 0) {
-            log_info("No devices found with standard timeout, trying with shorter timeout");
-            count = receive_extended_discovery_responses(devices, max_devices, 1, 2); // 1 sec timeout, 2 attempts
-        }
-    } else {
-        // Create a socket for discovery probes
-        discovery_sock = socket(AF_INET, SOCK_DGRAM, 0);
-        if (discovery_sock < 0) {
-            log_error("Failed to create discovery socket: %s", strerror(errno));
-            return -1;
-        }
-
-        // Set socket options for broadcast
-        if (setsockopt(discovery_sock, SOL_SOCKET, SO_BROADCAST, &broadcast_enabled, sizeof(broadcast_enabled)) < 0) {
-            log_error("Failed to set SO_BROADCAST option: %s", strerror(errno));
-            close(discovery_sock);
-            return -1;
-        }
+    count = scan.device_count;
 
-        // Try binding to any interface to improve reliability
-        struct sockaddr_in bind_addr;
-        memset(&bind_addr, 0, sizeof(bind_addr));
-        bind_addr.sin_family = AF_INET;
-        bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-        bind_addr.sin_port = htons(0);  // Use any available port for sending
-
-        if (bind(discovery_sock, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) < 0) {
-            log_warn("Failed to bind discovery socket: %s", strerror(errno));
-            // Continue anyway, might still work
+    // If nothing answered at all, try broadcast and multicast with a longer wait
+    if (count == 0 && scan.candidate_count == 0) {
+        log_info("No devices with open ports found, trying broadcast and multicast");
+        count = discover_by_broadcast(broadcast, devices, max_devices);
+        if (count < 0) {
+            count = 0;
         }
+    }
 
-        // Set up destination address structure
-        struct sockaddr_in dest_addr;
-        memset(&dest_addr, 0, sizeof(dest_addr));
-        dest_addr.sin_family = AF_INET;
-        
-        // Send probes to each candidate IP
-        log_info("Sending discovery probes to %d candidate IPs", candidate_count);
-        
-        for (int i = 0; i < candidate_count; i++) {
-            // Try port 3702 (ONVIF discovery)
-            dest_addr.sin_port = htons(3702);
-            if (inet_aton(candidate_ips[i], &dest_addr.sin_addr) != 0) {
-                log_debug("Sending discovery probe to %s:3702", candidate_ips[i]);
-                send_all_discovery_probes(discovery_sock, candidate_ips[i], &dest_addr);
+    // Probe hosts with open ports that did not answer WS-Discovery over HTTP
+    if (scan.candidate_count > 0 && count < max_devices) {
+        int remaining = 0;
+        for (int i = 0; i < scan.candidate_count; i++) {
+            bool found = false;
+            for (int j = 0; j < count; j++) {
+                if (strcmp(devices[j].ip_address, scan.candidate_ips[i]) == 0) {
+                    found = true;
+                    break;
+                }
             }
-            
-            // Try port 80 (HTTP)
-            dest_addr.sin_port = htons(80);
-            if (inet_aton(candidate_ips[i], &dest_addr.sin_addr) != 0) {
-                log_debug("Sending discovery probe to %s:80", candidate_ips[i]);
-                send_all_discovery_probes(discovery_sock, candidate_ips[i], &dest_addr);
+            if (!found) {
+                memmove(scan.candidate_ips[remaining], scan.candidate_ips[i], sizeof(scan.candidate_ips[0]));
+                remaining++;
             }
         }
-        
-        // Close the sending socket
-        close(discovery_sock);
-        
-        // Try to receive responses
-        log_info("Waiting for discovery responses...");
-        count = receive_discovery_responses(devices, max_devices);
-        
-        // If no devices found, try with a slightly shorter timeout to speed up the process
-        if (count == 0) {
-            log_info("No devices found with standard timeout, trying with shorter timeout");
-            count = receive_extended_discovery_responses(devices, max_devices, 1, 2); // 1 sec timeout, 2 attempts
+
+        if (remaining > 0) {
+            log_info("Trying direct HTTP probing for %d hosts that did not answer WS-Discovery", remaining);
+            count += try_direct_http_discovery(scan.candidate_ips, remaining,
+                                               devices + count, max_devices - count);
         }
     }
+    onvif_scan_result_free(&scan);
 
     // Store the discovered devices for later retrieval
     pthread_mutex_lock(&g_discovery_mutex);
@@ -388,35 +272,26 @@ int discover_onvif_devices(const char *network, onvif_device_info_t *devices,
     
     pthread_mutex_unlock(&g_discovery_mutex);
 
-    // If we didn't find any devices with WS-Discovery, try direct HTTP probing
-    if (count == 0 && candidate_count > 0) {
-        log_info("No devices found with WS-Discovery, trying direct HTTP probing");
-        count = try_direct_http_discovery(candidate_ips, candidate_count, devices, max_devices);
-    }
-
     log_info("ONVIF discovery completed, found %d devices", count);
 
-    // Return 0 instead of -1 when no devices are found
-    return count < 0 ? 0 : count;
+    return count;
 }
 
 // Forward declaration of the callback function
 static size_t onvif_curl_write_callback(void *contents, size_t size, size_t nmemb, void *userp);
 
+// One candidate being probed over HTTP, walking the ONVIF service paths in turn
+typedef struct {
+    CURL *curl;
+    int candidate;
+    int path_index;
+    char url[128];
+} http_probe_t;
+
 // Try direct HTTP probing for ONVIF devices
 int try_direct_http_discovery(char candidate_ips[][16], int candidate_count, 
                              onvif_device_info_t *devices, int max_devices) {
     int count = 0;
-    CURL *curl;
-    CURLcode res;
-    
-    // Initialize CURL
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl = curl_easy_init();
-    if (!curl) {
-        log_error("Failed to initialize CURL for direct HTTP discovery");
-        return 0;
-    }
     
     // SOAP request for GetSystemDateAndTime (simple request that doesn't require authentication)
     const char *soap_request = 
@@ -439,74 +314,148 @@ int try_direct_http_discovery(char candidate_ips[][16], int candidate_count,
         "/service",
         NULL
     };
+
+    if (candidate_count <= 0 || max_devices <= 0) {
+        return 0;
+    }
+
+    int probe_count = candidate_count < MAX_HTTP_PROBES_IN_FLIGHT ? candidate_count : MAX_HTTP_PROBES_IN_FLIGHT;
+    http_probe_t *probes = calloc(probe_count, sizeof(http_probe_t));
+    if (!probes) {
+        log_error("Failed to allocate memory for direct HTTP discovery");
+        return 0;
+    }
     
-    // Set up CURL options
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 2L);  // Short timeout
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 1L);
-    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, soap_request);
-    curl_easy_setopt(curl, CURLOPT_NOBODY, 0L);
+    // Initialize CURL
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    CURLM *multi = curl_multi_init();
+    if (!multi) {
+        log_error("Failed to initialize CURL for direct HTTP discovery");
+        free(probes);
+        curl_global_cleanup();
+        return 0;
+    }
     
     // Set HTTP headers
     struct curl_slist *headers = NULL;
     headers = curl_slist_append(headers, "Content-Type: application/soap+xml; charset=utf-8");
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    
-    // Disable verbose output and don't write response to stdout
-    curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, onvif_curl_write_callback);
     
     log_info("Starting direct HTTP probing for %d candidate IPs", candidate_count);
-    
-    // Try each candidate IP
-    for (int i = 0; i < candidate_count && count < max_devices; i++) {
-        const char *ip = candidate_ips[i];
-        log_info("Probing IP %s for ONVIF services", ip);
+
+    // Every probe slot walks the paths of one candidate, then moves to the next candidate
+    int next_candidate = 0;
+    int in_flight = 0;
+    for (int i = 0; i < probe_count; i++) {
+        http_probe_t *probe = &probes[i];
+        probe->curl = curl_easy_init();
+        if (!probe->curl) {
+            log_error("Failed to initialize CURL handle for direct HTTP discovery");
+            break;
+        }
+
+        // Set up CURL options
+        curl_easy_setopt(probe->curl, CURLOPT_TIMEOUT, 2L);  // Short timeout
+        curl_easy_setopt(probe->curl, CURLOPT_CONNECTTIMEOUT, 1L);
+        curl_easy_setopt(probe->curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(probe->curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(probe->curl, CURLOPT_POSTFIELDS, soap_request);
+        curl_easy_setopt(probe->curl, CURLOPT_NOBODY, 0L);
+        curl_easy_setopt(probe->curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(probe->curl, CURLOPT_PRIVATE, probe);
         
-        // Try each ONVIF path
-        for (int j = 0; onvif_paths[j] != NULL && count < max_devices; j++) {
-            char url[128];
-            snprintf(url, sizeof(url), "http://%s%s", ip, onvif_paths[j]);
-            
-            log_debug("Trying URL: %s", url);
-            curl_easy_setopt(curl, CURLOPT_URL, url);
-            
-            // Perform the request
-            res = curl_easy_perform(curl);
-            
-            // Check if successful
+        // Disable verbose output and don't write response to stdout
+        curl_easy_setopt(probe->curl, CURLOPT_VERBOSE, 0L);
+        curl_easy_setopt(probe->curl, CURLOPT_WRITEFUNCTION, onvif_curl_write_callback);
+
+        probe->candidate = next_candidate++;
+        probe->path_index = 0;
+        snprintf(probe->url, sizeof(probe->url), "http://%s%s",
+                 candidate_ips[probe->candidate], onvif_paths[0]);
+        curl_easy_setopt(probe->curl, CURLOPT_URL, probe->url);
+        curl_multi_add_handle(multi, probe->curl);
+        in_flight++;
+    }
+
+    while (in_flight > 0 && count < max_devices) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg *msg;
+        int msgs_left = 0;
+        while ((msg = curl_multi_info_read(multi, &msgs_left)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            CURL *curl = msg->easy_handle;
+            CURLcode res = msg->data.result;
+            http_probe_t *probe = NULL;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **)&probe);
+            curl_multi_remove_handle(multi, curl);
+
+            long http_code = 0;
             if (res == CURLE_OK) {
-                long http_code = 0;
                 curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+            }
+
+            bool found = false;
+            if (http_code >= 200 && http_code < 300 && count < max_devices) {
+                const char *ip = candidate_ips[probe->candidate];
+                log_info("Found ONVIF device at %s", probe->url);
                 
-                if (http_code >= 200 && http_code < 300) {
-                    log_info("Found ONVIF device at %s", url);
-                    
-                    // Initialize device info
-                    memset(&devices[count], 0, sizeof(onvif_device_info_t));
-                    
-                    // Set device info
-                    strncpy(devices[count].ip_address, ip, sizeof(devices[count].ip_address) - 1);
-                    strncpy(devices[count].device_service, url, sizeof(devices[count].device_service) - 1);
-                    strncpy(devices[count].endpoint, url, sizeof(devices[count].endpoint) - 1);
-                    strncpy(devices[count].model, "Unknown (HTTP discovery)", sizeof(devices[count].model) - 1);
-                    
-                    // Set discovery time and online status
-                    devices[count].discovery_time = time(NULL);
-                    devices[count].online = true;
-                    
-                    count++;
-                    break;  // Found a working path for this IP, move to next IP
-                }
+                // Initialize device info
+                memset(&devices[count], 0, sizeof(onvif_device_info_t));
+                
+                // Set device info
+                strncpy(devices[count].ip_address, ip, sizeof(devices[count].ip_address) - 1);
+                strncpy(devices[count].device_service, probe->url, sizeof(devices[count].device_service) - 1);
+                strncpy(devices[count].endpoint, probe->url, sizeof(devices[count].endpoint) - 1);
+                strncpy(devices[count].model, "Unknown (HTTP discovery)", sizeof(devices[count].model) - 1);
+                
+                // Set discovery time and online status
+                devices[count].discovery_time = time(NULL);
+                devices[count].online = true;
+                
+                count++;
+                found = true;
+            }
+
+            // A refused connection will not succeed on another path either
+            if (!found && res != CURLE_COULDNT_CONNECT && res != CURLE_OPERATION_TIMEDOUT &&
+                onvif_paths[probe->path_index + 1] != NULL) {
+                probe->path_index++;
+            } else if (next_candidate < candidate_count) {
+                // Found a working path or ran out of paths, move to next IP
+                probe->candidate = next_candidate++;
+                probe->path_index = 0;
+            } else {
+                in_flight--;
+                continue;
             }
+
+            snprintf(probe->url, sizeof(probe->url), "http://%s%s",
+                     candidate_ips[probe->candidate], onvif_paths[probe->path_index]);
+            log_debug("Trying URL: %s", probe->url);
+            curl_easy_setopt(curl, CURLOPT_URL, probe->url);
+            curl_multi_add_handle(multi, curl);
+        }
+
+        if (in_flight > 0 && count < max_devices) {
+            curl_multi_wait(multi, NULL, 0, 100, NULL);
         }
     }
     
     // Clean up
+    for (int i = 0; i < probe_count; i++) {
+        if (probes[i].curl) {
+            curl_multi_remove_handle(multi, probes[i].curl);
+            curl_easy_cleanup(probes[i].curl);
+        }
+    }
+    curl_multi_cleanup(multi);
     curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
     curl_global_cleanup();
+    free(probes);
     
     log_info("Direct HTTP probing completed, found %d devices", count);
     
@@ -0,0 +1,504 @@
+#define _GNU_SOURCE
+
+#include "video/onvif_discovery_scan.h"
+#include "video/onvif_discovery_messages.h"
+#include "video/onvif_discovery_response.h"
+#include "core/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// TCP ports that mark a host as a candidate, in the order they are tried
+static const uint16_t scan_ports[] = {80, 3702};
+#define SCAN_PORT_COUNT ((int)(sizeof(scan_ports) / sizeof(scan_ports[0])))
+
+// Per-host state flags
+#define HOST_CANDIDATE 0x01
+#define HOST_PROBED    0x02
+
+// epoll tag of the UDP socket, slots use their index
+#define UDP_EVENT_TAG UINT32_MAX
+
+#define SCAN_EPOLL_EVENTS 64
+#define SCAN_REPLY_BUFFER_SIZE 8192
+
+typedef struct {
+    int fd;            // -1 when the slot is free
+    uint32_t host;     // Index of the host in the scanned range
+    int64_t deadline;  // Monotonic time in ms
+} scan_slot_t;
+
+typedef struct {
+    int epfd;
+    int udp_fd;
+    uint32_t first_host;
+    uint32_t host_count;
+    uint8_t *host_state;
+    scan_slot_t *slots;
+    int *free_slots;
+    int free_count;
+    int active;
+    char probe[1024];
+    int probe_len;
+    char *reply_buffer;
+    onvif_device_info_t *devices;
+    int max_devices;
+    int device_count;
+} scan_state_t;
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void format_host(uint32_t addr, char *buf, size_t size) {
+    struct in_addr in;
+    in.s_addr = htonl(addr);
+    inet_ntop(AF_INET, &in, buf, size);
+}
+
+// Send a WS-Discovery message without blocking, a full socket buffer just skips it
+static void send_probe(scan_state_t *state, uint32_t addr, const char *message, int len) {
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(3702);
+    dest.sin_addr.s_addr = htonl(addr);
+
+    if (sendto(state->udp_fd, message, len, MSG_DONTWAIT, (struct sockaddr *)&dest, sizeof(dest)) < 0 &&
+        errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+        char ip[INET_ADDRSTRLEN];
+        format_host(addr, ip, sizeof(ip));
+        log_debug("Failed to send discovery probe to %s: %s", ip, strerror(errno));
+    }
+}
+
+// Send the alternative probe templates to a host that has an open port
+static void send_candidate_probes(scan_state_t *state, uint32_t addr) {
+    const char *templates[] = {ONVIF_DISCOVERY_MSG_ALT, ONVIF_DISCOVERY_MSG_WITH_SCOPE};
+    char uuid[64];
+    char message[1024];
+
+    for (int i = 0; i < 2; i++) {
+        generate_uuid(uuid, sizeof(uuid));
+        int len = snprintf(message, sizeof(message), templates[i], uuid);
+        if (len > 0 && len < (int)sizeof(message)) {
+            send_probe(state, addr, message, len);
+        }
+    }
+}
+
+static void release_slot(scan_state_t *state, int index) {
+    scan_slot_t *slot = &state->slots[index];
+    close(slot->fd);  // Also removes it from the epoll set
+    slot->fd = -1;
+    state->free_slots[state->free_count++] = index;
+    state->active--;
+}
+
+static void mark_candidate(scan_state_t *state, uint32_t host) {
+    if (state->host_state[host] & HOST_CANDIDATE) {
+        return;
+    }
+    state->host_state[host] |= HOST_CANDIDATE;
+
+    char ip[INET_ADDRSTRLEN];
+    format_host(state->first_host + host, ip, sizeof(ip));
+    log_debug("Found potential ONVIF device at %s", ip);
+
+    send_candidate_probes(state, state->first_host + host);
+}
+
+/**
+ * Start a non-blocking connect
+ *
+ * @return 1 if the connect is in flight, 0 if it finished immediately,
+ *         -1 if no socket could be created
+ */
+static int start_connect(scan_state_t *state, uint32_t host, uint16_t port, int64_t now) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(state->first_host + host);
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        close(fd);
+        mark_candidate(state, host);
+        return 0;
+    }
+    if (errno != EINPROGRESS) {
+        close(fd);
+        return 0;
+    }
+
+    int index = state->free_slots[--state->free_count];
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLOUT;
+    ev.data.u32 = (uint32_t)index;
+    if (epoll_ctl(state->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        state->free_count++;
+        close(fd);
+        return -1;
+    }
+
+    state->slots[index].fd = fd;
+    state->slots[index].host = host;
+    state->slots[index].deadline = now + ONVIF_SCAN_CONNECT_TIMEOUT_MS;
+    state->active++;
+    return 1;
+}
+
+static void finish_connect(scan_state_t *state, int index) {
+    scan_slot_t *slot = &state->slots[index];
+    int so_error = 0;
+    socklen_t len = sizeof(so_error);
+
+    if (getsockopt(slot->fd, SOL_SOCKET, SO_ERROR, &so_error, &len) == 0 && so_error == 0) {
+        mark_candidate(state, slot->host);
+    }
+    release_slot(state, index);
+}
+
+static void drain_replies(scan_state_t *state) {
+    struct sockaddr_in from;
+    socklen_t from_len;
+
+    while (state->device_count < state->max_devices) {
+        from_len = sizeof(from);
+        ssize_t n = recvfrom(state->udp_fd, state->reply_buffer, SCAN_REPLY_BUFFER_SIZE - 1,
+                             MSG_DONTWAIT, (struct sockaddr *)&from, &from_len);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                log_warn("Failed to receive discovery reply: %s", strerror(errno));
+            }
+            return;
+        }
+        state->reply_buffer[n] = '\0';
+
+        onvif_device_info_t *device = &state->devices[state->device_count];
+        if (parse_device_info(state->reply_buffer, device) != 0) {
+            continue;
+        }
+
+        // Devices answer every probe template, keep the first reply
+        bool duplicate = false;
+        for (int i = 0; i < state->device_count; i++) {
+            if (strcmp(state->devices[i].ip_address, device->ip_address) == 0) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate) {
+            log_info("Discovered ONVIF device: %s (%s)", device->device_service, device->ip_address);
+            state->device_count++;
+        }
+    }
+}
+
+static int open_udp_socket(void) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        log_error("Failed to create discovery socket: %s", strerror(errno));
+        return -1;
+    }
+
+    int enable = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable)) < 0) {
+        log_warn("Failed to set SO_BROADCAST option: %s", strerror(errno));
+    }
+
+    // Replies to hundreds of probes arrive in a burst
+    int rcvbuf = 256 * 1024;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0) {
+        log_warn("Failed to increase receive buffer size: %s", strerror(errno));
+    }
+
+    struct sockaddr_in bind_addr;
+    memset(&bind_addr, 0, sizeof(bind_addr));
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    bind_addr.sin_port = htons(0);
+    if (bind(fd, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) < 0) {
+        log_warn("Failed to bind discovery socket: %s", strerror(errno));
+    }
+
+    return fd;
+}
+
+// Keep enough descriptors free for the rest of the process
+static int clamp_concurrency(int concurrency) {
+    if (concurrency <= 0) {
+        concurrency = ONVIF_SCAN_DEFAULT_CONCURRENCY;
+    }
+    if (concurrency > ONVIF_SCAN_MAX_CONCURRENCY) {
+        concurrency = ONVIF_SCAN_MAX_CONCURRENCY;
+    }
+
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        int available = (int)(limit.rlim_cur / 2);
+        if (available < 16) {
+            available = 16;
+        }
+        if (concurrency > available) {
+            log_info("Limiting ONVIF scan to %d connects in flight (open file limit %llu)",
+                     available, (unsigned long long)limit.rlim_cur);
+            concurrency = available;
+        }
+    }
+
+    return concurrency;
+}
+
+static void run_scan(scan_state_t *state, int concurrency) {
+    struct epoll_event events[SCAN_EPOLL_EVENTS];
+    uint64_t total_work = (uint64_t)state->host_count * SCAN_PORT_COUNT;
+    uint64_t next_work = 0;
+    int64_t reply_deadline = 0;
+    int64_t now = monotonic_ms();
+
+    while (state->device_count < state->max_devices) {
+        // Keep the connect pipeline full
+        while (state->active < concurrency && next_work < total_work) {
+            uint32_t host = (uint32_t)(next_work / SCAN_PORT_COUNT);
+            uint16_t port = scan_ports[next_work % SCAN_PORT_COUNT];
+
+            if (state->host_state[host] & HOST_CANDIDATE) {
+                next_work++;
+                continue;
+            }
+            if (!(state->host_state[host] & HOST_PROBED)) {
+                state->host_state[host] |= HOST_PROBED;
+                send_probe(state, state->first_host + host, state->probe, state->probe_len);
+            }
+
+            if (start_connect(state, host, port, now) < 0) {
+                if (state->active > 0) {
+                    // Out of descriptors, retry once a connect finishes
+                    break;
+                }
+                log_error("Failed to start ONVIF port scan connect: %s", strerror(errno));
+                next_work = total_work;
+                break;
+            }
+            next_work++;
+        }
+
+        int timeout;
+        if (state->active > 0) {
+            int64_t earliest = INT64_MAX;
+            for (int i = 0; i < concurrency; i++) {
+                if (state->slots[i].fd >= 0 && state->slots[i].deadline < earliest) {
+                    earliest = state->slots[i].deadline;
+                }
+            }
+            timeout = earliest > now ? (int)(earliest - now) : 0;
+        } else if (next_work >= total_work) {
+            if (reply_deadline == 0) {
+                reply_deadline = now + ONVIF_SCAN_REPLY_WAIT_MS;
+            }
+            if (now >= reply_deadline) {
+                break;
+            }
+            timeout = (int)(reply_deadline - now);
+        } else {
+            timeout = 0;
+        }
+
+        int n = epoll_wait(state->epfd, events, SCAN_EPOLL_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_error("epoll_wait failed during ONVIF scan: %s", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u32 == UDP_EVENT_TAG) {
+                drain_replies(state);
+            } else if (state->slots[events[i].data.u32].fd >= 0) {
+                finish_connect(state, (int)events[i].data.u32);
+            }
+        }
+
+        now = monotonic_ms();
+        for (int i = 0; i < concurrency && state->active > 0; i++) {
+            if (state->slots[i].fd >= 0 && state->slots[i].deadline <= now) {
+                release_slot(state, i);
+            }
+        }
+    }
+
+    for (int i = 0; i < concurrency; i++) {
+        if (state->slots[i].fd >= 0) {
+            release_slot(state, i);
+        }
+    }
+}
+
+static int collect_candidates(const scan_state_t *state, onvif_scan_result_t *result) {
+    int count = 0;
+    for (uint32_t i = 0; i < state->host_count; i++) {
+        if (state->host_state[i] & HOST_CANDIDATE) {
+            count++;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    result->candidate_ips = malloc((size_t)count * sizeof(*result->candidate_ips));
+    if (!result->candidate_ips) {
+        log_error("Failed to allocate memory for ONVIF candidates");
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < state->host_count; i++) {
+        if (state->host_state[i] & HOST_CANDIDATE) {
+            format_host(state->first_host + i, result->candidate_ips[result->candidate_count],
+                        sizeof(result->candidate_ips[0]));
+            result->candidate_count++;
+        }
+    }
+    return 0;
+}
+
+// Scan a subnet for ONVIF devices
+int onvif_scan_network(uint32_t network_addr, uint32_t broadcast, int concurrency,
+                       onvif_device_info_t *devices, int max_devices,
+                       onvif_scan_result_t *result) {
+    scan_state_t state;
+    int ret = -1;
+
+    if (!devices || max_devices <= 0 || !result) {
+        return -1;
+    }
+    memset(result, 0, sizeof(*result));
+    memset(&state, 0, sizeof(state));
+    state.epfd = -1;
+    state.udp_fd = -1;
+    state.devices = devices;
+    state.max_devices = max_devices;
+
+    // /31 and /32 networks have no network and broadcast addresses to skip
+    if (broadcast - network_addr < 2) {
+        state.first_host = network_addr;
+        state.host_count = broadcast - network_addr + 1;
+    } else {
+        state.first_host = network_addr + 1;
+        state.host_count = broadcast - network_addr - 1;
+    }
+    if (state.host_count > ONVIF_SCAN_MAX_HOSTS) {
+        log_error("Network has %u hosts, ONVIF discovery scans at most %d (a /16)",
+                  state.host_count, ONVIF_SCAN_MAX_HOSTS);
+        return -1;
+    }
+
+    concurrency = clamp_concurrency(concurrency);
+
+    state.host_state = calloc(state.host_count, 1);
+    state.slots = malloc((size_t)concurrency * sizeof(scan_slot_t));
+    state.free_slots = malloc((size_t)concurrency * sizeof(int));
+    state.reply_buffer = malloc(SCAN_REPLY_BUFFER_SIZE);
+    if (!state.host_state || !state.slots || !state.free_slots || !state.reply_buffer) {
+        log_error("Failed to allocate memory for ONVIF scan");
+        goto cleanup;
+    }
+    for (int i = 0; i < concurrency; i++) {
+        state.slots[i].fd = -1;
+        state.free_slots[i] = concurrency - 1 - i;
+    }
+    state.free_count = concurrency;
+
+    state.epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (state.epfd < 0) {
+        log_error("Failed to create epoll instance for ONVIF scan: %s", strerror(errno));
+        goto cleanup;
+    }
+
+    state.udp_fd = open_udp_socket();
+    if (state.udp_fd < 0) {
+        goto cleanup;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = UDP_EVENT_TAG;
+    if (epoll_ctl(state.epfd, EPOLL_CTL_ADD, state.udp_fd, &ev) < 0) {
+        log_error("Failed to watch discovery socket: %s", strerror(errno));
+        goto cleanup;
+    }
+
+    char uuid[64];
+    generate_uuid(uuid, sizeof(uuid));
+    state.probe_len = snprintf(state.probe, sizeof(state.probe), ONVIF_DISCOVERY_MSG, uuid);
+    if (state.probe_len <= 0 || state.probe_len >= (int)sizeof(state.probe)) {
+        log_error("Failed to build WS-Discovery probe");
+        goto cleanup;
+    }
+
+    // Devices that do not answer unicast probes usually answer multicast ones
+    struct in_addr multicast;
+    inet_pton(AF_INET, "239.255.255.250", &multicast);
+    send_probe(&state, ntohl(multicast.s_addr), state.probe, state.probe_len);
+    send_probe(&state, broadcast, state.probe, state.probe_len);
+
+    char first_ip[INET_ADDRSTRLEN];
+    format_host(state.first_host, first_ip, sizeof(first_ip));
+    log_info("Scanning %u hosts from %s with %d connects in flight",
+             state.host_count, first_ip, concurrency);
+
+    int64_t started = monotonic_ms();
+    run_scan(&state, concurrency);
+
+    if (collect_candidates(&state, result) != 0) {
+        goto cleanup;
+    }
+    result->device_count = state.device_count;
+
+    log_info("ONVIF scan finished in %lld ms: %d WS-Discovery replies, %d hosts with open ports",
+             (long long)(monotonic_ms() - started), state.device_count, result->candidate_count);
+    ret = 0;
+
+cleanup:
+    if (state.udp_fd >= 0) {
+        close(state.udp_fd);
+    }
+    if (state.epfd >= 0) {
+        close(state.epfd);
+    }
+    free(state.host_state);
+    free(state.slots);
+    free(state.free_slots);
+    free(state.reply_buffer);
+    return ret;
+}
+
+// Free the candidate list of a scan result
+void onvif_scan_result_free(onvif_scan_result_t *result) {
+    if (!result) {
+        return;
+    }
+    free(result->candidate_ips);
+    result->candidate_ips = NULL;
+    result->candidate_count = 0;
+}
@@ -16,6 +16,7 @@
 #include "video/onvif_motion_recording.h"
 #include "video/streams.h"
 #include "video/stream_manager.h"
+#include "video/live_events.h"
 #include "core/logger.h"
 #include "core/config.h"
 #include "core/shutdown_coordinator.h"
@@ -417,6 +418,7 @@ static void update_recording_state(motion_recording_context_t *ctx, time_t curre
                 // Motion has ended, enter finalizing state for post-buffer
                 ctx->state = RECORDING_STATE_FINALIZING;
                 ctx->state_change_time = current_time;
+                live_events_publish_motion(ctx->stream_name, false, current_time);
                 log_info("Motion ended for stream: %s, entering finalizing state (post-buffer: %ds)",
                          ctx->stream_name, ctx->post_buffer_seconds);
             }
@@ -781,6 +783,8 @@ int process_motion_event(const char *stream_name, bool motion_detected, time_t t
     event.confidence = 1.0f;
     strncpy(event.event_type, "motion", sizeof(event.event_type) - 1);
 
+    live_events_publish_motion(stream_name, motion_detected, timestamp);
+
     // Push to event queue
     if (push_event(&event) != 0) {
         log_error("Failed to push motion event to queue for stream: %s", stream_name);
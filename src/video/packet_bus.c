@@ -0,0 +1,689 @@
+/**
+ * Shared RTSP ingest packet bus
+ *
+ * One demux thread per input URL reads packets with av_read_frame() and
+ * pushes a new reference of every packet into the bounded queue of each
+ * subscriber.  Consumers read from their queue exactly as they would read
+ * from their own input context, but the camera only sees one session.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <errno.h>
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/time.h>
+
+#include "core/logger.h"
+#include "core/config.h"
+#include "core/shutdown_coordinator.h"
+#include "video/stream_protocol.h"
+#include "video/packet_bus.h"
+
+// Maximum number of elementary streams tracked per ingest
+#define PACKET_BUS_MAX_STREAMS 8
+
+// Reconnect backoff bounds in milliseconds
+#define PACKET_BUS_MIN_RECONNECT_MS 500
+#define PACKET_BUS_MAX_RECONNECT_MS 30000
+
+typedef struct packet_bus packet_bus_t;
+
+struct packet_bus_subscriber {
+    packet_bus_t *bus;
+    char name[32];
+    int flags;
+
+    // Ring of packet references, protected by bus->mutex
+    AVPacket **queue;
+    int queue_size;
+    int head;
+    int count;
+    pthread_cond_t cond;
+
+    uint64_t generation;      // Ingest generation of the consumer's stream copy (0 = none)
+    bool need_keyframe;       // Drop packets until the next video keyframe
+    uint64_t delivered;
+    uint64_t dropped;
+};
+
+struct packet_bus {
+    char stream_name[MAX_STREAM_NAME];
+    char url[MAX_URL_LENGTH];
+    int protocol;
+
+    pthread_t thread;
+    atomic_int running;
+    pthread_mutex_t mutex;
+    pthread_cond_t info_cond;
+
+    // Layout of the current connection, valid while connected
+    AVCodecParameters *codecpar[PACKET_BUS_MAX_STREAMS];
+    AVRational time_base[PACKET_BUS_MAX_STREAMS];
+    AVRational avg_frame_rate[PACKET_BUS_MAX_STREAMS];
+    AVRational r_frame_rate[PACKET_BUS_MAX_STREAMS];
+    int nb_streams;
+    int video_stream_idx;
+    uint64_t generation;      // Incremented on every successful connect
+    bool connected;
+    bool stopped;             // Demux thread has exited
+
+    packet_bus_subscriber_t *subscribers[PACKET_BUS_MAX_SUBSCRIBERS];
+    int subscriber_count;
+
+    // Demux thread + subscribers; the bus is freed when this drops to zero
+    int refs;
+};
+
+// Registry of active ingests, keyed by URL
+static packet_bus_t *g_buses[MAX_STREAMS] = {0};
+static pthread_mutex_t g_buses_mutex = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int g_active_ingests = ATOMIC_VAR_INIT(0);
+static bool g_initialized = false;
+
+/**
+ * Build an absolute CLOCK_REALTIME deadline for pthread_cond_timedwait
+ */
+static void deadline_from_now(struct timespec *ts, int timeout_ms) {
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * Drop every queued packet of a subscriber. Caller holds bus->mutex.
+ */
+static void subscriber_clear_locked(packet_bus_subscriber_t *sub) {
+    while (sub->count > 0) {
+        av_packet_free(&sub->queue[sub->head]);
+        sub->head = (sub->head + 1) % sub->queue_size;
+        sub->count--;
+    }
+    sub->head = 0;
+}
+
+/**
+ * Release one reference to the bus, freeing it on the last one.
+ * Caller holds bus->mutex; it is released (and possibly destroyed) here.
+ */
+static void bus_release_locked(packet_bus_t *bus) {
+    bus->refs--;
+    bool destroy = (bus->refs == 0);
+    pthread_mutex_unlock(&bus->mutex);
+
+    if (!destroy) {
+        return;
+    }
+
+    for (int i = 0; i < PACKET_BUS_MAX_STREAMS; i++) {
+        if (bus->codecpar[i]) {
+            avcodec_parameters_free(&bus->codecpar[i]);
+        }
+    }
+    pthread_cond_destroy(&bus->info_cond);
+    pthread_mutex_destroy(&bus->mutex);
+    free(bus);
+}
+
+/**
+ * Remove a bus from the registry so new subscribers start a fresh ingest
+ */
+static void registry_remove(packet_bus_t *bus) {
+    pthread_mutex_lock(&g_buses_mutex);
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        if (g_buses[i] == bus) {
+            g_buses[i] = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_buses_mutex);
+}
+
+/**
+ * Publish the stream layout of a new connection. Caller holds bus->mutex.
+ */
+static void bus_publish_layout_locked(packet_bus_t *bus, AVFormatContext *input_ctx, int video_stream_idx) {
+    for (int i = 0; i < PACKET_BUS_MAX_STREAMS; i++) {
+        if (bus->codecpar[i]) {
+            avcodec_parameters_free(&bus->codecpar[i]);
+        }
+    }
+
+    bus->nb_streams = 0;
+    for (unsigned int i = 0; i < input_ctx->nb_streams && i < PACKET_BUS_MAX_STREAMS; i++) {
+        AVStream *st = input_ctx->streams[i];
+        bus->codecpar[i] = avcodec_parameters_alloc();
+        if (bus->codecpar[i]) {
+            avcodec_parameters_copy(bus->codecpar[i], st->codecpar);
+        }
+        bus->time_base[i] = st->time_base;
+        bus->avg_frame_rate[i] = st->avg_frame_rate;
+        bus->r_frame_rate[i] = st->r_frame_rate;
+        bus->nb_streams++;
+    }
+
+    bus->video_stream_idx = video_stream_idx;
+    bus->generation++;
+    bus->connected = true;
+
+    // Anything still queued belongs to the previous connection
+    for (int i = 0; i < bus->subscriber_count; i++) {
+        packet_bus_subscriber_t *sub = bus->subscribers[i];
+        subscriber_clear_locked(sub);
+        sub->need_keyframe = true;
+        pthread_cond_broadcast(&sub->cond);
+    }
+    pthread_cond_broadcast(&bus->info_cond);
+}
+
+/**
+ * Queue a reference of pkt for every interested subscriber. Caller holds bus->mutex.
+ */
+static void bus_fan_out_locked(packet_bus_t *bus, const AVPacket *pkt) {
+    bool is_video = (pkt->stream_index == bus->video_stream_idx);
+    bool is_keyframe = is_video && (pkt->flags & AV_PKT_FLAG_KEY);
+
+    for (int i = 0; i < bus->subscriber_count; i++) {
+        packet_bus_subscriber_t *sub = bus->subscribers[i];
+
+        if (!is_video && (sub->flags & (PACKET_BUS_SUB_VIDEO_ONLY | PACKET_BUS_SUB_KEYFRAMES_ONLY))) {
+            continue;
+        }
+        if (is_video && !is_keyframe && (sub->flags & PACKET_BUS_SUB_KEYFRAMES_ONLY)) {
+            continue;
+        }
+
+        // After a resync only restart on a keyframe so decoders and muxers see a clean GOP
+        if (sub->need_keyframe) {
+            if (!is_keyframe) {
+                continue;
+            }
+            sub->need_keyframe = false;
+        }
+
+        if (sub->count == sub->queue_size) {
+            // Consumer fell behind: drop the backlog rather than growing without bound
+            sub->dropped += sub->count;
+            subscriber_clear_locked(sub);
+            log_warn("Packet bus consumer '%s' for stream %s fell behind, dropped %d queued packets",
+                     sub->name, bus->stream_name, sub->queue_size);
+            if (!is_keyframe) {
+                sub->need_keyframe = true;
+                continue;
+            }
+        }
+
+        AVPacket *ref = av_packet_clone(pkt);
+        if (!ref) {
+            sub->dropped++;
+            continue;
+        }
+
+        int tail = (sub->head + sub->count) % sub->queue_size;
+        sub->queue[tail] = ref;
+        sub->count++;
+        pthread_cond_signal(&sub->cond);
+    }
+}
+
+/**
+ * Demux thread: one camera session shared by all subscribers
+ */
+static void *packet_bus_thread(void *arg) {
+    packet_bus_t *bus = (packet_bus_t *)arg;
+    AVFormatContext *input_ctx = NULL;
+    AVPacket *pkt = NULL;
+    int reconnect_delay_ms = PACKET_BUS_MIN_RECONNECT_MS;
+
+    log_info("Shared ingest thread started for stream %s", bus->stream_name);
+
+    pkt = av_packet_alloc();
+    if (!pkt) {
+        log_error("Failed to allocate packet for shared ingest of stream %s", bus->stream_name);
+        atomic_store(&bus->running, 0);
+    }
+
+    while (atomic_load(&bus->running) && !is_shutdown_initiated()) {
+        if (!input_ctx) {
+            int ret = open_input_stream(&input_ctx, bus->url, bus->protocol);
+            int video_idx = (ret >= 0 && input_ctx) ? find_video_stream_index(input_ctx) : -1;
+
+            if (ret < 0 || video_idx < 0) {
+                if (input_ctx) {
+                    avformat_close_input(&input_ctx);
+                }
+                log_warn("Shared ingest for stream %s could not connect, retrying in %d ms",
+                         bus->stream_name, reconnect_delay_ms);
+
+                // Sleep in small steps so an unsubscribe or shutdown is noticed quickly
+                for (int waited = 0; waited < reconnect_delay_ms && atomic_load(&bus->running) &&
+                     !is_shutdown_initiated(); waited += 100) {
+                    av_usleep(100000);
+                }
+                reconnect_delay_ms *= 2;
+                if (reconnect_delay_ms > PACKET_BUS_MAX_RECONNECT_MS) {
+                    reconnect_delay_ms = PACKET_BUS_MAX_RECONNECT_MS;
+                }
+                continue;
+            }
+
+            pthread_mutex_lock(&bus->mutex);
+            bus_publish_layout_locked(bus, input_ctx, video_idx);
+            uint64_t generation = bus->generation;
+            pthread_mutex_unlock(&bus->mutex);
+
+            reconnect_delay_ms = PACKET_BUS_MIN_RECONNECT_MS;
+            log_info("Shared ingest for stream %s connected (%u streams, generation %llu)",
+                     bus->stream_name, input_ctx->nb_streams, (unsigned long long)generation);
+        }
+
+        int ret = av_read_frame(input_ctx, pkt);
+        if (ret == AVERROR(EAGAIN)) {
+            av_usleep(10000);
+            continue;
+        }
+        if (ret < 0) {
+            char error_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+            av_strerror(ret, error_buf, AV_ERROR_MAX_STRING_SIZE);
+            log_error("Shared ingest read error for stream %s: %s, reconnecting", bus->stream_name, error_buf);
+
+            pthread_mutex_lock(&bus->mutex);
+            bus->connected = false;
+            pthread_mutex_unlock(&bus->mutex);
+
+            avformat_close_input(&input_ctx);
+            continue;
+        }
+
+        if (!pkt->data || pkt->size <= 0 || pkt->stream_index < 0 ||
+            pkt->stream_index >= PACKET_BUS_MAX_STREAMS) {
+            av_packet_unref(pkt);
+            continue;
+        }
+
+        // Make the packet reference-counted once so every subscriber shares the same buffer
+        if (av_packet_make_refcounted(pkt) < 0) {
+            av_packet_unref(pkt);
+            continue;
+        }
+
+        pthread_mutex_lock(&bus->mutex);
+        bus_fan_out_locked(bus, pkt);
+        pthread_mutex_unlock(&bus->mutex);
+
+        av_packet_unref(pkt);
+    }
+
+    if (input_ctx) {
+        avformat_close_input(&input_ctx);
+    }
+    if (pkt) {
+        av_packet_free(&pkt);
+    }
+
+    registry_remove(bus);
+
+    pthread_mutex_lock(&bus->mutex);
+    bus->connected = false;
+    bus->stopped = true;
+    for (int i = 0; i < bus->subscriber_count; i++) {
+        pthread_cond_broadcast(&bus->subscribers[i]->cond);
+    }
+    pthread_cond_broadcast(&bus->info_cond);
+    log_info("Shared ingest thread for stream %s exited", bus->stream_name);
+    bus_release_locked(bus);
+
+    atomic_fetch_sub(&g_active_ingests, 1);
+    return NULL;
+}
+
+/**
+ * Initialize the packet bus system
+ */
+void init_packet_bus_system(void) {
+    pthread_mutex_lock(&g_buses_mutex);
+    if (!g_initialized) {
+        memset(g_buses, 0, sizeof(g_buses));
+        g_initialized = true;
+    }
+    pthread_mutex_unlock(&g_buses_mutex);
+
+    log_info("Packet bus system initialized (shared ingest %s)",
+             packet_bus_is_enabled() ? "enabled" : "disabled");
+}
+
+/**
+ * Stop all ingest threads and wait for them to exit
+ */
+void shutdown_packet_bus_system(void) {
+    pthread_mutex_lock(&g_buses_mutex);
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        if (g_buses[i]) {
+            atomic_store(&g_buses[i]->running, 0);
+        }
+    }
+    pthread_mutex_unlock(&g_buses_mutex);
+
+    // Reads time out after a few seconds, so wait a bit longer than that
+    for (int i = 0; i < 100 && atomic_load(&g_active_ingests) > 0; i++) {
+        usleep(100000);
+    }
+
+    int remaining = atomic_load(&g_active_ingests);
+    if (remaining > 0) {
+        log_warn("%d shared ingest threads still running at shutdown", remaining);
+    }
+
+    log_info("Packet bus system shut down");
+}
+
+/**
+ * Check whether shared ingest is enabled in the configuration
+ */
+bool packet_bus_is_enabled(void) {
+    return g_config.shared_ingest_enabled;
+}
+
+/**
+ * Subscribe to the shared ingest of a URL
+ */
+packet_bus_subscriber_t *packet_bus_subscribe(const char *stream_name, const char *url, int protocol,
+                                              const char *consumer_name, int flags, int queue_size) {
+    if (!stream_name || !url || url[0] == '\0') {
+        log_error("Invalid parameters for packet_bus_subscribe");
+        return NULL;
+    }
+
+    if (queue_size <= 0) {
+        queue_size = PACKET_BUS_DEFAULT_QUEUE_SIZE;
+    }
+
+    packet_bus_subscriber_t *sub = calloc(1, sizeof(packet_bus_subscriber_t));
+    if (!sub) {
+        log_error("Failed to allocate packet bus subscriber for stream %s", stream_name);
+        return NULL;
+    }
+    sub->queue = calloc(queue_size, sizeof(AVPacket *));
+    if (!sub->queue) {
+        log_error("Failed to allocate packet bus queue for stream %s", stream_name);
+        free(sub);
+        return NULL;
+    }
+    sub->queue_size = queue_size;
+    sub->flags = flags;
+    sub->need_keyframe = true;
+    snprintf(sub->name, sizeof(sub->name), "%s", consumer_name ? consumer_name : "consumer");
+    pthread_cond_init(&sub->cond, NULL);
+
+    pthread_mutex_lock(&g_buses_mutex);
+
+    packet_bus_t *bus = NULL;
+    int free_slot = -1;
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        if (g_buses[i] && strcmp(g_buses[i]->url, url) == 0 && atomic_load(&g_buses[i]->running)) {
+            bus = g_buses[i];
+            break;
+        }
+        if (!g_buses[i] && free_slot < 0) {
+            free_slot = i;
+        }
+    }
+
+    if (!bus) {
+        if (free_slot < 0) {
+            pthread_mutex_unlock(&g_buses_mutex);
+            log_error("No free packet bus slot for stream %s", stream_name);
+            goto fail;
+        }
+
+        bus = calloc(1, sizeof(packet_bus_t));
+        if (!bus) {
+            pthread_mutex_unlock(&g_buses_mutex);
+            log_error("Failed to allocate packet bus for stream %s", stream_name);
+            goto fail;
+        }
+        snprintf(bus->stream_name, sizeof(bus->stream_name), "%s", stream_name);
+        snprintf(bus->url, sizeof(bus->url), "%s", url);
+        bus->protocol = protocol;
+        bus->video_stream_idx = -1;
+        bus->refs = 1;  // Held by the demux thread
+        atomic_store(&bus->running, 1);
+        pthread_mutex_init(&bus->mutex, NULL);
+        pthread_cond_init(&bus->info_cond, NULL);
+
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        atomic_fetch_add(&g_active_ingests, 1);
+        if (pthread_create(&bus->thread, &attr, packet_bus_thread, bus) != 0) {
+            pthread_attr_destroy(&attr);
+            atomic_fetch_sub(&g_active_ingests, 1);
+            pthread_mutex_unlock(&g_buses_mutex);
+            log_error("Failed to start shared ingest thread for stream %s", stream_name);
+            pthread_cond_destroy(&bus->info_cond);
+            pthread_mutex_destroy(&bus->mutex);
+            free(bus);
+            goto fail;
+        }
+        pthread_attr_destroy(&attr);
+
+        g_buses[free_slot] = bus;
+        log_info("Started shared ingest for stream %s", stream_name);
+    }
+
+    pthread_mutex_lock(&bus->mutex);
+    if (bus->subscriber_count >= PACKET_BUS_MAX_SUBSCRIBERS) {
+        pthread_mutex_unlock(&bus->mutex);
+        pthread_mutex_unlock(&g_buses_mutex);
+        log_error("Too many packet bus subscribers for stream %s", stream_name);
+        goto fail;
+    }
+    sub->bus = bus;
+    bus->subscribers[bus->subscriber_count++] = sub;
+    bus->refs++;
+    int count = bus->subscriber_count;
+    pthread_mutex_unlock(&bus->mutex);
+
+    pthread_mutex_unlock(&g_buses_mutex);
+
+    log_info("Consumer '%s' subscribed to shared ingest of stream %s (%d subscribers)",
+             sub->name, stream_name, count);
+    return sub;
+
+fail:
+    pthread_cond_destroy(&sub->cond);
+    free(sub->queue);
+    free(sub);
+    return NULL;
+}
+
+/**
+ * Detach a subscriber
+ */
+void packet_bus_unsubscribe(packet_bus_subscriber_t *sub) {
+    if (!sub) {
+        return;
+    }
+
+    packet_bus_t *bus = sub->bus;
+
+    pthread_mutex_lock(&g_buses_mutex);
+    pthread_mutex_lock(&bus->mutex);
+
+    for (int i = 0; i < bus->subscriber_count; i++) {
+        if (bus->subscribers[i] == sub) {
+            bus->subscribers[i] = bus->subscribers[bus->subscriber_count - 1];
+            bus->subscribers[bus->subscriber_count - 1] = NULL;
+            bus->subscriber_count--;
+            break;
+        }
+    }
+
+    if (bus->subscriber_count == 0 && atomic_load(&bus->running)) {
+        log_info("Last consumer left shared ingest of stream %s, stopping it", bus->stream_name);
+        atomic_store(&bus->running, 0);
+        for (int i = 0; i < MAX_STREAMS; i++) {
+            if (g_buses[i] == bus) {
+                g_buses[i] = NULL;
+                break;
+            }
+        }
+    }
+
+    log_info("Consumer '%s' unsubscribed from shared ingest of stream %s", sub->name, bus->stream_name);
+    subscriber_clear_locked(sub);
+    pthread_mutex_unlock(&g_buses_mutex);
+    bus_release_locked(bus);
+
+    pthread_cond_destroy(&sub->cond);
+    free(sub->queue);
+    free(sub);
+}
+
+/**
+ * Build a stand-alone format context describing the ingest streams
+ */
+int packet_bus_copy_streams(packet_bus_subscriber_t *sub, AVFormatContext **ctx, int timeout_ms) {
+    if (!sub || !ctx) {
+        return AVERROR(EINVAL);
+    }
+
+    packet_bus_t *bus = sub->bus;
+    struct timespec deadline;
+    deadline_from_now(&deadline, timeout_ms);
+
+    pthread_mutex_lock(&bus->mutex);
+    while (!bus->connected && !bus->stopped) {
+        if (pthread_cond_timedwait(&bus->info_cond, &bus->mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+
+    if (bus->stopped) {
+        pthread_mutex_unlock(&bus->mutex);
+        return AVERROR_EOF;
+    }
+    if (!bus->connected) {
+        pthread_mutex_unlock(&bus->mutex);
+        return AVERROR(EAGAIN);
+    }
+
+    AVFormatContext *copy = avformat_alloc_context();
+    if (!copy) {
+        pthread_mutex_unlock(&bus->mutex);
+        return AVERROR(ENOMEM);
+    }
+
+    for (int i = 0; i < bus->nb_streams; i++) {
+        AVStream *st = avformat_new_stream(copy, NULL);
+        if (!st || !bus->codecpar[i] || avcodec_parameters_copy(st->codecpar, bus->codecpar[i]) < 0) {
+            pthread_mutex_unlock(&bus->mutex);
+            avformat_free_context(copy);
+            return AVERROR(ENOMEM);
+        }
+        st->time_base = bus->time_base[i];
+        st->avg_frame_rate = bus->avg_frame_rate[i];
+        st->r_frame_rate = bus->r_frame_rate[i];
+    }
+
+    sub->generation = bus->generation;
+    pthread_mutex_unlock(&bus->mutex);
+
+    *ctx = copy;
+    return 0;
+}
+
+/**
+ * Read the next packet for this subscriber
+ */
+int packet_bus_read(packet_bus_subscriber_t *sub, AVPacket *pkt, int timeout_ms) {
+    if (!sub || !pkt) {
+        return AVERROR(EINVAL);
+    }
+
+    packet_bus_t *bus = sub->bus;
+    struct timespec deadline;
+    deadline_from_now(&deadline, timeout_ms);
+
+    pthread_mutex_lock(&bus->mutex);
+    while (1) {
+        if (sub->generation != 0 && sub->generation != bus->generation) {
+            // The stream copy the consumer holds is stale
+            sub->generation = 0;
+            pthread_mutex_unlock(&bus->mutex);
+            return PACKET_BUS_ERR_RESET;
+        }
+
+        if (sub->count > 0) {
+            AVPacket *queued = sub->queue[sub->head];
+            sub->queue[sub->head] = NULL;
+            sub->head = (sub->head + 1) % sub->queue_size;
+            sub->count--;
+            sub->delivered++;
+            pthread_mutex_unlock(&bus->mutex);
+
+            av_packet_move_ref(pkt, queued);
+            av_packet_free(&queued);
+            return 0;
+        }
+
+        if (bus->stopped) {
+            pthread_mutex_unlock(&bus->mutex);
+            return AVERROR_EOF;
+        }
+
+        if (pthread_cond_timedwait(&sub->cond, &bus->mutex, &deadline) == ETIMEDOUT) {
+            pthread_mutex_unlock(&bus->mutex);
+            return AVERROR(EAGAIN);
+        }
+    }
+}
+
+/**
+ * Discard everything queued for a subscriber
+ */
+void packet_bus_flush(packet_bus_subscriber_t *sub) {
+    if (!sub) {
+        return;
+    }
+
+    pthread_mutex_lock(&sub->bus->mutex);
+    subscriber_clear_locked(sub);
+    sub->need_keyframe = true;
+    pthread_mutex_unlock(&sub->bus->mutex);
+}
+
+/**
+ * Get subscriber statistics
+ */
+int packet_bus_get_subscriber_stats(packet_bus_subscriber_t *sub, packet_bus_subscriber_stats_t *stats) {
+    if (!sub || !stats) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&sub->bus->mutex);
+    stats->packets_delivered = sub->delivered;
+    stats->packets_dropped = sub->dropped;
+    stats->queued = sub->count;
+    stats->queue_size = sub->queue_size;
+    pthread_mutex_unlock(&sub->bus->mutex);
+
+    return 0;
+}
+
+/**
+ * Get the number of active ingest threads
+ */
+int packet_bus_active_ingest_count(void) {
+    return atomic_load(&g_active_ingests);
+}
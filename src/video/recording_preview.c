@@ -0,0 +1,410 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+#include <cJSON.h>
+
+#include "core/logger.h"
+#include "video/recording_preview.h"
+#include "video/jpeg_encoder.h"
+
+struct recording_preview {
+    AVCodecContext *decoder;            // NULL when only the keyframe index is written
+    struct SwsContext *sws_ctx;
+    AVFrame *frame;
+    AVRational time_base;
+    int64_t first_pts;
+    int64_t interval_pts;               // Sampling interval in time_base units
+    int64_t next_sample_pts;
+    int tile_width;
+    int tile_height;                    // 0 until the first frame is decoded
+    int tile_count;
+    uint8_t *tiles[RECORDING_PREVIEW_MAX_TILES];    // Packed RGB24 thumbnails
+    int64_t tile_pts[RECORDING_PREVIEW_MAX_TILES];
+};
+
+recording_preview_t *recording_preview_begin(const AVCodecParameters *codecpar, AVRational time_base,
+                                             int interval) {
+    if (!codecpar || time_base.num <= 0 || time_base.den <= 0) {
+        return NULL;
+    }
+
+    recording_preview_t *preview = calloc(1, sizeof(recording_preview_t));
+    if (!preview) {
+        log_error("Failed to allocate recording preview");
+        return NULL;
+    }
+
+    preview->time_base = time_base;
+    preview->first_pts = AV_NOPTS_VALUE;
+    preview->tile_width = RECORDING_PREVIEW_TILE_WIDTH;
+
+    if (interval <= 0) {
+        return preview;
+    }
+
+    preview->interval_pts = av_rescale_q(interval, (AVRational){1, 1}, time_base);
+
+    const AVCodec *codec = avcodec_find_decoder(codecpar->codec_id);
+    if (!codec) {
+        log_warn("No decoder for %s, recording previews without thumbnails",
+                 avcodec_get_name(codecpar->codec_id));
+        return preview;
+    }
+
+    AVCodecContext *decoder = avcodec_alloc_context3(codec);
+    preview->frame = av_frame_alloc();
+    if (!decoder || !preview->frame || avcodec_parameters_to_context(decoder, codecpar) < 0) {
+        log_warn("Failed to set up thumbnail decoder, recording previews without thumbnails");
+        avcodec_free_context(&decoder);
+        return preview;
+    }
+
+    // Only isolated keyframes are decoded, keep it cheap and frame-exact
+    decoder->thread_count = 1;
+    decoder->flags |= AV_CODEC_FLAG_LOW_DELAY;
+
+    if (avcodec_open2(decoder, codec, NULL) < 0) {
+        log_warn("Failed to open thumbnail decoder, recording previews without thumbnails");
+        avcodec_free_context(&decoder);
+        return preview;
+    }
+
+    preview->decoder = decoder;
+    return preview;
+}
+
+/**
+ * Scale a decoded frame into a new thumbnail
+ */
+static int store_tile(recording_preview_t *preview, const AVFrame *frame, int64_t pts) {
+    if (frame->width <= 0 || frame->height <= 0) {
+        return -1;
+    }
+
+    // Thumbnail height follows the first frame's aspect ratio, rounded to even for the JPEG encoder
+    if (preview->tile_height == 0) {
+        int height = (int)((int64_t)preview->tile_width * frame->height / frame->width);
+        preview->tile_height = height < 2 ? 2 : height & ~1;
+    }
+
+    preview->sws_ctx = sws_getCachedContext(preview->sws_ctx, frame->width, frame->height, frame->format,
+                                            preview->tile_width, preview->tile_height, AV_PIX_FMT_RGB24,
+                                            SWS_BILINEAR, NULL, NULL, NULL);
+    if (!preview->sws_ctx) {
+        return -1;
+    }
+
+    uint8_t *tile = malloc((size_t)preview->tile_width * preview->tile_height * 3);
+    if (!tile) {
+        return -1;
+    }
+
+    uint8_t *dst_data[4] = { tile, NULL, NULL, NULL };
+    int dst_linesize[4] = { preview->tile_width * 3, 0, 0, 0 };
+    sws_scale(preview->sws_ctx, (const uint8_t * const *)frame->data, frame->linesize, 0, frame->height,
+              dst_data, dst_linesize);
+
+    preview->tiles[preview->tile_count] = tile;
+    preview->tile_pts[preview->tile_count] = pts;
+    preview->tile_count++;
+    return 0;
+}
+
+/**
+ * Keep every other thumbnail and sample half as often from now on
+ */
+static void thin_tiles(recording_preview_t *preview) {
+    int kept = 0;
+    for (int i = 0; i < preview->tile_count; i++) {
+        if (i % 2 == 0) {
+            preview->tiles[kept] = preview->tiles[i];
+            preview->tile_pts[kept] = preview->tile_pts[i];
+            kept++;
+        } else {
+            free(preview->tiles[i]);
+        }
+    }
+    preview->tile_count = kept;
+    preview->interval_pts *= 2;
+}
+
+void recording_preview_add_keyframe(recording_preview_t *preview, const AVPacket *pkt, int64_t pts) {
+    if (!preview || !pkt || pts == AV_NOPTS_VALUE) {
+        return;
+    }
+
+    if (preview->first_pts == AV_NOPTS_VALUE) {
+        preview->first_pts = pts;
+        preview->next_sample_pts = pts;
+    }
+
+    if (!preview->decoder || pts < preview->next_sample_pts) {
+        return;
+    }
+
+    // A keyframe decodes on its own: send it, drain the decoder and reset it for the next one
+    bool decoded = false;
+    if (avcodec_send_packet(preview->decoder, pkt) >= 0 && avcodec_send_packet(preview->decoder, NULL) >= 0) {
+        while (avcodec_receive_frame(preview->decoder, preview->frame) >= 0) {
+            if (!decoded) {
+                if (preview->tile_count == RECORDING_PREVIEW_MAX_TILES) {
+                    thin_tiles(preview);
+                }
+                decoded = store_tile(preview, preview->frame, pts) == 0;
+            }
+            av_frame_unref(preview->frame);
+        }
+    }
+    avcodec_flush_buffers(preview->decoder);
+
+    if (decoded) {
+        preview->next_sample_pts = pts + preview->interval_pts;
+    }
+}
+
+void recording_preview_free(recording_preview_t *preview) {
+    if (!preview) {
+        return;
+    }
+
+    for (int i = 0; i < preview->tile_count; i++) {
+        free(preview->tiles[i]);
+    }
+    if (preview->decoder) {
+        avcodec_free_context(&preview->decoder);
+    }
+    if (preview->sws_ctx) {
+        sws_freeContext(preview->sws_ctx);
+    }
+    if (preview->frame) {
+        av_frame_free(&preview->frame);
+    }
+    free(preview);
+}
+
+int recording_preview_path(const char *recording_path, const char *suffix, char *path, size_t path_size) {
+    if (!recording_path || !suffix || !path || path_size == 0) {
+        return -1;
+    }
+
+    size_t base_len = strlen(recording_path);
+    const char *ext = strrchr(recording_path, '.');
+    const char *slash = strrchr(recording_path, '/');
+    if (ext && (!slash || ext > slash) && strcmp(ext, ".mp4") == 0) {
+        base_len = (size_t)(ext - recording_path);
+    }
+
+    int written = snprintf(path, path_size, "%.*s%s", (int)base_len, recording_path, suffix);
+    return (written < 0 || (size_t)written >= path_size) ? -1 : 0;
+}
+
+void recording_preview_remove(const char *recording_path) {
+    static const char *suffixes[] = { ".preview.json", ".sprite.jpg" };
+    char path[1024];
+
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        if (recording_preview_path(recording_path, suffixes[i], path, sizeof(path)) == 0 &&
+            unlink(path) != 0 && errno != ENOENT) {
+            log_warn("Failed to delete preview file %s: %s", path, strerror(errno));
+        }
+    }
+}
+
+/**
+ * Write a buffer to a file through a temporary file, so readers never see a partial preview
+ */
+static int write_file_atomic(const char *path, const void *data, size_t size) {
+    char tmp_path[1024];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) {
+        return -1;
+    }
+
+    FILE *file = fopen(tmp_path, "wb");
+    if (!file) {
+        log_error("Failed to create preview file %s: %s", tmp_path, strerror(errno));
+        return -1;
+    }
+
+    bool ok = fwrite(data, 1, size, file) == size;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tmp_path, path) != 0) {
+        log_error("Failed to write preview file %s: %s", path, strerror(errno));
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Read the keyframe positions of the finished file
+ *
+ * The offsets are only final once the trailer is written (faststart moves
+ * the sample data), so they are taken from the demuxer's index of the
+ * closed file.  Opening an MP4 parses the moov box only.
+ */
+static cJSON *read_keyframe_index(const char *recording_path, int64_t *duration_ms) {
+    AVFormatContext *fmt_ctx = NULL;
+    if (avformat_open_input(&fmt_ctx, recording_path, NULL, NULL) < 0) {
+        log_error("Failed to open %s for its keyframe index", recording_path);
+        return NULL;
+    }
+
+    AVStream *stream = NULL;
+    for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++) {
+        if (fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            stream = fmt_ctx->streams[i];
+            break;
+        }
+    }
+
+    cJSON *keyframes = stream ? cJSON_CreateArray() : NULL;
+    if (keyframes) {
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+        int entry_count = avformat_index_get_entries_count(stream);
+#else
+        int entry_count = stream->nb_index_entries;
+#endif
+        int64_t first_timestamp = AV_NOPTS_VALUE;
+
+        for (int i = 0; i < entry_count; i++) {
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+            const AVIndexEntry *entry = avformat_index_get_entry(stream, i);
+#else
+            const AVIndexEntry *entry = &stream->index_entries[i];
+#endif
+            if (!entry || !(entry->flags & AVINDEX_KEYFRAME)) {
+                continue;
+            }
+            if (first_timestamp == AV_NOPTS_VALUE) {
+                first_timestamp = entry->timestamp;
+            }
+
+            cJSON *item = cJSON_CreateArray();
+            if (!item) {
+                break;
+            }
+            cJSON_AddItemToArray(item, cJSON_CreateNumber((double)av_rescale_q(
+                entry->timestamp - first_timestamp, stream->time_base, (AVRational){1, 1000})));
+            cJSON_AddItemToArray(item, cJSON_CreateNumber((double)entry->pos));
+            cJSON_AddItemToArray(item, cJSON_CreateNumber(entry->size));
+            cJSON_AddItemToArray(keyframes, item);
+        }
+    }
+
+    *duration_ms = fmt_ctx->duration > 0 ? fmt_ctx->duration / 1000 : 0;
+    avformat_close_input(&fmt_ctx);
+    return keyframes;
+}
+
+/**
+ * Tile the thumbnails into one sprite sheet and write it as JPEG
+ */
+static int write_sprite(const recording_preview_t *preview, const char *sprite_path, int *columns) {
+    int cols = preview->tile_count < RECORDING_PREVIEW_COLUMNS ? preview->tile_count : RECORDING_PREVIEW_COLUMNS;
+    int rows = (preview->tile_count + cols - 1) / cols;
+    int width = cols * preview->tile_width;
+    int height = rows * preview->tile_height;
+    size_t tile_stride = (size_t)preview->tile_width * 3;
+    size_t sheet_stride = (size_t)width * 3;
+
+    // Unused cells of the last row stay black
+    uint8_t *sheet = calloc((size_t)height, sheet_stride);
+    if (!sheet) {
+        log_error("Failed to allocate %dx%d sprite sheet", width, height);
+        return -1;
+    }
+
+    for (int i = 0; i < preview->tile_count; i++) {
+        uint8_t *dst = sheet + (size_t)(i / cols) * preview->tile_height * sheet_stride +
+                       (size_t)(i % cols) * tile_stride;
+        for (int y = 0; y < preview->tile_height; y++) {
+            memcpy(dst + y * sheet_stride, preview->tiles[i] + y * tile_stride, tile_stride);
+        }
+    }
+
+    unsigned char *jpeg = NULL;
+    size_t jpeg_size = 0;
+    int ret = jpeg_encode_frame(sheet, width, height, 3, RECORDING_PREVIEW_JPEG_QUALITY, &jpeg, &jpeg_size);
+    free(sheet);
+    if (ret != 0) {
+        return -1;
+    }
+
+    ret = write_file_atomic(sprite_path, jpeg, jpeg_size);
+    free(jpeg);
+
+    *columns = cols;
+    return ret;
+}
+
+int recording_preview_finish(recording_preview_t *preview, const char *recording_path) {
+    if (!preview || !recording_path) {
+        recording_preview_free(preview);
+        return -1;
+    }
+
+    char index_path[1024];
+    char sprite_path[1024];
+    if (recording_preview_path(recording_path, ".preview.json", index_path, sizeof(index_path)) != 0 ||
+        recording_preview_path(recording_path, ".sprite.jpg", sprite_path, sizeof(sprite_path)) != 0) {
+        log_error("Preview path too long for %s", recording_path);
+        recording_preview_free(preview);
+        return -1;
+    }
+
+    int64_t duration_ms = 0;
+    cJSON *keyframes = read_keyframe_index(recording_path, &duration_ms);
+    cJSON *root = cJSON_CreateObject();
+    if (!keyframes || !root) {
+        cJSON_Delete(keyframes);
+        cJSON_Delete(root);
+        recording_preview_free(preview);
+        return -1;
+    }
+
+    cJSON_AddNumberToObject(root, "version", 1);
+    cJSON_AddNumberToObject(root, "duration_ms", (double)duration_ms);
+    // Each entry is [time in ms from the segment start, byte offset, size]
+    cJSON_AddItemToObject(root, "keyframes", keyframes);
+
+    int columns = 0;
+    if (preview->tile_count > 0 && write_sprite(preview, sprite_path, &columns) == 0) {
+        cJSON *sprite = cJSON_AddObjectToObject(root, "sprite");
+        cJSON *tiles = cJSON_CreateArray();
+        if (sprite && tiles) {
+            cJSON_AddNumberToObject(sprite, "tile_width", preview->tile_width);
+            cJSON_AddNumberToObject(sprite, "tile_height", preview->tile_height);
+            cJSON_AddNumberToObject(sprite, "columns", columns);
+            for (int i = 0; i < preview->tile_count; i++) {
+                cJSON_AddItemToArray(tiles, cJSON_CreateNumber((double)av_rescale_q(
+                    preview->tile_pts[i] - preview->first_pts, preview->time_base, (AVRational){1, 1000})));
+            }
+            // Time in ms from the segment start of each tile, in sheet order
+            cJSON_AddItemToObject(sprite, "tiles", tiles);
+        } else {
+            cJSON_Delete(tiles);
+        }
+    }
+
+    int ret = -1;
+    char *json = cJSON_PrintUnformatted(root);
+    if (json) {
+        ret = write_file_atomic(index_path, json, strlen(json));
+        free(json);
+    }
+
+    log_debug("Wrote recording preview for %s (%d keyframes, %d thumbnails)", recording_path,
+              cJSON_GetArraySize(keyframes), preview->tile_count);
+
+    cJSON_Delete(root);
+    recording_preview_free(preview);
+    return ret;
+}
@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libavutil/dict.h>
+#include <libavutil/mathematics.h>
+
+#include "core/logger.h"
+#include "video/segment_remux.h"
+
+// Output stream slots: video and audio
+#define REMUX_STREAM_COUNT 2
+
+typedef struct {
+    AVStream *stream;
+    enum AVCodecID codec_id;
+    int64_t last_dts;            // In the output stream's time base
+    bool has_dts;
+} remux_output_t;
+
+static const enum AVMediaType remux_media_types[REMUX_STREAM_COUNT] = {
+    AVMEDIA_TYPE_VIDEO, AVMEDIA_TYPE_AUDIO
+};
+
+/**
+ * Open a segment for reading with generated timestamps
+ */
+static AVFormatContext *open_segment(const char *path) {
+    AVFormatContext *ctx = NULL;
+    AVDictionary *opts = NULL;
+    av_dict_set(&opts, "fflags", "+genpts", 0);
+
+    int ret = avformat_open_input(&ctx, path, NULL, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        log_warn("Failed to open segment %s for remux: %s", path, errbuf);
+        return NULL;
+    }
+
+    ret = avformat_find_stream_info(ctx, NULL);
+    if (ret < 0) {
+        log_warn("Failed to read stream info of segment %s", path);
+        avformat_close_input(&ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+/**
+ * Find the input stream for each output slot, -1 when absent
+ */
+static void map_segment_streams(AVFormatContext *in_ctx, int map[REMUX_STREAM_COUNT]) {
+    for (int i = 0; i < REMUX_STREAM_COUNT; i++) {
+        map[i] = av_find_best_stream(in_ctx, remux_media_types[i], -1, -1, NULL, 0);
+        if (map[i] < 0) {
+            map[i] = -1;
+        }
+    }
+}
+
+/**
+ * Create the output streams from the first readable segment
+ */
+static int create_output_streams(AVFormatContext *out_ctx, AVFormatContext *in_ctx,
+                                 const int map[REMUX_STREAM_COUNT],
+                                 remux_output_t outputs[REMUX_STREAM_COUNT]) {
+    int created = 0;
+
+    for (int i = 0; i < REMUX_STREAM_COUNT; i++) {
+        outputs[i].stream = NULL;
+        outputs[i].codec_id = AV_CODEC_ID_NONE;
+        outputs[i].has_dts = false;
+        if (map[i] < 0) {
+            continue;
+        }
+
+        AVStream *in_stream = in_ctx->streams[map[i]];
+        AVStream *out_stream = avformat_new_stream(out_ctx, NULL);
+        if (!out_stream) {
+            return -1;
+        }
+
+        if (avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar) < 0) {
+            return -1;
+        }
+        // Let the MP4 muxer pick its own tag for the codec
+        out_stream->codecpar->codec_tag = 0;
+        out_stream->time_base = in_stream->time_base;
+
+        outputs[i].stream = out_stream;
+        outputs[i].codec_id = in_stream->codecpar->codec_id;
+        created++;
+    }
+
+    return created > 0 ? 0 : -1;
+}
+
+/**
+ * Copy one segment's packets into the output
+ *
+ * @param offset Time added to the segment's timestamps, in AV_TIME_BASE units
+ * @param end Advanced to the end of the latest packet written, in AV_TIME_BASE units
+ * @return 0 on success, -1 on a write error
+ */
+static int copy_segment_packets(AVFormatContext *in_ctx, AVFormatContext *out_ctx,
+                                const int map[REMUX_STREAM_COUNT],
+                                remux_output_t outputs[REMUX_STREAM_COUNT],
+                                int64_t offset, int64_t *end) {
+    AVPacket *pkt = av_packet_alloc();
+    if (!pkt) {
+        return -1;
+    }
+
+    int result = 0;
+    while (av_read_frame(in_ctx, pkt) >= 0) {
+        int slot = -1;
+        for (int i = 0; i < REMUX_STREAM_COUNT; i++) {
+            if (map[i] == pkt->stream_index && outputs[i].stream) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0 || (pkt->dts == AV_NOPTS_VALUE && pkt->pts == AV_NOPTS_VALUE)) {
+            av_packet_unref(pkt);
+            continue;
+        }
+
+        remux_output_t *out = &outputs[slot];
+        AVRational in_tb = in_ctx->streams[pkt->stream_index]->time_base;
+        AVRational out_tb = out->stream->time_base;
+        int64_t shift = av_rescale_q(offset, AV_TIME_BASE_Q, out_tb);
+
+        if (pkt->dts == AV_NOPTS_VALUE) {
+            pkt->dts = pkt->pts;
+        }
+        if (pkt->pts == AV_NOPTS_VALUE) {
+            pkt->pts = pkt->dts;
+        }
+
+        int64_t dts = av_rescale_q(pkt->dts, in_tb, out_tb) + shift;
+        int64_t pts = av_rescale_q(pkt->pts, in_tb, out_tb) + shift;
+        int64_t duration = av_rescale_q(pkt->duration, in_tb, out_tb);
+
+        // The muxer rejects non-increasing timestamps
+        if (out->has_dts && dts <= out->last_dts) {
+            dts = out->last_dts + 1;
+        }
+        if (pts < dts) {
+            pts = dts;
+        }
+        out->last_dts = dts;
+        out->has_dts = true;
+
+        int64_t packet_end = av_rescale_q(pts + (duration > 0 ? duration : 0), out_tb, AV_TIME_BASE_Q);
+        if (packet_end > *end) {
+            *end = packet_end;
+        }
+
+        pkt->dts = dts;
+        pkt->pts = pts;
+        pkt->duration = duration;
+        pkt->stream_index = out->stream->index;
+        pkt->pos = -1;
+
+        int ret = av_interleaved_write_frame(out_ctx, pkt);
+        av_packet_unref(pkt);
+        if (ret < 0) {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            log_error("Failed to write remuxed packet: %s", errbuf);
+            result = -1;
+            break;
+        }
+    }
+
+    av_packet_free(&pkt);
+    return result;
+}
+
+int remux_segments_to_mp4(const char *const *segment_paths, int count,
+                          const char *output_path, double *duration) {
+    if (!segment_paths || count <= 0 || !output_path) {
+        return -1;
+    }
+
+    if (duration) {
+        *duration = 0.0;
+    }
+
+    AVFormatContext *out_ctx = NULL;
+    remux_output_t outputs[REMUX_STREAM_COUNT];
+    memset(outputs, 0, sizeof(outputs));
+    bool file_opened = false;
+    bool header_written = false;
+    int written = 0;
+    int64_t end = 0;
+    int result = -1;
+
+    for (int s = 0; s < count; s++) {
+        AVFormatContext *in_ctx = open_segment(segment_paths[s]);
+        if (!in_ctx) {
+            continue;
+        }
+
+        int map[REMUX_STREAM_COUNT];
+        map_segment_streams(in_ctx, map);
+
+        if (!out_ctx) {
+            int ret = avformat_alloc_output_context2(&out_ctx, NULL, "mp4", output_path);
+            if (ret < 0 || !out_ctx) {
+                log_error("Failed to create MP4 output context for %s", output_path);
+                avformat_close_input(&in_ctx);
+                goto cleanup;
+            }
+
+            if (create_output_streams(out_ctx, in_ctx, map, outputs) != 0) {
+                log_error("Failed to create MP4 streams for %s", output_path);
+                avformat_close_input(&in_ctx);
+                goto cleanup;
+            }
+
+            ret = avio_open(&out_ctx->pb, output_path, AVIO_FLAG_WRITE);
+            if (ret < 0) {
+                char errbuf[AV_ERROR_MAX_STRING_SIZE];
+                av_strerror(ret, errbuf, sizeof(errbuf));
+                log_error("Failed to open %s for writing: %s", output_path, errbuf);
+                avformat_close_input(&in_ctx);
+                goto cleanup;
+            }
+            file_opened = true;
+
+            // Same output as "-movflags +faststart -avoid_negative_ts make_zero"
+            AVDictionary *opts = NULL;
+            av_dict_set(&opts, "movflags", "+faststart", 0);
+            out_ctx->avoid_negative_ts = AVFMT_AVOID_NEG_TS_MAKE_ZERO;
+
+            ret = avformat_write_header(out_ctx, &opts);
+            av_dict_free(&opts);
+            if (ret < 0) {
+                char errbuf[AV_ERROR_MAX_STRING_SIZE];
+                av_strerror(ret, errbuf, sizeof(errbuf));
+                log_error("Failed to write MP4 header for %s: %s", output_path, errbuf);
+                avformat_close_input(&in_ctx);
+                goto cleanup;
+            }
+            header_written = true;
+        } else {
+            // Drop streams whose codec changed, the MP4 track cannot switch codecs
+            bool usable = false;
+            for (int i = 0; i < REMUX_STREAM_COUNT; i++) {
+                if (map[i] >= 0 &&
+                    (!outputs[i].stream ||
+                     in_ctx->streams[map[i]]->codecpar->codec_id != outputs[i].codec_id)) {
+                    map[i] = -1;
+                }
+                usable = usable || map[i] >= 0;
+            }
+            if (!usable) {
+                log_warn("Skipping segment %s: streams do not match the first segment",
+                         segment_paths[s]);
+                avformat_close_input(&in_ctx);
+                continue;
+            }
+        }
+
+        // Start this segment where the previous one ended
+        int64_t start = in_ctx->start_time != AV_NOPTS_VALUE ? in_ctx->start_time : 0;
+        int ret = copy_segment_packets(in_ctx, out_ctx, map, outputs, end - start, &end);
+        avformat_close_input(&in_ctx);
+        if (ret != 0) {
+            goto cleanup;
+        }
+
+        written++;
+    }
+
+    if (!header_written) {
+        log_error("None of the %d segments could be read for %s", count, output_path);
+        goto cleanup;
+    }
+
+    if (av_write_trailer(out_ctx) < 0) {
+        log_error("Failed to write MP4 trailer for %s", output_path);
+        goto cleanup;
+    }
+
+    if (duration) {
+        *duration = (double)end / AV_TIME_BASE;
+    }
+    result = written;
+
+cleanup:
+    if (out_ctx) {
+        if (out_ctx->pb) {
+            avio_closep(&out_ctx->pb);
+        }
+        avformat_free_context(out_ctx);
+    }
+    if (result < 0 && file_opened) {
+        remove(output_path);
+    }
+
+    return result;
+}
@@ -62,6 +62,7 @@ typedef struct {
     char type[16];               // Model type (sod)
     sod_model_t sod;             // SOD model
     char path[MAX_PATH_LENGTH];  // Path to the model file (for reference)
+    sod_img input;               // CHW float input image, reused across frames of the same size
 } model_t;
 
 /**
@@ -179,12 +180,38 @@ void cleanup_sod_model(detection_model_t model) {
         }
     }
 
+    if (m->input.data) {
+        sod_free_image(m->input);
+    }
+
     // Free the model structure
     free(m);
 
     log_info("SOD model cleanup complete");
 }
 
+/**
+ * Get the input size of a SOD CNN model
+ */
+int get_sod_model_input_size(detection_model_t model, int *width, int *height) {
+    if (!model || !width || !height) {
+        return -1;
+    }
+
+    model_t *m = (model_t *)model;
+    if (strcmp(m->type, MODEL_TYPE_SOD) != 0 || !m->sod.model) {
+        return -1;
+    }
+
+    int channels = 0;
+    if (sod_cnn_get_network_size(m->sod.model, width, height, &channels) != 0 ||
+        *width <= 0 || *height <= 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
 /**
  * Check if SOD is available
  */
@@ -272,6 +299,7 @@ detection_model_t load_sod_model(const char *model_path, float threshold) {
     strncpy(model->type, MODEL_TYPE_SOD, sizeof(model->type) - 1);
     model->sod.model = sod_model;
     model->sod.threshold = threshold;
+    memset(&model->input, 0, sizeof(model->input));
 
     // Store the model path in the model structure
     strncpy(model->path, model_path, MAX_PATH_LENGTH - 1);
@@ -310,86 +338,34 @@ int detect_with_sod_model(detection_model_t model, const unsigned char *frame_da
         return -1;
     }
 
-    // Step 1: Create a SOD image
-    log_info("Step 1: Creating SOD image from frame data (dimensions: %dx%d, channels: %d)",
-            width, height, channels);
-
-    sod_img img = sod_make_image(width, height, channels);
-    if (!img.data) {
-        log_error("Failed to create SOD image");
-        return -1;
-    }
-
-    // Step 2: Copy the frame data to the SOD image
-    log_info("Step 2: Copying frame data to SOD image");
-
-    // Calculate the total size of the image data with overflow check
-    size_t pixel_count = (size_t)width * (size_t)height;
-    if (pixel_count / width != height) { // Check for overflow
-        log_error("Integer overflow in image dimensions: width=%d, height=%d", width, height);
-        sod_free_image(img);
-        return -1;
-    }
-
-    size_t total_size = pixel_count * channels;
-    if (total_size / pixel_count != channels) { // Check for overflow
-        log_error("Integer overflow in total size calculation: width=%d, height=%d, channels=%d",
-                 width, height, channels);
-        sod_free_image(img);
-        return -1;
-    }
-
-    // Allocate a temporary buffer to store the converted data
-    float *temp_buffer = (float *)malloc(total_size * sizeof(float));
-    if (!temp_buffer) {
-        log_error("Failed to allocate temporary buffer for image data conversion (size=%zu bytes)",
-                 total_size * sizeof(float));
-        sod_free_image(img);
-        return -1;
+    // Step 1: Reuse the model's input image, reallocating only when the frame size changes
+    if (!m->input.data || m->input.w != width || m->input.h != height || m->input.c != channels) {
+        log_info("Step 1: Creating SOD input image (dimensions: %dx%d, channels: %d)",
+                width, height, channels);
+        if (m->input.data) {
+            sod_free_image(m->input);
+        }
+        m->input = sod_make_image(width, height, channels);
+        if (!m->input.data) {
+            log_error("Failed to create SOD image");
+            memset(&m->input, 0, sizeof(m->input));
+            return -1;
+        }
     }
+    sod_img img = m->input;
 
-    // Initialize the temp buffer to zeros for safety
-    memset(temp_buffer, 0, total_size * sizeof(float));
-
-    // Convert the frame data from HWC to CHW format and from 0-255 to 0-1 range
+    // Step 2: Convert the frame data from HWC to CHW format and from 0-255 to 0-1 range,
+    // straight into the input image
+    size_t plane_size = (size_t)width * (size_t)height;
+    const float scale = 1.0f / 255.0f;
     for (int c = 0; c < channels; c++) {
-        for (int h = 0; h < height; h++) {
-            for (int w = 0; w < width; w++) {
-                // Calculate the index in the SOD image (CHW format) with overflow checks
-                size_t c_offset = (size_t)c * (size_t)height * (size_t)width;
-                size_t h_offset = (size_t)h * (size_t)width;
-                size_t sod_idx = c_offset + h_offset + w;
-
-                // Calculate the index in the frame data (HWC format) with overflow checks
-                size_t row_offset = (size_t)h * (size_t)width * (size_t)channels;
-                size_t pixel_offset = (size_t)w * (size_t)channels;
-                size_t frame_idx = row_offset + pixel_offset + c;
-
-                // Make sure the indices are within bounds
-                if (sod_idx < total_size && frame_idx < total_size) {
-                    // Convert from 0-255 to 0-1 range
-                    temp_buffer[sod_idx] = frame_data[frame_idx] / 255.0f;
-                } else {
-                    log_warn("Index out of bounds: sod_idx=%zu, frame_idx=%zu, total_size=%zu",
-                             sod_idx, frame_idx, total_size);
-                }
-            }
+        float *plane = img.data + (size_t)c * plane_size;
+        const unsigned char *src = frame_data + c;
+        for (size_t i = 0; i < plane_size; i++) {
+            plane[i] = src[i * channels] * scale;
         }
     }
 
-    // Copy the converted data to the SOD image with NULL check
-    if (img.data != NULL) {
-        memcpy(img.data, temp_buffer, total_size * sizeof(float));
-    } else {
-        log_error("SOD image data pointer is NULL");
-        free(temp_buffer);
-        sod_free_image(img);
-        return -1;
-    }
-
-    // Free the temporary buffer
-    free(temp_buffer);
-
     log_info("Step 3: Successfully copied frame data to SOD image");
 
     // Step 3: Prepare the image for CNN detection
@@ -399,14 +375,20 @@ int detect_with_sod_model(detection_model_t model, const unsigned char *frame_da
     // Extra safety check for model pointer
     if (!m->sod.model) {
         log_error("Model pointer is NULL before preparing image");
-        sod_free_image(img);
         return -1;
     }
 
     prepared_data = sod_cnn_prepare_image(m->sod.model, img);
+
+    // SOD only resizes frames that differ from the network size, frames
+    // converted straight to that size are used as they are
+    int net_width = 0, net_height = 0, net_channels = 0;
+    if (sod_cnn_get_network_size(m->sod.model, &net_width, &net_height, &net_channels) == 0 &&
+        net_width == width && net_height == height && net_channels == channels) {
+        prepared_data = img.data;
+    }
     if (!prepared_data) {
         log_error("Failed to prepare image for CNN detection");
-        sod_free_image(img);
         return -1;
     }
 
@@ -420,8 +402,6 @@ int detect_with_sod_model(detection_model_t model, const unsigned char *frame_da
     // Add extra safety check
     if (!m->sod.model) {
         log_error("Model pointer is NULL before prediction");
-        // prepared_data is freed when we free the image
-        sod_free_image(img);
         return -1;
     }
 
@@ -432,7 +412,6 @@ int detect_with_sod_model(detection_model_t model, const unsigned char *frame_da
     // Extra safety check for prepared_data
     if (!prepared_data) {
         log_error("Prepared data is NULL before prediction");
-        sod_free_image(img);
         return -1;
     }
 
@@ -442,7 +421,6 @@ int detect_with_sod_model(detection_model_t model, const unsigned char *frame_da
 
     if (rc != 0) { // SOD_OK is 0
         log_error("CNN detection failed with error code: %d", rc);
-        sod_free_image(img); // This also frees prepared_data
         return -1;
     }
 
@@ -464,7 +442,6 @@ int detect_with_sod_model(detection_model_t model, const unsigned char *frame_da
     // Skip processing boxes if count is 0 or boxes is NULL
     if (count <= 0 || !boxes) {
         log_warn("No detection boxes returned (count=%d, boxes=%p)", count, (void*)boxes);
-        sod_free_image(img); // This also frees prepared_data
         result->count = 0; // Ensure result is properly initialized
         return 0;
     }
@@ -559,11 +536,8 @@ int detect_with_sod_model(detection_model_t model, const unsigned char *frame_da
     result->count = valid_count;
     log_info("Detection found %d valid objects out of %d total", valid_count, count);
 
-    // Step 7: Free the image data and prepared data
-    log_info("Step 9: Freeing SOD image and prepared data");
-    sod_free_image(img);
-    // Note: The prepared_data is actually part of the SOD image structure, so we don't need to free it separately
-    // It's automatically freed when we call sod_free_image(img)
+    // The input image stays with the model for the next frame, and the
+    // prepared data belongs to the network
 
     return 0;
 }
@@ -12,6 +12,7 @@
 #include "video/stream_reader.h"
 #include "video/stream_state.h"
 #include "database/db_streams.h"
+#include "database/db_stream_registry.h"
 #include "video/detection_stream_thread.h"
 
 // Stream structure
@@ -190,10 +191,10 @@ stream_handle_t get_stream_by_name(const char *name) {
         }
     }
 
-    // If stream not found in memory, check if it exists in the database
+    // If stream not found in memory, check if it exists in the stream registry
     stream_config_t db_config;
-    if (get_stream_config_by_name(name, &db_config) == 0) {
-        // Found in database, add to memory
+    if (stream_registry_get(name, &db_config) == 0) {
+        // Found in the registry, add to memory
         for (int i = 0; i < MAX_STREAMS; i++) {
             if (streams[i].config.name[0] == '\0') {
                 // Found empty slot
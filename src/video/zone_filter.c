@@ -1,8 +1,54 @@
 #include "video/zone_filter.h"
 #include "database/db_zones.h"
+#include "core/config.h"
 #include "core/logger.h"
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
+
+// Zones are rasterized onto a ZONE_MASK_SIZE x ZONE_MASK_SIZE grid over the
+// normalized frame, one bit per cell in each row word
+#define ZONE_MASK_SIZE 64
+
+// Distinct class names referenced by the filters of one stream's zones
+#define ZONE_MAX_CLASSES 64
+
+/**
+ * A zone compiled for constant-time containment and class tests
+ */
+typedef struct {
+    char id[MAX_ZONE_ID];
+    char name[MAX_ZONE_NAME];
+    zone_point_t polygon[MAX_ZONE_POINTS];
+    int polygon_count;
+    uint64_t inside[ZONE_MASK_SIZE];    // Cells entirely inside the polygon
+    uint64_t edge[ZONE_MASK_SIZE];      // Cells crossed by a polygon edge
+    bool has_class_filter;
+    uint64_t class_mask;                // Bit i set when classes[i] is accepted
+    float min_confidence;
+} compiled_zone_t;
+
+/**
+ * The enabled zones of one stream, immutable once published
+ */
+typedef struct {
+    int refcount;                       // Protected by zone_cache_mutex
+    int zone_count;
+    compiled_zone_t zones[MAX_ZONES_PER_STREAM];
+    int class_count;
+    char classes[ZONE_MAX_CLASSES][MAX_LABEL_LENGTH];
+} zone_set_t;
+
+typedef struct {
+    char stream_name[MAX_STREAM_NAME];
+    zone_set_t *set;                    // NULL until loaded or after invalidation
+    unsigned int generation;            // Bumped on every invalidation
+} zone_cache_slot_t;
+
+static zone_cache_slot_t zone_cache[MAX_STREAMS];
+static pthread_mutex_t zone_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /**
  * Check if a point is inside a polygon using ray casting algorithm
@@ -29,36 +75,143 @@ static bool point_in_polygon(float x, float y, const zone_point_t *polygon, int
 }
 
 /**
- * Check if a detection's center point is within a zone
+ * Grid cell holding a normalized coordinate, clamped to the grid
  */
-static bool detection_in_zone(const detection_t *detection, const detection_zone_t *zone) {
-    if (!detection || !zone || !zone->enabled) {
-        return false;
+static int coord_to_cell(float v) {
+    int cell = (int)floorf(v * ZONE_MASK_SIZE);
+    if (cell < 0) return 0;
+    if (cell >= ZONE_MASK_SIZE) return ZONE_MASK_SIZE - 1;
+    return cell;
+}
+
+/**
+ * Check whether the segment a-b touches the grid cell (cx, cy)
+ *
+ * The bounding boxes are known to overlap, so the segment reaches the cell
+ * unless all four cell corners lie strictly on one side of its line.
+ */
+static bool segment_touches_cell(zone_point_t a, zone_point_t b, int cx, int cy) {
+    const float step = 1.0f / ZONE_MASK_SIZE;
+    float x0 = cx * step, y0 = cy * step;
+    float corners[4][2] = {
+        { x0, y0 }, { x0 + step, y0 }, { x0, y0 + step }, { x0 + step, y0 + step }
+    };
+
+    int positive = 0, negative = 0;
+    for (int i = 0; i < 4; i++) {
+        float side = (b.x - a.x) * (corners[i][1] - a.y) - (b.y - a.y) * (corners[i][0] - a.x);
+        if (side > 0.0f) positive++;
+        else if (side < 0.0f) negative++;
+    }
+    return positive < 4 && negative < 4;
+}
+
+/**
+ * Rasterize a polygon into its inside and edge masks
+ *
+ * Cells crossed by an edge are marked as edge cells and resolved exactly at
+ * test time, every other cell is classified once by its center.
+ */
+static void rasterize_zone(compiled_zone_t *zone) {
+    memset(zone->inside, 0, sizeof(zone->inside));
+    memset(zone->edge, 0, sizeof(zone->edge));
+
+    if (zone->polygon_count < 3) {
+        return;
     }
 
-    // Calculate center point of detection bounding box
-    float center_x = detection->x + (detection->width / 2.0f);
-    float center_y = detection->y + (detection->height / 2.0f);
+    for (int i = 0, j = zone->polygon_count - 1; i < zone->polygon_count; j = i++) {
+        zone_point_t a = zone->polygon[j];
+        zone_point_t b = zone->polygon[i];
+        int min_cx = coord_to_cell(fminf(a.x, b.x));
+        int max_cx = coord_to_cell(fmaxf(a.x, b.x));
+        int min_cy = coord_to_cell(fminf(a.y, b.y));
+        int max_cy = coord_to_cell(fmaxf(a.y, b.y));
+
+        for (int cy = min_cy; cy <= max_cy; cy++) {
+            for (int cx = min_cx; cx <= max_cx; cx++) {
+                if (segment_touches_cell(a, b, cx, cy)) {
+                    zone->edge[cy] |= 1ULL << cx;
+                }
+            }
+        }
+    }
 
-    // Check if center is in polygon
-    return point_in_polygon(center_x, center_y, zone->polygon, zone->polygon_count);
+    const float step = 1.0f / ZONE_MASK_SIZE;
+    for (int cy = 0; cy < ZONE_MASK_SIZE; cy++) {
+        for (int cx = 0; cx < ZONE_MASK_SIZE; cx++) {
+            if (zone->edge[cy] & (1ULL << cx)) {
+                continue;
+            }
+            if (point_in_polygon((cx + 0.5f) * step, (cy + 0.5f) * step,
+                                 zone->polygon, zone->polygon_count)) {
+                zone->inside[cy] |= 1ULL << cx;
+            }
+        }
+    }
 }
 
 /**
- * Check if a detection's class matches the zone's filter
+ * Check if a point is within a compiled zone
  */
-static bool detection_class_matches(const detection_t *detection, const detection_zone_t *zone) {
-    // If no filter is set, all classes match
-    if (!zone->filter_classes || zone->filter_classes[0] == '\0') {
+static bool compiled_zone_contains(const compiled_zone_t *zone, float x, float y) {
+    // Points off the frame are outside the grid, test them exactly
+    if (x < 0.0f || x >= 1.0f || y < 0.0f || y >= 1.0f) {
+        return point_in_polygon(x, y, zone->polygon, zone->polygon_count);
+    }
+
+    int cx = (int)(x * ZONE_MASK_SIZE);
+    int cy = (int)(y * ZONE_MASK_SIZE);
+    uint64_t bit = 1ULL << cx;
+
+    if (zone->inside[cy] & bit) {
         return true;
     }
+    if (zone->edge[cy] & bit) {
+        return point_in_polygon(x, y, zone->polygon, zone->polygon_count);
+    }
+    return false;
+}
+
+/**
+ * Index of a class name in the stream's class table, adding it if needed
+ *
+ * @return Index, or -1 if the table is full
+ */
+static int intern_class(zone_set_t *set, const char *label) {
+    for (int i = 0; i < set->class_count; i++) {
+        if (strcmp(set->classes[i], label) == 0) {
+            return i;
+        }
+    }
+
+    if (set->class_count >= ZONE_MAX_CLASSES) {
+        return -1;
+    }
+
+    strncpy(set->classes[set->class_count], label, MAX_LABEL_LENGTH - 1);
+    set->classes[set->class_count][MAX_LABEL_LENGTH - 1] = '\0';
+    return set->class_count++;
+}
+
+/**
+ * Turn a zone's comma-separated class filter into a bitset
+ */
+static void compile_class_filter(zone_set_t *set, compiled_zone_t *zone, const char *filter_classes) {
+    zone->has_class_filter = false;
+    zone->class_mask = 0;
+
+    // If no filter is set, all classes match
+    if (!filter_classes || filter_classes[0] == '\0') {
+        return;
+    }
 
-    // Check if detection label is in the comma-separated filter list
     char filter_copy[256];
-    strncpy(filter_copy, zone->filter_classes, sizeof(filter_copy) - 1);
+    strncpy(filter_copy, filter_classes, sizeof(filter_copy) - 1);
     filter_copy[sizeof(filter_copy) - 1] = '\0';
 
-    char *token = strtok(filter_copy, ",");
+    char *saveptr = NULL;
+    char *token = strtok_r(filter_copy, ",", &saveptr);
     while (token) {
         // Trim whitespace
         while (*token == ' ') token++;
@@ -68,21 +221,182 @@ static bool detection_class_matches(const detection_t *detection, const detectio
             end--;
         }
 
-        // Check if it matches
-        if (strcmp(token, detection->label) == 0) {
-            return true;
+        if (*token != '\0') {
+            zone->has_class_filter = true;
+            int index = intern_class(set, token);
+            if (index >= 0) {
+                zone->class_mask |= 1ULL << index;
+            } else {
+                log_warn("Too many distinct classes in zone filters, ignoring '%s' in zone %s",
+                         token, zone->name);
+            }
         }
 
-        token = strtok(NULL, ",");
+        token = strtok_r(NULL, ",", &saveptr);
     }
+}
 
-    return false;
+/**
+ * Load a stream's zones from the database and compile the enabled ones
+ *
+ * @return New zone set with a reference for the caller, NULL on error
+ */
+static zone_set_t *load_zone_set(const char *stream_name) {
+    detection_zone_t zones[MAX_ZONES_PER_STREAM];
+    int zone_count = get_detection_zones(stream_name, zones, MAX_ZONES_PER_STREAM);
+    if (zone_count < 0) {
+        log_error("Failed to get detection zones for stream %s", stream_name);
+        return NULL;
+    }
+
+    zone_set_t *set = calloc(1, sizeof(zone_set_t));
+    if (!set) {
+        log_error("Failed to allocate zone cache for stream %s", stream_name);
+        return NULL;
+    }
+    set->refcount = 1;
+
+    for (int i = 0; i < zone_count; i++) {
+        if (!zones[i].enabled) {
+            continue;
+        }
+
+        compiled_zone_t *zone = &set->zones[set->zone_count++];
+        strncpy(zone->id, zones[i].id, sizeof(zone->id) - 1);
+        strncpy(zone->name, zones[i].name, sizeof(zone->name) - 1);
+        zone->polygon_count = zones[i].polygon_count;
+        if (zone->polygon_count > MAX_ZONE_POINTS) {
+            zone->polygon_count = MAX_ZONE_POINTS;
+        }
+        memcpy(zone->polygon, zones[i].polygon, zone->polygon_count * sizeof(zone_point_t));
+        zone->min_confidence = zones[i].min_confidence;
+
+        rasterize_zone(zone);
+        compile_class_filter(set, zone, zones[i].filter_classes);
+    }
+
+    log_info("Compiled %d enabled zones (%d configured) for stream %s",
+             set->zone_count, zone_count, stream_name);
+    return set;
+}
+
+/**
+ * Drop a reference to a zone set, freeing it with the last one
+ */
+static void release_zone_set(zone_set_t *set) {
+    if (!set) {
+        return;
+    }
+
+    pthread_mutex_lock(&zone_cache_mutex);
+    bool last = --set->refcount == 0;
+    pthread_mutex_unlock(&zone_cache_mutex);
+
+    if (last) {
+        free(set);
+    }
+}
+
+/**
+ * Get the compiled zones of a stream, loading them on a cache miss
+ *
+ * @return Zone set with a reference for the caller, NULL on error
+ */
+static zone_set_t *acquire_zone_set(const char *stream_name) {
+    pthread_mutex_lock(&zone_cache_mutex);
+
+    zone_cache_slot_t *slot = NULL;
+    zone_cache_slot_t *free_slot = NULL;
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        if (zone_cache[i].stream_name[0] == '\0') {
+            if (!free_slot) free_slot = &zone_cache[i];
+        } else if (strcmp(zone_cache[i].stream_name, stream_name) == 0) {
+            slot = &zone_cache[i];
+            break;
+        }
+    }
+
+    if (slot && slot->set) {
+        zone_set_t *set = slot->set;
+        set->refcount++;
+        pthread_mutex_unlock(&zone_cache_mutex);
+        return set;
+    }
+
+    if (!slot && free_slot) {
+        slot = free_slot;
+        strncpy(slot->stream_name, stream_name, sizeof(slot->stream_name) - 1);
+        slot->stream_name[sizeof(slot->stream_name) - 1] = '\0';
+    }
+    unsigned int generation = slot ? slot->generation : 0;
+    pthread_mutex_unlock(&zone_cache_mutex);
+
+    // Query and compile without holding the lock
+    zone_set_t *set = load_zone_set(stream_name);
+    if (!set) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&zone_cache_mutex);
+    // Only publish if the zones were not changed while we were loading them
+    if (slot && !slot->set && slot->generation == generation &&
+        strcmp(slot->stream_name, stream_name) == 0) {
+        slot->set = set;
+        set->refcount++;
+    }
+    pthread_mutex_unlock(&zone_cache_mutex);
+
+    return set;
+}
+
+/**
+ * Drop cached zones for one stream, or for all streams
+ */
+void zone_filter_invalidate(const char *stream_name) {
+    zone_set_t *dropped[MAX_STREAMS];
+    int dropped_count = 0;
+
+    pthread_mutex_lock(&zone_cache_mutex);
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        zone_cache_slot_t *slot = &zone_cache[i];
+        if (slot->stream_name[0] == '\0' ||
+            (stream_name && strcmp(slot->stream_name, stream_name) != 0)) {
+            continue;
+        }
+
+        if (slot->set) {
+            dropped[dropped_count++] = slot->set;
+            slot->set = NULL;
+        }
+        slot->generation++;
+    }
+    pthread_mutex_unlock(&zone_cache_mutex);
+
+    // Filters still holding a set keep it alive until they finish
+    for (int i = 0; i < dropped_count; i++) {
+        release_zone_set(dropped[i]);
+    }
+
+    log_debug("Invalidated zone cache for %s", stream_name ? stream_name : "all streams");
+}
+
+/**
+ * Check if a detection's class matches the zone's filter
+ *
+ * @param class_index Index of the detection's label in the stream's class table, -1 if absent
+ */
+static bool detection_class_matches(int class_index, const compiled_zone_t *zone) {
+    if (!zone->has_class_filter) {
+        return true;
+    }
+
+    return class_index >= 0 && (zone->class_mask & (1ULL << class_index)) != 0;
 }
 
 /**
  * Check if a detection meets the zone's confidence threshold
  */
-static bool detection_meets_confidence(const detection_t *detection, const detection_zone_t *zone) {
+static bool detection_meets_confidence(const detection_t *detection, const compiled_zone_t *zone) {
     // If no minimum confidence is set (0.0), accept all
     if (zone->min_confidence <= 0.0f) {
         return true;
@@ -105,37 +419,20 @@ int filter_detections_by_zones(const char *stream_name, detection_result_t *resu
         return 0;
     }
 
-    // Get zones for this stream
-    detection_zone_t zones[MAX_ZONES_PER_STREAM];
-    int zone_count = get_detection_zones(stream_name, zones, MAX_ZONES_PER_STREAM);
-
-    if (zone_count < 0) {
-        log_error("Failed to get detection zones for stream %s", stream_name);
+    zone_set_t *set = acquire_zone_set(stream_name);
+    if (!set) {
         return -1;
     }
 
-    // If no zones are configured, don't filter (allow all detections)
-    if (zone_count == 0) {
-        log_debug("No zones configured for stream %s, allowing all detections", stream_name);
-        return 0;
-    }
-
-    // Count enabled zones
-    int enabled_zone_count = 0;
-    for (int i = 0; i < zone_count; i++) {
-        if (zones[i].enabled) {
-            enabled_zone_count++;
-        }
-    }
-
-    // If no enabled zones, don't filter (allow all detections)
-    if (enabled_zone_count == 0) {
+    // If no zones are enabled, don't filter (allow all detections)
+    if (set->zone_count == 0) {
         log_debug("No enabled zones for stream %s, allowing all detections", stream_name);
+        release_zone_set(set);
         return 0;
     }
 
     log_info("Filtering %d detections using %d enabled zones for stream %s",
-             result->count, enabled_zone_count, stream_name);
+             result->count, set->zone_count, stream_name);
 
     // Create a filtered result
     detection_result_t filtered;
@@ -147,21 +444,29 @@ int filter_detections_by_zones(const char *stream_name, detection_result_t *resu
         bool detection_accepted = false;
         const char *matched_zone_id = NULL;
 
-        // Check if detection is in any enabled zone
-        for (int j = 0; j < zone_count; j++) {
-            detection_zone_t *zone = &zones[j];
+        // Calculate center point of detection bounding box
+        float center_x = det->x + (det->width / 2.0f);
+        float center_y = det->y + (det->height / 2.0f);
 
-            if (!zone->enabled) {
-                continue;
+        int class_index = -1;
+        for (int c = 0; c < set->class_count; c++) {
+            if (strcmp(set->classes[c], det->label) == 0) {
+                class_index = c;
+                break;
             }
+        }
+
+        // Check if detection is in any enabled zone
+        for (int j = 0; j < set->zone_count; j++) {
+            const compiled_zone_t *zone = &set->zones[j];
 
             // Check if detection is in this zone
-            if (!detection_in_zone(det, zone)) {
+            if (!compiled_zone_contains(zone, center_x, center_y)) {
                 continue;
             }
 
             // Check if detection class matches zone filter
-            if (!detection_class_matches(det, zone)) {
+            if (!detection_class_matches(class_index, zone)) {
                 log_debug("Detection %s rejected by zone %s (class filter)",
                          det->label, zone->name);
                 continue;
@@ -185,22 +490,23 @@ int filter_detections_by_zones(const char *stream_name, detection_result_t *resu
         // If detection was accepted by at least one zone, add it to filtered result
         if (detection_accepted) {
             memcpy(&filtered.detections[filtered.count], det, sizeof(detection_t));
-            
+
             // Set the zone_id for this detection
             if (matched_zone_id) {
                 strncpy(filtered.detections[filtered.count].zone_id, matched_zone_id,
                        sizeof(filtered.detections[filtered.count].zone_id) - 1);
                 filtered.detections[filtered.count].zone_id[sizeof(filtered.detections[filtered.count].zone_id) - 1] = '\0';
             }
-            
+
             filtered.count++;
         } else {
             log_debug("Detection %s (%.2f%%) at [%.2f, %.2f] rejected (not in any enabled zone)",
-                     det->label, det->confidence * 100.0f,
-                     det->x + det->width / 2.0f, det->y + det->height / 2.0f);
+                     det->label, det->confidence * 100.0f, center_x, center_y);
         }
     }
 
+    release_zone_set(set);
+
     log_info("Zone filtering: %d detections -> %d detections (filtered out %d)",
              result->count, filtered.count, result->count - filtered.count);
 
@@ -209,4 +515,3 @@ int filter_detections_by_zones(const char *stream_name, detection_result_t *resu
 
     return 0;
 }
-
@@ -150,6 +150,15 @@ void mg_handle_auth_verify(struct mg_connection *c, struct mg_http_message *hm)
 void mg_handle_auth_logout(struct mg_connection *c, struct mg_http_message *hm) {
     log_info("Handling logout request");
     
+    // End the session on the server too, which also drops it from the auth cache
+    struct mg_str *cookie = mg_http_get_header(hm, "Cookie");
+    if (cookie) {
+        char session_token[64] = {0};
+        if (mg_http_get_var(cookie, "session", session_token, sizeof(session_token)) > 0) {
+            db_auth_delete_session(session_token);
+        }
+    }
+    
     // Check if this is an API request
     struct mg_str *content_type = mg_http_get_header(hm, "Content-Type");
     struct mg_str *requested_with = mg_http_get_header(hm, "X-Requested-With");
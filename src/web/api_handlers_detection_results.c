@@ -17,6 +17,7 @@
 #include "core/config.h"
 #include "video/detection.h"
 #include "video/detection_result.h"
+#include "video/live_events.h"
 #include "video/stream_manager.h"
 #include "database/database_manager.h"
 
@@ -44,6 +45,9 @@ void store_detection_result(const char *stream_name, const detection_result_t *r
     }
     
     log_info("Storing detection results for stream '%s': %d detections", stream_name, result->count);
+
+    // Push to live viewers before the database write
+    live_events_publish_detections(stream_name, result, 0);
     
     // Store in database
     int ret = store_detections_in_db(stream_name, result, 0); // 0 = use current time
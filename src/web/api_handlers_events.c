@@ -0,0 +1,262 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "web/api_handlers_events.h"
+#include "web/api_handlers.h"
+#include "web/mongoose_adapter.h"
+#include "web/mongoose_server.h"
+#include "core/logger.h"
+#include "core/config.h"
+#include "video/live_events.h"
+#include "mongoose.h"
+#include "cJSON.h"
+
+// Tags a connection holding an event stream subscription
+#define EVENTS_SUBSCRIBER_TAG 'E'
+
+// Comment line sent on idle streams so proxies keep the connection open
+#define EVENTS_HEARTBEAT_MS 15000
+
+// Stop writing to a client whose unsent output grows beyond this
+#define EVENTS_MAX_SEND_BACKLOG (256 * 1024)
+
+// Detections older than this are not replayed to new subscribers
+#define EVENTS_SNAPSHOT_MAX_AGE 60
+
+// Events read from the hub per batch
+#define EVENTS_READ_BATCH 32
+
+typedef struct {
+    uint64_t last_sequence;
+    uint64_t last_write_ms;
+    int stream_count;                               // 0 subscribes to every stream
+    char streams[MAX_STREAMS][MAX_STREAM_NAME];
+} events_subscriber_t;
+
+static events_subscriber_t *subscriber(struct mg_connection *c) {
+    return mongoose_server_get_data(c, EVENTS_SUBSCRIBER_TAG);
+}
+
+/**
+ * Split the comma separated streams parameter into the subscriber's filter
+ */
+static void parse_stream_filter(events_subscriber_t *sub, char *list) {
+    char *saveptr = NULL;
+    for (char *name = strtok_r(list, ",", &saveptr); name && sub->stream_count < MAX_STREAMS;
+         name = strtok_r(NULL, ",", &saveptr)) {
+        if (name[0] == '\0') {
+            continue;
+        }
+        strncpy(sub->streams[sub->stream_count], name, MAX_STREAM_NAME - 1);
+        sub->stream_count++;
+    }
+}
+
+static bool wants_stream(const events_subscriber_t *sub, const char *stream_name) {
+    if (sub->stream_count == 0) {
+        return true;
+    }
+    for (int i = 0; i < sub->stream_count; i++) {
+        if (strcmp(sub->streams[i], stream_name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void send_event(struct mg_connection *c, events_subscriber_t *sub, uint64_t sequence,
+                       const char *name, cJSON *data) {
+    char *json = cJSON_PrintUnformatted(data);
+    cJSON_Delete(data);
+    if (!json) {
+        return;
+    }
+
+    mg_printf(c, "id: %llu\nevent: %s\ndata: %s\n\n", (unsigned long long)sequence, name, json);
+    free(json);
+    sub->last_write_ms = mg_millis();
+}
+
+/**
+ * Send a detection event if it still describes the stream's latest result
+ *
+ * @param max_age Skip results older than this many seconds, 0 for no limit
+ * @param skip_empty Skip results without detections
+ */
+static void send_detection_event(struct mg_connection *c, events_subscriber_t *sub,
+                                 const live_event_t *event, int max_age, bool skip_empty) {
+    detection_result_t result;
+    time_t timestamp = 0;
+    uint64_t sequence = 0;
+
+    // Superseded results are skipped, the event that replaced them follows
+    if (!live_events_get_detections(event->stream_name, &result, &timestamp, &sequence) ||
+        sequence != event->sequence) {
+        return;
+    }
+    if (skip_empty && result.count == 0) {
+        return;
+    }
+    if (max_age > 0 && time(NULL) - timestamp > max_age) {
+        return;
+    }
+
+    cJSON *data = cJSON_CreateObject();
+    if (!data) {
+        return;
+    }
+    cJSON_AddStringToObject(data, "stream", event->stream_name);
+    cJSON_AddNumberToObject(data, "timestamp", (double)timestamp);
+
+    cJSON *detections = cJSON_AddArrayToObject(data, "detections");
+    for (int i = 0; detections && i < result.count; i++) {
+        const detection_t *det = &result.detections[i];
+        cJSON *item = cJSON_CreateObject();
+        if (!item) {
+            break;
+        }
+        cJSON_AddStringToObject(item, "label", det->label);
+        cJSON_AddNumberToObject(item, "confidence", det->confidence);
+        cJSON_AddNumberToObject(item, "x", det->x);
+        cJSON_AddNumberToObject(item, "y", det->y);
+        cJSON_AddNumberToObject(item, "width", det->width);
+        cJSON_AddNumberToObject(item, "height", det->height);
+        if (det->track_id >= 0) {
+            cJSON_AddNumberToObject(item, "track_id", det->track_id);
+        }
+        if (det->zone_id[0] != '\0') {
+            cJSON_AddStringToObject(item, "zone_id", det->zone_id);
+        }
+        cJSON_AddItemToArray(detections, item);
+    }
+
+    send_event(c, sub, event->sequence, "detection", data);
+}
+
+static void send_state_event(struct mg_connection *c, events_subscriber_t *sub, const live_event_t *event) {
+    cJSON *data = cJSON_CreateObject();
+    if (!data) {
+        return;
+    }
+    cJSON_AddStringToObject(data, "stream", event->stream_name);
+    cJSON_AddNumberToObject(data, "timestamp", (double)event->timestamp);
+    cJSON_AddBoolToObject(data, "active", event->active);
+
+    send_event(c, sub, event->sequence,
+               event->type == LIVE_EVENT_MOTION ? "motion" : "recording", data);
+}
+
+/**
+ * Send every event after the subscriber's last sequence
+ *
+ * @param snapshot Only send current, recent detections (used right after subscribing)
+ */
+static void send_pending_events(struct mg_connection *c, events_subscriber_t *sub, bool snapshot) {
+    live_event_t events[EVENTS_READ_BATCH];
+    int count;
+
+    while ((count = live_events_read(sub->last_sequence, events, EVENTS_READ_BATCH)) > 0) {
+        for (int i = 0; i < count; i++) {
+            const live_event_t *event = &events[i];
+            sub->last_sequence = event->sequence;
+
+            if (!wants_stream(sub, event->stream_name)) {
+                continue;
+            }
+
+            if (event->type == LIVE_EVENT_DETECTION) {
+                send_detection_event(c, sub, event, snapshot ? EVENTS_SNAPSHOT_MAX_AGE : 0, snapshot);
+            } else if (!snapshot) {
+                send_state_event(c, sub, event);
+            }
+        }
+    }
+}
+
+/**
+ * Handler for GET /api/events
+ */
+void mg_handle_get_live_events(struct mg_connection *c, struct mg_http_message *hm) {
+    events_subscriber_t *sub = calloc(1, sizeof(events_subscriber_t));
+    if (!sub) {
+        mg_send_json_error(c, 503, "Out of memory");
+        return;
+    }
+
+    char streams_param[MAX_STREAMS * 64];
+    if (mg_http_get_var(&hm->query, "streams", streams_param, sizeof(streams_param)) > 0) {
+        parse_stream_filter(sub, streams_param);
+    }
+
+    // A reconnecting EventSource resumes after the last event it received
+    bool resume = false;
+    struct mg_str *last_event_id = mg_http_get_header(hm, "Last-Event-ID");
+    if (last_event_id && last_event_id->len > 0 && last_event_id->len < 32) {
+        char id[32];
+        memcpy(id, last_event_id->buf, last_event_id->len);
+        id[last_event_id->len] = '\0';
+        uint64_t sequence = strtoull(id, NULL, 10);
+        if (sequence <= live_events_sequence()) {
+            sub->last_sequence = sequence;
+            resume = true;
+        }
+    }
+
+    mg_printf(c, "HTTP/1.1 200 OK\r\n"
+                 "Content-Type: text/event-stream\r\n"
+                 "Cache-Control: no-cache\r\n"
+                 "Connection: keep-alive\r\n"
+                 "X-Accel-Buffering: no\r\n"
+                 "\r\n"
+                 "retry: 3000\n\n");
+    sub->last_write_ms = mg_millis();
+
+    // A new subscriber gets the detections currently on screen, not the event history
+    send_pending_events(c, sub, !resume);
+
+    mg_live_events_release(c);
+    mongoose_server_attach_data(c, EVENTS_SUBSCRIBER_TAG, sub);
+
+    log_debug("Live event subscriber connected (%d stream filter(s), sequence %llu)",
+              sub->stream_count, (unsigned long long)sub->last_sequence);
+}
+
+/**
+ * Send pending events to a subscribed connection
+ */
+void mg_live_events_poll(struct mg_connection *c) {
+    events_subscriber_t *sub = subscriber(c);
+    if (!sub || c->is_closing) {
+        return;
+    }
+
+    // A slow client skips ahead, the hub keeps the latest detections anyway
+    if (c->send.len > EVENTS_MAX_SEND_BACKLOG) {
+        return;
+    }
+
+    if (live_events_sequence() != sub->last_sequence) {
+        send_pending_events(c, sub, false);
+    }
+
+    if (mg_millis() - sub->last_write_ms >= EVENTS_HEARTBEAT_MS) {
+        mg_printf(c, ": keepalive\n\n");
+        sub->last_write_ms = mg_millis();
+    }
+}
+
+/**
+ * Free the subscription of a closing connection
+ */
+void mg_live_events_release(struct mg_connection *c) {
+    events_subscriber_t *sub = subscriber(c);
+    if (sub) {
+        mongoose_server_detach_data(c);
+        free(sub);
+        log_debug("Live event subscriber disconnected");
+    }
+}
@@ -22,6 +22,7 @@
 #include "web/api_handlers.h"
 #include "web/mongoose_adapter.h"
 #include "web/http_server.h"
+#include "web/mongoose_server_multithreading.h"
 #include "core/logger.h"
 #include "core/config.h"
 #include "mongoose.h"
@@ -175,6 +176,38 @@ void mg_handle_get_health(struct mg_connection *c, struct mg_http_message *hm) {
     cJSON_AddNumberToObject(health, "totalRequests", g_total_requests);
     cJSON_AddNumberToObject(health, "failedRequests", g_failed_requests);
 
+    // Add worker pool metrics
+    mg_worker_pool_stats_t pool_stats;
+    mg_worker_pool_get_stats(&pool_stats);
+    cJSON *pool = cJSON_CreateObject();
+    if (pool) {
+        cJSON_AddNumberToObject(pool, "threads", pool_stats.threads);
+        cJSON_AddNumberToObject(pool, "active", pool_stats.active);
+        cJSON_AddNumberToObject(pool, "queued", pool_stats.queued);
+        cJSON_AddNumberToObject(pool, "queuedHigh", pool_stats.queued_by_priority[MG_WORK_PRIORITY_HIGH]);
+        cJSON_AddNumberToObject(pool, "queuedNormal", pool_stats.queued_by_priority[MG_WORK_PRIORITY_NORMAL]);
+        cJSON_AddNumberToObject(pool, "queuedLow", pool_stats.queued_by_priority[MG_WORK_PRIORITY_LOW]);
+        cJSON_AddNumberToObject(pool, "capacity", pool_stats.capacity);
+        cJSON_AddNumberToObject(pool, "peakQueued", pool_stats.peak_queued);
+        cJSON_AddNumberToObject(pool, "completed", (double)pool_stats.completed);
+        cJSON_AddNumberToObject(pool, "rejected", (double)pool_stats.rejected);
+        cJSON_AddNumberToObject(pool, "avgWaitMs", pool_stats.avg_wait_ms);
+        cJSON_AddNumberToObject(pool, "maxWaitMs", pool_stats.max_wait_ms);
+        cJSON_AddNumberToObject(pool, "avgRunMs", pool_stats.avg_run_ms);
+        cJSON_AddItemToObject(health, "workerPool", pool);
+    }
+
+    // Add asynchronous logger counters
+    uint64_t log_written = 0;
+    uint64_t log_dropped = 0;
+    get_logger_stats(&log_written, &log_dropped);
+    cJSON *log_stats = cJSON_CreateObject();
+    if (log_stats) {
+        cJSON_AddNumberToObject(log_stats, "written", (double)log_written);
+        cJSON_AddNumberToObject(log_stats, "dropped", (double)log_dropped);
+        cJSON_AddItemToObject(health, "logger", log_stats);
+    }
+
     // Add timestamp
     char timestamp[32];
     time_t now = time(NULL);
@@ -10,6 +10,7 @@
 #include <dirent.h>
 #include <time.h>
 #include <errno.h>
+#include <stdatomic.h>
 
 #include "web/api_handlers.h"
 #include "web/mongoose_adapter.h"
@@ -20,6 +21,7 @@
 #include "database/database_manager.h"
 #include "database/db_recordings.h"
 #include "web/mongoose_server_multithreading.h"
+#include "video/recording_preview.h"
 #include <pthread.h>
 
 /**
@@ -30,9 +32,107 @@ typedef struct {
     cJSON *json;  // Parsed JSON request (will be freed by thread)
 } batch_delete_thread_data_t;
 
+// Threads removing the files of a batch delete, deletes on one disk gain little beyond this
+#define BATCH_DELETE_UNLINK_WORKERS 4
+
+// How often progress is published while files are removed
+#define BATCH_DELETE_PROGRESS_INTERVAL_US 200000
+
+/**
+ * @brief Files of a batch delete shared by the unlink workers
+ */
+typedef struct {
+    char **file_paths;
+    int count;
+    atomic_int next;        // Next path to claim
+    atomic_int processed;   // Paths handled so far
+} unlink_queue_t;
+
+/**
+ * @brief Remove recording files until the queue is drained
+ *
+ * @param arg Pointer to unlink_queue_t
+ * @return NULL
+ */
+static void *unlink_worker_thread(void *arg) {
+    unlink_queue_t *queue = (unlink_queue_t *)arg;
+    int i;
+
+    while ((i = atomic_fetch_add(&queue->next, 1)) < queue->count) {
+        const char *path = queue->file_paths[i];
+
+        if (unlink(path) == 0) {
+            log_debug("Deleted recording file: %s", path);
+        } else if (errno == ENOENT) {
+            log_warn("Recording file does not exist: %s (already deleted or never created)", path);
+        } else {
+            // The database row is already gone, the file is left for the orphan cleanup
+            log_warn("Failed to delete recording file: %s (error: %s)", path, strerror(errno));
+        }
+        recording_preview_remove(path);
+
+        atomic_fetch_add(&queue->processed, 1);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Remove the files of deleted recordings with a pool of workers
+ *
+ * Progress is published as files are removed. The database rows are already
+ * gone, so every file counts as a succeeded delete.
+ *
+ * @param job_id Batch delete job
+ * @param file_paths Paths returned by the database delete
+ * @param count Number of paths
+ * @param skipped Requested recordings that were not deleted, counted as failed
+ */
+static void unlink_recording_files(const char *job_id, char **file_paths, int count, int skipped) {
+    unlink_queue_t queue = {
+        .file_paths = file_paths,
+        .count = count
+    };
+    atomic_init(&queue.next, 0);
+    atomic_init(&queue.processed, 0);
+
+    pthread_t workers[BATCH_DELETE_UNLINK_WORKERS];
+    int worker_count = 0;
+    int wanted = count < BATCH_DELETE_UNLINK_WORKERS ? count : BATCH_DELETE_UNLINK_WORKERS;
+
+    for (int i = 0; i < wanted; i++) {
+        if (pthread_create(&workers[worker_count], NULL, unlink_worker_thread, &queue) != 0) {
+            log_warn("Failed to create unlink worker, continuing with %d", worker_count);
+            break;
+        }
+        worker_count++;
+    }
+
+    if (worker_count == 0) {
+        // Remove the files on this thread rather than leaving them behind
+        unlink_worker_thread(&queue);
+    }
+
+    int processed;
+    while ((processed = atomic_load(&queue.processed)) < count) {
+        char status_msg[256];
+        snprintf(status_msg, sizeof(status_msg), "Deleting recording files... %d/%d", processed, count);
+        batch_delete_progress_update(job_id, skipped + processed, processed, skipped, status_msg);
+        usleep(BATCH_DELETE_PROGRESS_INTERVAL_US);
+    }
+
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+}
+
 /**
  * @brief Thread function to perform batch delete with progress updates
  *
+ * The recordings are deleted from the database in a single transaction first,
+ * then their files are removed. A failed transaction deletes nothing, so no
+ * file is removed while its recording is still listed.
+ *
  * @param arg Pointer to batch_delete_thread_data_t
  * @return NULL
  */
@@ -52,6 +152,11 @@ static void *batch_delete_worker_thread(void *arg) {
     cJSON *ids_array = cJSON_GetObjectItem(json, "ids");
     cJSON *filter = cJSON_GetObjectItem(json, "filter");
 
+    char **file_paths = NULL;
+    int deleted = -1;
+    int requested = 0;
+    int invalid_count = 0;
+
     if (ids_array && cJSON_IsArray(ids_array)) {
         // Delete by IDs
         int array_size = cJSON_GetArraySize(ids_array);
@@ -59,67 +164,27 @@ static void *batch_delete_worker_thread(void *arg) {
         // Update progress to running
         batch_delete_progress_update(job_id, 0, 0, 0, "Starting batch delete operation...");
 
-        // Process each ID
-        int success_count = 0;
-        int error_count = 0;
+        uint64_t *ids = (uint64_t *)malloc((array_size > 0 ? array_size : 1) * sizeof(uint64_t));
+        if (!ids) {
+            log_error("Failed to allocate memory for recording IDs");
+            batch_delete_progress_error(job_id, "Failed to allocate memory");
+            cJSON_Delete(json);
+            free(data);
+            return NULL;
+        }
 
-        for (int i = 0; i < array_size; i++) {
-            cJSON *id_item = cJSON_GetArrayItem(ids_array, i);
-            if (!id_item || !cJSON_IsNumber(id_item)) {
-                log_warn("Invalid ID at index %d", i);
-                error_count++;
+        cJSON *id_item;
+        cJSON_ArrayForEach(id_item, ids_array) {
+            if (!cJSON_IsNumber(id_item)) {
+                log_warn("Invalid ID at index %d", requested + invalid_count);
+                invalid_count++;
                 continue;
             }
-
-            uint64_t id = (uint64_t)id_item->valuedouble;
-
-            // Get recording from database
-            recording_metadata_t recording;
-            if (get_recording_metadata_by_id(id, &recording) != 0) {
-                log_warn("Recording not found: %llu", (unsigned long long)id);
-                error_count++;
-            } else {
-                // Save file path before deleting from database
-                char file_path_copy[256];
-                strncpy(file_path_copy, recording.file_path, sizeof(file_path_copy) - 1);
-                file_path_copy[sizeof(file_path_copy) - 1] = '\0';
-
-                // Delete from database FIRST
-                if (delete_recording_metadata(id) != 0) {
-                    log_error("Failed to delete recording from database: %llu", (unsigned long long)id);
-                    error_count++;
-                } else {
-                    // Then delete the file from disk
-                    struct stat st;
-                    if (stat(file_path_copy, &st) == 0) {
-                        if (unlink(file_path_copy) != 0) {
-                            log_warn("Failed to delete recording file: %s (error: %s)",
-                                    file_path_copy, strerror(errno));
-                            // File deletion failed but DB entry is already removed
-                        } else {
-                            log_info("Deleted recording file: %s", file_path_copy);
-                        }
-                    } else {
-                        log_warn("Recording file does not exist: %s (already deleted or never created)",
-                                file_path_copy);
-                    }
-
-                    success_count++;
-                    log_info("Successfully deleted recording: %llu", (unsigned long long)id);
-                }
-            }
-
-            // Update progress every 10 recordings or on last recording
-            if ((i + 1) % 10 == 0 || (i + 1) == array_size) {
-                char status_msg[256];
-                snprintf(status_msg, sizeof(status_msg), "Deleting recordings... %d/%d", i + 1, array_size);
-                batch_delete_progress_update(job_id, i + 1, success_count, error_count, status_msg);
-            }
+            ids[requested++] = (uint64_t)id_item->valuedouble;
         }
 
-        // Mark as complete
-        batch_delete_progress_complete(job_id, success_count, error_count);
-        log_info("Batch delete job completed: %s (succeeded: %d, failed: %d)", job_id, success_count, error_count);
+        deleted = delete_recordings_by_ids(ids, requested, &file_paths);
+        free(ids);
 
     } else if (filter && cJSON_IsObject(filter)) {
         // Delete by filter
@@ -181,97 +246,41 @@ static void *batch_delete_worker_thread(void *arg) {
             has_detection = detection->valueint;
         }
 
-        // Get total count
-        int total_count = get_recording_count(start_time, end_time,
-                                            stream_name[0] != '\0' ? stream_name : NULL,
-                                            has_detection);
-
-        if (total_count <= 0) {
-            batch_delete_progress_complete(job_id, 0, 0);
-            cJSON_Delete(json);
-            free(data);
-            return NULL;
-        }
-
         // Update progress
-        batch_delete_progress_update(job_id, 0, 0, 0, "Loading recordings to delete...");
-
-        // Allocate memory for recordings
-        recording_metadata_t *recordings = (recording_metadata_t *)malloc(total_count * sizeof(recording_metadata_t));
-        if (!recordings) {
-            log_error("Failed to allocate memory for recordings");
-            batch_delete_progress_error(job_id, "Failed to allocate memory");
-            cJSON_Delete(json);
-            free(data);
-            return NULL;
-        }
-
-        // Get all recordings
-        int count = get_recording_metadata_paginated(start_time, end_time,
-                                                  stream_name[0] != '\0' ? stream_name : NULL,
-                                                  has_detection, "id", "asc",
-                                                  recordings, total_count, 0);
-
-        if (count <= 0) {
-            free(recordings);
-            batch_delete_progress_complete(job_id, 0, 0);
-            cJSON_Delete(json);
-            free(data);
-            return NULL;
-        }
-
-        // Process each recording
-        int success_count = 0;
-        int error_count = 0;
-
-        for (int i = 0; i < count; i++) {
-            uint64_t id = recordings[i].id;
-
-            // Save file path before deleting from database
-            char file_path_copy[256];
-            strncpy(file_path_copy, recordings[i].file_path, sizeof(file_path_copy) - 1);
-            file_path_copy[sizeof(file_path_copy) - 1] = '\0';
-
-            // Delete from database FIRST
-            if (delete_recording_metadata(id) != 0) {
-                log_error("Failed to delete recording from database: %llu", (unsigned long long)id);
-                error_count++;
-            } else {
-                // Then delete the file from disk
-                struct stat st;
-                if (stat(file_path_copy, &st) == 0) {
-                    if (unlink(file_path_copy) != 0) {
-                        log_warn("Failed to delete recording file: %s (error: %s)",
-                                file_path_copy, strerror(errno));
-                        // File deletion failed but DB entry is already removed
-                    } else {
-                        log_info("Deleted recording file: %s", file_path_copy);
-                    }
-                } else {
-                    log_warn("Recording file does not exist: %s (already deleted or never created)",
-                            file_path_copy);
-                }
-
-                success_count++;
-                log_info("Successfully deleted recording: %llu", (unsigned long long)id);
-            }
+        batch_delete_progress_update(job_id, 0, 0, 0, "Deleting recordings from database...");
 
-            // Update progress every 10 recordings or on last recording
-            if ((i + 1) % 10 == 0 || (i + 1) == count) {
-                char status_msg[256];
-                snprintf(status_msg, sizeof(status_msg), "Deleting recordings... %d/%d", i + 1, count);
-                batch_delete_progress_update(job_id, i + 1, success_count, error_count, status_msg);
-            }
-        }
-
-        free(recordings);
-        batch_delete_progress_complete(job_id, success_count, error_count);
-        log_info("Batch delete job completed: %s (succeeded: %d, failed: %d)", job_id, success_count, error_count);
+        deleted = delete_recordings_by_filter(start_time, end_time,
+                                              stream_name[0] != '\0' ? stream_name : NULL,
+                                              has_detection, &file_paths);
+        requested = deleted;
     } else {
         log_error("Invalid request format");
         batch_delete_progress_error(job_id, "Invalid request format");
+        cJSON_Delete(json);
+        free(data);
+        return NULL;
+    }
+
+    if (deleted < 0) {
+        log_error("Batch delete job failed: %s", job_id);
+        batch_delete_progress_error(job_id, "Failed to delete recordings from database");
+        cJSON_Delete(json);
+        free(data);
+        return NULL;
     }
 
+    // IDs that were not numbers or no longer exist
+    int failed_count = invalid_count + (requested - deleted);
+    if (requested > deleted) {
+        log_warn("%d of %d recordings not found", requested - deleted, requested);
+    }
+
+    unlink_recording_files(job_id, file_paths, deleted, failed_count);
+    free_recording_paths(file_paths, deleted);
+
+    batch_delete_progress_complete(job_id, deleted, failed_count);
+    log_info("Batch delete job completed: %s (succeeded: %d, failed: %d)", job_id, deleted, failed_count);
+
     // Cleanup
     cJSON_Delete(json);
     free(data);
@@ -20,6 +20,7 @@
 #include "database/db_recordings.h"
 #include "database/db_auth.h"
 #include "web/mongoose_server_multithreading.h"
+#include "video/recording_preview.h"
 
 // Forward declarations for batch delete functionality
 typedef struct {
@@ -129,6 +130,7 @@ void delete_recording_task_function(void *arg) {
             // This is acceptable - orphaned files can be cleaned up later
         } else {
             log_info("Deleted recording file: %s", file_path_copy);
+            recording_preview_remove(file_path_copy);
         }
     } else {
         log_warn("Recording file does not exist: %s (already deleted or never created)", file_path_copy);
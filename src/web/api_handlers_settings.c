@@ -15,6 +15,7 @@
 #include "database/db_streams.h"
 #include "video/stream_manager.h"
 #include "video/hls_streaming.h"
+#include "storage/storage_manager.h"
 #include "mongoose.h"
 
 /**
@@ -165,15 +166,18 @@ void mg_handle_post_settings(struct mg_connection *c, struct mg_http_message *hm
     // Max storage size
     cJSON *max_storage_size = cJSON_GetObjectItem(settings, "max_storage_size");
     if (max_storage_size && cJSON_IsNumber(max_storage_size)) {
-        g_config.max_storage_size = max_storage_size->valueint;
+        // Bytes; valueint would overflow above 2 GB
+        g_config.max_storage_size = max_storage_size->valuedouble > 0 ? (uint64_t)max_storage_size->valuedouble : 0;
+        set_max_storage_size(g_config.max_storage_size);
         settings_changed = true;
-        log_info("Updated max_storage_size: %d", g_config.max_storage_size);
+        log_info("Updated max_storage_size: %llu", (unsigned long long)g_config.max_storage_size);
     }
     
     // Retention days
     cJSON *retention_days = cJSON_GetObjectItem(settings, "retention_days");
     if (retention_days && cJSON_IsNumber(retention_days)) {
         g_config.retention_days = retention_days->valueint;
+        set_retention_days(g_config.retention_days);
         settings_changed = true;
         log_info("Updated retention_days: %d", g_config.retention_days);
     }
@@ -182,6 +186,7 @@ void mg_handle_post_settings(struct mg_connection *c, struct mg_http_message *hm
     cJSON *auto_delete_oldest = cJSON_GetObjectItem(settings, "auto_delete_oldest");
     if (auto_delete_oldest && cJSON_IsBool(auto_delete_oldest)) {
         g_config.auto_delete_oldest = cJSON_IsTrue(auto_delete_oldest);
+        set_auto_delete_oldest(g_config.auto_delete_oldest);
         settings_changed = true;
         log_info("Updated auto_delete_oldest: %s", g_config.auto_delete_oldest ? "true" : "false");
     }
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 // This file provides implementations of the HLS API functions
 
 #include <stdio.h>
@@ -8,7 +9,217 @@
 #include "core/logger.h"
 #include "core/config.h"
 #include "web/http_server.h"
+#include "web/mongoose_server.h"
+#include "web/api_handlers_streaming.h"
 #include "video/streams.h"
+#include "video/hls_memory_store.h"
+
+// Tags a connection holding a parked blocking playlist request
+#define HLS_BLOCKED_TAG 'H'
+
+// Target duration assumed before the first playlist reports one
+#define HLS_DEFAULT_TARGET_DURATION 2
+
+// Playlist request waiting for a media sequence number that is not out yet
+typedef struct {
+    char stream_name[MAX_STREAM_NAME];
+    char file_name[HLS_MEMORY_MAX_FILE_NAME];
+    int64_t msn;
+    uint64_t deadline_ms;
+    bool head_only;
+} hls_blocked_request_t;
+
+// Advertised in memory-served playlists so clients use blocking reloads
+static const char server_control_tag[] = "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES\n";
+
+static const char *hls_content_type(const char *file_name) {
+    if (strstr(file_name, ".m3u8")) {
+        return "application/vnd.apple.mpegurl";
+    } else if (strstr(file_name, ".ts")) {
+        return "video/mp2t";
+    } else if (strstr(file_name, ".m4s")) {
+        return "video/iso.segment";
+    } else if (strstr(file_name, "init.mp4")) {
+        return "video/mp4";
+    }
+    return "application/octet-stream";
+}
+
+/**
+ * Send a stored file, the store reference stays with the caller
+ */
+static void send_memory_file(struct mg_connection *c, const hls_memory_file_t *file, bool head_only) {
+    const uint8_t *body = file->data;
+    size_t body_len = file->size;
+    size_t header_len = 0;
+
+    // Insert the server control tag right after #EXTM3U
+    bool add_control = strstr(file->name, ".m3u8") && body_len >= 8 &&
+                       memcmp(body, "#EXTM3U\n", 8) == 0 &&
+                       !memmem(body, body_len, "#EXT-X-SERVER-CONTROL", 21);
+    if (add_control) {
+        header_len = 8;
+    }
+
+    size_t content_length = body_len + (add_control ? strlen(server_control_tag) : 0);
+
+    mg_printf(c, "HTTP/1.1 200 OK\r\n"
+                 "Content-Type: %s\r\n"
+                 "Content-Length: %zu\r\n"
+                 "ETag: \"%llx\"\r\n"
+                 "Cache-Control: no-cache\r\n"
+                 "Connection: close\r\n"
+                 "Access-Control-Allow-Origin: *\r\n"
+                 "Access-Control-Allow-Methods: GET, OPTIONS\r\n"
+                 "Access-Control-Allow-Headers: Origin, Content-Type, Accept, Authorization\r\n"
+                 "\r\n",
+              hls_content_type(file->name), content_length, (unsigned long long)file->serial);
+
+    if (head_only) {
+        return;
+    }
+
+    if (add_control) {
+        mg_send(c, body, header_len);
+        mg_send(c, server_control_tag, strlen(server_control_tag));
+    }
+    mg_send(c, body + header_len, body_len - header_len);
+}
+
+/**
+ * Send a file from the store, or 404 if it has been evicted
+ */
+static void send_memory_file_by_name(struct mg_connection *c, const char *stream_name,
+                                     const char *file_name, bool head_only) {
+    hls_memory_file_t *file = hls_memory_store_get(stream_name, file_name);
+    if (!file) {
+        mg_http_reply(c, 404, "", "{\"error\": \"HLS file not found\"}\n");
+        return;
+    }
+    send_memory_file(c, file, head_only);
+    hls_memory_file_release(file);
+}
+
+static hls_blocked_request_t *blocked_request(struct mg_connection *c) {
+    return mongoose_server_get_data(c, HLS_BLOCKED_TAG);
+}
+
+/**
+ * Serve a live HLS file from the in-memory segment store
+ */
+bool mg_serve_hls_from_memory(struct mg_connection *c, struct mg_http_message *hm,
+                              const char *stream_name, const char *file_name) {
+    bool head_only = mg_match(hm->method, mg_str("HEAD"), NULL);
+    int64_t last_sequence = -1;
+    int target_duration = 0;
+    bool has_playlist = hls_memory_store_playlist_state(stream_name, &last_sequence, &target_duration);
+
+    // Blocking playlist reload: hold the request until the segment is listed
+    char msn_param[32];
+    if (has_playlist && strstr(file_name, ".m3u8") &&
+        mg_http_get_var(&hm->query, "_HLS_msn", msn_param, sizeof(msn_param)) > 0) {
+        int64_t msn = strtoll(msn_param, NULL, 10);
+
+        if (msn > last_sequence + 2) {
+            mg_http_reply(c, 400, "", "{\"error\": \"_HLS_msn is too far ahead of the live edge\"}\n");
+            return true;
+        }
+
+        if (msn > last_sequence) {
+            hls_blocked_request_t *request = calloc(1, sizeof(hls_blocked_request_t));
+            if (!request) {
+                mg_http_reply(c, 503, "", "{\"error\": \"Out of memory\"}\n");
+                return true;
+            }
+
+            strncpy(request->stream_name, stream_name, sizeof(request->stream_name) - 1);
+            strncpy(request->file_name, file_name, sizeof(request->file_name) - 1);
+            request->msn = msn;
+            request->head_only = head_only;
+
+            // Servers should answer within three target durations
+            if (target_duration <= 0) {
+                target_duration = HLS_DEFAULT_TARGET_DURATION;
+            }
+            request->deadline_ms = mg_millis() + (uint64_t)target_duration * 3000;
+
+            mg_hls_release_blocked_request(c);
+            mongoose_server_attach_data(c, HLS_BLOCKED_TAG, request);
+
+            log_debug("Parked blocking playlist request for stream %s until segment %lld",
+                     stream_name, (long long)msn);
+            return true;
+        }
+    }
+
+    hls_memory_file_t *file = hls_memory_store_get(stream_name, file_name);
+    if (!file) {
+        return false;
+    }
+
+    // Conditional request for an unchanged file
+    struct mg_str *if_none_match = mg_http_get_header(hm, "If-None-Match");
+    if (if_none_match) {
+        char etag[32];
+        snprintf(etag, sizeof(etag), "\"%llx\"", (unsigned long long)file->serial);
+        if (if_none_match->len == strlen(etag) && memcmp(if_none_match->buf, etag, if_none_match->len) == 0) {
+            mg_printf(c, "HTTP/1.1 304 Not Modified\r\n"
+                         "ETag: %s\r\n"
+                         "Cache-Control: no-cache\r\n"
+                         "Content-Length: 0\r\n"
+                         "Connection: close\r\n"
+                         "Access-Control-Allow-Origin: *\r\n"
+                         "\r\n", etag);
+            hls_memory_file_release(file);
+            return true;
+        }
+    }
+
+    send_memory_file(c, file, head_only);
+    hls_memory_file_release(file);
+    return true;
+}
+
+/**
+ * Answer a parked blocking playlist request once it can be satisfied or has timed out
+ */
+void mg_hls_poll_blocked_request(struct mg_connection *c) {
+    hls_blocked_request_t *request = blocked_request(c);
+    if (!request) {
+        return;
+    }
+
+    int64_t last_sequence = -1;
+    bool ready = hls_memory_store_playlist_state(request->stream_name, &last_sequence, NULL) &&
+                 last_sequence >= request->msn;
+    bool expired = mg_millis() >= request->deadline_ms;
+
+    if (!ready && !expired && !c->is_closing) {
+        return;
+    }
+
+    mongoose_server_detach_data(c);
+
+    if (ready) {
+        send_memory_file_by_name(c, request->stream_name, request->file_name, request->head_only);
+    } else if (!c->is_closing) {
+        mg_http_reply(c, 503, "Retry-After: 1\r\n",
+                      "{\"error\": \"Requested HLS segment was not produced in time\"}\n");
+    }
+
+    free(request);
+}
+
+/**
+ * Free the parked blocking playlist request of a closing connection
+ */
+void mg_hls_release_blocked_request(struct mg_connection *c) {
+    hls_blocked_request_t *request = blocked_request(c);
+    if (request) {
+        mongoose_server_detach_data(c);
+        free(request);
+    }
+}
 
 
 void mg_handle_direct_hls_request(struct mg_connection *c, struct mg_http_message *hm) {
@@ -71,6 +282,11 @@ void mg_handle_direct_hls_request(struct mg_connection *c, struct mg_http_messag
         return;
     }
 
+    // Live HLS kept in memory is served without touching the filesystem
+    if (mg_serve_hls_from_memory(c, hm, decoded_stream_name, file_name)) {
+        return;
+    }
+
     // Get the config to find the storage path - make a local copy of needed values
     config_t *global_config = get_streaming_config();
     if (!global_config) {
@@ -18,6 +18,18 @@
 #include "database/database_manager.h"
 
 #include "database/db_motion_config.h"
+
+/**
+ * Add the per-stream retention settings to a stream object
+ */
+static void add_stream_retention_to_json(cJSON *stream_obj, const char *stream_name) {
+    int retention_days = 0;
+    int max_storage_mb = 0;
+    get_stream_retention_config(stream_name, &retention_days, &max_storage_mb);
+    cJSON_AddNumberToObject(stream_obj, "retention_days", retention_days);
+    cJSON_AddNumberToObject(stream_obj, "max_storage_mb", max_storage_mb);
+}
+
 /**
  * @brief Direct handler for GET /api/streams
  */
@@ -79,6 +91,7 @@ void mg_handle_get_streams(struct mg_connection *c, struct mg_http_message *hm)
         cJSON_AddNumberToObject(stream_obj, "protocol", (int)db_streams[i].protocol);
         cJSON_AddBoolToObject(stream_obj, "record_audio", db_streams[i].record_audio);
         cJSON_AddBoolToObject(stream_obj, "isOnvif", db_streams[i].is_onvif);
+        add_stream_retention_to_json(stream_obj, db_streams[i].name);
 
         // Get stream status
         stream_handle_t stream = get_stream_by_name(db_streams[i].name);
@@ -200,6 +213,7 @@ void mg_handle_get_stream(struct mg_connection *c, struct mg_http_message *hm) {
     cJSON_AddNumberToObject(stream_obj, "protocol", (int)config.protocol);
     cJSON_AddBoolToObject(stream_obj, "record_audio", config.record_audio);
     cJSON_AddBoolToObject(stream_obj, "isOnvif", config.is_onvif);
+    add_stream_retention_to_json(stream_obj, config.name);
 
     // Get stream status
     stream_status_t stream_status = get_stream_status(stream);
@@ -318,6 +332,7 @@ void mg_handle_get_stream_full(struct mg_connection *c, struct mg_http_message *
     cJSON_AddNumberToObject(stream_obj, "protocol", (int)config.protocol);
     cJSON_AddBoolToObject(stream_obj, "record_audio", config.record_audio);
     cJSON_AddBoolToObject(stream_obj, "isOnvif", config.is_onvif);
+    add_stream_retention_to_json(stream_obj, config.name);
 
     // Status
     stream_status_t stream_status = get_stream_status(stream);
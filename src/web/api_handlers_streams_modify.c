@@ -25,6 +25,29 @@
 #include "video/go2rtc/go2rtc_integration.h"
 #include "video/go2rtc/go2rtc_api.h"
 
+/**
+ * Store the retention_days and max_storage_mb fields of a request, if present
+ */
+static void update_stream_retention_from_json(const cJSON *stream_json, const char *stream_name) {
+    cJSON *retention_days = cJSON_GetObjectItem(stream_json, "retention_days");
+    cJSON *max_storage_mb = cJSON_GetObjectItem(stream_json, "max_storage_mb");
+    bool has_retention = retention_days && cJSON_IsNumber(retention_days);
+    bool has_quota = max_storage_mb && cJSON_IsNumber(max_storage_mb);
+    if (!has_retention && !has_quota) {
+        return;
+    }
+
+    int current_days = 0;
+    int current_mb = 0;
+    get_stream_retention_config(stream_name, &current_days, &current_mb);
+
+    int days = has_retention ? retention_days->valueint : current_days;
+    int mb = has_quota ? max_storage_mb->valueint : current_mb;
+    if (set_stream_retention_config(stream_name, days < 0 ? 0 : days, mb < 0 ? 0 : mb) != 0) {
+        log_warn("Failed to update retention settings for stream %s", stream_name);
+    }
+}
+
 /**
  * @brief Direct handler for POST /api/streams
  */
@@ -229,6 +252,7 @@ void mg_handle_post_stream(struct mg_connection *c, struct mg_http_message *hm)
         mg_send_json_error(c, 500, "Failed to add stream configuration");
         return;
     }
+    update_stream_retention_from_json(stream_json, config.name);
 
     // Create stream in memory from the database configuration
     stream_handle_t stream = add_stream(&config);
@@ -591,6 +615,7 @@ void mg_handle_put_stream(struct mg_connection *c, struct mg_http_message *hm) {
                         log_error("Failed to enable stream %s: %s", decoded_id, sqlite3_errmsg(db));
                     } else {
                         log_info("Successfully enabled stream %s", decoded_id);
+                        stream_registry_reload(decoded_id);
 
                         // Get the stream configuration to register with go2rtc
                         stream_config_t stream_config;
@@ -655,6 +680,7 @@ void mg_handle_put_stream(struct mg_connection *c, struct mg_http_message *hm) {
         mg_send_json_error(c, 500, "Failed to update stream configuration");
         return;
     }
+    update_stream_retention_from_json(stream_json, config.name);
 
     // Force update of stream configuration in memory to ensure it matches the database
     // This ensures the stream handle has the latest configuration
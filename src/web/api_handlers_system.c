@@ -230,19 +230,13 @@ void mg_handle_get_system_info(struct mg_connection *c, struct mg_http_message *
             unsigned long long total = disk_info.f_blocks * disk_info.f_frsize;
             unsigned long long free = disk_info.f_bfree * disk_info.f_frsize;
 
-            // Get actual usage of the storage directory
+            // Usage of the recordings, from the per-stream storage counters
             unsigned long long used = 0;
-            char command[512];
-            snprintf(command, sizeof(command), "du -sb %s 2>/dev/null | cut -f1", g_config.storage_path);
-            FILE *fp = popen(command, "r");
-            if (fp) {
-                if (fscanf(fp, "%llu", &used) != 1) {
-                    // If du command fails, fall back to statvfs calculation
-                    used = (disk_info.f_blocks - disk_info.f_bfree) * disk_info.f_frsize;
-                }
-                pclose(fp);
+            int64_t recordings_size = get_recordings_total_size(NULL);
+            if (recordings_size >= 0) {
+                used = (unsigned long long)recordings_size;
             } else {
-                // Fallback if popen fails
+                // Fall back to the filesystem usage
                 used = (disk_info.f_blocks - disk_info.f_bfree) * disk_info.f_frsize;
             }
 
@@ -462,57 +456,13 @@ void mg_handle_get_system_info(struct mg_connection *c, struct mg_http_message *
             log_error("Failed to get recording count from database");
         }
 
-        // Get recordings size from storage directory
+        // Get recordings size from the per-stream storage counters
         unsigned long long recording_size = 0;
-
-        // Check if we have a recordings directory
-        char recordings_dir[512];
-        snprintf(recordings_dir, sizeof(recordings_dir), "%s/", g_config.storage_path);
-
-        struct stat st;
-        if (stat(recordings_dir, &st) == 0 && S_ISDIR(st.st_mode)) {
-            // Get size of recordings directory using du command
-            char command[512];
-            snprintf(command, sizeof(command), "du -sb %s 2>/dev/null | cut -f1", recordings_dir);
-            log_debug("Executing command: %s", command);
-
-            FILE *fp = popen(command, "r");
-            if (fp) {
-                if (fscanf(fp, "%llu", &recording_size) != 1) {
-                    log_error("Failed to parse du command output");
-                    recording_size = 0;
-                } else {
-                    log_debug("Recordings size from du command: %llu bytes", recording_size);
-                }
-                pclose(fp);
-            } else {
-                log_error("Failed to execute du command");
-            }
-
-            // If du command failed, try to get size using stat
-            if (recording_size == 0) {
-                log_debug("Trying to get recordings size using stat");
-
-                // Use a different approach - recursively list all files and sum their sizes
-                char find_command[512];
-                snprintf(find_command, sizeof(find_command),
-                        "find %s -type f -name \"*.mp4\" -exec stat -c %%s {} \\; | awk '{sum+=$1} END {print sum}'",
-                        recordings_dir);
-                log_debug("Executing command: %s", find_command);
-
-                FILE *find_fp = popen(find_command, "r");
-                if (find_fp) {
-                    if (fscanf(find_fp, "%llu", &recording_size) != 1) {
-                        log_error("Failed to parse find command output");
-                        recording_size = 0;
-                    } else {
-                        log_debug("Recordings size from find command: %llu bytes", recording_size);
-                    }
-                    pclose(find_fp);
-                } else {
-                    log_error("Failed to execute find command");
-                }
-            }
+        int64_t total_size = get_recordings_total_size(NULL);
+        if (total_size >= 0) {
+            recording_size = (unsigned long long)total_size;
+        } else {
+            log_error("Failed to get recordings size from database");
         }
 
         cJSON_AddNumberToObject(recordings, "count", recording_count);
@@ -522,8 +472,8 @@ void mg_handle_get_system_info(struct mg_connection *c, struct mg_http_message *
         cJSON_AddItemToObject(info, "recordings", recordings);
     }
 
-    // Add stream storage usage information with caching
-    add_cached_stream_storage_usage_to_json(info, 0);
+    // Add stream storage usage information (counters are cheap to read, no caching needed)
+    add_stream_storage_usage_to_json(info);
 
     // Convert to string
     char *json_str = cJSON_PrintUnformatted(info);
@@ -3,9 +3,14 @@
  * @brief API handlers for system logs
  */
 
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 #include <ctype.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -14,6 +19,7 @@
 #include "web/api_handlers.h"
 #include "web/mongoose_adapter.h"
 #include "core/logger.h"
+#include "core/logger_recent.h"
 #include "core/config.h"
 #include "mongoose.h"
 
@@ -204,131 +210,150 @@ int log_level_meets_minimum(const char *log_level, const char *min_level) {
     return level_value <= min_value;
 }
 
+/**
+ * @brief Map a level name from the API to a log level
+ */
+static log_level_t parse_min_level(const char *min_level) {
+    if (strcmp(min_level, "error") == 0) {
+        return LOG_LEVEL_ERROR;
+    } else if (strcmp(min_level, "warning") == 0 || strcmp(min_level, "warn") == 0) {
+        return LOG_LEVEL_WARN;
+    } else if (strcmp(min_level, "info") == 0) {
+        return LOG_LEVEL_INFO;
+    }
+    return LOG_LEVEL_DEBUG;
+}
+
+/**
+ * @brief Parse a "since" value: Unix seconds or a local "YYYY-MM-DD HH:MM:SS" timestamp
+ *
+ * @return Time, or 0 if the value cannot be parsed
+ */
+static time_t parse_since(const char *value) {
+    if (!value || !value[0]) {
+        return 0;
+    }
+
+    char *end = NULL;
+    long long seconds = strtoll(value, &end, 10);
+    if (end && *end == '\0') {
+        return seconds > 0 ? (time_t)seconds : 0;
+    }
+
+    struct tm tm_info;
+    memset(&tm_info, 0, sizeof(tm_info));
+    if (!strptime(value, "%Y-%m-%d %H:%M:%S", &tm_info) &&
+        !strptime(value, "%Y-%m-%dT%H:%M:%S", &tm_info)) {
+        return 0;
+    }
+    tm_info.tm_isdst = -1;
+
+    time_t t = mktime(&tm_info);
+    return t > 0 ? t : 0;
+}
+
 /**
  * @brief Direct handler for GET /api/system/logs
+ *
+ * Query parameters:
+ *   level  - minimum level: error, warning, info or debug (default debug)
+ *   limit  - maximum number of entries (default 500)
+ *   cursor - only entries after this cursor (returned by the previous call)
+ *   since  - only entries after this time (Unix seconds or "YYYY-MM-DD HH:MM:SS")
+ *
+ * Without cursor or since, the end of the log file is returned.  Otherwise
+ * entries come from the in-memory recent-log index.
  */
 void mg_handle_get_system_logs(struct mg_connection *c, struct mg_http_message *hm) {
-    log_info("Handling GET /api/system/logs request");
+    log_debug("Handling GET /api/system/logs request");
 
     // Get query parameters
     char level[16] = "debug";
+    char value[64];
 
-    // Extract log level from query parameters
     struct mg_str query = mg_str_n(mg_str_get_ptr(&hm->query), mg_str_get_len(&hm->query));
-    char level_buf[16] = {0};
-    int level_len = mg_http_get_var(&query, "level", level_buf, sizeof(level_buf) - 1);
-    if (level_len > 0) {
-        strncpy(level, level_buf, sizeof(level) - 1);
+    if (mg_http_get_var(&query, "level", value, sizeof(level)) > 0) {
+        strncpy(level, value, sizeof(level) - 1);
         level[sizeof(level) - 1] = '\0';
     }
 
-    // Get system logs
-    char **logs = NULL;
-    int count = 250;
+    int limit = 500;
+    if (mg_http_get_var(&query, "limit", value, sizeof(value)) > 0) {
+        limit = atoi(value);
+        if (limit <= 0) {
+            limit = 500;
+        } else if (limit > 5000) {
+            limit = 5000;
+        }
+    }
 
-    const int result = get_json_logs_tail(level, NULL, &logs, &count);
+    uint64_t after_seq = 0;
+    bool have_cursor = false;
+    if (mg_http_get_var(&query, "cursor", value, sizeof(value)) > 0) {
+        after_seq = strtoull(value, NULL, 10);
+        have_cursor = true;
+    }
 
-    if (result != 0 || !logs) {
-        mg_send_json_error(c, 500, "Failed to get system logs");
-        return;
+    time_t since = 0;
+    if (mg_http_get_var(&query, "since", value, sizeof(value)) > 0) {
+        since = parse_since(value);
     }
 
-    // Create JSON object
     cJSON *logs_obj = cJSON_CreateObject();
-    if (!logs_obj) {
-        log_error("Failed to create logs JSON object");
-
-        // Free logs
-        if (logs) {
-            for (int i = 0; i < count; i++) {
-                if (logs[i]) {
-                    free(logs[i]);
-                }
-            }
-            free(logs);
-        }
-
+    cJSON *logs_array = cJSON_CreateArray();
+    if (!logs_obj || !logs_array) {
+        log_error("Failed to create logs JSON");
+        cJSON_Delete(logs_obj);
+        cJSON_Delete(logs_array);
         mg_send_json_error(c, 500, "Failed to create logs JSON");
         return;
     }
+    cJSON_AddItemToObject(logs_obj, "logs", logs_array);
 
-    // Create logs array
-    cJSON *logs_array = cJSON_CreateArray();
-    if (!logs_array) {
-        log_error("Failed to create logs array");
-
-        // Free logs
-        if (logs) {
-            for (int i = 0; i < count; i++) {
-                if (logs[i]) {
-                    free(logs[i]);
-                }
-            }
-            free(logs);
-        }
+    uint64_t cursor = 0;
+    bool truncated = false;
+    const char *source = "memory";
 
-        cJSON_Delete(logs_obj);
-        mg_send_json_error(c, 500, "Failed to create logs array");
-        return;
-    }
+    // First page: the end of the log file, which also covers earlier runs
+    bool from_file = !have_cursor && since == 0 && g_config.log_file[0] != '\0' &&
+                     add_log_file_tail_to_json(level, limit, logs_array, &cursor) >= 0;
 
-    // Parse and add logs to array as objects
-    // Note: get_json_logs_tail returns JSON-formatted strings, so we need to parse them
-    for (int i = 0; i < count; i++) {
-        if (logs[i] != NULL) {
-            // Parse the JSON string
-            cJSON *log_json = cJSON_Parse(logs[i]);
-            if (!log_json) {
-                log_error("Failed to parse log JSON: %s", logs[i]);
-                continue;
-            }
+    if (from_file) {
+        source = "file";
+    } else {
+        recent_log_record_t *records = NULL;
+        int count = get_recent_logs(parse_min_level(level), after_seq, since, limit,
+                                    &records, &cursor, &truncated);
 
-            // Extract fields from JSON
-            cJSON *timestamp_json = cJSON_GetObjectItem(log_json, "timestamp");
-            cJSON *level_json = cJSON_GetObjectItem(log_json, "level");
-            cJSON *message_json = cJSON_GetObjectItem(log_json, "message");
-
-            const char *timestamp = timestamp_json && cJSON_IsString(timestamp_json) ? timestamp_json->valuestring : "Unknown";
-            const char *log_level = level_json && cJSON_IsString(level_json) ? level_json->valuestring : "info";
-            const char *message = message_json && cJSON_IsString(message_json) ? message_json->valuestring : "";
-
-            // Check if this log meets the minimum level
-            if (log_level_meets_minimum(log_level, level)) {
-                // Create log entry object
-                cJSON *log_entry = cJSON_CreateObject();
-                if (log_entry) {
-                    cJSON_AddStringToObject(log_entry, "timestamp", timestamp);
-                    cJSON_AddStringToObject(log_entry, "level", log_level);
-                    cJSON_AddStringToObject(log_entry, "message", message);
-
-                    cJSON_AddItemToArray(logs_array, log_entry);
-                }
+        for (int i = 0; i < count; i++) {
+            cJSON *log_entry = cJSON_CreateObject();
+            if (!log_entry) {
+                break;
             }
 
-            // Clean up parsed JSON
-            cJSON_Delete(log_json);
+            char timestamp[32];
+            struct tm tm_info;
+            localtime_r(&records[i].time, &tm_info);
+            strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+
+            cJSON_AddStringToObject(log_entry, "timestamp", timestamp);
+            cJSON_AddStringToObject(log_entry, "level", get_recent_log_level_name(records[i].level));
+            cJSON_AddStringToObject(log_entry, "message", records[i].message);
+            cJSON_AddItemToArray(logs_array, log_entry);
         }
-    }
 
-    // Add logs array to response
-    cJSON_AddItemToObject(logs_obj, "logs", logs_array);
+        free(records);
+    }
 
     // Add metadata
     cJSON_AddStringToObject(logs_obj, "file", g_config.log_file);
     cJSON_AddStringToObject(logs_obj, "level", level);
+    cJSON_AddNumberToObject(logs_obj, "cursor", (double)cursor);
+    cJSON_AddStringToObject(logs_obj, "source", source);
+    cJSON_AddBoolToObject(logs_obj, "truncated", truncated);
 
     // Convert to string
     char *json_str = cJSON_PrintUnformatted(logs_obj);
-
-    // Clean up
-    if (logs) {
-        for (int i = 0; i < count; i++) {
-            if (logs[i]) {
-                free(logs[i]);
-            }
-        }
-        free(logs);
-    }
     cJSON_Delete(logs_obj);
 
     if (!json_str) {
@@ -342,8 +367,6 @@ void mg_handle_get_system_logs(struct mg_connection *c, struct mg_http_message *
 
     // Clean up
     free(json_str);
-
-    log_info("Successfully handled GET /api/system/logs request");
 }
 
 /**
@@ -1,6 +1,11 @@
 /**
  * @file api_handlers_system_logs_tail.c
- * @brief Optimized API handlers for system logs using tail
+ * @brief Reading the end of the log file without forking tail
+ *
+ * The log file is read backwards in fixed-size chunks with pread, so getting
+ * the last few hundred lines costs a few reads at the end of the file no
+ * matter how large it has grown, and a "newer than" filter stops at the first
+ * older line.
  */
 
 #include <stdio.h>
@@ -10,16 +15,227 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <stdbool.h>
+#include <sys/stat.h>
 
 #include "web/api_handlers.h"
 #include "web/mongoose_adapter.h"
 #include "core/logger.h"
+#include "core/logger_recent.h"
 #include "core/config.h"
 #include "mongoose.h"
 #include "cJSON.h"
 
+// Bytes read per pread call
+#define LOG_TAIL_CHUNK_SIZE (64 * 1024)
+
+// Longest line kept when it spans chunks, longer ones are skipped
+#define LOG_TAIL_MAX_LINE 4096
+
+// Never scan more than this much of the file for one request
+#define LOG_TAIL_MAX_SCAN (4 * 1024 * 1024)
+
+/**
+ * Callback for each line, newest first
+ *
+ * @return 0 to continue, non-zero to stop
+ */
+typedef int (*log_line_fn)(const char *line, size_t len, void *ctx);
+
+/**
+ * @brief Call fn for each line of a file, from the last line backwards
+ *
+ * Does not log, so it can run with the log output locked.
+ *
+ * @return 0 on success, -1 if the file cannot be read
+ */
+static int for_each_log_line_backwards(const char *path, off_t max_scan, log_line_fn fn, void *ctx) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    char *buf = malloc(LOG_TAIL_CHUNK_SIZE + LOG_TAIL_MAX_LINE);
+    char *carry = malloc(LOG_TAIL_MAX_LINE);
+    if (!buf || !carry) {
+        free(buf);
+        free(carry);
+        close(fd);
+        return -1;
+    }
+
+    off_t end = st.st_size;
+    off_t limit = end > max_scan ? end - max_scan : 0;
+    size_t carry_len = 0;       // Start of a line whose beginning is in an earlier chunk
+    bool carry_valid = true;
+    bool stop = false;
+    int result = 0;
+
+    while (end > limit && !stop) {
+        size_t n = (size_t)(end - limit) < LOG_TAIL_CHUNK_SIZE ? (size_t)(end - limit) : LOG_TAIL_CHUNK_SIZE;
+        off_t start = end - (off_t)n;
+
+        size_t got = 0;
+        while (got < n) {
+            ssize_t r = pread(fd, buf + got, n - got, start + (off_t)got);
+            if (r < 0 && errno == EINTR) {
+                continue;
+            }
+            if (r <= 0) {
+                break;
+            }
+            got += (size_t)r;
+        }
+        if (got < n) {
+            result = -1;
+            break;
+        }
+
+        memcpy(buf + n, carry, carry_len);
+        size_t total = n + carry_len;
+        end = start;
+
+        // Emit complete lines from the back of the buffer
+        size_t line_end = total;
+        for (size_t i = total; i-- > 0; ) {
+            if (buf[i] != '\n') {
+                continue;
+            }
+            if (line_end > i + 1 && (line_end < total || carry_valid)) {
+                if (fn(buf + i + 1, line_end - i - 1, ctx)) {
+                    stop = true;
+                    break;
+                }
+            }
+            line_end = i;
+            carry_valid = true;
+        }
+
+        // buf[0..line_end) continues in the previous chunk
+        if (line_end <= LOG_TAIL_MAX_LINE) {
+            memcpy(carry, buf, line_end);
+            carry_len = line_end;
+        } else {
+            carry_len = 0;
+            carry_valid = false;
+        }
+    }
+
+    // The first line of the file has no newline before it
+    if (!stop && result == 0 && end == 0 && carry_len > 0 && carry_valid) {
+        fn(carry, carry_len, ctx);
+    }
+
+    free(buf);
+    free(carry);
+    close(fd);
+    return result;
+}
+
 /**
- * @brief Get system logs using tail command
+ * @brief Split a text log line into timestamp, level and message
+ *
+ * Format: [TIMESTAMP] [LEVEL] MESSAGE
+ */
+static void parse_log_line(char *line, char *timestamp, size_t timestamp_size,
+                           char *level, size_t level_size, char **message) {
+    timestamp[0] = '\0';
+    level[0] = '\0';
+    *message = line;
+
+    if (line[0] != '[') {
+        return;
+    }
+
+    char *timestamp_end = strchr(line + 1, ']');
+    if (!timestamp_end) {
+        return;
+    }
+
+    size_t timestamp_len = timestamp_end - (line + 1);
+    if (timestamp_len >= timestamp_size) {
+        return;
+    }
+    memcpy(timestamp, line + 1, timestamp_len);
+    timestamp[timestamp_len] = '\0';
+
+    // Skip space after timestamp
+    char *level_start = timestamp_end + 1;
+    if (*level_start == ' ') {
+        level_start++;
+    }
+    if (level_start[0] != '[') {
+        return;
+    }
+
+    char *level_end = strchr(level_start + 1, ']');
+    if (!level_end) {
+        return;
+    }
+
+    size_t level_len = level_end - (level_start + 1);
+    if (level_len >= level_size) {
+        return;
+    }
+
+    // Use the lowercase names of the JSON log ("WARN" -> "warning")
+    for (size_t i = 0; i < level_len; i++) {
+        level[i] = (char)tolower((unsigned char)level_start[1 + i]);
+    }
+    level[level_len] = '\0';
+    if (strcmp(level, "warn") == 0) {
+        snprintf(level, level_size, "warning");
+    }
+
+    *message = level_end[1] == ' ' ? level_end + 2 : level_end + 1;
+}
+
+typedef struct {
+    char **lines;
+    int count;
+    int max;
+    bool failed;
+} raw_tail_ctx_t;
+
+static int collect_raw_line(const char *line, size_t len, void *arg) {
+    raw_tail_ctx_t *ctx = (raw_tail_ctx_t *)arg;
+
+    char *copy = strndup(line, len);
+    if (!copy) {
+        ctx->failed = true;
+        return 1;
+    }
+
+    ctx->lines[ctx->count++] = copy;
+    return ctx->count >= ctx->max;
+}
+
+/**
+ * @brief Reverse an array of strings collected newest first
+ */
+static void reverse_lines(char **lines, int count) {
+    for (int i = 0; i < count / 2; i++) {
+        char *tmp = lines[i];
+        lines[i] = lines[count - 1 - i];
+        lines[count - 1 - i] = tmp;
+    }
+}
+
+static void free_lines(char **lines, int count) {
+    for (int i = 0; i < count; i++) {
+        free(lines[i]);
+    }
+    free(lines);
+}
+
+/**
+ * @brief Get the last lines of the system log file
  *
  * @param logs Pointer to array of log strings (will be allocated)
  * @param count Pointer to store number of logs
@@ -44,94 +260,110 @@ int get_system_logs_tail(char ***logs, int *count, int max_lines) {
         max_lines = 5000; // Cap at 5000 lines to prevent excessive memory usage
     }
 
-    // Use tail command to get the last N lines
-    // We request 2*max_lines to ensure we have enough lines after filtering by log level
-    char command[512];
-    snprintf(command, sizeof(command), "tail -n %d %s 2>/dev/null", max_lines * 2, g_config.log_file);
-    
-    FILE *fp = popen(command, "r");
-    if (!fp) {
-        log_error("Failed to execute tail command: %s", strerror(errno));
+    raw_tail_ctx_t ctx = {
+        .lines = calloc(max_lines, sizeof(char *)),
+        .count = 0,
+        .max = max_lines,
+        .failed = false,
+    };
+    if (!ctx.lines) {
+        log_error("Failed to allocate memory for log lines");
         return -1;
     }
 
-    // Count lines first to allocate memory
-    int line_count = 0;
-    char line_buffer[4096]; // Increased buffer size for long log lines
-    
-    // Read all lines to count them
-    while (fgets(line_buffer, sizeof(line_buffer), fp) != NULL && line_count < max_lines * 2) {
-        line_count++;
+    if (for_each_log_line_backwards(g_config.log_file, LOG_TAIL_MAX_SCAN, collect_raw_line, &ctx) != 0 ||
+        ctx.failed) {
+        log_error("Failed to read log file %s: %s", g_config.log_file, strerror(errno));
+        free_lines(ctx.lines, ctx.count);
+        return -1;
     }
-    
-    // If no lines, return empty result
-    if (line_count == 0) {
-        pclose(fp);
+
+    if (ctx.count == 0) {
+        free(ctx.lines);
         return 0;
     }
-    
-    // Allocate array of log strings
-    char **log_lines = calloc(line_count, sizeof(char *));
-    if (!log_lines) {
-        log_error("Failed to allocate memory for log lines");
-        pclose(fp);
-        return -1;
+
+    reverse_lines(ctx.lines, ctx.count);
+
+    // Set output parameters
+    *logs = ctx.lines;
+    *count = ctx.count;
+
+    return 0;
+}
+
+typedef struct {
+    const char *min_level;
+    const char *last_timestamp;
+    cJSON *entries;             // Newest first
+    int count;
+    int max;
+    bool failed;
+} json_tail_ctx_t;
+
+static int collect_json_line(const char *line, size_t len, void *arg) {
+    json_tail_ctx_t *ctx = (json_tail_ctx_t *)arg;
+
+    char line_buffer[LOG_TAIL_MAX_LINE + 1];
+    if (len > LOG_TAIL_MAX_LINE) {
+        len = LOG_TAIL_MAX_LINE;
+    }
+    memcpy(line_buffer, line, len);
+    line_buffer[len] = '\0';
+
+    char timestamp[32];
+    char level[16];
+    char *message;
+    parse_log_line(line_buffer, timestamp, sizeof(timestamp), level, sizeof(level), &message);
+
+    // Lines are read newest first, so the first old one ends the scan
+    if (ctx->last_timestamp && ctx->last_timestamp[0] && timestamp[0] &&
+        strcmp(timestamp, ctx->last_timestamp) <= 0) {
+        return 1;
     }
-    
-    // Reopen the command to read the lines again
-    pclose(fp);
-    fp = popen(command, "r");
-    if (!fp) {
-        log_error("Failed to execute tail command (second time): %s", strerror(errno));
-        free(log_lines);
+
+    // Skip if doesn't meet minimum level
+    if (!log_level_meets_minimum(level[0] ? level : "info", ctx->min_level)) {
+        return 0;
+    }
+
+    cJSON *log_entry = cJSON_CreateObject();
+    if (!log_entry) {
+        ctx->failed = true;
+        return 1;
+    }
+
+    cJSON_AddStringToObject(log_entry, "timestamp", timestamp[0] ? timestamp : "Unknown");
+    cJSON_AddStringToObject(log_entry, "level", level[0] ? level : "info");
+    cJSON_AddStringToObject(log_entry, "message", message);
+    cJSON_AddItemToArray(ctx->entries, log_entry);
+
+    ctx->count++;
+    return ctx->count >= ctx->max;
+}
+
+/**
+ * @brief Collect JSON entries from the end of the log file without logging
+ */
+static int read_json_log_tail(json_tail_ctx_t *ctx) {
+    ctx->entries = cJSON_CreateArray();
+    if (!ctx->entries) {
         return -1;
     }
-    
-    // Read lines and store them
-    int log_index = 0;
-    while (fgets(line_buffer, sizeof(line_buffer), fp) != NULL && log_index < line_count) {
-        // Remove trailing newline
-        size_t len = strlen(line_buffer);
-        if (len > 0 && line_buffer[len - 1] == '\n') {
-            line_buffer[len - 1] = '\0';
-        }
-        
-        // Skip empty lines
-        if (line_buffer[0] == '\0') {
-            continue;
-        }
-        
-        // Allocate memory for the log line
-        log_lines[log_index] = strdup(line_buffer);
-        if (!log_lines[log_index]) {
-            log_error("Failed to allocate memory for log line");
-            
-            // Free previously allocated lines
-            for (int i = 0; i < log_index; i++) {
-                if (log_lines[i]) {
-                    free(log_lines[i]);
-                }
-            }
-            free(log_lines);
-            pclose(fp);
-            return -1;
-        }
-        
-        log_index++;
+
+    if (for_each_log_line_backwards(g_config.log_file, LOG_TAIL_MAX_SCAN, collect_json_line, ctx) != 0 ||
+        ctx->failed) {
+        cJSON_Delete(ctx->entries);
+        ctx->entries = NULL;
+        ctx->count = 0;
+        return -1;
     }
-    
-    // Close the command
-    pclose(fp);
-    
-    // Set output parameters
-    *logs = log_lines;
-    *count = log_index;
-    
+
     return 0;
 }
 
 /**
- * @brief Get JSON logs using tail command
+ * @brief Get JSON logs from the end of the log file
  *
  * @param min_level Minimum log level to include
  * @param last_timestamp Last timestamp received by client (for pagination)
@@ -143,162 +375,111 @@ int get_json_logs_tail(const char *min_level, const char *last_timestamp, char *
     // Initialize output parameters
     *logs = NULL;
     *count = 0;
-    
+
     // Check if log file is set
     if (g_config.log_file[0] == '\0') {
         log_error("Log file not configured");
         return -1;
     }
-    
-    // Default to 500 lines if not specified
-    int max_lines = 500;
-    
-    // Use tail command to get the last N lines
-    // We request 2*max_lines to ensure we have enough lines after filtering by log level
-    char command[512];
-    snprintf(command, sizeof(command), "tail -n %d %s 2>/dev/null", max_lines * 2, g_config.log_file);
-    
-    FILE *fp = popen(command, "r");
-    if (!fp) {
-        log_error("Failed to execute tail command: %s", strerror(errno));
+
+    json_tail_ctx_t ctx = {
+        .min_level = min_level,
+        .last_timestamp = last_timestamp,
+        .max = 500,
+    };
+
+    if (read_json_log_tail(&ctx) != 0) {
+        log_error("Failed to read log file %s", g_config.log_file);
         return -1;
     }
-    
-    // Allocate initial array of log strings
-    // We'll resize it if needed
-    int capacity = 100;
-    char **log_lines = calloc(capacity, sizeof(char *));
-    if (!log_lines) {
+
+    char **log_lines = ctx.count > 0 ? calloc(ctx.count, sizeof(char *)) : NULL;
+    if (ctx.count > 0 && !log_lines) {
         log_error("Failed to allocate memory for log lines");
-        pclose(fp);
+        cJSON_Delete(ctx.entries);
         return -1;
     }
-    
-    // Read lines and store them
+
+    // Oldest first
     int log_index = 0;
-    char line_buffer[4096]; // Increased buffer size for long log lines
-    
-    while (fgets(line_buffer, sizeof(line_buffer), fp) != NULL && log_index < max_lines) {
-        // Remove trailing newline
-        size_t len = strlen(line_buffer);
-        if (len > 0 && line_buffer[len - 1] == '\n') {
-            line_buffer[len - 1] = '\0';
-        }
-        
-        // Skip empty lines
-        if (line_buffer[0] == '\0') {
-            continue;
+    for (int i = ctx.count - 1; i >= 0; i--) {
+        char *json_str = cJSON_PrintUnformatted(cJSON_GetArrayItem(ctx.entries, i));
+        if (!json_str) {
+            log_error("Failed to convert log entry to JSON string");
+            free_lines(log_lines, log_index);
+            cJSON_Delete(ctx.entries);
+            return -1;
         }
+        log_lines[log_index++] = json_str;
+    }
+    cJSON_Delete(ctx.entries);
 
-        // Parse log line (format: [TIMESTAMP] [LEVEL] MESSAGE)
-        char timestamp[32] = "";
-        char level[16] = "";
-        char *message = line_buffer;
-
-        // Extract timestamp and level if line starts with [
-        if (line_buffer[0] == '[') {
-            char *timestamp_end = strchr(line_buffer + 1, ']');
-            if (timestamp_end) {
-                size_t timestamp_len = timestamp_end - (line_buffer + 1);
-                if (timestamp_len < sizeof(timestamp)) {
-                    memcpy(timestamp, line_buffer + 1, timestamp_len);
-                    timestamp[timestamp_len] = '\0';
-
-                    // Skip space after timestamp
-                    char *level_start = timestamp_end + 2;
-                    if (level_start[0] == '[') {
-                        char *level_end = strchr(level_start + 1, ']');
-                        if (level_end) {
-                            size_t level_len = level_end - (level_start + 1);
-                            if (level_len < sizeof(level)) {
-                                memcpy(level, level_start + 1, level_len);
-                                level[level_len] = '\0';
-                                message = level_end + 2;
-                            }
-                        }
-                    }
-                }
-            }
-        }
+    // Set output parameters
+    *logs = log_lines;
+    *count = log_index;
 
-        // Skip if timestamp filtering is enabled and this log is older
-        if (last_timestamp && last_timestamp[0] && strcmp(timestamp, last_timestamp) <= 0) {
-            continue;
-        }
+    return 0;
+}
 
-        // Skip if doesn't meet minimum level
-        if (!log_level_meets_minimum(level, min_level)) {
-            continue;
-        }
-        
-        // Check if we need to resize the array
-        if (log_index >= capacity) {
-            capacity *= 2;
-            char **new_lines = realloc(log_lines, capacity * sizeof(char *));
-            if (!new_lines) {
-                log_error("Failed to resize log lines array");
-                
-                // Free previously allocated lines
-                for (int i = 0; i < log_index; i++) {
-                    if (log_lines[i]) {
-                        free(log_lines[i]);
-                    }
-                }
-                free(log_lines);
-                pclose(fp);
-                return -1;
-            }
-            log_lines = new_lines;
-        }
+typedef struct {
+    json_tail_ctx_t tail;
+    uint64_t cursor;
+    int result;
+} locked_tail_ctx_t;
 
-        // Create JSON format log entry using cJSON to properly escape strings
-        cJSON *log_entry = cJSON_CreateObject();
-        if (!log_entry) {
-            log_error("Failed to create JSON object for log entry");
+static int read_json_log_tail_locked(void *arg) {
+    locked_tail_ctx_t *ctx = (locked_tail_ctx_t *)arg;
 
-            // Free previously allocated lines
-            for (int i = 0; i < log_index; i++) {
-                if (log_lines[i]) {
-                    free(log_lines[i]);
-                }
-            }
-            free(log_lines);
-            pclose(fp);
-            return -1;
-        }
+    // Nothing is written while this runs, so the file ends exactly at the cursor
+    ctx->cursor = get_recent_log_cursor();
+    ctx->result = read_json_log_tail(&ctx->tail);
+    return ctx->result;
+}
 
-        cJSON_AddStringToObject(log_entry, "timestamp", timestamp[0] ? timestamp : "Unknown");
-        cJSON_AddStringToObject(log_entry, "level", level[0] ? level : "info");
-        cJSON_AddStringToObject(log_entry, "message", message);
+/**
+ * @brief Add the last lines of the log file to a JSON array, with the matching cursor
+ *
+ * @param min_level Minimum log level to include
+ * @param max_lines Maximum number of lines
+ * @param logs_array Array to add {timestamp, level, message} objects to, oldest first
+ * @param cursor Recent-log cursor of the newest line in the file
+ * @return Number of entries added, -1 on error
+ */
+int add_log_file_tail_to_json(const char *min_level, int max_lines, cJSON *logs_array, uint64_t *cursor) {
+    if (!logs_array || g_config.log_file[0] == '\0') {
+        return -1;
+    }
 
-        char *json_str = cJSON_PrintUnformatted(log_entry);
-        cJSON_Delete(log_entry);
+    locked_tail_ctx_t ctx = {
+        .tail = {
+            .min_level = min_level,
+            .last_timestamp = NULL,
+            .max = max_lines > 0 ? max_lines : 500,
+        },
+        .cursor = 0,
+        .result = -1,
+    };
 
-        if (!json_str) {
-            log_error("Failed to convert log entry to JSON string");
+    run_with_log_output_locked(read_json_log_tail_locked, &ctx);
+    if (ctx.result != 0) {
+        log_error("Failed to read log file %s", g_config.log_file);
+        return -1;
+    }
 
-            // Free previously allocated lines
-            for (int i = 0; i < log_index; i++) {
-                if (log_lines[i]) {
-                    free(log_lines[i]);
-                }
-            }
-            free(log_lines);
-            pclose(fp);
-            return -1;
+    // Move the entries over, oldest first
+    int added = 0;
+    for (int i = ctx.tail.count - 1; i >= 0; i--) {
+        cJSON *entry = cJSON_DetachItemFromArray(ctx.tail.entries, i);
+        if (entry) {
+            cJSON_AddItemToArray(logs_array, entry);
+            added++;
         }
+    }
+    cJSON_Delete(ctx.tail.entries);
 
-        // Store the JSON string (already allocated by cJSON)
-        log_lines[log_index] = json_str;
-        log_index++;
+    if (cursor) {
+        *cursor = ctx.cursor;
     }
-    
-    // Close the command
-    pclose(fp);
-    
-    // Set output parameters
-    *logs = log_lines;
-    *count = log_index;
-    
-    return 0;
+
+    return added;
 }
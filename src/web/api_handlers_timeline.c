@@ -19,11 +19,14 @@
 #include "mongoose.h"
 #include "database/database_manager.h"
 #include "database/db_recordings.h"
+#include "video/recording_preview.h"
 
 // Forward declarations for Mongoose API handlers
 void mg_handle_get_timeline_segments(struct mg_connection *c, struct mg_http_message *hm);
 void mg_handle_timeline_manifest(struct mg_connection *c, struct mg_http_message *hm);
 void mg_handle_timeline_playback(struct mg_connection *c, struct mg_http_message *hm);
+void mg_handle_get_timeline_preview(struct mg_connection *c, struct mg_http_message *hm);
+void mg_handle_get_timeline_sprite(struct mg_connection *c, struct mg_http_message *hm);
 
 // Maximum number of segments to return in a single request
 #define MAX_TIMELINE_SEGMENTS 1000
@@ -70,6 +73,11 @@ int get_timeline_segments(const char *stream_name, time_t start_time, time_t end
         segments[i].end_time = recordings[i].end_time;
         segments[i].size_bytes = recordings[i].size_bytes;
         segments[i].has_detection = false; // Default to false, could be updated with detection info
+
+        char preview_path[MAX_PATH_LENGTH];
+        segments[i].has_preview =
+            recording_preview_path(recordings[i].file_path, ".preview.json", preview_path, sizeof(preview_path)) == 0 &&
+            access(preview_path, F_OK) == 0;
     }
     
     // Free recordings
@@ -311,6 +319,7 @@ void mg_handle_get_timeline_segments(struct mg_connection *c, struct mg_http_mes
         cJSON_AddNumberToObject(segment, "duration", duration);
         cJSON_AddStringToObject(segment, "size", size_str);
         cJSON_AddBoolToObject(segment, "has_detection", segments[i].has_detection);
+        cJSON_AddBoolToObject(segment, "has_preview", segments[i].has_preview);
         
         // Add Unix timestamps for easier frontend processing
         // Convert to local timezone by adding the timezone offset
@@ -786,3 +795,57 @@ void mg_handle_timeline_playback(struct mg_connection *c, struct mg_http_message
     mg_printf(c, "Content-Length: 0\r\n");
     mg_printf(c, "\r\n");
 }
+
+/**
+ * Serve a preview file of a recording, the recording ID is the last path component
+ */
+static void serve_recording_preview(struct mg_connection *c, struct mg_http_message *hm,
+                                    const char *prefix, const char *suffix) {
+    char id_str[32];
+    if (mg_extract_path_param(hm, prefix, id_str, sizeof(id_str)) != 0) {
+        mg_send_json_error(c, 400, "Invalid recording ID");
+        return;
+    }
+
+    char *endptr;
+    uint64_t id = strtoull(id_str, &endptr, 10);
+    if (*endptr != '\0' || id == 0) {
+        mg_send_json_error(c, 400, "Invalid recording ID");
+        return;
+    }
+
+    recording_metadata_t recording;
+    if (get_recording_metadata_by_id(id, &recording) != 0) {
+        mg_send_json_error(c, 404, "Recording not found");
+        return;
+    }
+
+    char preview_path[MAX_PATH_LENGTH];
+    if (recording_preview_path(recording.file_path, suffix, preview_path, sizeof(preview_path)) != 0 ||
+        access(preview_path, R_OK) != 0) {
+        mg_send_json_error(c, 404, "No preview for this recording");
+        return;
+    }
+
+    // Previews never change once written
+    mg_http_serve_file(c, hm, preview_path, &(struct mg_http_serve_opts){
+        .mime_types = "json=application/json,jpg=image/jpeg",
+        .extra_headers = "Cache-Control: private, max-age=86400\r\n"
+    });
+}
+
+/**
+ * @brief Handler for GET /api/timeline/preview/:id
+ * Keyframe index and sprite sheet layout of a recording
+ */
+void mg_handle_get_timeline_preview(struct mg_connection *c, struct mg_http_message *hm) {
+    serve_recording_preview(c, hm, "/api/timeline/preview/", ".preview.json");
+}
+
+/**
+ * @brief Handler for GET /api/timeline/sprite/:id
+ * Thumbnail sprite sheet of a recording
+ */
+void mg_handle_get_timeline_sprite(struct mg_connection *c, struct mg_http_message *hm) {
+    serve_recording_preview(c, hm, "/api/timeline/sprite/", ".sprite.jpg");
+}
@@ -36,11 +36,23 @@
 #include "web/api_handlers_health.h"
 #include "web/api_handlers_motion.h"
 #include "web/api_handlers_zones.h"
+#include "web/api_handlers_streaming.h"
+#include "web/api_handlers_events.h"
+
+// Where mongoose_server_attach_data keeps its tag and pointer in c->data
+// (byte 1 holds the Connection: close marker)
+#define CONN_DATA_TAG_OFFSET 2
+#define CONN_DATA_PTR_OFFSET 8
+
+_Static_assert(sizeof(((struct mg_connection *)0)->data) >= CONN_DATA_PTR_OFFSET + sizeof(void *),
+               "mongoose connection data too small for a parked pointer");
 
 // Forward declarations for timeline API handlers
 void mg_handle_get_timeline_segments(struct mg_connection *c, struct mg_http_message *hm);
 void mg_handle_timeline_manifest(struct mg_connection *c, struct mg_http_message *hm);
 void mg_handle_timeline_playback(struct mg_connection *c, struct mg_http_message *hm);
+void mg_handle_get_timeline_preview(struct mg_connection *c, struct mg_http_message *hm);
+void mg_handle_get_timeline_sprite(struct mg_connection *c, struct mg_http_message *hm);
 
 // Forward declarations for HLS API handlers
 void mg_handle_hls_master_playlist(struct mg_connection *c, struct mg_http_message *hm);
@@ -60,6 +72,7 @@ typedef struct {
     const char *uri;        // URI pattern
     mg_api_handler_t handler; // Handler function
     bool no_auto_threading;  // If true, don't automatically thread this handler
+    mg_work_priority_t priority; // Worker pool priority for auto-threaded handlers (default normal)
 } mg_api_route_t;
 
 // Forward declarations
@@ -82,9 +95,9 @@ static int match_route(struct mg_http_message *hm);
 // API routes table
 static const mg_api_route_t s_api_routes[] = {
     // Auth API
-    {"POST", "/api/auth/login", mg_handle_auth_login, false},
+    {"POST", "/api/auth/login", mg_handle_auth_login, false, MG_WORK_PRIORITY_HIGH},
     {"POST", "/api/auth/logout", mg_handle_auth_logout, false},
-    {"GET", "/api/auth/verify", mg_handle_auth_verify, false},
+    {"GET", "/api/auth/verify", mg_handle_auth_verify, false, MG_WORK_PRIORITY_HIGH},
     {"GET", "/logout", mg_handle_auth_logout, false},  // Simple GET logout route
 
     // User Management API
@@ -117,13 +130,13 @@ static const mg_api_route_t s_api_routes[] = {
     // System API
     {"GET", "/api/system", mg_handle_get_system_info, false},
     {"GET", "/api/system/info", mg_handle_get_system_info, false}, // Keep for backward compatibility
-    {"GET", "/api/system/logs", mg_handle_get_system_logs, false},
+    {"GET", "/api/system/logs", mg_handle_get_system_logs, false, MG_WORK_PRIORITY_LOW},
     {"POST", "/api/system/restart", mg_handle_post_system_restart, false},
     {"POST", "/api/system/shutdown", mg_handle_post_system_shutdown, false},
     {"POST", "/api/system/logs/clear", mg_handle_post_system_logs_clear, false},
-    {"POST", "/api/system/backup", mg_handle_post_system_backup, false},
+    {"POST", "/api/system/backup", mg_handle_post_system_backup, false, MG_WORK_PRIORITY_LOW},
     {"GET", "/api/system/status", mg_handle_get_system_status, false},
-    {"GET", "/api/health", mg_handle_get_health, false},
+    {"GET", "/api/health", mg_handle_get_health, false, MG_WORK_PRIORITY_HIGH},
     {"GET", "/api/health/hls", mg_handle_get_hls_health, false},
 
     // Recordings API
@@ -136,7 +149,7 @@ static const mg_api_route_t s_api_routes[] = {
     {"DELETE", "/api/recordings/#", mg_handle_delete_recording, true},  // Already uses threading
     {"POST", "/api/recordings/batch-delete", mg_handle_batch_delete_recordings, true},  // Already uses threading
     {"GET", "/api/recordings/batch-delete/progress/#", mg_handle_batch_delete_progress, false},  // Progress check is fast
-    {"POST", "/api/recordings/sync", mg_handle_post_recordings_sync, false},  // Sync recordings file sizes
+    {"POST", "/api/recordings/sync", mg_handle_post_recordings_sync, false, MG_WORK_PRIORITY_LOW},  // Sync recordings file sizes
 
     // No direct HLS handlers - handled by static file handler
 
@@ -153,19 +166,22 @@ static const mg_api_route_t s_api_routes[] = {
     // Detection API
     {"GET", "/api/detection/results/#", mg_handle_get_detection_results, true},  // Opt out of auto-threading to prevent double threading
     {"GET", "/api/detection/models", mg_handle_get_detection_models, false},
+    {"GET", "/api/events", mg_handle_get_live_events, true},  // Long-lived event stream, stays on the event loop
 
     // ONVIF API
     {"GET", "/api/onvif/discovery/status", mg_handle_get_onvif_discovery_status, false},
     {"GET", "/api/onvif/devices", mg_handle_get_discovered_onvif_devices, false},
-    {"GET", "/api/onvif/device/profiles", mg_handle_get_onvif_device_profiles, false},
+    {"GET", "/api/onvif/device/profiles", mg_handle_get_onvif_device_profiles, false, MG_WORK_PRIORITY_LOW},
     {"POST", "/api/onvif/discovery/discover", mg_handle_post_discover_onvif_devices, true},  // Already uses threading
     {"POST", "/api/onvif/device/add", mg_handle_post_add_onvif_device_as_stream, false},
-    {"POST", "/api/onvif/device/test", mg_handle_post_test_onvif_connection, false},
+    {"POST", "/api/onvif/device/test", mg_handle_post_test_onvif_connection, false, MG_WORK_PRIORITY_LOW},
 
     // Timeline API
     {"GET", "/api/timeline/segments", mg_handle_get_timeline_segments, true},  // Opt out of auto-threading to prevent hanging
     {"GET", "/api/timeline/manifest", mg_handle_timeline_manifest, true},
     {"GET", "/api/timeline/play", mg_handle_timeline_playback, false},
+    {"GET", "/api/timeline/preview/#", mg_handle_get_timeline_preview, false},
+    {"GET", "/api/timeline/sprite/#", mg_handle_get_timeline_sprite, false},
 
     // Motion Recording API
     {"GET", "/api/motion/config/#", mg_handle_get_motion_config, false},
@@ -175,7 +191,7 @@ static const mg_api_route_t s_api_routes[] = {
     {"GET", "/api/motion/stats/#", mg_handle_get_motion_stats, false},
     {"GET", "/api/motion/recordings/#", mg_handle_get_motion_recordings, false},
     {"DELETE", "/api/motion/recordings/#", mg_handle_delete_motion_recording, false},
-    {"POST", "/api/motion/cleanup", mg_handle_post_motion_cleanup, false},
+    {"POST", "/api/motion/cleanup", mg_handle_post_motion_cleanup, false, MG_WORK_PRIORITY_LOW},
     {"GET", "/api/motion/storage", mg_handle_get_motion_storage, false},
 
     // End of table marker
@@ -238,10 +254,17 @@ static bool handle_api_request(struct mg_connection *c, struct mg_http_message *
             data->mgr = c->mgr;
             data->handler_func = s_api_routes[route_index].handler;
 
-            // Start thread
-            mg_start_thread(mg_thread_function, data);
+            // Queue on the worker pool, turning the client away if it is saturated
+            if (!mg_queue_request(data, s_api_routes[route_index].priority)) {
+                log_warn("Worker pool saturated, rejecting API request: %s %s", method_buf, uri_buf);
+                free((void *)data->message.buf);
+                free(data);
+                mg_http_reply(c, 503, "Content-Type: application/json\r\nRetry-After: 1\r\n",
+                              "{\"error\":\"Server busy, try again\"}\n");
+                return true;
+            }
 
-            log_info("API request started in a worker thread: %s %s", method_buf, uri_buf);
+            log_info("API request queued for a worker thread: %s %s", method_buf, uri_buf);
             return true;
         } else {
             // Either threading is disabled or this handler has opted out of auto-threading
@@ -518,6 +541,11 @@ int http_server_start(http_server_handle_t server) {
         mg_tls_init(c, &opts);
     }
 
+    // Threaded API handlers run on a bounded pool, queue sized like the connection limit
+    if (mg_worker_pool_init(0, server->config.max_connections) != 0) {
+        log_warn("Failed to start HTTP worker pool, threaded requests will use their own threads");
+    }
+
     server->running = true;
     log_info("HTTP server started on port %d", server->config.port);
 
@@ -526,6 +554,7 @@ int http_server_start(http_server_handle_t server) {
     if (pthread_create(&thread, NULL, (void *(*)(void *))mongoose_server_event_loop, server) != 0) {
         log_error("Failed to create server thread");
         server->running = false;
+        mg_worker_pool_shutdown();
         c->is_closing = 1;
         mg_mgr_poll(server->mgr, 0);
         return -1;
@@ -556,6 +585,9 @@ void http_server_stop(http_server_handle_t server) {
     server->running = false;
     log_info("Stopping HTTP server");
 
+    // Answer queued requests with 503 and wait for running handlers before the manager goes away
+    mg_worker_pool_shutdown();
+
     // Give connections time to close gracefully
     usleep(250000); // 250ms for connections to close
 
@@ -822,6 +854,25 @@ int http_server_get_stats(http_server_handle_t server, int *active_connections,
     return 0;
 }
 
+void mongoose_server_attach_data(struct mg_connection *c, char tag, void *ptr) {
+    memcpy(&c->data[CONN_DATA_PTR_OFFSET], &ptr, sizeof(ptr));
+    c->data[CONN_DATA_TAG_OFFSET] = tag;
+}
+
+void *mongoose_server_get_data(struct mg_connection *c, char tag) {
+    if (c->data[CONN_DATA_TAG_OFFSET] != tag) {
+        return NULL;
+    }
+    void *ptr;
+    memcpy(&ptr, &c->data[CONN_DATA_PTR_OFFSET], sizeof(ptr));
+    return ptr;
+}
+
+void mongoose_server_detach_data(struct mg_connection *c) {
+    c->data[CONN_DATA_TAG_OFFSET] = 0;
+    memset(&c->data[CONN_DATA_PTR_OFFSET], 0, sizeof(void *));
+}
+
 /**
  * @brief Mongoose event handler
  */
@@ -1071,13 +1122,23 @@ static void mongoose_event_handler(struct mg_connection *c, int ev, void *ev_dat
         // Connection closed
         log_debug("Connection closed");
 
+        // A client may give up on a blocking playlist reload
+        mg_hls_release_blocked_request(c);
+
+        // Drop the live event subscription of an event stream client
+        mg_live_events_release(c);
+
         // Connection cleanup
         log_debug("Connection closed and cleaned up");
     } else if (ev == MG_EV_ERROR) {
         // Connection error
         log_error("Connection error: %s", (char *)ev_data);
     } else if (ev == MG_EV_POLL) {
-        // Poll event - do nothing
+        // Answer blocking playlist reloads whose segment has been published
+        mg_hls_poll_blocked_request(c);
+
+        // Push new detections, motion and recording events to subscribers
+        mg_live_events_poll(c);
     } else if (ev == MG_EV_READ || ev == MG_EV_WRITE) {
         // Read/write events - normal socket operations
         // No need to log these high-frequency events
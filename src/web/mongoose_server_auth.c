@@ -164,14 +164,11 @@ int mongoose_server_basic_auth_check(struct mg_http_message *hm, http_server_t *
         if (user[0] != '\0') {
             // First try to authenticate against the database
             int64_t user_id;
+            // db_auth_authenticate only accepts active users
             if (db_auth_authenticate(user, pass, &user_id) == 0) {
-                // Get the user to check if they're active
-                user_t db_user;
-                if (db_auth_get_user_by_id(user_id, &db_user) == 0 && db_user.is_active) {
-                    log_info("Authentication successful with database credentials for user: %s (ID: %lld)", 
-                            user, (long long)user_id);
-                    return 0; // Authentication successful
-                }
+                log_debug("Authentication successful with database credentials for user: %s (ID: %lld)",
+                        user, (long long)user_id);
+                return 0; // Authentication successful
             }
             
             // If database authentication fails, check against server config (legacy)
@@ -6,11 +6,13 @@
  * allowing it to handle multiple requests in parallel.
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <time.h>
 
 #include "web/mongoose_server.h"
 #include "web/mongoose_server_multithreading.h"
@@ -19,25 +21,376 @@
 
 // Thread data structure is defined in the header file
 
+// Worker pool defaults
+#define MG_WORKER_POOL_MIN_THREADS 4
+#define MG_WORKER_POOL_MAX_THREADS 16
+#define MG_WORKER_POOL_DEFAULT_CAPACITY 64
+
+// Time shutdown waits for running requests before leaving them behind
+#define MG_WORKER_POOL_JOIN_TIMEOUT_S 5
+
+// Response sent when a request cannot be queued
+#define MG_SERVICE_UNAVAILABLE_BODY "{\"error\":\"Server busy, try again\"}"
+#define MG_SERVICE_UNAVAILABLE_RESPONSE \
+  "HTTP/1.1 503 Service Unavailable\r\n" \
+  "Content-Type: application/json\r\n" \
+  "Retry-After: 1\r\n" \
+  "Content-Length: 34\r\n" \
+  "\r\n" \
+  MG_SERVICE_UNAVAILABLE_BODY
+
+typedef struct mg_work_item {
+  void *(*func)(void *);
+  void *arg;
+  struct timespec queued_at;
+  struct mg_work_item *next;
+} mg_work_item_t;
+
+static struct {
+  pthread_t *threads;
+  int thread_count;
+  int capacity;
+  bool running;
+
+  // One FIFO per priority, all protected by mutex
+  mg_work_item_t *head[MG_WORK_PRIORITY_COUNT];
+  mg_work_item_t *tail[MG_WORK_PRIORITY_COUNT];
+  int depth[MG_WORK_PRIORITY_COUNT];
+  int queued;
+  int active;
+  int peak_queued;
+
+  unsigned long long completed;
+  unsigned long long rejected;
+  double total_wait_ms;
+  double max_wait_ms;
+  double total_run_ms;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} s_pool = {
+  .mutex = PTHREAD_MUTEX_INITIALIZER,
+  .cond = PTHREAD_COND_INITIALIZER,
+};
+
+// Order in which workers pick up work
+static const mg_work_priority_t s_dispatch_order[] = {
+  MG_WORK_PRIORITY_HIGH, MG_WORK_PRIORITY_NORMAL, MG_WORK_PRIORITY_LOW
+};
+
+static double elapsed_ms(const struct timespec *from, const struct timespec *to) {
+  return (double)(to->tv_sec - from->tv_sec) * 1000.0 +
+         (double)(to->tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
 /**
- * @brief Start a thread
+ * @brief Queue depth at which a priority is turned away
  *
- * @param f Thread function
- * @param p Thread data
+ * Low priority work may only use half of the queue and normal priority work
+ * seven eighths, the rest is kept for high priority requests.
  */
-void mg_start_thread(void *(*f)(void *), void *p) {
-#ifdef _WIN32
-  _beginthread((void(__cdecl *)(void *)) f, 0, p);
-#else
-#define closesocket(x) close(x)
-#include <pthread.h>
+static int admission_limit(mg_work_priority_t priority) {
+  switch (priority) {
+    case MG_WORK_PRIORITY_HIGH:
+      return s_pool.capacity;
+    case MG_WORK_PRIORITY_LOW:
+      return s_pool.capacity / 2;
+    default:
+      return s_pool.capacity - s_pool.capacity / 8;
+  }
+}
+
+/**
+ * @brief Add work to the queue
+ *
+ * @return true if queued, false if the pool is not running or saturated
+ */
+static bool enqueue_work(void *(*func)(void *), void *arg, mg_work_priority_t priority) {
+  if (priority < 0 || priority >= MG_WORK_PRIORITY_COUNT) {
+    priority = MG_WORK_PRIORITY_NORMAL;
+  }
+
+  pthread_mutex_lock(&s_pool.mutex);
+
+  if (!s_pool.running) {
+    pthread_mutex_unlock(&s_pool.mutex);
+    return false;
+  }
+
+  if (s_pool.queued >= admission_limit(priority)) {
+    s_pool.rejected++;
+    pthread_mutex_unlock(&s_pool.mutex);
+    return false;
+  }
+
+  mg_work_item_t *item = (mg_work_item_t *) calloc(1, sizeof(*item));
+  if (!item) {
+    pthread_mutex_unlock(&s_pool.mutex);
+    return false;
+  }
+
+  item->func = func;
+  item->arg = arg;
+  clock_gettime(CLOCK_MONOTONIC, &item->queued_at);
+
+  if (s_pool.tail[priority]) {
+    s_pool.tail[priority]->next = item;
+  } else {
+    s_pool.head[priority] = item;
+  }
+  s_pool.tail[priority] = item;
+  s_pool.depth[priority]++;
+  s_pool.queued++;
+  if (s_pool.queued > s_pool.peak_queued) {
+    s_pool.peak_queued = s_pool.queued;
+  }
+
+  pthread_cond_signal(&s_pool.cond);
+  pthread_mutex_unlock(&s_pool.mutex);
+  return true;
+}
+
+/**
+ * @brief Take the next item, highest priority first (mutex must be held)
+ */
+static mg_work_item_t *dequeue_work_locked(void) {
+  for (size_t i = 0; i < sizeof(s_dispatch_order) / sizeof(s_dispatch_order[0]); i++) {
+    mg_work_priority_t priority = s_dispatch_order[i];
+    mg_work_item_t *item = s_pool.head[priority];
+    if (item) {
+      s_pool.head[priority] = item->next;
+      if (!s_pool.head[priority]) {
+        s_pool.tail[priority] = NULL;
+      }
+      s_pool.depth[priority]--;
+      s_pool.queued--;
+      return item;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Worker thread body
+ */
+static void *worker_pool_thread(void *arg) {
+  (void) arg;
+
+  pthread_mutex_lock(&s_pool.mutex);
+  for (;;) {
+    while (s_pool.running && s_pool.queued == 0) {
+      pthread_cond_wait(&s_pool.cond, &s_pool.mutex);
+    }
+    if (!s_pool.running) {
+      break;
+    }
+
+    mg_work_item_t *item = dequeue_work_locked();
+    if (!item) {
+      continue;
+    }
+
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    double wait_ms = elapsed_ms(&item->queued_at, &started);
+    s_pool.active++;
+    pthread_mutex_unlock(&s_pool.mutex);
+
+    item->func(item->arg);
+
+    struct timespec finished;
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    free(item);
+
+    pthread_mutex_lock(&s_pool.mutex);
+    s_pool.active--;
+    s_pool.completed++;
+    s_pool.total_wait_ms += wait_ms;
+    if (wait_ms > s_pool.max_wait_ms) {
+      s_pool.max_wait_ms = wait_ms;
+    }
+    s_pool.total_run_ms += elapsed_ms(&started, &finished);
+  }
+  pthread_mutex_unlock(&s_pool.mutex);
+
+  return NULL;
+}
+
+/**
+ * @brief Run work on a detached thread, used when the pool is not running
+ * and for work handed off with mg_start_thread
+ */
+static bool start_detached(void *(*f)(void *), void *p) {
   pthread_t thread_id = (pthread_t) 0;
   pthread_attr_t attr;
   (void) pthread_attr_init(&attr);
   (void) pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
-  pthread_create(&thread_id, &attr, f, p);
+  int rc = pthread_create(&thread_id, &attr, f, p);
   pthread_attr_destroy(&attr);
+  return rc == 0;
+}
+
+static bool pool_is_running(void) {
+  pthread_mutex_lock(&s_pool.mutex);
+  bool running = s_pool.running;
+  pthread_mutex_unlock(&s_pool.mutex);
+  return running;
+}
+
+int mg_worker_pool_init(int threads, int queue_capacity) {
+  pthread_mutex_lock(&s_pool.mutex);
+
+  if (s_pool.running) {
+    pthread_mutex_unlock(&s_pool.mutex);
+    return 0;
+  }
+
+  if (threads <= 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (int) cpus * 2 : MG_WORKER_POOL_MIN_THREADS;
+    if (threads < MG_WORKER_POOL_MIN_THREADS) threads = MG_WORKER_POOL_MIN_THREADS;
+    if (threads > MG_WORKER_POOL_MAX_THREADS) threads = MG_WORKER_POOL_MAX_THREADS;
+  }
+  if (queue_capacity <= 0) {
+    queue_capacity = MG_WORKER_POOL_DEFAULT_CAPACITY;
+  }
+
+  s_pool.threads = (pthread_t *) calloc((size_t) threads, sizeof(pthread_t));
+  if (!s_pool.threads) {
+    pthread_mutex_unlock(&s_pool.mutex);
+    log_error("Failed to allocate worker pool");
+    return -1;
+  }
+
+  s_pool.capacity = queue_capacity;
+  s_pool.running = true;
+  s_pool.thread_count = 0;
+
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&s_pool.threads[i], NULL, worker_pool_thread, NULL) != 0) {
+      log_error("Failed to create worker thread %d", i);
+      break;
+    }
+    s_pool.thread_count++;
+  }
+
+  if (s_pool.thread_count == 0) {
+    s_pool.running = false;
+    free(s_pool.threads);
+    s_pool.threads = NULL;
+    pthread_mutex_unlock(&s_pool.mutex);
+    return -1;
+  }
+
+  pthread_mutex_unlock(&s_pool.mutex);
+
+  log_info("HTTP worker pool started: %d threads, queue capacity %d",
+           s_pool.thread_count, s_pool.capacity);
+  return 0;
+}
+
+void mg_worker_pool_shutdown(void) {
+  pthread_mutex_lock(&s_pool.mutex);
+
+  if (!s_pool.running) {
+    pthread_mutex_unlock(&s_pool.mutex);
+    return;
+  }
+
+  s_pool.running = false;
+
+  // Answer whatever is still queued instead of running it (only requests
+  // from mg_queue_request are queued)
+  mg_work_item_t *item;
+  while ((item = dequeue_work_locked()) != NULL) {
+    struct mg_thread_data *data = (struct mg_thread_data *) item->arg;
+    mg_wakeup(data->mgr, data->conn_id, MG_SERVICE_UNAVAILABLE_RESPONSE,
+              strlen(MG_SERVICE_UNAVAILABLE_RESPONSE));
+    free((void *) data->message.buf);
+    free(data);
+    free(item);
+  }
+
+  pthread_cond_broadcast(&s_pool.cond);
+  pthread_t *threads = s_pool.threads;
+  int thread_count = s_pool.thread_count;
+  s_pool.threads = NULL;
+  s_pool.thread_count = 0;
+  pthread_mutex_unlock(&s_pool.mutex);
+
+  // One deadline for all workers so a long request cannot hold up shutdown
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += MG_WORKER_POOL_JOIN_TIMEOUT_S;
+
+  for (int i = 0; i < thread_count; i++) {
+#if defined(__linux__) && defined(_GNU_SOURCE)
+    int rc = pthread_timedjoin_np(threads[i], NULL, &deadline);
+    if (rc != 0) {
+      log_warn("HTTP worker %d still running a request at shutdown, not waiting for it", i);
+      pthread_detach(threads[i]);
+    }
+#else
+    pthread_join(threads[i], NULL);
 #endif
+  }
+  free(threads);
+
+  log_info("HTTP worker pool stopped (%llu requests completed, %llu rejected)",
+           s_pool.completed, s_pool.rejected);
+}
+
+bool mg_queue_request(struct mg_thread_data *data, mg_work_priority_t priority) {
+  if (!data) {
+    return false;
+  }
+  if (enqueue_work(mg_thread_function, data, priority)) {
+    return true;
+  }
+  if (pool_is_running()) {
+    return false;
+  }
+  return start_detached(mg_thread_function, data);
+}
+
+void mg_worker_pool_get_stats(mg_worker_pool_stats_t *stats) {
+  if (!stats) {
+    return;
+  }
+
+  memset(stats, 0, sizeof(*stats));
+
+  pthread_mutex_lock(&s_pool.mutex);
+  stats->threads = s_pool.thread_count;
+  stats->active = s_pool.active;
+  stats->queued = s_pool.queued;
+  for (int i = 0; i < MG_WORK_PRIORITY_COUNT; i++) {
+    stats->queued_by_priority[i] = s_pool.depth[i];
+  }
+  stats->capacity = s_pool.capacity;
+  stats->peak_queued = s_pool.peak_queued;
+  stats->completed = s_pool.completed;
+  stats->rejected = s_pool.rejected;
+  if (s_pool.completed > 0) {
+    stats->avg_wait_ms = s_pool.total_wait_ms / (double) s_pool.completed;
+    stats->avg_run_ms = s_pool.total_run_ms / (double) s_pool.completed;
+  }
+  stats->max_wait_ms = s_pool.max_wait_ms;
+  pthread_mutex_unlock(&s_pool.mutex);
+}
+
+/**
+ * @brief Start a thread
+ *
+ * @param f Thread function
+ * @param p Thread data
+ */
+void mg_start_thread(void *(*f)(void *), void *p) {
+  // Handlers hand off here after already replying (202) or for long jobs
+  // such as ONVIF discovery, so never reject them or tie up a pool worker
+  if (!start_detached(f, p)) {
+    log_error("Failed to start thread");
+  }
 }
 
 /**
@@ -12,6 +12,7 @@
 #include "core/config.h"
 #include "video/streams.h"
 #include "database/db_auth.h"
+#include "web/api_handlers_streaming.h"
 
 #ifdef USE_GO2RTC
 #include "video/go2rtc/go2rtc_integration.h"
@@ -134,6 +135,11 @@ void mongoose_server_handle_static_file(struct mg_connection *c, struct mg_http_
         
         // Extract file name (everything after the stream name)
         const char *file_name = file_part + 1; // Skip "/"
+
+        // Live HLS kept in memory is served without touching the filesystem
+        if (mg_serve_hls_from_memory(c, hm, decoded_stream_name, file_name)) {
+            return;
+        }
         
         // Construct the full path to the HLS file
         char hls_file_path[MAX_PATH_LENGTH * 2]; // Double the buffer size to avoid truncation
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "database/db_auth_cache.h"
+#include "core/logger.h"
+#include "test_common.h"
+
+static void test_store_and_lookup(void) {
+    int64_t user_id = 0;
+
+    auth_cache_store(AUTH_CACHE_SESSION, "token-a", 7, 0, auth_cache_generation());
+    CHECK(auth_cache_lookup(AUTH_CACHE_SESSION, "token-a", &user_id) && user_id == 7,
+          "stored session is found with its user");
+    CHECK(!auth_cache_lookup(AUTH_CACHE_API_KEY, "token-a", NULL),
+          "credential kinds are kept apart");
+    CHECK(!auth_cache_lookup(AUTH_CACHE_SESSION, "token-b", NULL),
+          "unknown token misses");
+}
+
+static void test_remove(void) {
+    auth_cache_store(AUTH_CACHE_SESSION, "token-remove", 8, 0, auth_cache_generation());
+    auth_cache_remove(AUTH_CACHE_SESSION, "token-remove");
+    CHECK(!auth_cache_lookup(AUTH_CACHE_SESSION, "token-remove", NULL),
+          "removed session misses");
+}
+
+static void test_invalidate_user(void) {
+    unsigned int generation = auth_cache_generation();
+    auth_cache_store(AUTH_CACHE_SESSION, "token-user", 9, 0, generation);
+    auth_cache_store(AUTH_CACHE_API_KEY, "key-user", 9, 0, generation);
+    auth_cache_store(AUTH_CACHE_BASIC, "digest-other", 10, 0, generation);
+
+    auth_cache_invalidate_user(9);
+    CHECK(!auth_cache_lookup(AUTH_CACHE_SESSION, "token-user", NULL),
+          "user invalidation drops sessions");
+    CHECK(!auth_cache_lookup(AUTH_CACHE_API_KEY, "key-user", NULL),
+          "user invalidation drops API keys");
+    CHECK(auth_cache_lookup(AUTH_CACHE_BASIC, "digest-other", NULL),
+          "user invalidation keeps other users");
+}
+
+static void test_stale_store_rejected(void) {
+    // A validation that started before an invalidation must not be cached
+    unsigned int generation = auth_cache_generation();
+    auth_cache_invalidate_user(11);
+    auth_cache_store(AUTH_CACHE_SESSION, "token-stale", 11, 0, generation);
+    CHECK(!auth_cache_lookup(AUTH_CACHE_SESSION, "token-stale", NULL),
+          "store after a concurrent invalidation is ignored");
+}
+
+static void test_expiry(void) {
+    auth_cache_store(AUTH_CACHE_SESSION, "token-expired", 12, time(NULL) - 1,
+                     auth_cache_generation());
+    CHECK(!auth_cache_lookup(AUTH_CACHE_SESSION, "token-expired", NULL),
+          "expired session is not cached");
+}
+
+static void test_eviction(void) {
+    // Far more entries than the cache holds, all must remain consistent
+    char key[32];
+    unsigned int generation = auth_cache_generation();
+    for (int i = 0; i < 4096; i++) {
+        snprintf(key, sizeof(key), "bulk-%d", i);
+        auth_cache_store(AUTH_CACHE_SESSION, key, 1000 + i, 0, generation);
+    }
+
+    int hits = 0, wrong = 0;
+    for (int i = 0; i < 4096; i++) {
+        int64_t user_id = 0;
+        snprintf(key, sizeof(key), "bulk-%d", i);
+        if (auth_cache_lookup(AUTH_CACHE_SESSION, key, &user_id)) {
+            hits++;
+            if (user_id != 1000 + i) wrong++;
+        }
+    }
+    CHECK(hits > 0 && wrong == 0, "evicting entries never returns the wrong user");
+
+    auth_cache_clear();
+    CHECK(!auth_cache_lookup(AUTH_CACHE_SESSION, "bulk-4095", NULL), "clear drops everything");
+}
+
+int main(void) {
+    init_logger();
+    set_log_level(LOG_LEVEL_ERROR);
+
+    test_store_and_lookup();
+    test_remove();
+    test_invalidate_user();
+    test_stale_store_rejected();
+    test_expiry();
+    test_eviction();
+
+    shutdown_logger();
+
+    return test_summary("auth cache");
+}
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "database/db_core.h"
+#include "database/db_recordings.h"
+#include "core/logger.h"
+#include "test_common.h"
+
+// Test database path
+#define TEST_DB_PATH "/tmp/test_recordings_delete.sqlite"
+
+static uint64_t add_recording(const char *stream_name, time_t start_time, const char *trigger_type) {
+    recording_metadata_t recording;
+    memset(&recording, 0, sizeof(recording));
+    snprintf(recording.stream_name, sizeof(recording.stream_name), "%s", stream_name);
+    snprintf(recording.file_path, sizeof(recording.file_path), "/recordings/%s/%ld.mp4",
+             stream_name, (long)start_time);
+    snprintf(recording.codec, sizeof(recording.codec), "h264");
+    snprintf(recording.trigger_type, sizeof(recording.trigger_type), "%s", trigger_type);
+    recording.start_time = start_time;
+    recording.end_time = start_time + 60;
+    recording.size_bytes = 1000;
+    recording.is_complete = true;
+    return add_recording_metadata(&recording);
+}
+
+static void test_delete_by_ids(void) {
+    enum { COUNT = 1200 };
+    uint64_t ids[COUNT + 1];
+    recording_metadata_t found;
+    char **paths = NULL;
+
+    // More IDs than fit in one statement
+    for (int i = 0; i < COUNT; i++) {
+        ids[i] = add_recording("front", 1000 + i * 60, "scheduled");
+    }
+    ids[COUNT] = ids[COUNT - 1] + 1000;
+
+    int deleted = delete_recordings_by_ids(ids, COUNT + 1, &paths);
+    CHECK(deleted == COUNT, "every existing ID is deleted, missing IDs are skipped");
+    CHECK(paths && strcmp(paths[0], "/recordings/front/1000.mp4") == 0, "file paths are returned");
+    CHECK(get_recording_metadata_by_id(ids[COUNT / 2], &found) != 0, "deleted recording is gone");
+    CHECK(get_recording_count(0, 0, "front", 0) == 0, "no recordings are left");
+    free_recording_paths(paths, deleted);
+
+    CHECK(delete_recordings_by_ids(ids, 0, &paths) == 0 && paths == NULL, "empty ID list deletes nothing");
+}
+
+static void test_delete_by_filter(void) {
+    char **paths = NULL;
+
+    add_recording("front", 10000, "scheduled");
+    add_recording("front", 20000, "detection");
+    add_recording("front", 30000, "detection");
+    uint64_t kept = add_recording("back", 20000, "detection");
+
+    int deleted = delete_recordings_by_filter(15000, 0, "front", 1, &paths);
+    CHECK(deleted == 2, "filter deletes the matching recordings");
+    free_recording_paths(paths, deleted);
+
+    recording_metadata_t found;
+    CHECK(get_recording_metadata_by_id(kept, &found) == 0, "other streams are kept");
+    CHECK(get_recording_count(0, 0, "front", 0) == 1, "recordings outside the filter are kept");
+
+    deleted = delete_recordings_by_filter(0, 0, NULL, 0, &paths);
+    CHECK(deleted == 2, "empty filter deletes every complete recording");
+    free_recording_paths(paths, deleted);
+}
+
+int main(void) {
+    init_logger();
+    set_log_level(LOG_LEVEL_ERROR);
+
+    unlink(TEST_DB_PATH);
+    if (init_database(TEST_DB_PATH) != 0) {
+        printf("Failed to initialize database\n");
+        return 1;
+    }
+
+    test_delete_by_ids();
+    test_delete_by_filter();
+
+    shutdown_database();
+    unlink(TEST_DB_PATH);
+    shutdown_logger();
+
+    return test_summary("recordings delete");
+}
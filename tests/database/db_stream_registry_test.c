@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "database/db_core.h"
+#include "database/db_streams.h"
+#include "database/db_stream_registry.h"
+#include "core/logger.h"
+#include "test_common.h"
+
+// Test database path
+#define TEST_DB_PATH "/tmp/test_stream_registry.sqlite"
+
+static void make_stream(stream_config_t *stream, const char *name, int segment_duration) {
+    memset(stream, 0, sizeof(*stream));
+    snprintf(stream->name, sizeof(stream->name), "%s", name);
+    snprintf(stream->url, sizeof(stream->url), "rtsp://camera/%s", name);
+    snprintf(stream->codec, sizeof(stream->codec), "h264");
+    stream->enabled = true;
+    stream->streaming_enabled = true;
+    stream->record = true;
+    stream->segment_duration = segment_duration;
+    stream->detection_threshold = 0.5f;
+    stream->detection_interval = 10;
+}
+
+static void test_lookup(void) {
+    stream_config_t stream, found;
+
+    make_stream(&stream, "front", 60);
+    CHECK(add_stream_config(&stream) != 0, "stream is added");
+    CHECK(get_stream_config_by_name("front", &found) == 0 && found.segment_duration == 60,
+          "added stream is found");
+    CHECK(stream_registry_generation() != 0, "registry is loaded on first lookup");
+    CHECK(get_stream_config_by_name("missing", &found) != 0, "unknown stream is not found");
+}
+
+static void test_refresh(void) {
+    stream_config_t stream, copy;
+    uint64_t generation = 0;
+
+    CHECK(stream_registry_refresh("front", &copy, &generation) == 1 && copy.segment_duration == 60,
+          "first refresh copies the configuration");
+    CHECK(stream_registry_refresh("front", &copy, &generation) == 0,
+          "refresh without a change is a no-op");
+
+    make_stream(&stream, "front", 120);
+    CHECK(update_stream_config("front", &stream) == 0, "stream is updated");
+    CHECK(stream_registry_refresh("front", &copy, &generation) == 1 && copy.segment_duration == 120,
+          "refresh picks up the update");
+
+    // Writes that bypass db_streams.c are picked up through an explicit reload
+    sqlite3_exec(get_db_handle(), "UPDATE streams SET segment_duration = 30 WHERE name = 'front';",
+                 NULL, NULL, NULL);
+    stream_registry_reload("front");
+    CHECK(stream_registry_refresh("front", &copy, &generation) == 1 && copy.segment_duration == 30,
+          "reload picks up direct table writes");
+}
+
+static void test_rename_and_delete(void) {
+    stream_config_t stream, found;
+
+    make_stream(&stream, "back", 60);
+    CHECK(update_stream_config("front", &stream) == 0, "stream is renamed");
+    CHECK(get_stream_config_by_name("front", &found) != 0, "old name is gone after a rename");
+    CHECK(get_stream_config_by_name("back", &found) == 0, "new name is found after a rename");
+
+    CHECK(delete_stream_config("back") == 0, "stream is disabled");
+    CHECK(get_stream_config_by_name("back", &found) == 0 && !found.enabled,
+          "disabled stream stays in the registry");
+
+    uint64_t generation = 0;
+    stream_config_t copy;
+    stream_registry_refresh("back", &copy, &generation);
+    CHECK(delete_stream_config_internal("back", true) == 0, "stream is deleted");
+    CHECK(stream_registry_refresh("back", &copy, &generation) == -1,
+          "refresh reports a deleted stream");
+}
+
+int main(void) {
+    init_logger();
+    set_log_level(LOG_LEVEL_ERROR);
+
+    unlink(TEST_DB_PATH);
+    if (init_database(TEST_DB_PATH) != 0) {
+        printf("Failed to initialize database\n");
+        return 1;
+    }
+
+    test_lookup();
+    test_refresh();
+    test_rename_and_delete();
+
+    shutdown_database();
+    unlink(TEST_DB_PATH);
+    shutdown_logger();
+
+    return test_summary("stream registry");
+}
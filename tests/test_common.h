@@ -0,0 +1,40 @@
+/**
+ * @file test_common.h
+ * @brief Check macro and summary shared by the standalone test programs
+ *
+ * Each test is its own executable, so the failure counter lives here.
+ */
+
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { \
+        printf("FAIL: %s\n", msg); \
+        failures++; \
+    } else { \
+        printf("PASS: %s\n", msg); \
+    } \
+} while (0)
+
+/**
+ * Print the result line for a test program
+ *
+ * @param name What was tested, e.g. "HLS memory store"
+ * @return Exit status for main()
+ */
+static inline int test_summary(const char *name) {
+    if (failures > 0) {
+        printf("%d %s test(s) failed\n", failures, name);
+        return 1;
+    }
+
+    printf("All %s tests passed\n", name);
+    return 0;
+}
+
+#endif /* TEST_COMMON_H */
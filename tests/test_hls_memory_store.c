@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libavutil/mem.h>
+
+#include "video/hls_memory_store.h"
+#include "core/logger.h"
+#include "test_common.h"
+
+static int put_text(const char *stream, const char *name, const char *text) {
+    size_t len = strlen(text);
+    uint8_t *data = av_malloc(len);
+    if (!data) {
+        return -1;
+    }
+    memcpy(data, text, len);
+    return hls_memory_store_put(stream, name, data, len);
+}
+
+static void test_put_and_get(void) {
+    put_text("cam", "segment_0.ts", "first");
+    hls_memory_file_t *file = hls_memory_store_get("cam", "segment_0.ts");
+    CHECK(file && file->size == 5 && memcmp(file->data, "first", 5) == 0, "stored segment is returned");
+
+    // Replacing a file keeps the old contents alive for the reader holding it
+    put_text("cam", "segment_0.ts", "second");
+    hls_memory_file_t *replaced = hls_memory_store_get("cam", "segment_0.ts");
+    CHECK(file && memcmp(file->data, "first", 5) == 0, "held file survives replacement");
+    CHECK(replaced && replaced->size == 6 && file && replaced->serial != file->serial,
+          "replacement gets a new ETag serial");
+
+    hls_memory_file_release(file);
+    hls_memory_file_release(replaced);
+    CHECK(!hls_memory_store_get("other", "segment_0.ts"), "streams are kept apart");
+}
+
+static void test_ring_eviction(void) {
+    char name[32];
+    for (int i = 1; i <= HLS_MEMORY_MAX_SEGMENTS + 2; i++) {
+        snprintf(name, sizeof(name), "segment_%d.ts", i);
+        put_text("ring", name, "data");
+    }
+
+    hls_memory_file_t *oldest = hls_memory_store_get("ring", "segment_1.ts");
+    CHECK(!oldest, "oldest segment is evicted once the ring is full");
+    hls_memory_file_release(oldest);
+
+    char newest[HLS_MEMORY_MAX_FILE_NAME];
+    int count = 0;
+    snprintf(name, sizeof(name), "segment_%d.ts", HLS_MEMORY_MAX_SEGMENTS + 2);
+    CHECK(hls_memory_store_newest_segment("ring", newest, sizeof(newest), NULL, &count) &&
+          strcmp(newest, name) == 0 && count == HLS_MEMORY_MAX_SEGMENTS,
+          "newest segment and segment count are reported");
+
+    // Playlists are not part of the segment ring
+    put_text("ring", "index.m3u8", "#EXTM3U\n");
+    for (int i = 0; i < HLS_MEMORY_MAX_SEGMENTS; i++) {
+        snprintf(name, sizeof(name), "late_%d.ts", i);
+        put_text("ring", name, "data");
+    }
+    hls_memory_file_t *playlist = hls_memory_store_get("ring", "index.m3u8");
+    CHECK(playlist != NULL, "playlist is never evicted by segments");
+    hls_memory_file_release(playlist);
+
+    hls_memory_store_remove("ring");
+    CHECK(!hls_memory_store_get("ring", "index.m3u8"), "removing a stream drops its files");
+}
+
+static void test_playlist_state(void) {
+    int64_t last = 0;
+    int target = 0;
+
+    CHECK(!hls_memory_store_playlist_state("live", &last, &target), "no state before a playlist");
+
+    put_text("live", "index.m3u8",
+             "#EXTM3U\n"
+             "#EXT-X-VERSION:3\n"
+             "#EXT-X-TARGETDURATION:4\n"
+             "#EXT-X-MEDIA-SEQUENCE:17\n"
+             "#EXTINF:4.000000,\n"
+             "segment_17.ts\n"
+             "#EXTINF:4.000000,\n"
+             "segment_18.ts\n"
+             "#EXTINF:4.000000,\n"
+             "segment_19.ts\n");
+    CHECK(hls_memory_store_playlist_state("live", &last, &target) && last == 19 && target == 4,
+          "media sequence of the newest listed segment is parsed");
+}
+
+static void test_save_for_pre_detection_buffer(void) {
+    // The pre-detection buffer keeps copies of in-memory segments on disk
+    const char *path = "/tmp/test_hls_memory_store_buffer_0.ts";
+    unlink(path);
+
+    put_text("buffered", "segment_3.ts", "segment bytes");
+    CHECK(hls_memory_store_save("buffered", "segment_3.ts", path) == 0, "stored segment is written out");
+
+    char contents[32] = {0};
+    FILE *file = fopen(path, "rb");
+    size_t read = file ? fread(contents, 1, sizeof(contents) - 1, file) : 0;
+    if (file) {
+        fclose(file);
+    }
+    CHECK(read == 13 && strcmp(contents, "segment bytes") == 0, "written copy matches the stored segment");
+
+    // The copy outlives the segment being evicted from the store
+    hls_memory_store_remove("buffered");
+    CHECK(access(path, F_OK) == 0, "copy survives eviction from the store");
+    CHECK(hls_memory_store_save("buffered", "segment_3.ts", path) != 0, "evicted segment cannot be saved");
+    unlink(path);
+}
+
+int main(void) {
+    init_logger();
+    set_log_level(LOG_LEVEL_ERROR);
+
+    test_put_and_get();
+    test_ring_eviction();
+    test_playlist_state();
+    test_save_for_pre_detection_buffer();
+
+    hls_memory_store_clear();
+    shutdown_logger();
+
+    return test_summary("HLS memory store");
+}
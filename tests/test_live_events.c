@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "video/live_events.h"
+#include "core/logger.h"
+#include "test_common.h"
+
+static void make_result(detection_result_t *result, int count, const char *label) {
+    memset(result, 0, sizeof(*result));
+    result->count = count;
+    for (int i = 0; i < count; i++) {
+        snprintf(result->detections[i].label, MAX_LABEL_LENGTH, "%s", label);
+        result->detections[i].confidence = 0.9f;
+        result->detections[i].track_id = -1;
+    }
+}
+
+static void test_detections(void) {
+    detection_result_t result, latest;
+    live_event_t events[8];
+    uint64_t sequence = 0;
+
+    CHECK(live_events_sequence() == 0, "no events before the first publish");
+    CHECK(!live_events_get_detections("cam", &latest, NULL, NULL), "unknown stream has no detections");
+
+    make_result(&result, 2, "person");
+    live_events_publish_detections("cam", &result, 0);
+    CHECK(live_events_read(0, events, 8) == 1 && events[0].type == LIVE_EVENT_DETECTION &&
+          events[0].active && strcmp(events[0].stream_name, "cam") == 0,
+          "detection result is published as an event");
+    CHECK(live_events_get_detections("cam", &latest, NULL, &sequence) && latest.count == 2 &&
+          sequence == events[0].sequence, "latest result is kept per stream");
+
+    // A newer result supersedes the previous event
+    make_result(&result, 1, "car");
+    live_events_publish_detections("cam", &result, 0);
+    live_events_get_detections("cam", &latest, NULL, &sequence);
+    CHECK(latest.count == 1 && strcmp(latest.detections[0].label, "car") == 0 &&
+          sequence == live_events_sequence(), "newer result replaces the slot");
+
+    make_result(&result, 0, "");
+    live_events_publish_detections("cam", &result, 0);
+    uint64_t after_clear = live_events_sequence();
+    live_events_publish_detections("cam", &result, 0);
+    CHECK(live_events_sequence() == after_clear, "repeated empty result is not an event");
+}
+
+static void test_state_events(void) {
+    live_event_t events[8];
+    uint64_t before = live_events_sequence();
+
+    live_events_publish_motion("cam", true, 0);
+    live_events_publish_motion("cam", true, 0);
+    live_events_publish_recording("cam", true);
+    live_events_publish_motion("cam", false, 0);
+
+    int count = live_events_read(before, events, 8);
+    CHECK(count == 3, "repeated motion report is not an event");
+    CHECK(count == 3 && events[0].type == LIVE_EVENT_MOTION && events[0].active &&
+          events[1].type == LIVE_EVENT_RECORDING && events[1].active &&
+          events[2].type == LIVE_EVENT_MOTION && !events[2].active,
+          "state changes are read back in order");
+}
+
+static void test_ring_overflow(void) {
+    live_event_t events[LIVE_EVENTS_RING_SIZE];
+    uint64_t before = live_events_sequence();
+
+    for (int i = 0; i < LIVE_EVENTS_RING_SIZE + 10; i++) {
+        live_events_publish_recording("cam", i % 2 == 0);
+    }
+
+    int count = live_events_read(before, events, LIVE_EVENTS_RING_SIZE);
+    CHECK(count == LIVE_EVENTS_RING_SIZE, "slow reader gets a full ring");
+    CHECK(events[0].sequence == before + 11 &&
+          events[count - 1].sequence == live_events_sequence(),
+          "events that fell out of the ring are skipped");
+    CHECK(live_events_read(live_events_sequence(), events, LIVE_EVENTS_RING_SIZE) == 0,
+          "caught up reader gets nothing");
+}
+
+int main(void) {
+    init_logger();
+    set_log_level(LOG_LEVEL_ERROR);
+
+    test_detections();
+    test_state_events();
+    test_ring_overflow();
+
+    shutdown_logger();
+
+    return test_summary("live event");
+}
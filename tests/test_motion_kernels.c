@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "video/motion_kernels.h"
+#include "core/logger.h"
+
+/**
+ * Bit-exactness check and microbenchmark for the motion detection kernels
+ *
+ * Every vector variant supported by this CPU is run against the scalar
+ * reference on random frames of awkward sizes, then all variants are timed
+ * on a 1280x720 frame.  Pass --bench-only to skip the exactness check.
+ */
+
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 720
+#define BENCH_ITERATIONS 200
+
+static const motion_isa_t vector_isas[] = { MOTION_ISA_SSE2, MOTION_ISA_AVX2, MOTION_ISA_NEON };
+
+static int failures = 0;
+
+static void fill_random(uint8_t *buf, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        buf[i] = (uint8_t)(rand() & 0xFF);
+    }
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void expect_same(const char *isa, const char *kernel, const uint8_t *a, const uint8_t *b,
+                        size_t size, int width, int height, int param) {
+    if (memcmp(a, b, size) != 0) {
+        fprintf(stderr, "FAIL: %s %s differs from scalar (%dx%d, param %d)\n",
+                isa, kernel, width, height, param);
+        failures++;
+    }
+}
+
+static void check_kernels(const motion_kernels_t *ref, const motion_kernels_t *vec) {
+    static const int sizes[][2] = {
+        {1, 1}, {7, 3}, {16, 2}, {33, 17}, {64, 64}, {65, 31}, {127, 45}, {320, 180}, {641, 361}
+    };
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int w = sizes[s][0];
+        int h = sizes[s][1];
+        size_t plane = (size_t)w * h;
+
+        uint8_t *src = malloc(plane * 3 + 64);
+        uint8_t *prev = malloc(plane);
+        uint8_t *bg = malloc(plane);
+        uint8_t *out_ref = malloc(plane);
+        uint8_t *out_vec = malloc(plane);
+        uint8_t *tmp = malloc(plane);
+        if (!src || !prev || !bg || !out_ref || !out_vec || !tmp) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+
+        fill_random(src, plane * 3 + 64);
+        fill_random(prev, plane);
+        fill_random(bg, plane);
+
+        // RGB to gray, with padded rows
+        int rgb_stride = w * 3 + 16;
+        int rows = (int)((plane * 3 + 64) / rgb_stride);
+        if (rows > h) rows = h;
+        ref->rgb_to_gray(src, rgb_stride, out_ref, w, w, rows);
+        vec->rgb_to_gray(src, rgb_stride, out_vec, w, w, rows);
+        expect_same(vec->name, "rgb_to_gray", out_ref, out_vec, (size_t)w * rows, w, rows, rgb_stride);
+
+        // Downscale, including outputs padded past the source
+        for (int factor = 2; factor <= 4; factor++) {
+            int dw = w / factor < 1 ? 1 : w / factor;
+            int dh = h / factor < 1 ? 1 : h / factor;
+            ref->downscale(src, w, w, h, factor, out_ref, dw, dh);
+            vec->downscale(src, w, w, h, factor, out_vec, dw, dh);
+            expect_same(vec->name, "downscale", out_ref, out_vec, (size_t)dw * dh, w, h, factor);
+        }
+
+        // Box blur for every supported radius
+        for (int radius = 0; radius <= 6; radius++) {
+            ref->box_blur(src, out_ref, w, h, radius, tmp);
+            vec->box_blur(src, out_vec, w, h, radius, tmp);
+            expect_same(vec->name, "box_blur", out_ref, out_vec, plane, w, h, radius);
+        }
+
+        // Background update at both learning rates used by motion detection
+        static const int alphas[] = {0, 2, 12, 128, 256};
+        for (size_t a = 0; a < sizeof(alphas) / sizeof(alphas[0]); a++) {
+            memcpy(out_ref, bg, plane);
+            memcpy(out_vec, bg, plane);
+            ref->update_background(out_ref, src, (int)plane, alphas[a]);
+            vec->update_background(out_vec, src, (int)plane, alphas[a]);
+            expect_same(vec->name, "update_background", out_ref, out_vec, plane, w, h, alphas[a]);
+        }
+
+        // Cell statistics on whole frames and odd-aligned cells
+        static const int thresholds[] = {0, 10, 38, 200, 255};
+        for (size_t t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); t++) {
+            int x0 = w > 2 ? 1 : 0;
+            int y0 = h > 2 ? 1 : 0;
+            motion_cell_stats_t a, b;
+
+            ref->cell_stats(src, prev, bg, w, 0, 0, w, h, thresholds[t], &a);
+            vec->cell_stats(src, prev, bg, w, 0, 0, w, h, thresholds[t], &b);
+            if (memcmp(&a, &b, sizeof(a)) != 0) {
+                fprintf(stderr, "FAIL: %s cell_stats differs from scalar (%dx%d, threshold %d)\n",
+                        vec->name, w, h, thresholds[t]);
+                failures++;
+            }
+
+            ref->cell_stats(src, prev, bg, w, x0, y0, w - x0, h, thresholds[t], &a);
+            vec->cell_stats(src, prev, bg, w, x0, y0, w - x0, h, thresholds[t], &b);
+            if (memcmp(&a, &b, sizeof(a)) != 0) {
+                fprintf(stderr, "FAIL: %s cell_stats differs from scalar on offset cell (%dx%d, threshold %d)\n",
+                        vec->name, w, h, thresholds[t]);
+                failures++;
+            }
+        }
+
+        free(src);
+        free(prev);
+        free(bg);
+        free(out_ref);
+        free(out_vec);
+        free(tmp);
+    }
+}
+
+static void bench_kernels(const motion_kernels_t *k) {
+    const int w = BENCH_WIDTH;
+    const int h = BENCH_HEIGHT;
+    size_t plane = (size_t)w * h;
+
+    uint8_t *rgb = malloc(plane * 3);
+    uint8_t *gray = malloc(plane);
+    uint8_t *small = malloc(plane / 4);
+    uint8_t *blur = malloc(plane / 4);
+    uint8_t *prev = malloc(plane / 4);
+    uint8_t *bg = malloc(plane / 4);
+    uint8_t *tmp = malloc(plane / 4);
+    if (!rgb || !gray || !small || !blur || !prev || !bg || !tmp) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    fill_random(rgb, plane * 3);
+    fill_random(prev, plane / 4);
+    fill_random(bg, plane / 4);
+
+    double t_gray = 0, t_down = 0, t_blur = 0, t_bg = 0, t_cells = 0;
+    volatile int sink = 0;
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        double t0 = now_ms();
+        k->rgb_to_gray(rgb, w * 3, gray, w, w, h);
+        double t1 = now_ms();
+        k->downscale(gray, w, w, h, 2, small, w / 2, h / 2);
+        double t2 = now_ms();
+        k->box_blur(small, blur, w / 2, h / 2, 1, tmp);
+        double t3 = now_ms();
+        k->update_background(bg, blur, (int)(plane / 4), 12);
+        double t4 = now_ms();
+        for (int gy = 0; gy < 6; gy++) {
+            for (int gx = 0; gx < 6; gx++) {
+                motion_cell_stats_t stats;
+                int cw = (w / 2) / 6;
+                int ch = (h / 2) / 6;
+                k->cell_stats(blur, prev, bg, w / 2, gx * cw, gy * ch, (gx + 1) * cw, (gy + 1) * ch, 38, &stats);
+                sink += stats.changed;
+            }
+        }
+        double t5 = now_ms();
+
+        t_gray += t1 - t0;
+        t_down += t2 - t1;
+        t_blur += t3 - t2;
+        t_bg += t4 - t3;
+        t_cells += t5 - t4;
+    }
+
+    printf("%-8s rgb_to_gray %7.3f ms  downscale %7.3f ms  box_blur %7.3f ms  background %7.3f ms  cells %7.3f ms\n",
+           k->name, t_gray / BENCH_ITERATIONS, t_down / BENCH_ITERATIONS, t_blur / BENCH_ITERATIONS,
+           t_bg / BENCH_ITERATIONS, t_cells / BENCH_ITERATIONS);
+
+    free(rgb);
+    free(gray);
+    free(small);
+    free(blur);
+    free(prev);
+    free(bg);
+    free(tmp);
+}
+
+int main(int argc, char **argv) {
+    bool bench_only = argc > 1 && strcmp(argv[1], "--bench-only") == 0;
+
+    init_logger();
+    set_log_level(LOG_LEVEL_INFO);
+    srand(12345);
+
+    const motion_kernels_t *ref = motion_kernels_for_isa(MOTION_ISA_SCALAR);
+    printf("Selected motion kernels: %s\n", motion_kernels_get()->name);
+
+    if (!bench_only) {
+        for (size_t i = 0; i < sizeof(vector_isas) / sizeof(vector_isas[0]); i++) {
+            const motion_kernels_t *vec = motion_kernels_for_isa(vector_isas[i]);
+            if (vec) {
+                check_kernels(ref, vec);
+                printf("%s kernels checked against scalar\n", vec->name);
+            }
+        }
+    }
+
+    printf("Timing %dx%d, average of %d iterations:\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_ITERATIONS);
+    bench_kernels(ref);
+    for (size_t i = 0; i < sizeof(vector_isas) / sizeof(vector_isas[0]); i++) {
+        const motion_kernels_t *vec = motion_kernels_for_isa(vector_isas[i]);
+        if (vec) {
+            bench_kernels(vec);
+        }
+    }
+
+    if (failures > 0) {
+        fprintf(stderr, "%d kernel mismatches\n", failures);
+        return 1;
+    }
+
+    printf("All motion kernels are bit-exact\n");
+    return 0;
+}
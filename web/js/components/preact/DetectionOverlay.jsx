@@ -5,9 +5,13 @@
 import { h } from 'preact';
 import { useState, useEffect, useRef, useCallback } from 'preact/hooks';
 import { showStatusMessage } from './ToastContainer.jsx';
+import { isLiveEventsSupported, subscribeLiveEvents } from '../../utils/live-events.js';
 
 import { forwardRef, useImperativeHandle } from 'preact/compat';
 
+// Clear pushed detections that were not refreshed within this time
+const LIVE_DETECTION_TTL_MS = 10000;
+
 /**
  * DetectionOverlay component
  * @param {Object} props - Component props
@@ -29,6 +33,9 @@ export const DetectionOverlay = forwardRef(({
   const intervalRef = useRef(null);
   const errorCountRef = useRef(0);
   const currentIntervalRef = useRef(1000); // Start with 1 second polling interval
+  const expireTimeoutRef = useRef(null);
+  // Poll only when the browser or server cannot push detection events
+  const [useLiveEvents, setUseLiveEvents] = useState(isLiveEventsSupported());
 
   // Expose the canvas ref to parent components
   useImperativeHandle(ref, () => ({
@@ -153,10 +160,34 @@ export const DetectionOverlay = forwardRef(({
       });
   }, [streamName, videoRef]);
 
+  // Receive pushed detection events while detection is enabled
+  useEffect(() => {
+    if (!useLiveEvents || !enabled || !detectionModel) {
+      return;
+    }
+
+    const unsubscribe = subscribeLiveEvents(streamName, 'detection', data => {
+      setDetections(data.detections || []);
+
+      // Drop boxes if the detector goes quiet without clearing them
+      clearTimeout(expireTimeoutRef.current);
+      expireTimeoutRef.current = setTimeout(() => setDetections([]), LIVE_DETECTION_TTL_MS);
+    }, () => {
+      console.log(`Falling back to detection polling for stream ${streamName}`);
+      setUseLiveEvents(false);
+    });
+
+    return () => {
+      unsubscribe();
+      clearTimeout(expireTimeoutRef.current);
+      expireTimeoutRef.current = null;
+    };
+  }, [useLiveEvents, enabled, detectionModel, streamName]);
+
   // Start/stop detection polling based on enabled prop
   useEffect(() => {
-    // Only start polling if detection is enabled and we have a model
-    if (enabled && detectionModel && videoRef.current && canvasRef.current) {
+    // Only start polling if detection is enabled, we have a model and events are not pushed
+    if (!useLiveEvents && enabled && detectionModel && videoRef.current && canvasRef.current) {
       console.log(`Starting detection polling for stream ${streamName}`);
 
       // Clear any existing interval
@@ -182,7 +213,7 @@ export const DetectionOverlay = forwardRef(({
       clearInterval(intervalRef.current);
       intervalRef.current = null;
     }
-  }, [enabled, detectionModel, streamName, pollDetections, videoRef]);
+  }, [useLiveEvents, enabled, detectionModel, streamName, pollDetections, videoRef]);
 
   // Draw detections whenever they change
   useEffect(() => {
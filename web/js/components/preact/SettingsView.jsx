@@ -87,7 +87,8 @@ export function SettingsView() {
         logLevel: settingsData.log_level?.toString() || '',
         storagePath: settingsData.storage_path || '',
         storagePathHls: settingsData.storage_path_hls || '', // Map the HLS storage path
-        maxStorage: settingsData.max_storage_size?.toString() || '',
+        // The backend stores bytes, the form shows GB
+        maxStorage: settingsData.max_storage_size !== undefined ? Math.round(settingsData.max_storage_size / 1073741824).toString() : '',
         retention: settingsData.retention_days?.toString() || '',
         autoDelete: settingsData.auto_delete_oldest || false,
         dbPath: settingsData.db_path || '',
@@ -120,7 +121,7 @@ export function SettingsView() {
       log_level: parseInt(settings.logLevel, 10),
       storage_path: settings.storagePath,
       storage_path_hls: settings.storagePathHls, // Include the HLS storage path
-      max_storage_size: parseInt(settings.maxStorage, 10),
+      max_storage_size: (parseInt(settings.maxStorage, 10) || 0) * 1073741824,
       retention_days: parseInt(settings.retention, 10),
       auto_delete_oldest: settings.autoDelete,
       db_path: settings.dbPath,
@@ -110,6 +110,7 @@ export function SystemView() {
     onSuccess: () => {
       showStatusMessage('Logs cleared successfully');
       setLogs([]);
+      window.dispatchEvent(new CustomEvent('logs-cleared'));
     },
     onError: (error) => {
       console.error('Error clearing logs:', error);
@@ -1,6 +1,10 @@
 /**
  * LogsPoller Component
  * Handles polling for logs via HTTP API
+ *
+ * The first request returns the end of the log file together with a cursor.
+ * Later requests pass the cursor and only receive newer entries, which are
+ * appended to the logs already received.
  */
 
 import { useState, useEffect, useRef } from 'preact/hooks';
@@ -16,10 +20,15 @@ import { fetchJSON } from '../../../fetch-utils.js';
  * @param {Function} props.onLogsReceived Callback function when logs are received
  * @returns {JSX.Element} LogsPoller component (invisible)
  */
+// Maximum number of log entries kept in the browser
+const MAX_BUFFERED_LOGS = 1000;
+
 export function LogsPoller({ logLevel, logCount, pollingInterval = 5000, onLogsReceived }) {
   const [isPolling, setIsPolling] = useState(false);
   const pollingIntervalRef = useRef(null);
   const lastTimestampRef = useRef(null);
+  const cursorRef = useRef(null);
+  const bufferRef = useRef([]);
 
   // Try to load the last timestamp from localStorage on initial render
   useEffect(() => {
@@ -41,8 +50,12 @@ export function LogsPoller({ logLevel, logCount, pollingInterval = 5000, onLogsR
     console.log('Fetching logs via HTTP API with level: debug (to get all logs, will filter on frontend)');
 
     try {
-      // Fetch logs from the API
-      const response = await fetchJSON('/api/system/logs?level=debug', {
+      // Fetch logs from the API, only newer ones once we have a cursor
+      const cursor = cursorRef.current;
+      const url = cursor !== null
+        ? `/api/system/logs?level=debug&cursor=${cursor}`
+        : `/api/system/logs?level=debug&limit=${MAX_BUFFERED_LOGS}`;
+      const response = await fetchJSON(url, {
         timeout: 10000,
         retries: 1
       });
@@ -69,21 +82,25 @@ export function LogsPoller({ logLevel, logCount, pollingInterval = 5000, onLogsR
           return normalizedLog;
         });
 
-        // Sort logs by timestamp (newest first)
-        cleanedLogs.sort((a, b) => {
-          return new Date(b.timestamp) - new Date(a.timestamp);
-        });
+        // Append to what we already have (entries arrive oldest first)
+        const merged = cursor !== null ? bufferRef.current.concat(cleanedLogs) : cleanedLogs;
+        bufferRef.current = merged.slice(-MAX_BUFFERED_LOGS);
+        if (typeof response.cursor === 'number') {
+          cursorRef.current = response.cursor;
+        }
+
+        // Newest first for display
+        const displayLogs = bufferRef.current.slice().reverse();
 
         // Update last timestamp for future reference
-        if (cleanedLogs.length > 0 && cleanedLogs[0].timestamp) {
-          lastTimestampRef.current = cleanedLogs[0].timestamp;
-          localStorage.setItem('lastLogTimestamp', cleanedLogs[0].timestamp);
-          console.log('Updated and saved last log timestamp:', cleanedLogs[0].timestamp);
+        if (displayLogs.length > 0 && displayLogs[0].timestamp) {
+          lastTimestampRef.current = displayLogs[0].timestamp;
+          localStorage.setItem('lastLogTimestamp', displayLogs[0].timestamp);
         }
 
         // Call the callback with the logs
-        console.log(`Received ${cleanedLogs.length} logs via HTTP API`);
-        onLogsReceived(cleanedLogs);
+        console.log(`Received ${cleanedLogs.length} new logs via HTTP API`);
+        onLogsReceived(displayLogs);
       } else {
         console.log('No logs received from API');
       }
@@ -97,13 +114,21 @@ export function LogsPoller({ logLevel, logCount, pollingInterval = 5000, onLogsR
   useEffect(() => {
     const handleRefreshEvent = () => {
       console.log('Received refresh-logs event, triggering fetch');
+      cursorRef.current = null;
       fetchLogs();
     };
 
+    // Forget what we have, the next poll only returns newer entries
+    const handleClearedEvent = () => {
+      bufferRef.current = [];
+    };
+
     window.addEventListener('refresh-logs', handleRefreshEvent);
+    window.addEventListener('logs-cleared', handleClearedEvent);
 
     return () => {
       window.removeEventListener('refresh-logs', handleRefreshEvent);
+      window.removeEventListener('logs-cleared', handleClearedEvent);
     };
   }, []);
 
@@ -144,6 +169,7 @@ export function LogsPoller({ logLevel, logCount, pollingInterval = 5000, onLogsR
   useEffect(() => {
     console.log(`LogsPoller: Setting up polling with log level ${logLevel}, count ${logCount}`);
     setIsPolling(false); // Stop any existing polling
+    cursorRef.current = null; // Start over with a full page
 
     // Small delay to ensure any previous polling is cleaned up
     const timeoutId = setTimeout(() => {
@@ -18,6 +18,7 @@ export function TimelineSegments({ segments: propSegments }) {
   const [startHour, setStartHour] = useState(0);
   const [endHour, setEndHour] = useState(24);
   const [currentSegmentIndex, setCurrentSegmentIndex] = useState(-1);
+  const [hoverPreview, setHoverPreview] = useState(null);
 
   // Update segments when props change
   useEffect(() => {
@@ -31,6 +32,10 @@ export function TimelineSegments({ segments: propSegments }) {
   const containerRef = useRef(null);
   const isDragging = useRef(false);
 
+  // Preview indexes by recording id, a pending fetch is stored as its promise
+  const previewCacheRef = useRef(new Map());
+  const hoverRequestRef = useRef(0);
+
   // Track the last time segments were updated to prevent too frequent updates
   const lastSegmentsUpdateRef = useRef(0);
   const lastSegmentsRef = useRef([]);
@@ -125,6 +130,73 @@ export function TimelineSegments({ segments: propSegments }) {
     };
   }, [startHour, endHour, segments]);
 
+  // Load the keyframe index and sprite layout of a recording once
+  const loadPreview = (segmentId) => {
+    const cache = previewCacheRef.current;
+    if (!cache.has(segmentId)) {
+      cache.set(segmentId, fetch(`/api/timeline/preview/${segmentId}`)
+        .then(response => response.ok ? response.json() : null)
+        .catch(() => null)
+        .then(preview => {
+          cache.set(segmentId, preview);
+          return preview;
+        }));
+    }
+    return Promise.resolve(cache.get(segmentId));
+  };
+
+  // Show the sprite thumbnail nearest to the hovered time
+  const handlePreviewHover = (event) => {
+    const container = containerRef.current;
+    if (!container || isDragging.current) return;
+    const request = ++hoverRequestRef.current;
+
+    const rect = container.getBoundingClientRect();
+    const hoverX = event.clientX - rect.left;
+    const hoverHour = startHour + ((hoverX / rect.width) * (endHour - startHour));
+
+    const hoverDate = new Date(timelineState.selectedDate);
+    hoverDate.setHours(Math.floor(hoverHour));
+    hoverDate.setMinutes(Math.floor((hoverHour % 1) * 60));
+    hoverDate.setSeconds(Math.floor(((hoverHour % 1) * 60) % 1 * 60));
+    const hoverTimestamp = hoverDate.getTime() / 1000;
+
+    const segment = segments.find(s => s.has_preview &&
+      hoverTimestamp >= s.start_timestamp && hoverTimestamp <= s.end_timestamp);
+    if (!segment) {
+      setHoverPreview(null);
+      return;
+    }
+
+    loadPreview(segment.id).then(preview => {
+      // The pointer moved on or left while the index was loading
+      if (request !== hoverRequestRef.current) return;
+
+      const sprite = preview && preview.sprite;
+      if (!sprite || !sprite.tiles || sprite.tiles.length === 0) {
+        setHoverPreview(null);
+        return;
+      }
+
+      const offsetMs = (hoverTimestamp - segment.start_timestamp) * 1000;
+      let tile = 0;
+      sprite.tiles.forEach((ms, i) => {
+        if (Math.abs(ms - offsetMs) < Math.abs(sprite.tiles[tile] - offsetMs)) {
+          tile = i;
+        }
+      });
+
+      setHoverPreview({
+        id: segment.id,
+        left: hoverX,
+        width: sprite.tile_width,
+        height: sprite.tile_height,
+        x: (tile % sprite.columns) * sprite.tile_width,
+        y: Math.floor(tile / sprite.columns) * sprite.tile_height
+      });
+    });
+  };
+
   // Handle click on timeline for seeking
   const handleTimelineClick = (event) => {
     const container = containerRef.current;
@@ -450,8 +522,27 @@ export function TimelineSegments({ segments: propSegments }) {
     <div
       className="timeline-segments relative w-full h-16 pt-2"
       ref={containerRef}
+      onMouseMove={handlePreviewHover}
+      onMouseLeave={() => {
+        hoverRequestRef.current++;
+        setHoverPreview(null);
+      }}
     >
       {renderSegments()}
+      {hoverPreview && (
+        <div
+          className="timeline-preview absolute z-20 pointer-events-none rounded shadow-lg border border-border"
+          style={{
+            left: `${hoverPreview.left}px`,
+            bottom: '100%',
+            transform: 'translateX(-50%)',
+            width: `${hoverPreview.width}px`,
+            height: `${hoverPreview.height}px`,
+            backgroundImage: `url(/api/timeline/sprite/${hoverPreview.id})`,
+            backgroundPosition: `-${hoverPreview.x}px -${hoverPreview.y}px`
+          }}
+        ></div>
+      )}
     </div>
   );
 }
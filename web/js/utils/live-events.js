@@ -0,0 +1,94 @@
+/**
+ * LightNVR Web Interface Live Events
+ * Shares one server-sent event connection to /api/events between all
+ * components of a page that need live detections, motion or recording state
+ */
+
+// Consecutive connection errors before subscribers are told to fall back to polling
+const MAX_CONNECT_ERRORS = 3;
+
+let eventSource = null;
+let connectErrors = 0;
+const subscribers = new Set();
+
+/**
+ * Check whether the browser can receive live events
+ * @returns {boolean} - True if EventSource is available
+ */
+export function isLiveEventsSupported() {
+  return typeof window !== 'undefined' && typeof window.EventSource !== 'undefined';
+}
+
+function dispatch(type, event) {
+  let data;
+  try {
+    data = JSON.parse(event.data);
+  } catch (error) {
+    console.error(`Invalid live ${type} event:`, error);
+    return;
+  }
+
+  subscribers.forEach(subscriber => {
+    if (subscriber.type === type && subscriber.streamName === data.stream) {
+      subscriber.onEvent(data);
+    }
+  });
+}
+
+function connect() {
+  eventSource = new EventSource('/api/events');
+  connectErrors = 0;
+
+  eventSource.onopen = () => {
+    connectErrors = 0;
+  };
+
+  eventSource.onerror = () => {
+    // EventSource reconnects on its own, give up only when it keeps failing
+    connectErrors++;
+    if (connectErrors < MAX_CONNECT_ERRORS && eventSource.readyState !== EventSource.CLOSED) {
+      return;
+    }
+
+    console.warn('Live event stream unavailable');
+    disconnect();
+    const failed = Array.from(subscribers);
+    subscribers.clear();
+    failed.forEach(subscriber => subscriber.onFailure && subscriber.onFailure());
+  };
+
+  ['detection', 'motion', 'recording'].forEach(type => {
+    eventSource.addEventListener(type, event => dispatch(type, event));
+  });
+}
+
+function disconnect() {
+  if (eventSource) {
+    eventSource.close();
+    eventSource = null;
+  }
+}
+
+/**
+ * Subscribe to live events of one stream
+ * @param {string} streamName - Name of the stream
+ * @param {string} type - Event type: 'detection', 'motion' or 'recording'
+ * @param {Function} onEvent - Called with the parsed event data
+ * @param {Function} [onFailure] - Called once if the event stream cannot be used
+ * @returns {Function} - Unsubscribe function
+ */
+export function subscribeLiveEvents(streamName, type, onEvent, onFailure) {
+  const subscriber = { streamName, type, onEvent, onFailure };
+  subscribers.add(subscriber);
+
+  if (!eventSource) {
+    connect();
+  }
+
+  return () => {
+    subscribers.delete(subscriber);
+    if (subscribers.size === 0) {
+      disconnect();
+    }
+  };
+}